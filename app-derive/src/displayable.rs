@@ -0,0 +1,105 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use proc_macro::TokenStream;
+use proc_macro_error::{abort, abort_if_dirty, emit_error};
+use quote::quote;
+use syn::{parse_macro_input, spanned::Spanned, Data, DeriveInput, Fields};
+
+use crate::utils::cfg_variant_attributes;
+
+pub fn displayable_item(input: TokenStream) -> TokenStream {
+    let DeriveInput {
+        ident,
+        generics,
+        data,
+        ..
+    } = parse_macro_input!(input as DeriveInput);
+
+    let variants = match data {
+        Data::Enum(e) => e.variants,
+        _ => abort!(ident.span(), "only enums are supported"),
+    };
+
+    let mut arms = Vec::with_capacity(variants.len());
+
+    for variant in &variants {
+        let name = &variant.ident;
+        let cfg = cfg_variant_attributes(variant.attrs.clone());
+
+        match &variant.fields {
+            Fields::Unnamed(fields) if fields.unnamed.len() == 1 => arms.push(quote! {
+                #(#cfg)*
+                Self::#name(inner) => match item {
+                    Some((item_n, title, message, page)) => {
+                        crate::parser::DisplayableItem::render_item(
+                            inner, item_n, title, message, page
+                        )
+                    }
+                    None => crate::parser::DisplayableItem::num_items(inner),
+                },
+            }),
+            // nothing to show for an empty variant
+            Fields::Unit => arms.push(quote! {
+                #(#cfg)*
+                Self::#name => match item {
+                    Some(_) => Err(::zemu_sys::ViewError::NoData),
+                    None => Ok(0),
+                },
+            }),
+            _ => emit_error!(
+                variant.span(),
+                "only unit variants or variants with a single unnamed field are supported"
+            ),
+        }
+    }
+
+    abort_if_dirty();
+
+    let (impl_generics, type_generics, where_clause) = generics.split_for_impl();
+
+    // num_items and render_item share a single match,
+    // so each enum gets one jump table and one copy of the variant calls
+    quote! {
+        impl #impl_generics #ident #type_generics #where_clause {
+            #[inline(never)]
+            fn displayable_dispatch(
+                &self,
+                item: Option<(u8, &mut [u8], &mut [u8], u8)>,
+            ) -> Result<u8, ::zemu_sys::ViewError> {
+                match self {
+                    #(#arms)*
+                }
+            }
+        }
+
+        impl #impl_generics crate::parser::DisplayableItem for #ident #type_generics #where_clause {
+            fn num_items(&self) -> Result<u8, ::zemu_sys::ViewError> {
+                self.displayable_dispatch(None)
+            }
+
+            fn render_item(
+                &self,
+                item_n: u8,
+                title: &mut [u8],
+                message: &mut [u8],
+                page: u8,
+            ) -> Result<u8, ::zemu_sys::ViewError> {
+                self.displayable_dispatch(Some((item_n, title, message, page)))
+            }
+        }
+    }
+    .into()
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Keccak-256, as used by Solidity to derive the function selectors
+//!
+//! Only meant to hash a few short signatures at compile time,
+//! so it's the plain sponge without any optimization
+
+use std::convert::TryInto;
+
+const ROUNDS: usize = 24;
+const RATE: usize = 136;
+
+const ROUND_CONSTANTS: [u64; ROUNDS] = [
+    0x0000000000000001,
+    0x0000000000008082,
+    0x800000000000808a,
+    0x8000000080008000,
+    0x000000000000808b,
+    0x0000000080000001,
+    0x8000000080008081,
+    0x8000000000008009,
+    0x000000000000008a,
+    0x0000000000000088,
+    0x0000000080008009,
+    0x000000008000000a,
+    0x000000008000808b,
+    0x800000000000008b,
+    0x8000000000008089,
+    0x8000000000008003,
+    0x8000000000008002,
+    0x8000000000000080,
+    0x000000000000800a,
+    0x800000008000000a,
+    0x8000000080008081,
+    0x8000000000008080,
+    0x0000000080000001,
+    0x8000000080008008,
+];
+
+const ROTATIONS: [u32; 25] = [
+    0, 1, 62, 28, 27, 36, 44, 6, 55, 20, 3, 10, 43, 25, 39, 41, 45, 15, 21, 8, 18, 2, 61, 56, 14,
+];
+
+fn keccak_f(state: &mut [u64; 25]) {
+    for rc in ROUND_CONSTANTS {
+        // theta
+        let mut c = [0u64; 5];
+        for (x, c) in c.iter_mut().enumerate() {
+            *c = (0..5).fold(0, |acc, y| acc ^ state[x + 5 * y]);
+        }
+        for x in 0..5 {
+            let d = c[(x + 4) % 5] ^ c[(x + 1) % 5].rotate_left(1);
+            for y in 0..5 {
+                state[x + 5 * y] ^= d;
+            }
+        }
+
+        // rho and pi
+        let mut b = [0u64; 25];
+        for x in 0..5 {
+            for y in 0..5 {
+                let lane = x + 5 * y;
+                b[y + 5 * ((2 * x + 3 * y) % 5)] = state[lane].rotate_left(ROTATIONS[lane]);
+            }
+        }
+
+        // chi
+        for x in 0..5 {
+            for y in 0..5 {
+                state[x + 5 * y] =
+                    b[x + 5 * y] ^ (!b[(x + 1) % 5 + 5 * y] & b[(x + 2) % 5 + 5 * y]);
+            }
+        }
+
+        // iota
+        state[0] ^= rc;
+    }
+}
+
+pub fn keccak256(input: &[u8]) -> [u8; 32] {
+    let mut state = [0u64; 25];
+
+    // original keccak padding, not the one of SHA-3
+    let mut padded = input.to_vec();
+    padded.push(0x01);
+    padded.resize(padded.len().div_ceil(RATE) * RATE, 0);
+    *padded.last_mut().unwrap() |= 0x80;
+
+    for block in padded.chunks(RATE) {
+        for (lane, bytes) in state.iter_mut().zip(block.chunks(8)) {
+            *lane ^= u64::from_le_bytes(bytes.try_into().unwrap());
+        }
+        keccak_f(&mut state);
+    }
+
+    let mut out = [0; 32];
+    for (bytes, lane) in out.chunks_mut(8).zip(state) {
+        bytes.copy_from_slice(&lane.to_le_bytes());
+    }
+    out
+}
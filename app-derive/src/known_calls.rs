@@ -0,0 +1,426 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use std::collections::HashSet;
+
+use convert_case::{Case, Casing};
+use proc_macro::TokenStream;
+use proc_macro2::Span;
+use proc_macro_error::{abort, abort_if_dirty, emit_error};
+use quote::quote;
+use syn::{
+    braced,
+    parse::{Parse, ParseStream},
+    parse_macro_input,
+    punctuated::Punctuated,
+    Attribute, Ident, LitByteStr, LitStr, Token, Visibility,
+};
+
+use crate::keccak::keccak256;
+
+/// Seeds are stored as `u8`, 0 is reserved to pick the bucket
+const MAX_SEED: u32 = u8::MAX as u32;
+
+struct Entry {
+    attrs: Vec<Attribute>,
+    signature: LitStr,
+}
+
+impl Parse for Entry {
+    fn parse(input: ParseStream) -> syn::Result<Self> {
+        Ok(Self {
+            attrs: input.call(Attribute::parse_outer)?,
+            signature: input.parse()?,
+        })
+    }
+}
+
+struct Input {
+    attrs: Vec<Attribute>,
+    vis: Visibility,
+    ident: Ident,
+    entries: Punctuated<Entry, Token![,]>,
+}
+
+impl Parse for Input {
+    fn parse(input: ParseStream) -> syn::Result<Self> {
+        let attrs = input.call(Attribute::parse_outer)?;
+        let vis = input.parse()?;
+        input.parse::<Token![enum]>()?;
+        let ident = input.parse()?;
+
+        let content;
+        braced!(content in input);
+
+        Ok(Self {
+            attrs,
+            vis,
+            ident,
+            entries: content.parse_terminated(Entry::parse, Token![,])?,
+        })
+    }
+}
+
+#[derive(Clone, Copy)]
+enum Kind {
+    Address,
+    Bool,
+    Uint(u16),
+    FixedBytes(u8),
+    AddressArray,
+    UintArray(u16),
+}
+
+impl Kind {
+    /// Parses a solidity type, returning it along its canonical name
+    fn parse(ty: &str) -> Option<(Self, String)> {
+        fn uint_bits(bits: &str) -> Option<u16> {
+            let bits = if bits.is_empty() {
+                256
+            } else {
+                bits.parse().ok()?
+            };
+            (bits % 8 == 0 && (8..=256).contains(&bits)).then_some(bits)
+        }
+
+        if let Some(element) = ty.strip_suffix("[]") {
+            return match Self::parse(element)? {
+                (Self::Address, canonical) => Some((Self::AddressArray, canonical + "[]")),
+                (Self::Uint(bits), canonical) => Some((Self::UintArray(bits), canonical + "[]")),
+                _ => None,
+            };
+        }
+
+        let kind = match ty {
+            "address" => Self::Address,
+            "bool" => Self::Bool,
+            _ => {
+                if let Some(bits) = ty.strip_prefix("uint") {
+                    Self::Uint(uint_bits(bits)?)
+                } else if let Some(len) = ty.strip_prefix("bytes") {
+                    let len: u8 = len.parse().ok()?;
+                    if !(1..=32).contains(&len) {
+                        return None;
+                    }
+                    Self::FixedBytes(len)
+                } else {
+                    return None;
+                }
+            }
+        };
+
+        let canonical = match kind {
+            Self::Uint(bits) => format!("uint{bits}"),
+            _ => ty.to_string(),
+        };
+
+        Some((kind, canonical))
+    }
+}
+
+impl quote::ToTokens for Kind {
+    fn to_tokens(&self, tokens: &mut proc_macro2::TokenStream) {
+        tokens.extend(match *self {
+            Self::Address => quote!(crate::parser::AbiKind::Address),
+            Self::Bool => quote!(crate::parser::AbiKind::Bool),
+            Self::Uint(bits) => quote!(crate::parser::AbiKind::Uint(#bits)),
+            Self::FixedBytes(len) => quote!(crate::parser::AbiKind::FixedBytes(#len)),
+            Self::AddressArray => quote!(crate::parser::AbiKind::AddressArray),
+            Self::UintArray(bits) => quote!(crate::parser::AbiKind::UintArray(#bits)),
+        })
+    }
+}
+
+struct Function {
+    attrs: Vec<Attribute>,
+    variant: Ident,
+    name: String,
+    params: Vec<(String, Kind)>,
+    selector: u32,
+}
+
+impl Function {
+    fn parse(entry: Entry) -> Option<Self> {
+        let lit = &entry.signature;
+        let signature = lit.value();
+
+        let (name, params) = match signature.strip_suffix(')').and_then(|s| s.split_once('(')) {
+            Some((name, params)) if !name.is_empty() => (name.trim(), params.trim()),
+            _ => {
+                emit_error!(
+                    lit.span(),
+                    "expected a signature like `name(type arg, ...)`"
+                );
+                return None;
+            }
+        };
+
+        let mut canonical = Vec::new();
+        let mut parsed = Vec::new();
+        for param in params.split(',').filter(|_| !params.is_empty()) {
+            let (ty, arg) = match param.split_whitespace().collect::<Vec<_>>()[..] {
+                [ty, arg] => (ty, arg),
+                _ => {
+                    emit_error!(lit.span(), "`{}`: expected a type and a name", param.trim());
+                    return None;
+                }
+            };
+
+            match Kind::parse(ty) {
+                Some((kind, ty)) => {
+                    canonical.push(ty);
+                    parsed.push((arg.to_string(), kind));
+                }
+                None => {
+                    emit_error!(lit.span(), "unsupported type `{}`", ty);
+                    return None;
+                }
+            }
+        }
+
+        let hash = keccak256(format!("{}({})", name, canonical.join(",")).as_bytes());
+
+        Some(Self {
+            attrs: entry.attrs,
+            variant: Ident::new(&name.to_case(Case::UpperCamel), lit.span()),
+            name: name.to_string(),
+            params: parsed,
+            selector: u32::from_be_bytes([hash[0], hash[1], hash[2], hash[3]]),
+        })
+    }
+}
+
+/// Mixes the selector with the given seed
+///
+/// Has to match the function emitted in [`known_calls`]
+fn mix(selector: u32, seed: u32) -> u32 {
+    let mut h = selector ^ seed.wrapping_mul(0x9E37_79B9);
+    h ^= h >> 16;
+    h = h.wrapping_mul(0x85EB_CA6B);
+    h ^= h >> 13;
+    h = h.wrapping_mul(0xC2B2_AE35);
+    h ^ (h >> 16)
+}
+
+/// Builds a minimal perfect hash of the selectors
+/// with the "hash and displace" method
+///
+/// Each selector is first assigned to a bucket, then the buckets,
+/// largest first, look for a seed placing all of their selectors in free slots.
+///
+/// Returns the seed of every bucket and the selector index of every slot
+fn perfect_hash(selectors: &[u32]) -> Option<(Vec<u8>, Vec<usize>)> {
+    let n = selectors.len() as u32;
+
+    'buckets: for num_buckets in (n + 1) / 2..=n {
+        let mut buckets = vec![Vec::new(); num_buckets as usize];
+        for (i, &sel) in selectors.iter().enumerate() {
+            buckets[(mix(sel, 0) % num_buckets) as usize].push(i);
+        }
+
+        let mut order: Vec<_> = (0..buckets.len()).collect();
+        order.sort_by_key(|&b| std::cmp::Reverse(buckets[b].len()));
+
+        let mut seeds = vec![0; buckets.len()];
+        let mut slots = vec![None; n as usize];
+
+        for b in order {
+            let bucket = &buckets[b];
+            if bucket.is_empty() {
+                break;
+            }
+
+            let placed = (1..=MAX_SEED).find_map(|seed| {
+                let positions: Vec<_> = bucket
+                    .iter()
+                    .map(|&i| (mix(selectors[i], seed) % n) as usize)
+                    .collect();
+
+                let unique = positions.iter().collect::<HashSet<_>>().len() == positions.len();
+                let free = positions.iter().all(|&p| slots[p].is_none());
+
+                (unique && free).then_some((seed, positions))
+            });
+
+            let (seed, positions) = match placed {
+                Some(placed) => placed,
+                None => continue 'buckets,
+            };
+
+            seeds[b] = seed as u8;
+            for (&i, p) in bucket.iter().zip(positions) {
+                slots[p] = Some(i);
+            }
+        }
+
+        return Some((seeds, slots.into_iter().map(Option::unwrap).collect()));
+    }
+
+    None
+}
+
+pub fn known_calls(input: TokenStream) -> TokenStream {
+    let Input {
+        attrs,
+        vis,
+        ident,
+        entries,
+    } = parse_macro_input!(input as Input);
+
+    if entries.is_empty() {
+        abort!(ident.span(), "at least one function is required");
+    }
+
+    let functions: Vec<_> = entries.into_iter().filter_map(Function::parse).collect();
+    abort_if_dirty();
+
+    let mut variants_seen = HashSet::new();
+    let mut selectors_seen = HashSet::new();
+    for f in &functions {
+        if !variants_seen.insert(f.variant.to_string()) {
+            emit_error!(f.variant.span(), "overloaded functions are not supported");
+        }
+        if !selectors_seen.insert(f.selector) {
+            emit_error!(
+                f.variant.span(),
+                "selector 0x{:08x} is repeated",
+                f.selector
+            );
+        }
+    }
+    abort_if_dirty();
+
+    let selectors: Vec<_> = functions.iter().map(|f| f.selector).collect();
+    let (seeds, slots) = match perfect_hash(&selectors) {
+        Some(table) => table,
+        None => abort!(
+            ident.span(),
+            "unable to find a perfect hash for the selectors"
+        ),
+    };
+
+    let num_buckets = seeds.len() as u32;
+    let num_slots = slots.len() as u32;
+    // statics can't refer to `Self`
+    let slots = slots.iter().map(|&i| {
+        let selector = functions[i].selector;
+        let variant = &functions[i].variant;
+        quote! { (#selector, #ident::#variant) }
+    });
+
+    let variants = functions.iter().map(|f| {
+        let attrs = &f.attrs;
+        let variant = &f.variant;
+        quote! { #(#attrs)* #variant }
+    });
+
+    let selector_arms = functions.iter().map(|f| {
+        let variant = &f.variant;
+        let selector = f.selector;
+        quote! { Self::#variant => #selector, }
+    });
+
+    let name_arms = functions.iter().map(|f| {
+        let variant = &f.variant;
+        let name = LitByteStr::new(f.name.as_bytes(), Span::call_site());
+        quote! { Self::#variant => pic_str!(#name!), }
+    });
+
+    let num_params_arms = functions.iter().map(|f| {
+        let variant = &f.variant;
+        let len = f.params.len();
+        quote! { Self::#variant => #len, }
+    });
+
+    let param_arms = functions.iter().flat_map(|f| {
+        let variant = &f.variant;
+        f.params.iter().enumerate().map(move |(i, (name, kind))| {
+            let name = LitByteStr::new(name.as_bytes(), Span::call_site());
+            quote! {
+                (Self::#variant, #i) => Some(crate::parser::AbiParam {
+                    name: pic_str!(#name),
+                    kind: #kind,
+                }),
+            }
+        })
+    });
+
+    quote! {
+        #(#attrs)*
+        #[derive(Clone, Copy, PartialEq, Eq)]
+        #[repr(u8)]
+        #vis enum #ident {
+            #(#variants,)*
+        }
+
+        impl #ident {
+            /// Looks up the function with the given selector
+            #[inline(never)]
+            pub fn from_selector(selector: u32) -> Option<Self> {
+                use bolos::PIC;
+
+                static SEEDS: [u8; #num_buckets as usize] = [#(#seeds),*];
+                static SLOTS: [(u32, #ident); #num_slots as usize] = [#(#slots),*];
+
+                fn mix(selector: u32, seed: u32) -> u32 {
+                    let mut h = selector ^ seed.wrapping_mul(0x9E37_79B9);
+                    h ^= h >> 16;
+                    h = h.wrapping_mul(0x85EB_CA6B);
+                    h ^= h >> 13;
+                    h = h.wrapping_mul(0xC2B2_AE35);
+                    h ^ (h >> 16)
+                }
+
+                let seeds = PIC::new(&SEEDS).into_inner();
+                let slots = PIC::new(&SLOTS).into_inner();
+
+                let seed = seeds[(mix(selector, 0) % #num_buckets) as usize];
+                let (candidate, function) = slots[(mix(selector, seed as u32) % #num_slots) as usize];
+
+                (candidate == selector).then_some(function)
+            }
+
+            pub fn selector(&self) -> u32 {
+                match self {
+                    #(#selector_arms)*
+                }
+            }
+
+            pub fn name(&self) -> &'static [u8] {
+                use bolos::{pic_str, PIC};
+
+                match self {
+                    #(#name_arms)*
+                }
+            }
+
+            pub fn num_params(&self) -> usize {
+                match self {
+                    #(#num_params_arms)*
+                }
+            }
+
+            pub fn param(&self, index: usize) -> Option<crate::parser::AbiParam> {
+                use bolos::{pic_str, PIC};
+
+                match (self, index) {
+                    #(#param_arms)*
+                    _ => None,
+                }
+            }
+        }
+    }
+    .into()
+}
@@ -14,7 +14,7 @@
 *  limitations under the License.
 ********************************************************************************/
 #![allow(dead_code)]
-//! This crate exports 2 macros with a specific use case for the ledger-avalanche app
+//! This crate exports a few macros with a specific use case for the ledger-avalanche app
 //!
 //! See [macro@unroll] for more documentation
 
@@ -116,3 +116,84 @@ mod match_ranges;
 pub fn match_ranges(input: TokenStream) -> TokenStream {
     match_ranges::match_ranges(input)
 }
+
+mod displayable;
+#[proc_macro_error]
+#[proc_macro_derive(DisplayableItem)]
+/// Implements `DisplayableItem` for an enum by delegating to its variants.
+///
+/// Every variant must either hold a single item implementing `DisplayableItem`,
+/// or be a unit variant, which has no items to show.
+///
+/// `cfg` attributes on the variants are kept on the generated arms,
+/// so feature-gated variants need no extra handling.
+///
+/// # Note
+///
+/// The generated code refers to `crate::parser::DisplayableItem` and `zemu_sys::ViewError`,
+/// so it's only meant to be used inside the app crate.
+///
+/// The dispatch is a plain `match` on the discriminant, which rustc lowers
+/// to a PC-relative jump table. A table of function pointers or a trait object
+/// would need relocating on the device instead.
+/// `num_items` and `render_item` go through the same non-inlined
+/// `displayable_dispatch`, so each enum has a single copy of that match.
+///
+/// # Example
+/// ```rust,ignore
+/// #[derive(DisplayableItem)]
+/// pub enum Foo<'b> {
+///     Empty,
+///     Bar(Bar<'b>),
+///     #[cfg(feature = "baz")]
+///     Baz(Baz<'b>),
+/// }
+/// ```
+pub fn displayable_item(input: TokenStream) -> TokenStream {
+    displayable::displayable_item(input)
+}
+
+mod keccak;
+mod known_calls;
+#[proc_macro_error]
+#[proc_macro]
+/// Generates an enum of well-known contract functions from their Solidity signatures,
+/// along with a lookup from the 4-byte selector.
+///
+/// The selectors are computed at compile time, and arranged in a minimal perfect hash
+/// ("hash and displace"): the lookup is one table read to get the seed of the bucket
+/// and another to get the only candidate, which is then compared with the selector.
+///
+/// Both tables are `static`, so they stay in flash (and are read through `PIC`),
+/// and only hold the selectors and the enum discriminants, nothing to relocate.
+///
+/// The generated enum has the following methods:
+/// * `from_selector(u32) -> Option<Self>`
+/// * `selector(&self) -> u32`
+/// * `name(&self) -> &'static [u8]`
+/// * `num_params(&self) -> usize`
+/// * `param(&self, usize) -> Option<AbiParam>`
+///
+/// # Note
+///
+/// Every parameter needs a name, which is shown as the title of its value.
+/// Only `address`, `bool`, `uint<N>`, `bytes<N>`, `address[]` and `uint<N>[]` are supported.
+///
+/// The generated code refers to `crate::parser::{AbiParam, AbiKind}` and `bolos`,
+/// so it's only meant to be used inside the app crate.
+///
+/// # Example
+/// ```rust,ignore
+/// known_calls! {
+///     pub enum KnownCall {
+///         /// WAVAX
+///         "deposit()",
+///         "withdraw(uint256 wad)",
+///     }
+/// }
+///
+/// assert_eq!(KnownCall::from_selector(0x2e1a7d4d), Some(KnownCall::Withdraw));
+/// ```
+pub fn known_calls(input: TokenStream) -> TokenStream {
+    known_calls::known_calls(input)
+}
@@ -53,6 +53,7 @@ unsigned char io_event(unsigned char channel) {
         UX_REDISPLAY();
       }
     });
+    rs_idle_tick();
     break;
   }
 
@@ -10,6 +10,8 @@ void zemu_log(const char *buf);
 void rs_handle_apdu(volatile uint32_t *flags, volatile uint32_t *tx,
                     uint32_t rx, const uint8_t *buffer, uint16_t bufferLen);
 
+void rs_idle_tick();
+
 /////////////
 
 void view_init();
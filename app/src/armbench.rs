@@ -0,0 +1,105 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Entry points used by the device benchmarks in `armbench`
+//!
+//! The library is linked into a bare image for the device ISA,
+//! then each entry point is run under an emulator with the input
+//! written to [`ARMBENCH_INPUT`], see `armbench/src/main.rs`.
+use core::mem::MaybeUninit;
+
+use crate::{
+    handlers::eth::u256,
+    parser::{DisplayableItem, Transaction},
+    utils::{
+        bs58_encode,
+        trace::{self, TraceId},
+    },
+};
+
+/// Parse a transaction
+pub const KIND_PARSE: u32 = 0;
+/// Parse a transaction, then render every page of every item
+pub const KIND_REVIEW: u32 = 1;
+/// Encode the input in base58
+pub const KIND_BS58: u32 = 2;
+/// Format the input, a big endian u256, in decimal
+pub const KIND_U256: u32 = 3;
+
+/// Written by the emulator before each run
+#[no_mangle]
+pub static mut ARMBENCH_INPUT: [u8; 0x2000] = [0; 0x2000];
+
+/// Runs the benchmark `kind` over the first `len` bytes of [`ARMBENCH_INPUT`]
+///
+/// Returns 0 on success
+#[no_mangle]
+#[inline(never)]
+pub unsafe extern "C" fn armbench_run(kind: u32, len: usize) -> u32 {
+    let data = match ARMBENCH_INPUT.get(..len) {
+        Some(data) => data,
+        None => return u32::MAX,
+    };
+
+    let ok = match kind {
+        KIND_PARSE => parse(data).is_some(),
+        KIND_REVIEW => parse(data).and_then(|tx| review(&tx)).is_some(),
+        KIND_BS58 => {
+            let mut out = [0; 0x100];
+            bs58_encode(data, &mut out).is_ok()
+        }
+        KIND_U256 => {
+            let mut out = [0; u256::FORMATTED_SIZE_DECIMAL];
+            let num = u256::pic_from_big_endian()(data);
+            !num.to_lexical(&mut out).is_empty()
+        }
+        _ => false,
+    };
+
+    !ok as u32
+}
+
+#[inline(never)]
+fn parse(data: &'static [u8]) -> Option<Transaction<'static>> {
+    let mut tx = MaybeUninit::uninit();
+    Transaction::new_into(data, &mut tx).ok()?;
+
+    //safe: initialized
+    Some(unsafe { tx.assume_init() })
+}
+
+#[inline(never)]
+fn review(tx: &Transaction) -> Option<()> {
+    let mut title = [0; 100];
+    let mut message = [0; 100];
+
+    for item_n in 0..tx.num_items().ok()? {
+        let _span = trace::span_with(TraceId::Render, item_n as _);
+
+        let mut page = 0;
+        loop {
+            let num_pages = tx
+                .render_item(item_n, &mut title, &mut message, page)
+                .ok()?;
+
+            page += 1;
+            if page >= num_pages {
+                break;
+            }
+        }
+    }
+
+    Some(())
+}
@@ -31,6 +31,7 @@ pub enum ApduError {
     ClaNotSupported = 0x6E00,
     Unknown = 0x6F00,
     SignVerifyError = 0x6F01, //unused
+    MoreDataAvailable = 0x6310,
     Success = 0x9000,
     Busy = 0x9001,
 }
@@ -80,6 +81,7 @@ impl std::convert::TryFrom<u16> for ApduError {
             0x6E00 => Ok(Self::ClaNotSupported),
             0x6F00 => Ok(Self::Unknown),
             0x6F01 => Ok(Self::SignVerifyError),
+            0x6310 => Ok(Self::MoreDataAvailable),
             0x9000 => Ok(Self::Success),
             0x9001 => Ok(Self::Busy),
             err => Err(Self::Error::Unknown(err)),
@@ -118,6 +120,12 @@ pub(crate) mod instructions {
     pub const INS_SIGN_HASH: u8 = 0x04;
     pub const INS_SIGN: u8 = 0x05;
     pub const INS_SIGN_MSG: u8 = 0x06;
+    #[cfg(feature = "policy")]
+    pub const INS_SET_POLICY: u8 = 0x07;
+    pub const INS_GET_RESPONSE: u8 = 0xC0;
+
+    #[cfg(feature = "dev")]
+    pub const INS_DEV_FLASH_STATS: u8 = 0xF0;
 }
 
 pub(crate) mod evm_instructions {
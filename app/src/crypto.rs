@@ -26,8 +26,17 @@ use sys::{
 pub use sys::crypto::ecfp256::{BitFlags, ECCInfo};
 pub type ECCInfoFlags = BitFlags<ECCInfo>;
 
+cfg_if::cfg_if! {
+    if #[cfg(fuzzing)] {
+        mod mock;
+        use mock as ecfp256;
+    } else {
+        use sys::crypto::ecfp256;
+    }
+}
+
 #[derive(Clone, Copy)]
-pub struct PublicKey(pub(crate) sys::crypto::ecfp256::PublicKey);
+pub struct PublicKey(pub(crate) ecfp256::PublicKey);
 
 impl PublicKey {
     pub fn compress(&mut self) -> Result<(), Error> {
@@ -73,7 +82,7 @@ impl TryFrom<sys::crypto::Curve> for Curve {
     }
 }
 
-pub struct SecretKey<const B: usize>(sys::crypto::ecfp256::SecretKey<B>);
+pub struct SecretKey<const B: usize>(ecfp256::SecretKey<B>);
 
 pub enum SignError {
     BufferTooSmall,
@@ -84,11 +93,7 @@ impl<const B: usize> SecretKey<B> {
     pub fn new(curve: Curve, path: BIP32Path<B>) -> Self {
         use sys::crypto::Mode;
 
-        Self(sys::crypto::ecfp256::SecretKey::new(
-            Mode::BIP32,
-            curve.into(),
-            path,
-        ))
+        Self(ecfp256::SecretKey::new(Mode::BIP32, curve.into(), path))
     }
 
     pub fn public(&self) -> Result<PublicKey, Error> {
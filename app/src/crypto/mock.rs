@@ -0,0 +1,162 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Stand-in for the `ecfp256` primitives when fuzzing
+//!
+//! Key derivation and signing are what dominate the cost of each execution,
+//! so these are replaced by a cheap mixing function.
+//! Keys, chain codes and signatures are deterministic and well formed,
+//! but they are *not* valid secp256k1 values.
+use core::mem::MaybeUninit;
+
+use crate::sys::{
+    crypto::{bip32::BIP32Path, Curve, Mode, CHAIN_CODE_LEN},
+    errors::Error,
+};
+
+use super::{ECCInfo, ECCInfoFlags};
+
+const UNCOMPRESSED_LEN: usize = 65;
+const COMPRESSED_LEN: usize = 33;
+
+// splitmix64
+fn mix(state: &mut u64) -> u64 {
+    *state = state.wrapping_add(0x9E37_79B9_7F4A_7C15);
+
+    let mut z = *state;
+    z = (z ^ (z >> 30)).wrapping_mul(0xBF58_476D_1CE4_E5B9);
+    z = (z ^ (z >> 27)).wrapping_mul(0x94D0_49BB_1331_11EB);
+    z ^ (z >> 31)
+}
+
+fn fill(state: &mut u64, out: &mut [u8]) {
+    for chunk in out.chunks_mut(8) {
+        let n = mix(state).to_be_bytes();
+        chunk.copy_from_slice(&n[..chunk.len()]);
+    }
+}
+
+#[derive(Clone, Copy)]
+pub struct PublicKey {
+    bytes: [u8; UNCOMPRESSED_LEN],
+    len: usize,
+}
+
+impl PublicKey {
+    pub fn compress(&mut self) -> Result<(), Error> {
+        if self.len == UNCOMPRESSED_LEN {
+            let parity = self.bytes[UNCOMPRESSED_LEN - 1] & 1;
+            self.bytes[0] = 0x02 | parity;
+            self.len = COMPRESSED_LEN;
+        }
+
+        Ok(())
+    }
+
+    pub fn curve(&self) -> Curve {
+        Curve::Secp256K1
+    }
+}
+
+impl AsRef<[u8]> for PublicKey {
+    fn as_ref(&self) -> &[u8] {
+        &self.bytes[..self.len]
+    }
+}
+
+pub struct SecretKey<const B: usize> {
+    seed: u64,
+    curve: Curve,
+}
+
+impl<const B: usize> SecretKey<B> {
+    pub fn new(_: Mode, curve: Curve, path: BIP32Path<B>) -> Self {
+        let mut seed = 0;
+        for component in path.components() {
+            seed ^= *component as u64;
+            mix(&mut seed);
+        }
+
+        Self { seed, curve }
+    }
+
+    pub fn curve(&self) -> Curve {
+        self.curve
+    }
+
+    pub fn public(&self) -> Result<PublicKey, Error> {
+        let mut out = MaybeUninit::uninit();
+        self.public_into(None, &mut out)?;
+
+        //safe: initialized
+        Ok(unsafe { out.assume_init() })
+    }
+
+    pub fn public_into(
+        &self,
+        chaincode: Option<&mut [u8; CHAIN_CODE_LEN]>,
+        out: &mut MaybeUninit<PublicKey>,
+    ) -> Result<(), Error> {
+        let mut state = self.seed;
+
+        let mut bytes = [0x04; UNCOMPRESSED_LEN];
+        fill(&mut state, &mut bytes[1..]);
+        out.write(PublicKey {
+            bytes,
+            len: UNCOMPRESSED_LEN,
+        });
+
+        if let Some(cc) = chaincode {
+            fill(&mut state, cc);
+        }
+
+        Ok(())
+    }
+
+    /// Writes a DER encoded signature of `data`, with both
+    /// r and s of 32 bytes
+    ///
+    /// `out` is expected to be big enough, see [`super::SecretKey::sign`];
+    /// `H` is the nonce hasher of the real implementation, unused here
+    pub fn sign<H>(&self, data: &[u8], out: &mut [u8]) -> Result<(ECCInfoFlags, usize), Error> {
+        let mut state = self.seed;
+        for chunk in data.chunks(8) {
+            let mut n = [0; 8];
+            n[..chunk.len()].copy_from_slice(chunk);
+            state ^= u64::from_be_bytes(n);
+            mix(&mut state);
+        }
+
+        // 0x30 len [0x02 0x20 r] [0x02 0x20 s]
+        let len = 2 + 2 * (2 + 32);
+        let out = &mut out[..len];
+        out[..4].copy_from_slice(&[0x30, len as u8 - 2, 0x02, 0x20]);
+        fill(&mut state, &mut out[4..][..32]);
+        out[36..38].copy_from_slice(&[0x02, 0x20]);
+        fill(&mut state, &mut out[38..]);
+
+        // no padding byte needed if the high bit is clear,
+        // and no leading zero to strip if the next one is set
+        out[4] = (out[4] & 0x7F) | 0x40;
+        out[38] = (out[38] & 0x7F) | 0x40;
+
+        let mut flags = ECCInfoFlags::empty();
+        if state & 1 == 1 {
+            flags.insert(ECCInfo::ParityOdd);
+        }
+
+        Ok((flags, len))
+    }
+}
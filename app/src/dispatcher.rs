@@ -25,6 +25,8 @@ use crate::handlers::{
         set_plugin::SetPlugin, signing::Sign as EthSign,
     },
     public_key::{GetExtendedPublicKey, GetPublicKey},
+    resources::AppContext,
+    response::GetResponse,
     version::GetVersion,
     wallet_id::WalletId,
 };
@@ -36,13 +38,20 @@ use crate::handlers::avax::{
     message::Sign as AvaxSignMsg, sign_hash::Sign as SignHash, signing::Sign as AvaxSign,
 };
 
+#[cfg(feature = "policy")]
+use crate::handlers::avax::policy::SetPolicy;
+
 #[cfg(feature = "dev")]
 use crate::handlers::dev::*;
 
-use crate::utils::{ApduBufferRead, ApduPanic};
+use crate::utils::{
+    trace::{self, TraceId},
+    ApduBufferRead, ApduPanic,
+};
 
 pub trait ApduHandler {
     fn handle(
+        ctx: &mut AppContext,
         flags: &mut u32,
         tx: &mut u32,
         apdu_buffer: ApduBufferRead<'_>,
@@ -51,6 +60,7 @@ pub trait ApduHandler {
 
 #[inline(never)]
 pub fn apdu_dispatch(
+    ctx: &mut AppContext,
     flags: &mut u32,
     tx: &mut u32,
     apdu_buffer: ApduBufferRead<'_>,
@@ -66,39 +76,93 @@ pub fn apdu_dispatch(
 
     let ins = apdu_buffer.ins();
 
+    // a response not retrieved in full is dropped
+    // as soon as another instruction comes
+    if (cla, ins) != (CLA, INS_GET_RESPONSE) {
+        ctx.response.reset();
+    }
+
     //common instructions
     match (cla, ins) {
-        (CLA, INS_GET_VERSION) => GetVersion::handle(flags, tx, apdu_buffer),
-        (CLA, INS_GET_PUBLIC_KEY) => GetPublicKey::handle(flags, tx, apdu_buffer),
-        (CLA, INS_GET_EXTENDED_PUBLIC_KEY) => GetExtendedPublicKey::handle(flags, tx, apdu_buffer),
-        (CLA, INS_GET_WALLET_ID) => WalletId::handle(flags, tx, apdu_buffer),
-        (CLA, INS_SIGN) => AvaxSign::handle(flags, tx, apdu_buffer),
-        (CLA, INS_SIGN_HASH) => SignHash::handle(flags, tx, apdu_buffer),
-        (CLA, INS_SIGN_MSG) => AvaxSignMsg::handle(flags, tx, apdu_buffer),
-
-        (CLA_ETH, INS_ETH_GET_PUBLIC_KEY) => GetEthPublicKey::handle(flags, tx, apdu_buffer),
-        (CLA_ETH, INS_SET_PLUGIN) => SetPlugin::handle(flags, tx, apdu_buffer),
+        (CLA, INS_GET_VERSION) => GetVersion::handle(ctx, flags, tx, apdu_buffer),
+        (CLA, INS_GET_PUBLIC_KEY) => GetPublicKey::handle(ctx, flags, tx, apdu_buffer),
+        (CLA, INS_GET_EXTENDED_PUBLIC_KEY) => {
+            GetExtendedPublicKey::handle(ctx, flags, tx, apdu_buffer)
+        }
+        (CLA, INS_GET_WALLET_ID) => WalletId::handle(ctx, flags, tx, apdu_buffer),
+        (CLA, INS_SIGN) => AvaxSign::handle(ctx, flags, tx, apdu_buffer),
+        (CLA, INS_SIGN_HASH) => SignHash::handle(ctx, flags, tx, apdu_buffer),
+        (CLA, INS_SIGN_MSG) => AvaxSignMsg::handle(ctx, flags, tx, apdu_buffer),
+        #[cfg(feature = "policy")]
+        (CLA, INS_SET_POLICY) => SetPolicy::handle(ctx, flags, tx, apdu_buffer),
+        (CLA, INS_GET_RESPONSE) => GetResponse::handle(ctx, flags, tx, apdu_buffer),
+
+        (CLA_ETH, INS_ETH_GET_PUBLIC_KEY) => GetEthPublicKey::handle(ctx, flags, tx, apdu_buffer),
+        (CLA_ETH, INS_SET_PLUGIN) => SetPlugin::handle(ctx, flags, tx, apdu_buffer),
         #[cfg(feature = "erc20")]
-        (CLA_ETH, INS_ETH_PROVIDE_ERC20) => ProvideERC20::handle(flags, tx, apdu_buffer),
+        (CLA_ETH, INS_ETH_PROVIDE_ERC20) => ProvideERC20::handle(ctx, flags, tx, apdu_buffer),
         #[cfg(feature = "erc721")]
-        (CLA_ETH, INS_PROVIDE_NFT_INFORMATION) => NftProvider::handle(flags, tx, apdu_buffer),
-        (CLA_ETH, INS_ETH_GET_APP_CONFIGURATION) => EthGetAppConfig::handle(flags, tx, apdu_buffer),
-        (CLA_ETH, INS_ETH_SIGN) => EthSign::handle(flags, tx, apdu_buffer),
-        (CLA_ETH, INS_SIGN_ETH_MSG) => EthSignMsg::handle(flags, tx, apdu_buffer),
+        (CLA_ETH, INS_PROVIDE_NFT_INFORMATION) => NftProvider::handle(ctx, flags, tx, apdu_buffer),
+        (CLA_ETH, INS_ETH_GET_APP_CONFIGURATION) => {
+            EthGetAppConfig::handle(ctx, flags, tx, apdu_buffer)
+        }
+        (CLA_ETH, INS_ETH_SIGN) => EthSign::handle(ctx, flags, tx, apdu_buffer),
+        (CLA_ETH, INS_SIGN_ETH_MSG) => EthSignMsg::handle(ctx, flags, tx, apdu_buffer),
 
         #[cfg(feature = "dev")]
-        _ => Debug::handle(flags, tx, apdu_buffer),
+        (CLA, INS_DEV_FLASH_STATS) => GetFlashStats::handle(ctx, flags, tx, apdu_buffer),
+        #[cfg(feature = "dev")]
+        _ => Debug::handle(ctx, flags, tx, apdu_buffer),
         #[allow(unreachable_patterns)] //not unrechable for all feature configurations
         _ => Err(ApduError::CommandNotAllowed),
     }
 }
 
+// largest frame of a streamed response
+const MAX_FRAME_LEN: usize = u8::MAX as usize;
+
+/// Moves the next frame of the response in [`AppContext::response`]
+/// to the APDU buffer, if the handler wrote nothing there
+///
+/// Returns [`ApduError::MoreDataAvailable`] until the last frame
+fn send_response_frame(
+    ctx: &mut AppContext,
+    tx: &mut u32,
+    apdu_buffer: &mut [u8],
+) -> Result<(), ApduError> {
+    if *tx != 0 || ctx.response.is_empty() {
+        return Ok(());
+    }
+
+    // leave room for the status word
+    let frame_len = core::cmp::min(apdu_buffer.len().saturating_sub(2), MAX_FRAME_LEN);
+    *tx = ctx.response.read(&mut apdu_buffer[..frame_len]) as u32;
+
+    if ctx.response.is_empty() {
+        Ok(())
+    } else {
+        Err(ApduError::MoreDataAvailable)
+    }
+}
+
 pub fn handle_apdu(flags: &mut u32, tx: &mut u32, rx: u32, apdu_buffer: &mut [u8]) {
     crate::sys::zemu_log_stack("handle_apdu\x00");
+    let _span = trace::span_with(TraceId::Apdu, apdu_buffer.get(1).copied().unwrap_or(0) as _);
+
+    //safe: no other reference to the context is alive
+    // before the handler is dispatched
+    let ctx = unsafe { AppContext::current() };
 
     //construct reader
     let status_word = match ApduBufferRead::new(apdu_buffer, rx) {
-        Ok(reader) => match apdu_dispatch(flags, tx, reader)
+        Ok(reader) => match apdu_dispatch(ctx, flags, tx, reader)
+            .map_err(|e| {
+                // the handler could have written part of its response before failing,
+                // which shouldn't be retrieved afterwards
+                ctx.response.reset();
+                e
+            })
+            .and_then(|_| send_response_frame(ctx, tx, apdu_buffer))
             .and(Err::<(), _>(ApduError::Success))
             .map_err(|e| e as u16)
         {
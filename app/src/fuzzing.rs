@@ -0,0 +1,77 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Entry points used by the fuzz targets in `hfuzz`
+use core::mem::MaybeUninit;
+
+use crate::parser::{
+    listed_objects, parsed_objects, reset_parsed_objects, DisplayableItem, Transaction,
+};
+
+/// Work done to parse and review a transaction
+#[derive(Debug, Clone, Copy)]
+pub struct ReviewCost {
+    pub items: usize,
+    pub pages: usize,
+    /// Objects in the lists of the transaction, see [`listed_objects`]
+    pub objects: usize,
+    /// Objects parsed by any [`crate::parser::ObjectList`]
+    pub parsed_objects: usize,
+}
+
+/// Parses `data` as an avalanche transaction and renders
+/// every page of every item, as a user reviewing it would
+///
+/// Returns None if the transaction can't be parsed
+#[inline(never)]
+pub fn parse_and_review(data: &[u8]) -> Option<ReviewCost> {
+    reset_parsed_objects();
+
+    let mut tx = MaybeUninit::uninit();
+    Transaction::new_into(data, &mut tx).ok()?;
+    //safe: initialized
+    let tx = unsafe { tx.assume_init() };
+
+    // objects parsed again while reviewing list their
+    // inner objects again, so the size is taken before that
+    let objects = listed_objects();
+
+    let mut title = [0; 100];
+    let mut message = [0; 100];
+
+    let items = tx.num_items().ok()?;
+    let mut pages = 0;
+    for item_n in 0..items {
+        let mut page = 0;
+        loop {
+            let num_pages = tx
+                .render_item(item_n, &mut title, &mut message, page)
+                .ok()?;
+            pages += 1;
+            page += 1;
+
+            if page >= num_pages {
+                break;
+            }
+        }
+    }
+
+    Some(ReviewCost {
+        items: items as usize,
+        pages,
+        objects,
+        parsed_objects: parsed_objects(),
+    })
+}
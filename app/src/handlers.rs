@@ -15,6 +15,7 @@
 ********************************************************************************/
 pub mod avax;
 pub mod public_key;
+pub mod response;
 pub mod version;
 pub mod wallet_id;
 
@@ -29,27 +30,141 @@ pub use utils::*;
 pub mod resources {
     use crate::constants::MAX_BIP32_PATH_DEPTH;
 
-    use super::lock::Lock;
-    use bolos::{
-        crypto::bip32::BIP32Path, hash::Sha256, lazy_static, new_swapping_buffer, pic::PIC,
-        SwappingBuffer,
-    };
+    use super::{eth::signing::TxStream, idle::IdleTasks, lock::Lock};
+    use crate::parser::OutputCursor;
+    use crate::utils::{MsgStream, PagedBuffer, ResponseStream, UploadProgress, UploadRefs};
+    #[cfg(not(any(test, fuzzing)))]
+    use bolos::new_swapping_buffer;
+    use bolos::{crypto::bip32::BIP32Path, hash::Sha256, pic::PIC};
+
+    cfg_if::cfg_if! {
+        if #[cfg(feature = "large-ram-buffer")] {
+            // targets with enough RAM keep most uploads out of flash
+            const BUFFER_RAM_LEN: usize = 0x1000;
+            const NVM_PAGE_LEN: usize = 512;
+            const RESPONSE_LEN: usize = 0x800;
+        } else {
+            const BUFFER_RAM_LEN: usize = 0xFF;
+            const NVM_PAGE_LEN: usize = 64;
+            const RESPONSE_LEN: usize = 0x200;
+        }
+    }
+    const BUFFER_FLASH_LEN: usize = 0x1FFF;
+
+    pub type ZBuffer = PagedBuffer<BUFFER_RAM_LEN, BUFFER_FLASH_LEN, NVM_PAGE_LEN>;
+    pub type ZResponse = ResponseStream<RESPONSE_LEN>;
+
+    /// State kept by the app across APDUs
+    ///
+    /// Handlers receive it from the dispatcher, while the code running
+    /// outside of a handler (UI callbacks, parsers) retrieves it
+    /// with [`AppContext::current`].
+    ///
+    /// The device has a single instance, whereas host builds (tests, and the
+    /// `fuzzing` ones also linked by the client's mock device) get one per thread,
+    /// along with the storage behind `buffer`, so a thread only ever sees
+    /// its own session. The stored policy is still shared by the whole process.
+    pub struct AppContext {
+        pub buffer: Lock<ZBuffer, BUFFERAccessors>,
+        pub path: Lock<Option<BIP32Path<MAX_BIP32_PATH_DEPTH>>, PATHAccessors>,
+        pub hash: Lock<Option<[u8; Sha256::DIGEST_LEN]>, HASHAccessors>,
+        #[cfg(feature = "erc721")]
+        pub nft_info: Lock<Option<crate::parser::NftInfo>, NFTInfoAccessors>,
+        pub eth_stream: Lock<Option<TxStream>, ETHStreamAccessors>,
+        pub msg_stream: Lock<Option<MsgStream>, MSGStreamAccessors>,
+        /// Length of the data of the first upload packet,
+        /// see [`crate::utils::Uploader`]
+        pub upload_init_len: usize,
+        /// Values seen during a compressed upload
+        pub upload_refs: UploadRefs,
+        /// Bytes received during a sequenced upload
+        pub upload_progress: UploadProgress,
+        /// Work to do between ticker events
+        pub idle: IdleTasks,
+        /// Response not returned yet, see [`crate::dispatcher::handle_apdu`]
+        pub response: ZResponse,
+        /// Where the review is in the outputs of the transaction shown,
+        /// see [`OutputCursor`]
+        ///
+        /// It's only used for the outputs it was stored for, told apart
+        /// by the address and length of their list and which of them are shown,
+        /// and it's cleared whenever a transaction is parsed,
+        /// as other outputs could have been uploaded at the same address.
+        pub output_cursor: Option<OutputCursor>,
+        /// Set while the dispatcher handles an APDU, as ticker events
+        /// can be dispatched meanwhile, see [`crate::rs_idle_tick`]
+        pub handling_apdu: bool,
+        /// Spans recorded by host builds, see [`crate::utils::trace`]
+        #[cfg(all(feature = "trace", any(test, fuzzing)))]
+        pub trace: crate::utils::trace::ContextTrace,
+    }
 
-    #[lazy_static]
-    pub static mut BUFFER: Lock<SwappingBuffer<'static, 'static, 0xFF, 0x1FFF>, BUFFERAccessors> =
-        Lock::new(new_swapping_buffer!(0xFF, 0x1FFF));
+    #[cfg(not(any(test, fuzzing)))]
+    #[bolos::lazy_static]
+    static mut CONTEXT: AppContext = AppContext::new();
+
+    impl AppContext {
+        fn new() -> Self {
+            Self {
+                buffer: Lock::new(Self::new_buffer()),
+                path: Lock::new(None),
+                hash: Lock::new(None),
+                #[cfg(feature = "erc721")]
+                nft_info: Lock::new(None),
+                eth_stream: Lock::new(None),
+                msg_stream: Lock::new(None),
+                upload_init_len: 0,
+                upload_refs: UploadRefs::default(),
+                upload_progress: UploadProgress::default(),
+                idle: IdleTasks::new(),
+                response: ZResponse::default(),
+                output_cursor: None,
+                handling_apdu: false,
+                #[cfg(all(feature = "trace", any(test, fuzzing)))]
+                trace: crate::utils::trace::ContextTrace::new(),
+            }
+        }
 
-    #[lazy_static]
-    pub static mut PATH: Lock<Option<BIP32Path<MAX_BIP32_PATH_DEPTH>>, PATHAccessors> =
-        Lock::new(None);
+        #[cfg(not(any(test, fuzzing)))]
+        fn new_buffer() -> ZBuffer {
+            PagedBuffer::new(new_swapping_buffer!(BUFFER_RAM_LEN, BUFFER_FLASH_LEN))
+        }
 
-    #[lazy_static]
-    pub static mut HASH: Lock<Option<[u8; Sha256::DIGEST_LEN]>, HASHAccessors> = Lock::new(None);
+        // the storage of `new_swapping_buffer!` is a static,
+        // shared by every thread, so each context gets its own instead
+        #[cfg(any(test, fuzzing))]
+        fn new_buffer() -> ZBuffer {
+            use bolos::{nvm::NVM, SwappingBuffer};
+            use std::boxed::Box;
 
-    #[cfg(feature = "erc721")]
-    #[lazy_static]
-    pub static mut NFT_INFO: Lock<Option<crate::parser::NftInfo>, NFTInfoAccessors> =
-        Lock::new(None);
+            let ram = Box::leak(Box::new([0; BUFFER_RAM_LEN]));
+            let flash = Box::leak(Box::new(PIC::new(NVM::new())));
+
+            PagedBuffer::new(SwappingBuffer::new(ram, flash))
+        }
+
+        /// Retrieve the context of the running session
+        ///
+        /// # Safety
+        /// The returned reference aliases any other reference to the context
+        /// of this thread, like the one given to the running handler, so it
+        /// shouldn't be kept across calls that could also access the context,
+        /// nor sent to another thread.
+        pub unsafe fn current() -> &'static mut Self {
+            cfg_if::cfg_if! {
+                if #[cfg(any(test, fuzzing))] {
+                    std::thread_local! {
+                        static CONTEXT: *mut AppContext =
+                            std::boxed::Box::leak(std::boxed::Box::new(AppContext::new()));
+                    }
+
+                    &mut *CONTEXT.with(|ctx| *ctx)
+                } else {
+                    &mut *CONTEXT
+                }
+            }
+        }
+    }
 
     #[derive(Clone, Copy, PartialEq, Eq)]
     pub enum BUFFERAccessors {
@@ -58,6 +173,8 @@ pub mod resources {
         SignHash,
         SignMsg,
         EthSignMsg,
+        #[cfg(feature = "policy")]
+        SetPolicy,
         #[cfg(feature = "dev")]
         Debug,
     }
@@ -79,6 +196,20 @@ pub mod resources {
         SignMsg,
     }
 
+    #[derive(Clone, Copy, PartialEq, Eq)]
+    pub enum ETHStreamAccessors {
+        EthSign,
+        // The calldata subparser, to know if
+        // the calldata was cropped during the upload
+        CallDataParser,
+    }
+
+    #[derive(Clone, Copy, PartialEq, Eq)]
+    pub enum MSGStreamAccessors {
+        SignMsg,
+        EthSignMsg,
+    }
+
     #[derive(Clone, Copy, PartialEq, Eq)]
     #[cfg(feature = "erc721")]
     pub enum NFTInfoAccessors {
@@ -100,6 +231,13 @@ pub mod resources {
         }
     }
 
+    #[cfg(feature = "policy")]
+    impl From<super::avax::policy::SetPolicy> for BUFFERAccessors {
+        fn from(_: super::avax::policy::SetPolicy) -> Self {
+            Self::SetPolicy
+        }
+    }
+
     impl From<super::avax::sign_hash::Sign> for BUFFERAccessors {
         fn from(_: super::avax::sign_hash::Sign) -> Self {
             Self::SignHash
@@ -118,6 +256,32 @@ pub mod resources {
         }
     }
 
+    impl From<super::eth::signing::Sign> for ETHStreamAccessors {
+        fn from(_: super::eth::signing::Sign) -> Self {
+            Self::EthSign
+        }
+    }
+
+    // gives the calldata subparser access to the upload state
+    // of the transaction being signed, see `ERC721Parser` below
+    impl From<crate::parser::CallDataInfo> for ETHStreamAccessors {
+        fn from(_: crate::parser::CallDataInfo) -> Self {
+            Self::CallDataParser
+        }
+    }
+
+    impl From<super::avax::message::Sign> for MSGStreamAccessors {
+        fn from(_: super::avax::message::Sign) -> Self {
+            Self::SignMsg
+        }
+    }
+
+    impl From<super::eth::personal_msg::Sign> for MSGStreamAccessors {
+        fn from(_: super::eth::personal_msg::Sign) -> Self {
+            Self::EthSignMsg
+        }
+    }
+
     #[cfg(feature = "erc721")]
     impl From<super::eth::provide_nft_info::Info> for NFTInfoAccessors {
         fn from(_: super::eth::provide_nft_info::Info) -> Self {
@@ -205,4 +369,5 @@ pub mod resources {
     }
 }
 
+pub mod idle;
 pub mod lock;
@@ -15,5 +15,7 @@
 ********************************************************************************/
 
 pub mod message;
+#[cfg(feature = "policy")]
+pub mod policy;
 pub mod sign_hash;
 pub mod signing;
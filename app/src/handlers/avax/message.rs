@@ -13,22 +13,16 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use bolos::{
-    crypto::bip32::BIP32Path,
-    hash::{Hasher, Sha256},
-};
+use bolos::{crypto::bip32::BIP32Path, hash::Sha256, pic_str, PIC};
 use zemu_sys::{Show, ViewError, Viewable};
 
 use crate::{
     constants::{ApduError as Error, BIP32_PATH_PREFIX_DEPTH},
     dispatcher::ApduHandler,
-    handlers::{
-        avax::sign_hash::Sign as SignHash,
-        resources::{HASH, PATH},
-    },
+    handlers::{avax::sign_hash::Sign as SignHash, resources::AppContext, ZPacketType},
     parser::{AvaxMessage, DisplayableItem},
     sys,
-    utils::{ApduBufferRead, Uploader},
+    utils::{ApduBufferRead, MsgStream},
 };
 
 pub struct Sign;
@@ -39,29 +33,34 @@ impl Sign {
     pub const SIGN_HASH_SIZE: usize = Sha256::DIGEST_LEN;
 
     #[inline(never)]
-    fn sha256_digest(buffer: &[u8]) -> Result<[u8; Self::SIGN_HASH_SIZE], Error> {
-        Sha256::digest(buffer).map_err(|_| Error::ExecutionError)
+    fn init(ctx: &mut AppContext, payload: &[u8]) -> Result<(), Error> {
+        let root_path = BIP32Path::read(payload).map_err(|_| Error::DataInvalid)?;
+        // this path should be a root path of the form x/x/x
+        if root_path.components().len() != BIP32_PATH_PREFIX_DEPTH {
+            return Err(Error::WrongLength);
+        }
+
+        ctx.path.lock(Self).replace(root_path);
+        ctx.buffer.lock(Self).reset();
+
+        // Avax message structure: Header + 4-byte msg_len + msg
+        // the header is checked as it arrives, see `AvaxMessage`
+        let header = pic_str!(b"\x1AAvalanche Signed Message:\n"!);
+        let stream = MsgStream::new_sha256(header)?;
+
+        ctx.msg_stream.lock(Self).replace(stream);
+
+        Ok(())
     }
 
     #[inline(never)]
     pub fn start_sign(
-        init_data: &[u8],
         data: &'static [u8],
+        digest: [u8; Self::SIGN_HASH_SIZE],
         flags: &mut u32,
     ) -> Result<u32, Error> {
-        let root_path = BIP32Path::read(init_data).map_err(|_| Error::DataInvalid)?;
-        // this path should be a root path of the form x/x/x
-        if root_path.components().len() != BIP32_PATH_PREFIX_DEPTH {
-            return Err(Error::WrongLength);
-        }
-
-        unsafe {
-            PATH.lock(Self).replace(root_path);
-        }
-
-        let digest = Self::sha256_digest(data)?;
         // parse message
-        let msg = AvaxMessage::new(data).map_err(|_| Error::DataInvalid)?;
+        let msg = AvaxMessage::from_preview(data).map_err(|_| Error::DataInvalid)?;
 
         let ui = SignUI { hash: digest, msg };
 
@@ -71,13 +70,44 @@ impl Sign {
 
 impl ApduHandler for Sign {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        ctx: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("AvaxSignMsg::handle\x00");
 
         *tx = 0;
 
-        if let Some(upload) = Uploader::new(Self).upload(&buffer)? {
-            *tx = Self::start_sign(upload.first, upload.data, flags)?;
+        let packet_type = ZPacketType::new(buffer.p1()).map_err(|_| Error::InvalidP1P2)?;
+
+        // the first packet only carries the root path,
+        // the message follows in the next ones and is hashed as it arrives,
+        // keeping only its preview in the swapping buffer for review
+        if packet_type.is_init() {
+            let payload = buffer.payload().map_err(|_| Error::WrongLength)?;
+            return Self::init(ctx, payload);
+        }
+
+        let zbuffer = ctx.buffer.acquire(Self)?;
+        let stream = ctx
+            .msg_stream
+            .acquire(Self)?
+            .as_mut()
+            .ok_or(Error::ApduCodeConditionsNotSatisfied)?;
+
+        if let Ok(payload) = buffer.payload() {
+            stream.feed(zbuffer, payload)?;
+        }
+
+        if packet_type.is_last() {
+            if !stream.is_complete() {
+                return Err(Error::DataInvalid);
+            }
+
+            let digest = stream.finalize()?;
+            *tx = Self::start_sign(zbuffer.read_exact(), digest, flags)?;
         }
 
         Ok(())
@@ -107,44 +137,62 @@ impl Viewable for SignUI {
 
     fn accept(&mut self, _out: &mut [u8]) -> (usize, u16) {
         let tx = 0;
+        let ctx = unsafe { AppContext::current() };
+
+        // the message was reviewed already
+        cleanup_upload(ctx);
 
         // In this step the msg has not been signed
         // so store the hash for the next steps
-        unsafe {
-            HASH.lock(Sign).replace(self.hash);
+        ctx.hash.lock(Sign).replace(self.hash);
 
-            // next step requires SignHash handler to have
-            // access to the path and hash resources that this handler just updated
-            PATH.lock(SignHash);
-            HASH.lock(SignHash);
-        }
+        // next step requires SignHash handler to have
+        // access to the path and hash resources that this handler just updated
+        ctx.path.lock(SignHash);
+        ctx.hash.lock(SignHash);
 
         (tx, Error::Success as _)
     }
 
     fn reject(&mut self, _: &mut [u8]) -> (usize, u16) {
-        let _ = cleanup_globals();
+        let _ = cleanup_globals(unsafe { AppContext::current() });
         (0, Error::CommandNotAllowed as _)
     }
 }
 
-fn cleanup_globals() -> Result<(), Error> {
-    unsafe {
-        if let Ok(path) = PATH.acquire(Sign) {
-            path.take();
+fn cleanup_globals(ctx: &mut AppContext) -> Result<(), Error> {
+    if let Ok(path) = ctx.path.acquire(Sign) {
+        path.take();
 
-            //let's release the lock for the future
-            let _ = PATH.release(Sign);
-        }
+        //let's release the lock for the future
+        let _ = ctx.path.release(Sign);
+    }
 
-        if let Ok(hash) = HASH.acquire(Sign) {
-            hash.take();
+    if let Ok(hash) = ctx.hash.acquire(Sign) {
+        hash.take();
 
-            //let's release the lock for the future
-            let _ = HASH.release(Sign);
-        }
+        //let's release the lock for the future
+        let _ = ctx.hash.release(Sign);
     }
+
+    cleanup_upload(ctx);
     //if we failed to aquire then someone else is using it anyways
 
     Ok(())
 }
+
+fn cleanup_upload(ctx: &mut AppContext) {
+    if let Ok(buffer) = ctx.buffer.acquire(Sign) {
+        buffer.reset();
+
+        //let's release the lock for the future
+        let _ = ctx.buffer.release(Sign);
+    }
+
+    if let Ok(stream) = ctx.msg_stream.acquire(Sign) {
+        stream.take();
+
+        //let's release the lock for the future
+        let _ = ctx.msg_stream.release(Sign);
+    }
+}
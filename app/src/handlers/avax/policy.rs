@@ -0,0 +1,162 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use bolos::{lazy_static, new_nvm, nvm::NVM, pic_str, PIC};
+use zemu_sys::{Show, ViewError, Viewable};
+
+use crate::{
+    constants::ApduError as Error,
+    dispatcher::ApduHandler,
+    handlers::{handle_ui_message, resources::AppContext},
+    parser::{DisplayableItem, Policy},
+    sys,
+    utils::{
+        trace::{self, TraceId},
+        ApduBufferRead, Uploader,
+    },
+};
+
+// length prefix plus the largest policy
+const POLICY_NVM_LEN: usize = 512;
+const POLICY_LEN_SIZE: usize = 2;
+
+// stored as: policy.len() as 2-bytes big-endian integer | policy,
+// with a length of 0 meaning there's no policy
+#[lazy_static]
+static mut POLICY: NVM<POLICY_NVM_LEN> = new_nvm!(POLICY_NVM_LEN);
+
+/// Returns the policy approved on the device, if any
+pub fn stored_policy() -> Option<Policy<'static>> {
+    let data = unsafe { POLICY.read() };
+
+    let len = u16::from_be_bytes([data[0], data[1]]) as usize;
+    if len == 0 {
+        return None;
+    }
+
+    let policy = data.get(POLICY_LEN_SIZE..POLICY_LEN_SIZE + len)?;
+    Policy::new(policy).ok()
+}
+
+pub struct SetPolicy;
+
+impl SetPolicy {
+    #[inline(never)]
+    fn start_review(data: &'static [u8], flags: &mut u32) -> Result<u32, Error> {
+        if data.len() + POLICY_LEN_SIZE > POLICY_NVM_LEN {
+            return Err(Error::WrongLength);
+        }
+
+        // an empty policy clears the stored one
+        let policy = if data.is_empty() {
+            None
+        } else {
+            Some(Policy::new(data).map_err(|_| Error::DataInvalid)?)
+        };
+
+        let ui = PolicyUI { data, policy };
+
+        crate::show_ui!(ui.show(flags))
+    }
+}
+
+impl ApduHandler for SetPolicy {
+    #[inline(never)]
+    fn handle(
+        ctx: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
+        sys::zemu_log_stack("AvaxSetPolicy::handle\x00");
+
+        *tx = 0;
+
+        // the init packet carries no data,
+        // the policy follows in the next ones
+        if let Some(upload) = Uploader::new(Self).upload(ctx, &buffer)? {
+            *tx = Self::start_review(upload.data, flags)?;
+        } else {
+            *tx = Uploader::ack(ctx, buffer.p1(), buffer.write()) as _;
+        }
+
+        Ok(())
+    }
+}
+
+pub(crate) struct PolicyUI {
+    data: &'static [u8],
+    // None to clear the stored policy
+    policy: Option<Policy<'static>>,
+}
+
+impl Viewable for PolicyUI {
+    fn num_items(&mut self) -> Result<u8, ViewError> {
+        match self.policy {
+            Some(ref policy) => policy.num_items(),
+            None => Ok(1),
+        }
+    }
+
+    #[inline(never)]
+    fn render_item(
+        &mut self,
+        item_n: u8,
+        title: &mut [u8],
+        message: &mut [u8],
+        page: u8,
+    ) -> Result<u8, ViewError> {
+        if let Some(ref policy) = self.policy {
+            return policy.render_item(item_n, title, message, page);
+        }
+
+        if item_n != 0 {
+            return Err(ViewError::NoData);
+        }
+
+        let label = pic_str!(b"Auto-sign");
+        title[..label.len()].copy_from_slice(label);
+
+        let content = pic_str!(b"Disable"!);
+        handle_ui_message(&content[..], message, page)
+    }
+
+    fn accept(&mut self, _: &mut [u8]) -> (usize, u16) {
+        let len = (self.data.len() as u16).to_be_bytes();
+        let _span = trace::span(TraceId::NvmWrite);
+
+        // the length is cleared first so an interrupted
+        // update doesn't leave a different policy behind,
+        // which is all there's to do to clear it
+        let res = unsafe {
+            match self.policy {
+                Some(_) => POLICY
+                    .write(0, &[0; POLICY_LEN_SIZE])
+                    .and_then(|_| POLICY.write(POLICY_LEN_SIZE, self.data))
+                    .and_then(|_| POLICY.write(0, &len)),
+                None => POLICY.write(0, &[0; POLICY_LEN_SIZE]),
+            }
+        };
+
+        match res {
+            Ok(_) => (0, Error::Success as _),
+            Err(_) => (0, Error::ExecutionError as _),
+        }
+    }
+
+    fn reject(&mut self, _: &mut [u8]) -> (usize, u16) {
+        (0, Error::CommandNotAllowed as _)
+    }
+}
@@ -27,10 +27,7 @@ use crate::{
     },
     crypto::{Curve, ECCInfoFlags},
     dispatcher::ApduHandler,
-    handlers::{
-        handle_ui_message,
-        resources::{HASH, PATH},
-    },
+    handlers::{handle_ui_message, resources::AppContext},
     parser::{FromBytes, PathWrapper},
     sys,
     utils::{convert_der_to_rs, ApduBufferRead},
@@ -43,15 +40,20 @@ impl Sign {
     // sha256 is used
     pub const SIGN_HASH_SIZE: usize = Sha256::DIGEST_LEN;
 
-    fn get_derivation_info() -> Result<&'static BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
-        match unsafe { PATH.acquire(Self) } {
+    /// Length of the signatures returned, as R, S and V
+    pub const SIGNATURE_LEN: usize = 65;
+
+    fn get_derivation_info(
+        ctx: &mut AppContext,
+    ) -> Result<&BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
+        match ctx.path.acquire(Self) {
             Ok(Some(some)) => Ok(some),
             _ => Err(Error::ApduCodeConditionsNotSatisfied),
         }
     }
 
-    fn get_hash() -> Result<&'static [u8; Self::SIGN_HASH_SIZE], Error> {
-        match unsafe { HASH.acquire(Self) } {
+    fn get_hash(ctx: &mut AppContext) -> Result<&[u8; Self::SIGN_HASH_SIZE], Error> {
+        match ctx.hash.acquire(Self) {
             Ok(Some(some)) => Ok(some),
             _ => Err(Error::ApduCodeConditionsNotSatisfied),
         }
@@ -73,8 +75,39 @@ impl Sign {
         Ok((flags, sz, out))
     }
 
+    /// Signs `hash` with the key at `path`,
+    /// returning the signature as R, S and V
+    #[inline(never)]
+    pub fn sign_rsv(
+        path: &BIP32Path<MAX_BIP32_PATH_DEPTH>,
+        hash: &[u8],
+    ) -> Result<[u8; Self::SIGNATURE_LEN], Error> {
+        let (flags, sig_size, mut sig) = Self::sign(path, hash)?;
+        let mut out = [0; Self::SIGNATURE_LEN];
+
+        //set to 0x30 for the DER conversion
+        sig[0] = 0x30;
+
+        let mut r = [0; 33];
+        let mut s = [0; 33];
+        convert_der_to_rs(&sig[..sig_size], &mut r, &mut s).map_err(|_| Error::ExecutionError)?;
+
+        //format R and S by only having 32 bytes each,
+        // skipping the first byte if necessary
+        // if we have less than 32 bytes we just have 0s at the start
+        // this is consistent with the fact that in `convert_der_to_rs`
+        // we put the bytes at the end of the buffer first
+        out[..32].copy_from_slice(&r[1..]);
+        out[32..64].copy_from_slice(&s[1..]);
+
+        //write V, which is the oddity of the signature
+        out[64] = flags.contains(ECCInfo::ParityOdd) as u8;
+
+        Ok(out)
+    }
+
     #[inline(never)]
-    pub fn start_sign(data: &[u8], flags: &mut u32) -> Result<usize, Error> {
+    pub fn start_sign(ctx: &mut AppContext, data: &[u8], flags: &mut u32) -> Result<usize, Error> {
         // the data contains root_path + 32-byte hash
         let mut path = MaybeUninit::uninit();
         let rem = PathWrapper::from_bytes_into(data, &mut path).map_err(|_| Error::Unknown)?;
@@ -84,9 +117,7 @@ impl Sign {
             return Err(Error::WrongLength);
         }
 
-        unsafe {
-            PATH.lock(Self).replace(root_path);
-        }
+        ctx.path.lock(Self).replace(root_path);
 
         if rem.len() != Self::SIGN_HASH_SIZE {
             return Err(Error::WrongLength);
@@ -102,9 +133,12 @@ impl Sign {
         crate::show_ui!(ui.show(flags))
     }
 
-    fn get_signing_info(data: &[u8]) -> Result<BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
+    fn get_signing_info(
+        ctx: &mut AppContext,
+        data: &[u8],
+    ) -> Result<BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
         //We expect a path prefix of the form x'/x'/x'
-        let path_prefix = Self::get_derivation_info()?;
+        let path_prefix = Self::get_derivation_info(ctx)?;
         if path_prefix.components().len() != BIP32_PATH_PREFIX_DEPTH {
             return Err(Error::WrongLength);
         }
@@ -168,26 +202,31 @@ impl Viewable for SignUI {
 
         // In this step the msg has not been signed
         // so store the hash for the next steps
-        unsafe {
-            HASH.lock(Sign).replace(self.hash);
-        }
+        unsafe { AppContext::current() }
+            .hash
+            .lock(Sign)
+            .replace(self.hash);
 
         (tx, Error::Success as _)
     }
 
     fn reject(&mut self, _: &mut [u8]) -> (usize, u16) {
-        let _ = cleanup_globals();
+        let _ = cleanup_globals(unsafe { AppContext::current() });
         (0, Error::CommandNotAllowed as _)
     }
 }
 
 impl ApduHandler for Sign {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        ctx: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("SignHash::handle\x00");
 
         *tx = 0;
-        let mut offset = 0;
 
         let p1 = buffer.p1();
         let cdata = buffer.payload().map_err(|_| Error::DataInvalid)?;
@@ -197,53 +236,21 @@ impl ApduHandler for Sign {
         // either for signing transactions, messages or a hash all of them,
         // previously reviewed.
         if p1 == FIRST_MESSAGE {
-            return Self::start_sign(cdata, flags).map(|_| ());
+            return Self::start_sign(ctx, cdata, flags).map(|_| ());
         }
 
         // retrieve signing info
-        let path_prefix = Sign::get_signing_info(cdata)?;
-        let hash = Self::get_hash()?;
+        let path = Sign::get_signing_info(ctx, cdata)?;
+        let hash = *Self::get_hash(ctx)?;
 
-        let (flags, sig_size, mut sig) = Sign::sign(&path_prefix, hash)?;
-        let out = buffer.write();
+        let sig = Self::sign_rsv(&path, &hash)?;
 
-        //write signature as RSV
-        //write V, which is the oddity of the signature
-        let v = flags.contains(ECCInfo::ParityOdd) as u8;
-
-        //set to 0x30 for the DER conversion
-        sig[0] = 0x30;
-        {
-            let mut r = [0; 33];
-            let mut s = [0; 33];
-
-            //write as R S (V written earlier)
-            // this will write directly to buffer
-            match convert_der_to_rs(&sig[..sig_size], &mut r, &mut s) {
-                Ok((_, _)) => {
-                    //format R and S by only having 32 bytes each,
-                    // skipping the first byte if necessary
-                    // if we have less than 32 bytes we just have 0s at the start
-                    // this is consistent with the fact that in `convert_der_to_rs`
-                    // we put the bytes at the end of the buffer first
-                    let r = &r[1..];
-                    let s = &s[1..];
-
-                    out[offset..][..32].copy_from_slice(r);
-                    offset += 32;
-
-                    out[offset..][..32].copy_from_slice(s);
-                    offset += 32;
-                }
-                Err(_) => return Err(Error::ExecutionError as _),
-            }
-        }
-        // write V at the end
-        out[offset] = v;
-        offset += 1;
+        let out = buffer.write();
+        out[..Self::SIGNATURE_LEN].copy_from_slice(&sig);
+        let offset = Self::SIGNATURE_LEN;
 
         if p1 == LAST_MESSAGE {
-            let _ = cleanup_globals();
+            let _ = cleanup_globals(ctx);
         }
 
         *tx = offset as _;
@@ -251,21 +258,21 @@ impl ApduHandler for Sign {
     }
 }
 
-fn cleanup_globals() -> Result<(), Error> {
-    unsafe {
-        if let Ok(path) = PATH.acquire(Sign) {
-            path.take();
+fn cleanup_globals(ctx: &mut AppContext) -> Result<(), Error> {
+    ctx.idle.reset();
 
-            //let's release the lock for the future
-            let _ = PATH.release(Sign);
-        }
+    if let Ok(path) = ctx.path.acquire(Sign) {
+        path.take();
 
-        if let Ok(hash) = HASH.acquire(Sign) {
-            hash.take();
+        //let's release the lock for the future
+        let _ = ctx.path.release(Sign);
+    }
 
-            //let's release the lock for the future
-            let _ = HASH.release(Sign);
-        }
+    if let Ok(hash) = ctx.hash.acquire(Sign) {
+        hash.take();
+
+        //let's release the lock for the future
+        let _ = ctx.hash.release(Sign);
     }
     //if we failed to aquire then someone else is using it anyways
 
@@ -13,7 +13,7 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use core::mem::MaybeUninit;
+use core::{convert::TryFrom, mem::MaybeUninit};
 use nom::number::complete::be_u8;
 
 use bolos::{
@@ -29,11 +29,16 @@ use crate::{
     dispatcher::ApduHandler,
     handlers::{
         avax::sign_hash::Sign as SignHash,
-        resources::{HASH, PATH},
+        idle::{read_suffix, PathSuffix},
+        resources::AppContext,
+        ZPacketType,
     },
     parser::{DisplayableItem, ObjectList, ParserError, PathWrapper, Transaction},
     sys,
-    utils::{ApduBufferRead, Uploader},
+    utils::{
+        trace::{self, TraceId},
+        ApduBufferRead, Uploader, COMPRESSED_PAYLOAD, SEQUENCED_PAYLOAD,
+    },
 };
 
 pub struct Sign;
@@ -43,8 +48,10 @@ impl Sign {
     // sha256 is used
     pub const SIGN_HASH_SIZE: usize = Sha256::DIGEST_LEN;
 
-    fn get_derivation_info() -> Result<&'static BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
-        match unsafe { PATH.acquire(Self) } {
+    fn get_derivation_info(
+        ctx: &mut AppContext,
+    ) -> Result<&BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
+        match ctx.path.acquire(Self) {
             Ok(Some(some)) => Ok(some),
             _ => Err(Error::ApduCodeConditionsNotSatisfied),
         }
@@ -52,6 +59,7 @@ impl Sign {
 
     #[inline(never)]
     fn sha256_digest(buffer: &[u8]) -> Result<[u8; Self::SIGN_HASH_SIZE], Error> {
+        let _span = trace::span(TraceId::Hash);
         Sha256::digest(buffer).map_err(|_| Error::ExecutionError)
     }
 
@@ -78,11 +86,12 @@ impl Sign {
     }
 
     fn disable_outputs(
+        ctx: &mut AppContext,
         list: &mut ObjectList<PathWrapper<BIP32_PATH_SUFFIX_DEPTH>>,
         tx: &mut Transaction,
     ) -> Result<(), Error> {
         // get root path
-        let path_root = Self::get_derivation_info()?;
+        let path_root = *Self::get_derivation_info(ctx)?;
 
         //We expect a path prefix of the form x'/x'/x'
         if path_root.components().len() != BIP32_PATH_PREFIX_DEPTH {
@@ -102,28 +111,92 @@ impl Sign {
                 return Err(Error::WrongLength);
             }
 
-            let path_iter = path_root
-                .components()
-                .iter()
-                .chain(suffix.components())
-                .copied();
+            // the key might have been derived during the upload already
+            let cached = PathSuffix::try_from(suffix.components())
+                .ok()
+                .and_then(|suffix| ctx.idle.keyhash(&suffix));
+
+            if let Some(keyhash) = cached {
+                address = *keyhash;
+            } else {
+                let path_iter = path_root
+                    .components()
+                    .iter()
+                    .chain(suffix.components())
+                    .copied();
 
-            let full_path: BIP32Path<MAX_BIP32_PATH_DEPTH> =
-                BIP32Path::new(path_iter).map_err(|_| Error::DataInvalid)?;
+                let full_path: BIP32Path<MAX_BIP32_PATH_DEPTH> =
+                    BIP32Path::new(path_iter).map_err(|_| Error::DataInvalid)?;
 
-            Self::compute_keyhash(&full_path, &mut address)?;
+                Self::compute_keyhash(&full_path, &mut address)?;
+            }
 
             tx.disable_output_if(&address[..]);
         }
         Ok(())
     }
 
+    /// Queues the work that can be done while the rest
+    /// of the transaction is uploaded
+    ///
+    /// The init packet carries the root path,
+    /// while the change paths lead the data, see `docs/APDUSPEC.md`
+    #[inline(never)]
+    fn queue_idle_work(ctx: &mut AppContext, buffer: &ApduBufferRead<'_>) -> Result<(), Error> {
+        let packet_type = ZPacketType::new(buffer.p1() & !(COMPRESSED_PAYLOAD | SEQUENCED_PAYLOAD))
+            .map_err(|_| Error::InvalidP1P2)?;
+
+        if packet_type.is_init() {
+            let payload = buffer.payload().map_err(|_| Error::DataInvalid)?;
+            let root_path = BIP32Path::read(payload).map_err(|_| Error::DataInvalid)?;
+
+            ctx.idle.start(root_path);
+        } else if packet_type.is_next() {
+            Self::queue_change_paths(ctx);
+        }
+
+        Ok(())
+    }
+
+    // change paths are read back from the buffer as they arrive
+    fn queue_change_paths(ctx: &mut AppContext) {
+        const PATH_LEN: usize = 1 + BIP32_PATH_SUFFIX_DEPTH * core::mem::size_of::<u32>();
+
+        let start = 1 + ctx.upload_init_len;
+        let buffer = match ctx.buffer.acquire(Self) {
+            Ok(buffer) => buffer,
+            Err(_) => return,
+        };
+
+        let mut num_paths = [0];
+        if buffer.read_back(start, &mut num_paths).is_none() {
+            return;
+        }
+
+        let mut path = [0; PATH_LEN];
+        for i in 0..num_paths[0] as usize {
+            if buffer
+                .read_back(start + 1 + i * PATH_LEN, &mut path)
+                .is_none()
+            {
+                break;
+            }
+
+            if let Ok((suffix, _)) = read_suffix(&path) {
+                ctx.idle.queue_keyhash(suffix);
+            }
+        }
+    }
+
     #[inline(never)]
     pub fn start_sign(
+        ctx: &mut AppContext,
         init_data: &[u8],
         data: &'static [u8],
         flags: &mut u32,
     ) -> Result<u32, Error> {
+        let _span = trace::span(TraceId::StartSign);
+
         // read root path and store it in ram as during the
         // signing process and diseabling outputs we use it
         // to get a full path: root_path + path_suffix
@@ -133,9 +206,7 @@ impl Sign {
             return Err(Error::WrongLength);
         }
 
-        unsafe {
-            PATH.lock(Self).replace(root_path);
-        }
+        ctx.path.lock(Self).replace(root_path);
 
         // then, get the change_path list.
         let mut path_list: MaybeUninit<ObjectList<PathWrapper<BIP32_PATH_SUFFIX_DEPTH>>> =
@@ -143,20 +214,46 @@ impl Sign {
         let (rem, num_paths) = be_u8::<_, ParserError>(data).map_err(|_| Error::ExecutionError)?;
         let rem = ObjectList::new_into_with_len(rem, &mut path_list, num_paths as _)
             .map_err(|_| Error::DataInvalid)?;
-        let mut path_list = unsafe { path_list.assume_init() };
+        let path_list = unsafe { path_list.assume_init() };
 
         let unsigned_hash = Self::sha256_digest(rem)?;
 
         // parse transaction
         let mut tx = MaybeUninit::uninit();
         Transaction::new_into(rem, &mut tx).map_err(|_| Error::DataInvalid)?;
-        let mut transaction = unsafe { tx.assume_init() };
+        let transaction = unsafe { tx.assume_init() };
 
-        Self::disable_outputs(&mut path_list, &mut transaction)?;
+        // the keys of the change paths not derived during the upload
+        // are derived while the first screen is shown
+        let mut suffixes = true;
+        path_list.iterate_with(|path| {
+            //We expect a path suffix of the form x/x
+            match PathSuffix::try_from(path.path().components()) {
+                Ok(suffix) => ctx.idle.queue_keyhash(suffix),
+                Err(_) => suffixes = false,
+            }
+        });
+        if !suffixes {
+            return Err(Error::WrongLength);
+        }
 
         let ui = SignUI {
             hash: unsigned_hash,
             transaction,
+            change_paths: Some(path_list),
+            shown_first: false,
+        };
+
+        // transactions within the policy approved by the user
+        // are not reviewed again
+        #[cfg(feature = "policy")]
+        let ui = {
+            let mut ui = ui;
+            if ui.allowed_by_policy()? {
+                store_approved_hash(ctx, unsigned_hash);
+                return Ok(0);
+            }
+            ui
         };
 
         crate::show_ui!(ui.show(flags))
@@ -165,13 +262,21 @@ impl Sign {
 
 impl ApduHandler for Sign {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        ctx: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("AvaxSign::handle\x00");
 
         *tx = 0;
 
-        if let Some(upload) = Uploader::new(Self).upload(&buffer)? {
-            *tx = Self::start_sign(upload.first, upload.data, flags)?;
+        if let Some(upload) = Uploader::new(Self).upload(ctx, &buffer)? {
+            *tx = Self::start_sign(ctx, upload.first, upload.data, flags)?;
+        } else {
+            Self::queue_idle_work(ctx, &buffer)?;
+            *tx = Uploader::ack(ctx, buffer.p1(), buffer.write()) as _;
         }
 
         Ok(())
@@ -181,10 +286,54 @@ impl ApduHandler for Sign {
 pub(crate) struct SignUI {
     hash: [u8; Sign::SIGN_HASH_SIZE],
     transaction: Transaction<'static>,
+    /// Change paths whose outputs are yet to be disabled
+    change_paths: Option<ObjectList<'static, PathWrapper<BIP32_PATH_SUFFIX_DEPTH>>>,
+    /// Whether the first screen, the type of the transaction, was rendered
+    shown_first: bool,
+}
+
+impl SignUI {
+    /// Disables the change outputs, if not done yet
+    ///
+    /// The first screen doesn't depend on the outputs, so this is left until
+    /// the user moves away from it, using the keys derived between ticker
+    /// events meanwhile. Every other screen, and the number of them, depends
+    /// on which outputs are shown, so this must be done before any of them.
+    #[inline(never)]
+    fn match_change_outputs(&mut self) -> Result<(), ViewError> {
+        if let Some(mut change_paths) = self.change_paths.take() {
+            let ctx = unsafe { AppContext::current() };
+            Sign::disable_outputs(ctx, &mut change_paths, &mut self.transaction)
+                .map_err(|_| ViewError::Unknown)?;
+        }
+
+        Ok(())
+    }
+
+    /// Whether the transaction is within the policy approved by the user,
+    /// which applies to the outputs that aren't change
+    #[cfg(feature = "policy")]
+    fn allowed_by_policy(&mut self) -> Result<bool, Error> {
+        let policy = match super::policy::stored_policy() {
+            Some(policy) => policy,
+            None => return Ok(false),
+        };
+
+        self.match_change_outputs()
+            .map_err(|_| Error::ExecutionError)?;
+
+        Ok(policy.allows(&self.transaction))
+    }
 }
 
 impl Viewable for SignUI {
     fn num_items(&mut self) -> Result<u8, ViewError> {
+        // asked before rendering any screen, and only an upper bound
+        // of the number of items until the first screen was shown
+        if self.shown_first {
+            self.match_change_outputs()?;
+        }
+
         self.transaction.num_items()
     }
 
@@ -196,22 +345,21 @@ impl Viewable for SignUI {
         message: &mut [u8],
         page: u8,
     ) -> Result<u8, ViewError> {
+        let _span = trace::span_with(TraceId::Render, item_n as _);
+
+        if item_n == 0 {
+            self.shown_first = true;
+        } else {
+            self.match_change_outputs()?;
+        }
+
         self.transaction.render_item(item_n, title, message, page)
     }
 
     fn accept(&mut self, _out: &mut [u8]) -> (usize, u16) {
         let tx = 0;
 
-        // In this step the transaction has not been signed
-        // so store the hash for the next steps
-        unsafe {
-            HASH.lock(Sign).replace(self.hash);
-
-            // next step requires SignHash handler to have
-            // access to the path and hash resources that this handler just updated
-            PATH.lock(SignHash);
-            HASH.lock(SignHash);
-        }
+        store_approved_hash(unsafe { AppContext::current() }, self.hash);
 
         (tx, Error::Success as _)
     }
@@ -222,16 +370,82 @@ impl Viewable for SignUI {
     }
 }
 
+fn store_approved_hash(ctx: &mut AppContext, hash: [u8; Sign::SIGN_HASH_SIZE]) {
+    // In this step the transaction has not been signed
+    // so store the hash for the next steps
+    ctx.hash.lock(Sign).replace(hash);
+
+    // next step requires SignHash handler to have
+    // access to the path and hash resources that this handler just updated
+    ctx.path.lock(SignHash);
+    ctx.hash.lock(SignHash);
+}
+
 fn cleanup_globals() -> Result<(), Error> {
-    unsafe {
-        if let Ok(path) = PATH.acquire(Sign) {
-            path.take();
+    let ctx = unsafe { AppContext::current() };
+    ctx.idle.reset();
 
-            //let's release the lock for the future
-            let _ = PATH.release(Sign);
-        }
+    let path = &mut ctx.path;
+
+    if let Ok(inner) = path.acquire(Sign) {
+        inner.take();
+
+        //let's release the lock for the future
+        let _ = path.release(Sign);
     }
     //if we failed to aquire then someone else is using it anyways
 
     Ok(())
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::prelude::v1::*;
+
+    const ROOT: [u32; 3] = [0x8000_002c, 0x8000_2328, 0x8000_0000];
+
+    // a transfer with two outputs, see `parser::transactions`
+    const DATA: &str = "00000000000000000005ab68eb1ee142a05cfe768c36e11f0b596db5a3c6c77aabe665dad9e638ca94f7000000023d9bdac0ed1d761330cf680efdeb1a42159eb387d6d2950c96f7d28f61bbe2aa00000007000000003b9aca0000000000000000000000000100000001636fb961b8bce4d0038796f5db330fecc8e36f723d9bdac0ed1d761330cf680efdeb1a42159eb387d6d2950c96f7d28f61bbe2aa0000000700000000f44284800000000000000000000000010000000107fe53d8ed2b004df3ac75175a4e727a6dd461d8000000023be4ead93aa5e6396d1f2c6e9587c7642b30d52d605f917d8a402e6823f965f2000000003d9bdac0ed1d761330cf680efdeb1a42159eb387d6d2950c96f7d28f61bbe2aa000000050000000005e69ec0000000010000000095aff4ba72647c2a6a41802c047a9f3a3919b35aefcf7da843d4cc34980c7102000000003d9bdac0ed1d761330cf680efdeb1a42159eb387d6d2950c96f7d28f61bbe2aa00000005000000012a05f200000000010000000000000000";
+    const OUTPUT_ADDRESS: &str = "07fe53d8ed2b004df3ac75175a4e727a6dd461d8";
+
+    #[test]
+    fn change_outputs_matched_after_first_screen() {
+        let root = BIP32Path::new(ROOT.iter().copied()).unwrap();
+        let change = BIP32Path::new(ROOT.iter().chain([1, 0].iter()).copied()).unwrap();
+        let mut keyhash = [0; Ripemd160::DIGEST_LEN];
+        Sign::compute_keyhash(&change, &mut keyhash).unwrap();
+
+        // the second output goes to the change path 1/0
+        let data = hex::decode(DATA.replace(OUTPUT_ADDRESS, &hex::encode(keyhash))).unwrap();
+        let transaction = Transaction::new(Box::leak(data.into_boxed_slice())).unwrap();
+
+        let mut change_paths = MaybeUninit::uninit();
+        ObjectList::new_into_with_len(&[2, 0, 0, 0, 1, 0, 0, 0, 0], &mut change_paths, 1).unwrap();
+
+        let ctx = unsafe { AppContext::current() };
+        ctx.path.lock(Sign).replace(root);
+
+        let mut ui = SignUI {
+            hash: [0; Sign::SIGN_HASH_SIZE],
+            transaction,
+            change_paths: Some(unsafe { change_paths.assume_init() }),
+            shown_first: false,
+        };
+        let (mut title, mut message) = ([0; 100], [0; 100]);
+
+        // the first screen is shown before matching
+        let all_items = ui.num_items().unwrap();
+        ui.render_item(0, &mut title, &mut message, 0).unwrap();
+        assert!(ui.change_paths.is_some());
+
+        // which is done before moving to any other
+        assert!(ui.num_items().unwrap() < all_items);
+        assert!(ui.change_paths.is_none());
+
+        // and only once
+        let items = ui.num_items().unwrap();
+        ui.render_item(1, &mut title, &mut message, 0).unwrap();
+        assert_eq!(ui.num_items().unwrap(), items);
+    }
+}
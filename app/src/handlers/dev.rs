@@ -15,3 +15,6 @@
 ********************************************************************************/
 mod debug;
 pub use debug::Debug;
+
+mod flash_stats;
+pub use flash_stats::GetFlashStats;
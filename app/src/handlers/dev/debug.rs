@@ -18,7 +18,7 @@ use std::prelude::v1::*;
 use crate::{
     constants::ApduError as Error,
     dispatcher::ApduHandler,
-    handlers::{handle_ui_message, resources::BUFFER},
+    handlers::{handle_ui_message, resources::AppContext},
     sys::{Show, ViewError, Viewable, PIC},
     utils::ApduBufferRead,
 };
@@ -29,6 +29,7 @@ pub struct Debug;
 impl ApduHandler for Debug {
     #[inline(never)]
     fn handle<'apdu>(
+        ctx: &mut AppContext,
         flags: &mut u32,
         tx: &mut u32,
         apdu: ApduBufferRead<'apdu>,
@@ -37,7 +38,7 @@ impl ApduHandler for Debug {
 
         let payload = apdu.payload().map_err(|_| Error::DataInvalid)?;
 
-        let zbuffer = unsafe { BUFFER.lock(Self) };
+        let zbuffer = ctx.buffer.lock(Self);
         zbuffer
             .write(&[
                 apdu.cla(),
@@ -59,20 +60,23 @@ impl ApduHandler for Debug {
 
 impl Debug {
     fn cleanup(&mut self) {
-        unsafe {
-            if let Ok(zbuffer) = BUFFER.acquire(Self) {
-                zbuffer.reset();
+        let buffer = unsafe { &mut AppContext::current().buffer };
 
-                //we managed to acquire so we should release too
-                let _ = BUFFER.release(Self);
-            }
+        if let Ok(zbuffer) = buffer.acquire(Self) {
+            zbuffer.reset();
 
-            //couldn't acquire BUFFER so someone is trying to use it
+            //we managed to acquire so we should release too
+            let _ = buffer.release(Self);
         }
+
+        //couldn't acquire BUFFER so someone is trying to use it
     }
 
     fn get_buf() -> Result<&'static [u8], Error> {
-        let zbuffer = unsafe { BUFFER.acquire(Self).map_err(|_| Error::ExecutionError)? };
+        let zbuffer = unsafe { AppContext::current() }
+            .buffer
+            .acquire(Self)
+            .map_err(|_| Error::ExecutionError)?;
         Ok(zbuffer.read_exact())
     }
 }
@@ -0,0 +1,46 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use crate::{
+    constants::ApduError as Error,
+    dispatcher::ApduHandler,
+    handlers::resources::AppContext,
+    utils::{ApduBufferRead, FlashStats},
+};
+
+/// Reports how many bytes the upload buffer wrote to flash since the app started
+pub struct GetFlashStats;
+
+impl ApduHandler for GetFlashStats {
+    #[inline(never)]
+    fn handle(
+        ctx: &mut AppContext,
+        _: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
+        *tx = 0;
+
+        // an upload could be in progress, so the buffer is left locked
+        let FlashStats { bytes, writes } = ctx.buffer.peek().flash_stats();
+
+        let out = buffer.write();
+        out[..4].copy_from_slice(&bytes.to_be_bytes());
+        out[4..8].copy_from_slice(&writes.to_be_bytes());
+        *tx = 8;
+
+        Ok(())
+    }
+}
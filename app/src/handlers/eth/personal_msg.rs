@@ -17,20 +17,19 @@ use core::mem::MaybeUninit;
 
 use bolos::{
     crypto::{bip32::BIP32Path, ecfp256::ECCInfo},
-    hash::{Hasher, Keccak},
+    hash::Keccak,
     pic_str, PIC,
 };
-use nom::number::complete::be_u32;
 use zemu_sys::{Show, ViewError, Viewable};
 
 use crate::{
     constants::{ApduError as Error, MAX_BIP32_PATH_DEPTH},
     crypto::{Curve, ECCInfoFlags},
     dispatcher::ApduHandler,
-    handlers::resources::{BUFFER, PATH},
-    parser::{DisplayableItem, FromBytes, ParserError, PersonalMsg},
+    handlers::resources::AppContext,
+    parser::{DisplayableItem, PersonalMsg},
     sys,
-    utils::ApduBufferRead,
+    utils::{ApduBufferRead, MsgStream},
 };
 
 use super::utils::parse_bip32_eth;
@@ -41,8 +40,10 @@ pub struct Sign;
 impl Sign {
     pub const SIGN_HASH_SIZE: usize = Keccak::<32>::DIGEST_LEN;
 
-    fn get_derivation_info() -> Result<&'static BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
-        match unsafe { PATH.acquire(Self) } {
+    fn get_derivation_info(
+        ctx: &mut AppContext,
+    ) -> Result<&BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
+        match ctx.path.acquire(Self) {
             Ok(Some(some)) => Ok(some),
             _ => Err(Error::ApduCodeConditionsNotSatisfied),
         }
@@ -65,30 +66,14 @@ impl Sign {
     }
 
     #[inline(never)]
-    fn digest(buffer: &[u8]) -> Result<[u8; Self::SIGN_HASH_SIZE], Error> {
-        let mut hasher = {
-            let mut k = MaybeUninit::uninit();
-            Keccak::<32>::new_gce(&mut k).map_err(|_| Error::Unknown)?;
-
-            //safe: initialized
-            unsafe { k.assume_init() }
-        };
-        // The ethereum app does not expect the "header" as part of the apdu
-        // instruction as it is prepended when hashing, that is why the hw-app-eth
-        // sends only the msg size and the msg itself.
-        let header = pic_str!(b"\x19Ethereum Signed Message:\n"!);
-        hasher.update(&header[..]).map_err(|_| Error::Unknown)?;
-        hasher.update(buffer).map_err(|_| Error::Unknown)?;
-
-        hasher.finalize().map_err(|_| Error::Unknown)
-    }
-
-    #[inline(never)]
-    pub fn start_sign(txdata: &'static [u8], flags: &mut u32) -> Result<u32, Error> {
+    pub fn start_sign(
+        txdata: &'static [u8],
+        unsigned_hash: [u8; Self::SIGN_HASH_SIZE],
+        flags: &mut u32,
+    ) -> Result<u32, Error> {
         let mut tx = MaybeUninit::uninit();
-        _ = PersonalMsg::from_bytes_into(txdata, &mut tx).map_err(|_| Error::DataInvalid)?;
-
-        let unsigned_hash = Self::digest(txdata)?;
+        _ = PersonalMsg::preview_from_bytes_into(txdata, &mut tx)
+            .map_err(|_| Error::DataInvalid)?;
 
         let tx = unsafe { tx.assume_init() };
 
@@ -103,7 +88,12 @@ impl Sign {
 
 impl ApduHandler for Sign {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        ctx: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("EthSignMessage::handle\x00");
 
         *tx = 0;
@@ -114,10 +104,13 @@ impl ApduHandler for Sign {
         // moreover, it does not prepend the ethereum header
         // for personal messages, it just structures the message as:
         // path | msg.len() as 4-bytes big-indian integer | msg
+        //
+        // the message is hashed as it arrives, and only
+        // its preview is kept in the swapping buffer for review
 
         let packet_type = buffer.p1();
 
-        match packet_type {
+        let (zbuffer, stream) = match packet_type {
             //init
             0x00 => {
                 let payload = buffer.payload().map_err(|_| Error::WrongLength)?;
@@ -126,45 +119,47 @@ impl ApduHandler for Sign {
                 let (rest, bip32_path) =
                     parse_bip32_eth(payload).map_err(|_| Error::DataInvalid)?;
 
-                unsafe {
-                    PATH.lock(Self).replace(bip32_path);
-                }
-
-                let (msg, len) = be_u32::<_, ParserError>(rest).map_err(|_| Error::WrongLength)?;
+                ctx.path.lock(Self).replace(bip32_path);
 
-                //write( msg.len and msg) to the swapping buffer so we persist this data
-                let buffer = unsafe { BUFFER.lock(Self) };
-                buffer.reset();
+                let zbuffer = ctx.buffer.lock(Self);
+                zbuffer.reset();
 
-                buffer.write(rest).map_err(|_| Error::ExecutionError)?;
+                // The ethereum app does not expect the "header" as part of the apdu
+                // instruction as it is prepended when hashing, that is why the hw-app-eth
+                // sends only the msg size and the msg itself.
+                let header = pic_str!(b"\x19Ethereum Signed Message:\n"!);
+                let stream = ctx.msg_stream.lock(Self);
+                let stream = stream.insert(MsgStream::new_keccak(&header[..])?);
 
-                if len as usize == msg.len() {
-                    // The message is completed so we can proceed with the signature
-                    *tx = Self::start_sign(buffer.read_exact(), flags)?;
-                }
+                stream.feed(zbuffer, rest)?;
 
-                Ok(())
+                (zbuffer, stream)
             }
             //next
             0x80 => {
                 let payload = buffer.payload().map_err(|_| Error::WrongLength)?;
 
-                let buffer = unsafe { BUFFER.acquire(Self)? };
-
-                buffer.write(payload).map_err(|_| Error::ExecutionError)?;
+                let zbuffer = ctx.buffer.acquire(Self)?;
+                let stream = ctx
+                    .msg_stream
+                    .acquire(Self)?
+                    .as_mut()
+                    .ok_or(Error::ApduCodeConditionsNotSatisfied)?;
 
-                let (msg, len) = be_u32::<_, ParserError>(buffer.read_exact())
-                    .map_err(|_| Error::WrongLength)?;
+                stream.feed(zbuffer, payload)?;
 
-                if msg.len() == len as usize {
-                    //we read all the missing bytes so we can proceed with the signature
-                    *tx = Self::start_sign(buffer.read_exact(), flags)?;
-                }
-
-                Ok(())
+                (zbuffer, stream)
             }
-            _ => Err(Error::InvalidP1P2),
+            _ => return Err(Error::InvalidP1P2),
+        };
+
+        if stream.is_complete() {
+            // The message is completed so we can proceed with the signature
+            let unsigned_hash = stream.finalize()?;
+            *tx = Self::start_sign(zbuffer.read_exact(), unsigned_hash, flags)?;
         }
+
+        Ok(())
     }
 }
 
@@ -190,7 +185,9 @@ impl Viewable for SignUI {
     }
 
     fn accept(&mut self, out: &mut [u8]) -> (usize, u16) {
-        let path = match Sign::get_derivation_info() {
+        let ctx = unsafe { AppContext::current() };
+
+        let path = match Sign::get_derivation_info(ctx) {
             Err(e) => return (0, e as _),
             Ok(k) => k,
         };
@@ -201,7 +198,7 @@ impl Viewable for SignUI {
         };
 
         //reset globals to avoid skipping `Init`
-        if let Err(e) = cleanup_globals() {
+        if let Err(e) = cleanup_globals(ctx) {
             return (0, e as _);
         }
 
@@ -253,26 +250,31 @@ impl Viewable for SignUI {
     }
 
     fn reject(&mut self, _: &mut [u8]) -> (usize, u16) {
-        let _ = cleanup_globals();
+        let _ = cleanup_globals(unsafe { AppContext::current() });
         (0, Error::CommandNotAllowed as _)
     }
 }
 
-fn cleanup_globals() -> Result<(), Error> {
-    unsafe {
-        if let Ok(path) = PATH.acquire(Sign) {
-            path.take();
+fn cleanup_globals(ctx: &mut AppContext) -> Result<(), Error> {
+    if let Ok(path) = ctx.path.acquire(Sign) {
+        path.take();
 
-            //let's release the lock for the future
-            let _ = PATH.release(Sign);
-        }
+        //let's release the lock for the future
+        let _ = ctx.path.release(Sign);
+    }
 
-        if let Ok(buffer) = BUFFER.acquire(Sign) {
-            buffer.reset();
+    if let Ok(buffer) = ctx.buffer.acquire(Sign) {
+        buffer.reset();
 
-            //let's release the lock for the future
-            let _ = BUFFER.release(Sign);
-        }
+        //let's release the lock for the future
+        let _ = ctx.buffer.release(Sign);
+    }
+
+    if let Ok(stream) = ctx.msg_stream.acquire(Sign) {
+        stream.take();
+
+        //let's release the lock for the future
+        let _ = ctx.msg_stream.release(Sign);
     }
 
     //if we failed to aquire then someone else is using it anyways
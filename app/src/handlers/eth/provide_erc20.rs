@@ -13,13 +13,21 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use crate::{constants::ApduError as Error, dispatcher::ApduHandler, sys, utils::ApduBufferRead};
+use crate::{
+    constants::ApduError as Error, dispatcher::ApduHandler, handlers::resources::AppContext, sys,
+    utils::ApduBufferRead,
+};
 
 pub struct ProvideERC20;
 
 impl ApduHandler for ProvideERC20 {
     #[inline(never)]
-    fn handle(_: &mut u32, tx: &mut u32, _: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        _: &mut AppContext,
+        _: &mut u32,
+        tx: &mut u32,
+        _: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("ProvideERC20::handle\x00");
 
         *tx = 0;
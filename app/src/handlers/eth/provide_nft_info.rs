@@ -13,13 +13,16 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use crate::{constants::ApduError as Error, dispatcher::ApduHandler, sys, utils::ApduBufferRead};
+use crate::{
+    constants::ApduError as Error, dispatcher::ApduHandler, handlers::resources::AppContext, sys,
+    utils::ApduBufferRead,
+};
 
 pub struct Info;
 
 #[cfg(feature = "erc721")]
 impl Info {
-    fn process(input: &[u8]) -> Result<(), Error> {
+    fn process(ctx: &mut AppContext, input: &[u8]) -> Result<(), Error> {
         // skip type and version
         let mut nft_info = core::mem::MaybeUninit::uninit();
 
@@ -29,11 +32,7 @@ impl Info {
         let nft_info = unsafe { nft_info.assume_init() };
 
         // store the information use to parse erc721 token
-        unsafe {
-            crate::handlers::resources::NFT_INFO
-                .lock(super::signing::Sign)
-                .replace(nft_info);
-        }
+        ctx.nft_info.lock(super::signing::Sign).replace(nft_info);
 
         Ok(())
     }
@@ -41,14 +40,19 @@ impl Info {
 
 #[cfg(not(feature = "erc721"))]
 impl Info {
-    fn process(_: &[u8]) -> Result<(), Error> {
+    fn process(_: &mut AppContext, _: &[u8]) -> Result<(), Error> {
         Ok(())
     }
 }
 
 impl ApduHandler for Info {
     #[inline(never)]
-    fn handle(_flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        ctx: &mut AppContext,
+        _flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("NftInfoProvider::handle\x00");
 
         *tx = 0;
@@ -58,7 +62,7 @@ impl ApduHandler for Info {
         // less than that
         let payload = buffer.payload().map_err(|_| Error::WrongLength)?;
 
-        Info::process(payload)?;
+        Info::process(ctx, payload)?;
 
         Ok(())
     }
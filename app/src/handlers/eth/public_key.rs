@@ -26,6 +26,7 @@ use crate::{
     constants::{ApduError as Error, MAX_BIP32_PATH_DEPTH},
     crypto,
     dispatcher::ApduHandler,
+    handlers::resources::AppContext,
     sys::{self, Error as SysError},
     utils::ApduBufferRead,
 };
@@ -69,7 +70,12 @@ impl GetPublicKey {
 
 impl ApduHandler for GetPublicKey {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        _: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("GetPublicKey::handle\x00");
 
         *tx = 0;
@@ -13,7 +13,10 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use crate::{constants::ApduError as Error, dispatcher::ApduHandler, sys, utils::ApduBufferRead};
+use crate::{
+    constants::ApduError as Error, dispatcher::ApduHandler, handlers::resources::AppContext, sys,
+    utils::ApduBufferRead,
+};
 
 pub struct SetPlugin;
 
@@ -24,7 +27,12 @@ pub struct SetPlugin;
 // provide_token_info/provide_erc20_info instructions
 impl ApduHandler for SetPlugin {
     #[inline(never)]
-    fn handle(_: &mut u32, tx: &mut u32, _: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        _: &mut AppContext,
+        _: &mut u32,
+        tx: &mut u32,
+        _: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("SetPlugin::handle\x00");
 
         *tx = 0;
@@ -17,7 +17,7 @@ use core::mem::MaybeUninit;
 
 use bolos::{
     crypto::{bip32::BIP32Path, ecfp256::ECCInfo},
-    hash::{Hasher, Keccak},
+    hash::Keccak,
 };
 use zemu_sys::{Show, ViewError, Viewable};
 
@@ -25,23 +25,27 @@ use crate::{
     constants::{ApduError as Error, MAX_BIP32_PATH_DEPTH},
     crypto::{Curve, ECCInfoFlags},
     dispatcher::ApduHandler,
-    handlers::resources::{BUFFER, PATH},
-    parser::{bytes_to_u64, DisplayableItem, EthTransaction, FromBytes, U32_SIZE},
+    handlers::resources::AppContext,
+    parser::{bytes_to_u64, CallDataInfo, DisplayableItem, EthTransaction, U32_SIZE},
     sys,
     utils::ApduBufferRead,
 };
 
-use super::utils::get_tx_rlp_len;
 use super::utils::parse_bip32_eth;
 use crate::utils::convert_der_to_rs;
 
+mod stream;
+pub use stream::{TxStream, CALLDATA_RETAIN_LEN};
+
 pub struct Sign;
 
 impl Sign {
     pub const SIGN_HASH_SIZE: usize = Keccak::<32>::DIGEST_LEN;
 
-    fn get_derivation_info() -> Result<&'static BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
-        match unsafe { PATH.acquire(Self) } {
+    fn get_derivation_info(
+        ctx: &mut AppContext,
+    ) -> Result<&BIP32Path<MAX_BIP32_PATH_DEPTH>, Error> {
+        match ctx.path.acquire(Self) {
             Ok(Some(some)) => Ok(some),
             _ => Err(Error::ApduCodeConditionsNotSatisfied),
         }
@@ -64,42 +68,33 @@ impl Sign {
     }
 
     #[inline(never)]
-    fn digest(to_hash: &[u8]) -> Result<[u8; Self::SIGN_HASH_SIZE], Error> {
-        let mut hasher = {
-            let mut k = MaybeUninit::uninit();
-            Keccak::<32>::new_gce(&mut k).map_err(|_| Error::Unknown)?;
-
-            //safe: initialized
-            unsafe { k.assume_init() }
+    pub fn start_sign(
+        ctx: &mut AppContext,
+        txdata: &'static [u8],
+        flags: &mut u32,
+    ) -> Result<u32, Error> {
+        let stream = match ctx.eth_stream.acquire(Self)? {
+            Some(stream) => stream,
+            None => return Err(Error::ApduCodeConditionsNotSatisfied),
         };
 
-        hasher.update(to_hash).map_err(|_| Error::Unknown)?;
-        hasher.finalize().map_err(|_| Error::Unknown)
-    }
+        // the whole transaction was hashed while received,
+        // including the tx type as required by EIP-2718
+        let unsigned_hash = stream.finalize()?;
+        let tx_type = stream.tx_type();
 
-    #[inline(never)]
-    pub fn start_sign(txdata: &'static [u8], flags: &mut u32) -> Result<u32, Error> {
-        // The ERC721 parser might need access to the NFT_INFO resource
+        // The calldata parser needs to know if the
+        // calldata was cropped during the upload
+        ctx.eth_stream.lock(CallDataInfo);
+
+        // The ERC721 parser might need access to the NFT info resource
         // also during the review part
         #[cfg(feature = "erc721")]
-        unsafe {
-            crate::handlers::resources::NFT_INFO.lock(crate::parser::ERC721Info)
-        };
+        ctx.nft_info.lock(crate::parser::ERC721Info);
 
         // now parse the transaction
         let mut tx = MaybeUninit::uninit();
-        let rem =
-            EthTransaction::from_bytes_into(txdata, &mut tx).map_err(|_| Error::DataInvalid)?;
-
-        // some applications might append data at the end of an encoded
-        // transaction, so skip it to get the right hash.
-        //
-        // this would also include the tx type, as required by EIP-2718
-        // since the tx type is at the start of the data
-        let to_hash = txdata.len() - rem.len();
-        let to_hash = &txdata[..to_hash];
-
-        let unsigned_hash = Self::digest(to_hash)?;
+        EthTransaction::from_body_into(tx_type, txdata, &mut tx).map_err(|_| Error::DataInvalid)?;
         let tx = unsafe { tx.assume_init() };
 
         let ui = SignUI {
@@ -113,7 +108,12 @@ impl Sign {
 
 impl ApduHandler for Sign {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        ctx: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("EthSign::handle\x00");
 
         *tx = 0;
@@ -139,28 +139,23 @@ impl ApduHandler for Sign {
                 let (rest, bip32_path) =
                     parse_bip32_eth(payload).map_err(|_| Error::DataInvalid)?;
 
-                unsafe {
-                    PATH.lock(Self).replace(bip32_path);
-                }
-
-                //parse the length of the RLP message
-                let (read, to_read) = get_tx_rlp_len(rest)?;
-                let len = core::cmp::min((to_read as usize).saturating_add(read), rest.len());
+                ctx.path.lock(Self).replace(bip32_path);
 
-                //write the rest to the swapping buffer so we persist this data
-                let buffer = unsafe { BUFFER.lock(Self) };
+                let buffer = ctx.buffer.lock(Self);
                 buffer.reset();
 
-                buffer
-                    .write(&rest[..len])
-                    .map_err(|_| Error::ExecutionError)?;
+                // the stream reads the length of the RLP message
+                // and then hashes the data as it arrives, only
+                // keeping in the swapping buffer what is needed for review
+                let stream = ctx.eth_stream.lock(Self);
+                stream.take();
+                let stream = stream.insert(TxStream::new(buffer, rest)?);
 
-                //if the number of bytes read and the number of bytes to read
-                // is the same as what we read...
-                if (to_read as usize).saturating_add(read).saturating_sub(len) == 0 {
+                if stream.is_complete() {
                     //then we actually had all bytes in this tx!
                     // we should sign directly
-                    *tx = Self::start_sign(buffer.read_exact(), flags)?;
+                    let txdata = buffer.read_exact();
+                    *tx = Self::start_sign(ctx, txdata, flags)?;
                 }
 
                 Ok(())
@@ -169,28 +164,19 @@ impl ApduHandler for Sign {
             0x80 => {
                 let payload = buffer.payload().map_err(|_| Error::WrongLength)?;
 
-                let buffer = unsafe { BUFFER.acquire(Self)? };
+                let buffer = ctx.buffer.acquire(Self)?;
+                let stream = match ctx.eth_stream.acquire(Self)? {
+                    Some(stream) => stream,
+                    None => return Err(Error::ApduCodeConditionsNotSatisfied),
+                };
 
-                //we could unwrap here as this data should be guaranteed correct
-                // we read back what we wrote to see how many bytes we expect
-                // to have to collect
-                let (read, to_read) = get_tx_rlp_len(buffer.read_exact())?;
+                stream.feed(buffer, payload)?;
 
-                // let's ignore the little header at the start
-                let rlp_read = buffer.read_exact().len() - read;
-
-                //either the entire buffer of the remaining bytes we expect
-                let missing = to_read as usize - rlp_read;
-                let len = core::cmp::min(missing, payload.len());
-
-                buffer
-                    .write(&payload[..len])
-                    .map_err(|_| Error::ExecutionError)?;
-
-                if missing - len == 0 {
+                if stream.is_complete() {
                     //we read all the missing bytes so we can proceed with the signature
-                    // nwo
-                    *tx = Self::start_sign(buffer.read_exact(), flags)?;
+                    // now
+                    let txdata = buffer.read_exact();
+                    *tx = Self::start_sign(ctx, txdata, flags)?;
                 }
 
                 Ok(())
@@ -222,7 +208,9 @@ impl Viewable for SignUI {
     }
 
     fn accept(&mut self, out: &mut [u8]) -> (usize, u16) {
-        let path = match Sign::get_derivation_info() {
+        let ctx = unsafe { AppContext::current() };
+
+        let path = match Sign::get_derivation_info(ctx) {
             Err(e) => return (0, e as _),
             Ok(k) => k,
         };
@@ -233,7 +221,7 @@ impl Viewable for SignUI {
         };
 
         //reset globals to avoid skipping `Init`
-        if let Err(e) = cleanup_globals() {
+        if let Err(e) = cleanup_globals(ctx) {
             return (0, e as _);
         }
 
@@ -309,35 +297,39 @@ impl Viewable for SignUI {
     }
 
     fn reject(&mut self, _: &mut [u8]) -> (usize, u16) {
-        let _ = cleanup_globals();
+        let _ = cleanup_globals(unsafe { AppContext::current() });
         (0, Error::CommandNotAllowed as _)
     }
 }
 
-fn cleanup_globals() -> Result<(), Error> {
-    unsafe {
-        if let Ok(path) = PATH.acquire(Sign) {
-            path.take();
+fn cleanup_globals(ctx: &mut AppContext) -> Result<(), Error> {
+    if let Ok(path) = ctx.path.acquire(Sign) {
+        path.take();
 
-            //let's release the lock for the future
-            let _ = PATH.release(Sign);
-        }
+        //let's release the lock for the future
+        let _ = ctx.path.release(Sign);
+    }
 
-        if let Ok(buffer) = BUFFER.acquire(Sign) {
-            buffer.reset();
+    if let Ok(buffer) = ctx.buffer.acquire(Sign) {
+        buffer.reset();
 
-            //let's release the lock for the future
-            let _ = BUFFER.release(Sign);
-        }
+        //let's release the lock for the future
+        let _ = ctx.buffer.release(Sign);
+    }
 
-        // Forcefully acquire the resource as it is not longer in use
-        // transaction was rejected.
-        #[cfg(feature = "erc721")]
-        {
-            crate::handlers::resources::NFT_INFO.lock(Sign).take();
-            //let's release the lock for the future
-            _ = crate::handlers::resources::NFT_INFO.release(Sign);
-        }
+    // Forcefully acquire the resource as the
+    // calldata parser is not longer using it
+    ctx.eth_stream.lock(Sign).take();
+    //let's release the lock for the future
+    _ = ctx.eth_stream.release(Sign);
+
+    // Forcefully acquire the resource as it is not longer in use
+    // transaction was rejected.
+    #[cfg(feature = "erc721")]
+    {
+        ctx.nft_info.lock(Sign).take();
+        //let's release the lock for the future
+        _ = ctx.nft_info.release(Sign);
     }
 
     //if we failed to aquire then someone else is using it anyways
@@ -346,6 +338,7 @@ fn cleanup_globals() -> Result<(), Error> {
 
 #[cfg(test)]
 mod tests {
+    use super::super::utils::get_tx_rlp_len;
     use super::*;
 
     #[test]
@@ -0,0 +1,699 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use core::{convert::TryFrom, mem::MaybeUninit};
+
+use arrayvec::ArrayVec;
+use bolos::hash::{Hasher, Keccak};
+
+use crate::{
+    constants::ApduError as Error,
+    handlers::{eth::utils::get_tx_rlp_len, resources::ZBuffer},
+    parser::{EIP1559_TX, EIP2930_TX, ETH_ARG_LEN, U32_SIZE, U64_SIZE},
+};
+
+/// Number of calldata bytes kept for review when the calldata is bigger:
+/// the selector plus the first arguments, which is more than what
+/// the generic `EthData` renderers show.
+pub const CALLDATA_RETAIN_LEN: usize = U32_SIZE + 4 * ETH_ARG_LEN;
+
+// header of the calldata item when cropped to CALLDATA_RETAIN_LEN,
+// which is longer than 55 bytes so the length is in a second byte
+const CROPPED_CALLDATA_HEADER: [u8; 2] = [0xB8, CALLDATA_RETAIN_LEN as u8];
+
+// the largest rlp item expected before the calldata,
+// that is, the longest header plus an u256
+const MAX_FIELD_LEN: usize = 1 + U64_SIZE + 32;
+
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum Section {
+    /// Number of rlp items left before the calldata
+    Fields(u8),
+    /// The header of the calldata item
+    CallDataHeader,
+    /// The calldata payload, with the number of bytes left
+    /// and how many of those are still to be kept
+    CallData { left: usize, keep: usize },
+    /// Everything after the calldata
+    Tail,
+}
+
+/// Keeps track of an ethereum transaction while it's being uploaded
+///
+/// The whole transaction is hashed as it arrives, but only the fields
+/// needed for review are written to `AppContext::buffer`:
+/// every rlp item in the list but the calldata, and just the
+/// first [`CALLDATA_RETAIN_LEN`] bytes of the calldata.
+/// The tx type and the rlp list header are skipped, the type is kept
+/// here instead, see [`crate::parser::EthTransaction::from_body_into`].
+pub struct TxStream {
+    hasher: Keccak<32>,
+    // None for legacy transactions
+    tx_type: Option<u8>,
+    // number of bytes of the transaction, type and rlp list
+    expected: usize,
+    received: usize,
+    section: Section,
+    // rlp item being collected across chunks
+    pending: ArrayVec<u8, MAX_FIELD_LEN>,
+    // full calldata length, only if it was cropped
+    cropped_len: Option<usize>,
+}
+
+impl TxStream {
+    /// Starts a new stream with the first chunk of the transaction
+    ///
+    /// `data` should start with the (optional) tx type and the rlp list header
+    #[inline(never)]
+    pub fn new(buffer: &mut ZBuffer, data: &[u8]) -> Result<Self, Error> {
+        let (read, to_read) = get_tx_rlp_len(data)?;
+        let expected = (to_read as usize)
+            .checked_add(read)
+            .ok_or(Error::DataInvalid)?;
+
+        let hasher = {
+            let mut k = MaybeUninit::uninit();
+            Keccak::<32>::new_gce(&mut k).map_err(|_| Error::Unknown)?;
+
+            //safe: initialized
+            unsafe { k.assume_init() }
+        };
+
+        // number of items before the calldata, by tx type
+        // legacy transactions start with the list header instead
+        let (tx_type, fields) = match data[0] {
+            EIP1559_TX => (Some(EIP1559_TX), 7),
+            EIP2930_TX => (Some(EIP2930_TX), 6),
+            _ => (None, 5),
+        };
+
+        let mut this = Self {
+            hasher,
+            tx_type,
+            expected,
+            received: 0,
+            section: Section::Fields(fields),
+            pending: ArrayVec::new(),
+            cropped_len: None,
+        };
+
+        // the envelope is hashed but not kept
+        this.hash(&data[..read])?;
+        this.feed(buffer, &data[read..])?;
+
+        Ok(this)
+    }
+
+    fn hash(&mut self, data: &[u8]) -> Result<(), Error> {
+        self.hasher.update(data).map_err(|_| Error::Unknown)?;
+        self.received += data.len();
+
+        Ok(())
+    }
+
+    /// The EIP-2718 type of the transaction, None for legacy transactions
+    pub fn tx_type(&self) -> Option<u8> {
+        self.tx_type
+    }
+
+    /// Returns true once all the bytes of the transaction were received
+    pub fn is_complete(&self) -> bool {
+        self.received == self.expected
+    }
+
+    /// Returns the full length of the calldata if it was cropped
+    pub fn cropped_len(&self) -> Option<usize> {
+        self.cropped_len
+    }
+
+    /// Retrieve the hash of the received transaction
+    pub fn finalize(&mut self) -> Result<[u8; Keccak::<32>::DIGEST_LEN], Error> {
+        if !self.is_complete() {
+            return Err(Error::ApduCodeConditionsNotSatisfied);
+        }
+
+        self.hasher.finalize_dirty().map_err(|_| Error::Unknown)
+    }
+
+    /// Process a new chunk of the transaction
+    ///
+    /// Some applications might append data at the end of an encoded
+    /// transaction, this is ignored.
+    #[inline(never)]
+    pub fn feed(&mut self, buffer: &mut ZBuffer, data: &[u8]) -> Result<(), Error> {
+        let len = core::cmp::min(data.len(), self.expected - self.received);
+        let mut data = &data[..len];
+
+        self.hash(data)?;
+
+        while !data.is_empty() {
+            match self.section {
+                Section::Fields(left) => {
+                    let (rest, item) = self.collect(data, true)?;
+                    data = rest;
+
+                    if item.is_some() {
+                        buffer
+                            .write(&self.pending)
+                            .map_err(|_| Error::ExecutionError)?;
+                        self.pending.clear();
+
+                        self.section = match left {
+                            1 => Section::CallDataHeader,
+                            n => Section::Fields(n - 1),
+                        };
+                    }
+                }
+                Section::CallDataHeader => {
+                    let (rest, header) = self.collect(data, false)?;
+                    data = rest;
+
+                    let (header_len, payload_len) = match header {
+                        Some(header) => header,
+                        None => continue,
+                    };
+
+                    self.section = if header_len == 0 {
+                        // single byte calldata, which is its own header
+                        buffer
+                            .write(&self.pending)
+                            .map_err(|_| Error::ExecutionError)?;
+                        Section::Tail
+                    } else if payload_len > CALLDATA_RETAIN_LEN {
+                        // only the first bytes will be kept,
+                        // so the header is encoded accordingly
+                        buffer
+                            .write(&CROPPED_CALLDATA_HEADER)
+                            .map_err(|_| Error::ExecutionError)?;
+                        self.cropped_len = Some(payload_len);
+
+                        Section::CallData {
+                            left: payload_len,
+                            keep: CALLDATA_RETAIN_LEN,
+                        }
+                    } else {
+                        buffer
+                            .write(&self.pending)
+                            .map_err(|_| Error::ExecutionError)?;
+
+                        Section::CallData {
+                            left: payload_len,
+                            keep: payload_len,
+                        }
+                    };
+                    self.pending.clear();
+                }
+                Section::CallData { left, keep } => {
+                    let n = core::cmp::min(left, data.len());
+                    let (chunk, rest) = data.split_at(n);
+                    data = rest;
+
+                    let kept = core::cmp::min(keep, n);
+                    if kept > 0 {
+                        buffer
+                            .write(&chunk[..kept])
+                            .map_err(|_| Error::ExecutionError)?;
+                    }
+
+                    self.section = if left == n {
+                        Section::Tail
+                    } else {
+                        Section::CallData {
+                            left: left - n,
+                            keep: keep - kept,
+                        }
+                    };
+                }
+                Section::Tail => {
+                    buffer.write(data).map_err(|_| Error::ExecutionError)?;
+                    data = &[];
+                }
+            }
+        }
+
+        // an empty calldata item could be the last one received
+        if let Section::CallData { left: 0, .. } = self.section {
+            self.section = Section::Tail;
+        }
+
+        Ok(())
+    }
+
+    /// Moves bytes from `data` into `pending` until it holds the whole header
+    /// of the next rlp item, and its payload too if `with_payload` is set
+    ///
+    /// Returns the unused bytes of `data` and, once complete,
+    /// the length of the header and of the payload
+    fn collect<'d>(
+        &mut self,
+        mut data: &'d [u8],
+        with_payload: bool,
+    ) -> Result<(&'d [u8], Option<(usize, usize)>), Error> {
+        loop {
+            let header = rlp_item_header(&self.pending)?;
+
+            let missing = match header {
+                None => 1,
+                Some((header_len, payload_len)) if with_payload => header_len
+                    .checked_add(payload_len)
+                    .ok_or(Error::DataInvalid)?
+                    .saturating_sub(self.pending.len()),
+                Some((header_len, _)) => header_len.saturating_sub(self.pending.len()),
+            };
+
+            if missing == 0 {
+                return Ok((data, header));
+            }
+
+            if data.is_empty() {
+                return Ok((data, None));
+            }
+
+            let n = core::cmp::min(missing, data.len());
+            self.pending
+                .try_extend_from_slice(&data[..n])
+                .map_err(|_| Error::DataInvalid)?;
+            data = &data[n..];
+        }
+    }
+}
+
+/// Reads the header of the rlp item at the start of `data`
+///
+/// Returns the length of the header and the length of the payload,
+/// or None if `data` doesn't contain the whole header yet.
+/// Single byte items have no header.
+fn rlp_item_header(data: &[u8]) -> Result<Option<(usize, usize)>, Error> {
+    let marker = match data.first() {
+        Some(marker) => *marker,
+        None => return Ok(None),
+    };
+
+    let num_bytes = match marker {
+        0..=0x7F => return Ok(Some((0, 1))),
+        sstring @ 0x80..=0xB7 => return Ok(Some((1, (sstring - 0x80) as usize))),
+        string @ 0xB8..=0xBF => string as usize - 0xB7,
+        slist @ 0xC0..=0xF7 => return Ok(Some((1, (slist - 0xC0) as usize))),
+        list @ 0xF8.. => list as usize - 0xF7,
+    };
+
+    let num = match data.get(1..1 + num_bytes) {
+        Some(num) => num,
+        None => return Ok(None),
+    };
+
+    let mut array = [0; U64_SIZE];
+    array[U64_SIZE - num_bytes..].copy_from_slice(num);
+
+    let len = usize::try_from(u64::from_be_bytes(array)).map_err(|_| Error::DataInvalid)?;
+
+    Ok(Some((1 + num_bytes, len)))
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{
+        handlers::resources::{AppContext, BUFFERAccessors, ETHStreamAccessors},
+        parser::{CallDataInfo, EthTransaction, FromBytes},
+    };
+    use std::{vec, vec::Vec};
+
+    const LEGACY_TX: &str = "ed018504e3b292008252089428ee52a8f3d6e5d15f8b131996950d7f296c7952872bd72a248740008082a86a8080";
+
+    /// Streams `data` in chunks of `chunk` bytes,
+    /// returning the tx type and what was kept in the buffer
+    fn stream(data: &[u8], chunk: usize) -> (Option<u8>, Vec<u8>) {
+        //safe: the context of the test thread, only used here
+        let ctx = unsafe { AppContext::current() };
+        let buffer = ctx.buffer.lock(BUFFERAccessors::EthSign);
+        buffer.reset();
+
+        let (first, rest) = data.split_at(chunk);
+        let mut stream = TxStream::new(buffer, first).unwrap();
+        for chunk in rest.chunks(chunk) {
+            stream.feed(buffer, chunk).unwrap();
+        }
+        assert!(stream.is_complete());
+
+        (stream.tx_type(), buffer.read_exact().to_vec())
+    }
+
+    fn assert_streamed(data: &[u8], chunk: usize) {
+        let (_, expected) = EthTransaction::from_bytes(data).unwrap();
+
+        let (tx_type, body) = stream(data, chunk);
+        assert_eq!(tx_type, expected.raw_tx_type());
+
+        let mut tx = MaybeUninit::uninit();
+        EthTransaction::from_body_into(tx_type, &body, &mut tx).unwrap();
+        let tx = unsafe { tx.assume_init() };
+
+        assert_eq!(tx, expected);
+    }
+
+    #[test]
+    fn legacy_nonces() {
+        let mut data = hex::decode(LEGACY_TX).unwrap();
+
+        // the first item of the body is the nonce,
+        // which shouldn't be taken for a tx type
+        for nonce in [0x80, 0x01, 0x02, 0x7F] {
+            data[1] = nonce;
+            for chunk in [1, 7, data.len()] {
+                assert_streamed(&data, chunk);
+            }
+        }
+    }
+
+    #[test]
+    fn typed_tx() {
+        // the legacy tx, with an empty access list, as EIP-2930
+        let data = "01ec82a86a018504e3b292008252089428ee52a8f3d6e5d15f8b131996950d7f296c7952872bd72a2487400080c0";
+        let data = hex::decode(data).unwrap();
+
+        for chunk in [2, 7, data.len()] {
+            assert_streamed(&data, chunk);
+        }
+    }
+
+    #[test]
+    fn rlp_headers() {
+        assert_eq!(rlp_item_header(&[]).unwrap(), None);
+        assert_eq!(rlp_item_header(&[0x7F]).unwrap(), Some((0, 1)));
+        assert_eq!(rlp_item_header(&[0x80]).unwrap(), Some((1, 0)));
+        assert_eq!(rlp_item_header(&[0x94, 0xAA]).unwrap(), Some((1, 20)));
+        assert_eq!(rlp_item_header(&[0xB9, 0x01]).unwrap(), None);
+        assert_eq!(
+            rlp_item_header(&[0xB9, 0x01, 0x00]).unwrap(),
+            Some((3, 256))
+        );
+        assert_eq!(rlp_item_header(&[0xC0]).unwrap(), Some((1, 0)));
+        assert_eq!(rlp_item_header(&[0xF8, 0x78]).unwrap(), Some((2, 0x78)));
+    }
+
+    #[test]
+    fn cropped_header() {
+        assert_eq!(
+            rlp_item_header(&CROPPED_CALLDATA_HEADER).unwrap(),
+            Some((2, CALLDATA_RETAIN_LEN))
+        );
+    }
+
+    const CHAIN_ID: [u8; 2] = [0xa8, 0x6a];
+    const GAS_PRICE: [u8; 5] = [0x04, 0xe3, 0xb2, 0x92, 0x00];
+    const GAS_LIMIT: [u8; 3] = [0x01, 0x86, 0xa0];
+    const CONTRACT: [u8; 20] = [0x28; 20];
+    const ASSET_CALL: [u8; 20] = [1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2];
+
+    fn rlp_header(short: u8, len: usize) -> Vec<u8> {
+        if len <= 55 {
+            return vec![short + len as u8];
+        }
+
+        let len = (len as u64).to_be_bytes();
+        let len = &len[len.iter().position(|b| *b != 0).unwrap()..];
+        [&[short + 55 + len.len() as u8][..], len].concat()
+    }
+
+    fn rlp_bytes(bytes: &[u8]) -> Vec<u8> {
+        match bytes {
+            [b] if *b < 0x80 => vec![*b],
+            _ => [rlp_header(0x80, bytes.len()), bytes.to_vec()].concat(),
+        }
+    }
+
+    fn rlp_list(items: &[Vec<u8>]) -> Vec<u8> {
+        let payload = items.concat();
+        [rlp_header(0xC0, payload.len()), payload].concat()
+    }
+
+    /// Encodes an unsigned transaction calling `to` with `calldata`,
+    /// a deploy without `to`
+    ///
+    /// Returns the transaction and the body the stream is expected to keep
+    fn encode_tx(
+        tx_type: Option<u8>,
+        to: Option<&[u8; 20]>,
+        calldata: &[u8],
+    ) -> (Vec<u8>, Vec<u8>) {
+        let to = rlp_bytes(to.map(|to| &to[..]).unwrap_or_default());
+        let value = rlp_bytes(&[]);
+
+        let (before, after) = match tx_type {
+            None => (
+                vec![
+                    rlp_bytes(&[0x01]),
+                    rlp_bytes(&GAS_PRICE),
+                    rlp_bytes(&GAS_LIMIT),
+                    to,
+                    value,
+                ],
+                vec![rlp_bytes(&CHAIN_ID), rlp_bytes(&[]), rlp_bytes(&[])],
+            ),
+            Some(EIP2930_TX) => (
+                vec![
+                    rlp_bytes(&CHAIN_ID),
+                    rlp_bytes(&[0x01]),
+                    rlp_bytes(&GAS_PRICE),
+                    rlp_bytes(&GAS_LIMIT),
+                    to,
+                    value,
+                ],
+                vec![rlp_list(&[])],
+            ),
+            Some(_) => (
+                vec![
+                    rlp_bytes(&CHAIN_ID),
+                    rlp_bytes(&[0x01]),
+                    rlp_bytes(&GAS_PRICE),
+                    rlp_bytes(&GAS_PRICE),
+                    rlp_bytes(&GAS_LIMIT),
+                    to,
+                    value,
+                ],
+                vec![rlp_list(&[])],
+            ),
+        };
+
+        let items = [&before[..], &[rlp_bytes(calldata)], &after].concat();
+        let tx = [
+            tx_type.map(|t| vec![t]).unwrap_or_default(),
+            rlp_list(&items),
+        ]
+        .concat();
+
+        let kept_calldata = if calldata.len() > CALLDATA_RETAIN_LEN {
+            [
+                &CROPPED_CALLDATA_HEADER[..],
+                &calldata[..CALLDATA_RETAIN_LEN],
+            ]
+            .concat()
+        } else {
+            rlp_bytes(calldata)
+        };
+        let body = [before.concat(), kept_calldata, after.concat()].concat();
+
+        (tx, body)
+    }
+
+    /// 4-bytes selector followed by `len - 4` bytes of arguments
+    fn calldata(selector: u32, len: usize) -> Vec<u8> {
+        let args = (0..len - U32_SIZE).map(|i| i as u8);
+        selector.to_be_bytes().iter().copied().chain(args).collect()
+    }
+
+    struct Streamed {
+        tx_type: Option<u8>,
+        body: &'static [u8],
+        digest: [u8; 32],
+        cropped_len: Option<usize>,
+    }
+
+    /// Streams `data` as the handler receives it, a first chunk with the
+    /// whole rlp list header followed by chunks of `chunk` bytes
+    ///
+    /// The stream is left in the context for the calldata parser
+    fn stream_tx(data: &[u8], chunk: usize) -> Streamed {
+        //safe: the context of the test thread, only used here
+        let ctx = unsafe { AppContext::current() };
+        let buffer = ctx.buffer.lock(BUFFERAccessors::EthSign);
+        buffer.reset();
+
+        // type byte and a 3 bytes list header at most
+        let first = core::cmp::min(core::cmp::max(chunk, 4), data.len());
+        let (first, rest) = data.split_at(first);
+        let mut stream = TxStream::new(buffer, first).unwrap();
+        for chunk in rest.chunks(chunk) {
+            stream.feed(buffer, chunk).unwrap();
+        }
+        assert!(stream.is_complete());
+
+        let streamed = Streamed {
+            tx_type: stream.tx_type(),
+            body: buffer.read_exact(),
+            digest: stream.finalize().unwrap(),
+            cropped_len: stream.cropped_len(),
+        };
+        ctx.eth_stream
+            .lock(ETHStreamAccessors::EthSign)
+            .replace(stream);
+
+        streamed
+    }
+
+    type Items = Vec<(Vec<u8>, Vec<u8>)>;
+
+    fn render(tx: EthTransaction<'static>) -> Items {
+        let mut driver = zuit::MockDriver::<_, 18, 1024>::new(tx);
+        driver.drive();
+
+        driver
+            .out_ui()
+            .iter()
+            .flat_map(|item| item.iter())
+            .map(|page| (page.title.to_vec(), page.message.to_vec()))
+            .collect()
+    }
+
+    /// Parses and renders the kept body, as `Sign::start_sign` does
+    fn review_streamed(streamed: &Streamed) -> Option<Items> {
+        //safe: the context of the test thread, only used here
+        let ctx = unsafe { AppContext::current() };
+        ctx.eth_stream.lock(CallDataInfo);
+
+        let mut tx = MaybeUninit::uninit();
+        let parsed = EthTransaction::from_body_into(streamed.tx_type, streamed.body, &mut tx);
+
+        // no stream, for the parsing of whole transactions
+        ctx.eth_stream.lock(ETHStreamAccessors::EthSign).take();
+        ctx.eth_stream.release(ETHStreamAccessors::EthSign).unwrap();
+
+        parsed.ok()?;
+        Some(render(unsafe { tx.assume_init() }))
+    }
+
+    /// Parses and renders the whole transaction
+    fn review_whole(data: &[u8]) -> Option<Items> {
+        let data = Vec::leak(data.to_vec());
+        let (_, tx) = EthTransaction::from_bytes(data).ok()?;
+
+        Some(render(tx))
+    }
+
+    /// Checks the body kept while streaming `data`, its digest, and that it's
+    /// reviewed like the whole transaction
+    ///
+    /// Returns the full length of the calldata if it was cropped
+    fn assert_reviewed(data: &[u8], body: &[u8], chunk: usize) -> Option<usize> {
+        let expected_items = review_whole(data);
+        assert!(expected_items.is_some());
+
+        let streamed = stream_tx(data, chunk);
+        assert_eq!(streamed.body, body, "chunk {}", chunk);
+        assert_eq!(streamed.digest, Keccak::<32>::digest(data).unwrap());
+        assert_eq!(review_streamed(&streamed), expected_items);
+
+        streamed.cropped_len
+    }
+
+    const CHUNKS: [usize; 6] = [1, 7, 32, 133, 250, 1000];
+
+    #[test]
+    fn cropped_multicall() {
+        for tx_type in [None, Some(EIP2930_TX), Some(EIP1559_TX)] {
+            // kept whole, then cropped
+            for len in [CALLDATA_RETAIN_LEN, CALLDATA_RETAIN_LEN + ETH_ARG_LEN, 388] {
+                let (data, body) = encode_tx(tx_type, Some(&CONTRACT), &calldata(0xac9650d8, len));
+                let cropped_len = (len > CALLDATA_RETAIN_LEN).then(|| len);
+
+                for chunk in CHUNKS {
+                    assert_eq!(assert_reviewed(&data, &body, chunk), cropped_len);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn cropped_calldata_header() {
+        let multicall = calldata(0xac9650d8, 388);
+        let (data, _) = encode_tx(None, Some(&CONTRACT), &multicall);
+        let streamed = stream_tx(&data, 7);
+
+        // the kept calldata is encoded with its cropped length, 0xB9 0x0184 otherwise
+        let kept = [
+            &CROPPED_CALLDATA_HEADER[..],
+            &multicall[..CALLDATA_RETAIN_LEN],
+        ]
+        .concat();
+        assert!(streamed
+            .body
+            .windows(kept.len())
+            .any(|item| item == &kept[..]));
+        assert!(!streamed
+            .body
+            .windows(3)
+            .any(|header| header == [0xB9, 0x01, 0x84]));
+    }
+
+    #[test]
+    fn cropped_deploy() {
+        // a deploy is not made of arguments, any length is fine
+        for len in [600, 601] {
+            let code = calldata(0x60806040, len);
+            for tx_type in [None, Some(EIP1559_TX)] {
+                let (data, body) = encode_tx(tx_type, None, &code);
+
+                for chunk in CHUNKS {
+                    assert_reviewed(&data, &body, chunk);
+                }
+            }
+        }
+    }
+
+    #[test]
+    fn cropped_asset_call_rejected() {
+        // asset calls can't be checked from the kept bytes only
+        let (data, body) = encode_tx(None, Some(&ASSET_CALL), &calldata(0x00000000, 388));
+
+        for chunk in CHUNKS {
+            let streamed = stream_tx(&data, chunk);
+            assert_eq!(streamed.body, &body[..]);
+            assert_eq!(streamed.cropped_len, Some(388));
+            assert_eq!(review_streamed(&streamed), None);
+        }
+    }
+
+    #[test]
+    fn cropped_call_arguments() {
+        // the arguments past the kept bytes have to be whole too
+        for extra in [1, 31] {
+            let len = 388 + extra;
+            let (data, body) = encode_tx(
+                Some(EIP1559_TX),
+                Some(&CONTRACT),
+                &calldata(0xac9650d8, len),
+            );
+            assert_eq!(review_whole(&data), None);
+
+            for chunk in CHUNKS {
+                let streamed = stream_tx(&data, chunk);
+                assert_eq!(streamed.body, &body[..]);
+                assert_eq!(streamed.digest, Keccak::<32>::digest(&data).unwrap());
+                assert_eq!(review_streamed(&streamed), None);
+            }
+        }
+    }
+}
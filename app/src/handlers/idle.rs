@@ -0,0 +1,194 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Work done while the device waits for the user
+//!
+//! Between ticker events the device is idle: waiting for the next APDU,
+//! or for the user to go through a review.
+//! Handlers queue the keys of change paths here, and [`IdleTasks::step`]
+//! derives one of them on every ticker event, so that matching
+//! the change outputs doesn't derive them all at once.
+//!
+//! Only the hashes of public keys are cached, nothing is ever signed here.
+//! They belong to the signing session that queued them,
+//! and are dropped along with it.
+
+use core::{convert::TryFrom, mem::MaybeUninit};
+
+use arrayvec::ArrayVec;
+use bolos::{crypto::bip32::BIP32Path, hash::Ripemd160};
+
+use crate::{
+    constants::{ApduError as Error, BIP32_PATH_SUFFIX_DEPTH, MAX_BIP32_PATH_DEPTH},
+    handlers::avax::signing::Sign,
+    parser::{FromBytes, PathWrapper},
+};
+
+/// The last components of a path, relative to the session root path
+pub type PathSuffix = [u32; BIP32_PATH_SUFFIX_DEPTH];
+
+type Keyhash = [u8; Ripemd160::DIGEST_LEN];
+
+cfg_if::cfg_if! {
+    if #[cfg(feature = "large-ram-buffer")] {
+        const MAX_KEYHASHES: usize = 8;
+    } else {
+        const MAX_KEYHASHES: usize = 2;
+    }
+}
+
+pub struct IdleTasks {
+    root: Option<BIP32Path<MAX_BIP32_PATH_DEPTH>>,
+    /// Change paths whose key hash is yet to be derived
+    tasks: ArrayVec<PathSuffix, MAX_KEYHASHES>,
+    keyhashes: ArrayVec<(PathSuffix, Keyhash), MAX_KEYHASHES>,
+}
+
+/// Reads a path suffix, encoded as its number of components followed by them
+pub fn read_suffix(data: &[u8]) -> Result<(PathSuffix, &[u8]), Error> {
+    let mut path = MaybeUninit::uninit();
+    let rem = PathWrapper::<BIP32_PATH_SUFFIX_DEPTH>::from_bytes_into(data, &mut path)
+        .map_err(|_| Error::DataInvalid)?;
+    let path = unsafe { path.assume_init().path() };
+
+    let suffix = PathSuffix::try_from(path.components()).map_err(|_| Error::WrongLength)?;
+
+    Ok((suffix, rem))
+}
+
+impl IdleTasks {
+    pub fn new() -> Self {
+        Self {
+            root: None,
+            tasks: ArrayVec::new(),
+            keyhashes: ArrayVec::new(),
+        }
+    }
+
+    /// Drops the queued tasks and their results
+    pub fn reset(&mut self) {
+        self.keyhashes.clear();
+        self.tasks.clear();
+        self.root = None;
+    }
+
+    /// Starts a new session, for the keys under `root`
+    pub fn start(&mut self, root: BIP32Path<MAX_BIP32_PATH_DEPTH>) {
+        self.reset();
+        self.root = Some(root);
+    }
+
+    /// Queues the derivation of the key hash at `suffix`
+    ///
+    /// Work is done on a best effort basis,
+    /// a task is dropped if there is no room left for its result
+    pub fn queue_keyhash(&mut self, suffix: PathSuffix) {
+        let queued = self.tasks.len() + self.keyhashes.len();
+        let known =
+            self.tasks.contains(&suffix) || self.keyhashes.iter().any(|(s, _)| *s == suffix);
+
+        if !known && queued < MAX_KEYHASHES {
+            self.tasks.push(suffix);
+        }
+    }
+
+    pub fn keyhash(&self, suffix: &PathSuffix) -> Option<&Keyhash> {
+        self.keyhashes
+            .iter()
+            .find(|(s, _)| s == suffix)
+            .map(|(_, keyhash)| keyhash)
+    }
+
+    fn full_path(&self, suffix: &PathSuffix) -> Option<BIP32Path<MAX_BIP32_PATH_DEPTH>> {
+        let root = self.root.as_ref()?;
+
+        let components = root.components().iter().chain(suffix.iter()).copied();
+        BIP32Path::new(components).ok()
+    }
+
+    /// Derives the next queued key hash, if any
+    ///
+    /// Returns whether a key was derived
+    #[inline(never)]
+    pub fn step(&mut self) -> bool {
+        let suffix = match self.tasks.pop_at(0) {
+            Some(suffix) => suffix,
+            None => return false,
+        };
+
+        let mut keyhash = [0; Ripemd160::DIGEST_LEN];
+        if let Some(path) = self.full_path(&suffix) {
+            if Sign::compute_keyhash(&path, &mut keyhash).is_ok() {
+                let _ = self.keyhashes.try_push((suffix, keyhash));
+            }
+        }
+
+        true
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    const ROOT: [u32; 3] = [0x8000_002c, 0x8000_2328, 0x8000_0000];
+
+    fn path(suffix: PathSuffix) -> BIP32Path<MAX_BIP32_PATH_DEPTH> {
+        BIP32Path::new(ROOT.iter().chain(suffix.iter()).copied()).unwrap()
+    }
+
+    #[test]
+    fn cached_keyhash() {
+        let mut idle = IdleTasks::new();
+        idle.start(BIP32Path::new(ROOT.iter().copied()).unwrap());
+
+        idle.queue_keyhash([1, 0]);
+        idle.queue_keyhash([1, 0]);
+        assert!(idle.keyhash(&[1, 0]).is_none());
+
+        assert!(idle.step());
+        assert!(!idle.step());
+
+        let mut expected = [0; Ripemd160::DIGEST_LEN];
+        Sign::compute_keyhash(&path([1, 0]), &mut expected).unwrap();
+        assert_eq!(idle.keyhash(&[1, 0]), Some(&expected));
+
+        // already derived
+        idle.queue_keyhash([1, 0]);
+        assert!(!idle.step());
+
+        idle.reset();
+        assert!(idle.keyhash(&[1, 0]).is_none());
+    }
+
+    #[test]
+    fn bounded_keyhashes() {
+        let mut idle = IdleTasks::new();
+        idle.start(BIP32Path::new(ROOT.iter().copied()).unwrap());
+
+        (0..MAX_KEYHASHES as u32 + 1).for_each(|i| idle.queue_keyhash([1, i]));
+        while idle.step() {}
+
+        assert!(idle.keyhash(&[1, 0]).is_some());
+        assert!(idle.keyhash(&[1, MAX_KEYHASHES as u32]).is_none());
+    }
+
+    #[test]
+    fn invalid_suffix() {
+        // not a suffix
+        assert!(read_suffix(&[1, 0, 0, 0, 0]).is_err());
+        assert!(read_suffix(&[2, 0, 0, 0, 0, 0, 0, 0, 5]).is_ok());
+    }
+}
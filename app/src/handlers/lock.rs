@@ -31,6 +31,17 @@ impl<T, A> Lock<T, A> {
     pub const fn new(item: T) -> Self {
         Self { item, lock: None }
     }
+
+    ///Read the resource without acquiring it,
+    /// leaving it to whoever locked it
+    pub fn peek(&self) -> &T {
+        &self.item
+    }
+
+    ///Tells if the resource is locked by anyone
+    pub fn is_locked(&self) -> bool {
+        self.lock.is_some()
+    }
 }
 
 impl<T, A: Eq> Lock<T, A> {
@@ -126,4 +137,13 @@ mod tests {
         lock.acquire(0).unwrap_err();
         lock.acquire(1).unwrap();
     }
+
+    #[test]
+    fn peek_keeps_lock() {
+        let mut lock = build_lock(7);
+        lock.lock(0);
+
+        assert_eq!(7, *lock.peek());
+        lock.acquire(0).unwrap();
+    }
 }
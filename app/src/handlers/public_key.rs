@@ -20,7 +20,7 @@ use bolos::{crypto::bip32::BIP32Path, PIC};
 use zemu_sys::{Show, Viewable};
 
 mod xpub;
-pub use xpub::GetExtendedPublicKey;
+pub use xpub::{GetExtendedPublicKey, P2_BULK};
 
 mod ui;
 pub use ui::{AddrUI, AddrUIInitError, AddrUIInitializer};
@@ -29,8 +29,13 @@ use crate::{
     constants::{ApduError as Error, ASCII_HRP_MAX_SIZE, DEFAULT_CHAIN_ID, MAX_BIP32_PATH_DEPTH},
     crypto,
     dispatcher::ApduHandler,
+    handlers::resources::AppContext,
     sys::{self, Error as SysError},
-    utils::{read_slice, ApduBufferRead, ApduPanic},
+    utils::{
+        read_slice,
+        trace::{self, TraceId},
+        ApduBufferRead, ApduPanic,
+    },
 };
 
 pub struct GetPublicKey;
@@ -56,6 +61,7 @@ impl GetPublicKey {
         chaincode: Option<&mut [u8; 32]>,
     ) -> Result<(), SysError> {
         sys::zemu_log_stack("GetAddres::new_key\x00");
+        let _span = trace::span(TraceId::Derive);
         crypto::Curve
             .to_secret(path)
             .into_public_into(chaincode, out)?;
@@ -113,7 +119,12 @@ impl GetPublicKey {
 
 impl ApduHandler for GetPublicKey {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        _: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("GetPublicKey::handle\x00");
 
         *tx = 0;
@@ -20,7 +20,7 @@ use crate::{
         CHAIN_ID_LEN, MAX_BIP32_PATH_DEPTH,
     },
     crypto,
-    handlers::{handle_ui_message, resources::PATH},
+    handlers::{handle_ui_message, resources::AppContext},
     sys::{
         bech32,
         crypto::{bip32::BIP32Path, CHAIN_CODE_LEN},
@@ -101,9 +101,10 @@ impl<'ui> AddrUIInitializer<'ui> {
 
     /// Initialie the path with the given one
     pub fn with_path(&mut self, path: BIP32Path<MAX_BIP32_PATH_DEPTH>) -> &mut Self {
-        unsafe {
-            PATH.lock(super::GetPublicKey).replace(path);
-        }
+        unsafe { AppContext::current() }
+            .path
+            .lock(super::GetPublicKey)
+            .replace(path);
 
         self.path_init = true;
         self
@@ -227,7 +228,9 @@ impl AddrUI {
     ) -> Result<crypto::PublicKey, Error> {
         let mut out = MaybeUninit::uninit();
 
-        let path = unsafe { PATH.acquire(super::GetPublicKey) }?
+        let path = unsafe { AppContext::current() }
+            .path
+            .acquire(super::GetPublicKey)?
             .as_ref()
             .ok_or(Error::ExecutionError)?;
 
@@ -342,7 +345,6 @@ impl Viewable for AddrUI {
 mod tests {
     use arrayref::array_ref;
     use bolos::{bech32, crypto::bip32::BIP32Path};
-    use serial_test::file_serial;
     use zuit::{MockDriver, Page};
 
     use crate::{handlers::public_key::GetPublicKey, utils::strlen};
@@ -426,13 +428,11 @@ mod tests {
     }
 
     #[test]
-    #[cfg_attr(not(miri), file_serial(path))]
     pub fn p_chain() {
         test_chain_alias(Some("P"), None)
     }
 
     #[test]
-    #[cfg_attr(not(miri), file_serial(path))]
     pub fn x_chain() {
         let id = hex::decode("ab68eb1ee142a05cfe768c36e11f0b596db5a3c6c77aabe665dad9e638ca94f7")
             .unwrap();
@@ -441,7 +441,6 @@ mod tests {
     }
 
     #[test]
-    #[cfg_attr(not(miri), file_serial(path))]
     pub fn c_chain() {
         let id = hex::decode("7fc93d85c6d62c5b2ac0b519c87010ea5294012d1e407030d6acd0021cac10d5")
             .unwrap();
@@ -450,7 +449,6 @@ mod tests {
     }
 
     #[test]
-    #[cfg_attr(not(miri), file_serial(path))]
     pub fn unknown_chain() {
         let id = hex::decode("2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a2a")
             .unwrap();
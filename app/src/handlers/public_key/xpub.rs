@@ -13,7 +13,11 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use core::{convert::TryFrom, mem::MaybeUninit, ptr::addr_of_mut};
+use core::{
+    convert::{TryFrom, TryInto},
+    mem::MaybeUninit,
+    ptr::addr_of_mut,
+};
 
 use zemu_sys::{Show, ViewError, Viewable};
 
@@ -21,7 +25,7 @@ use crate::{
     constants::{ApduError as Error, BIP32_PATH_ROOT_1, MAX_BIP32_PATH_DEPTH},
     crypto,
     dispatcher::ApduHandler,
-    handlers::handle_ui_message,
+    handlers::{handle_ui_message, resources::AppContext},
     sys::{
         self,
         crypto::{bip32::BIP32Path, CHAIN_CODE_LEN},
@@ -32,6 +36,13 @@ use crate::{
 
 use super::{AddrUI, AddrUIInitError, AddrUIInitializer, GetPublicKey};
 
+/// P2 value to request the keys of multiple accounts at once,
+/// see [`GetExtendedPublicKey::handle_bulk`]
+pub const P2_BULK: u8 = 1;
+
+// compressed public key followed by the chain code
+const BULK_ENTRY_LEN: usize = 33 + CHAIN_CODE_LEN;
+
 pub struct GetExtendedPublicKey;
 
 impl GetExtendedPublicKey {
@@ -50,15 +61,82 @@ impl GetExtendedPublicKey {
 
         initializer.finalize().map_err(|_| Error::ExecutionError)
     }
+
+    /// Retrieve the extended public keys of multiple accounts, without confirmation
+    ///
+    /// The payload is a path prefix followed by the number of accounts
+    /// and the last path component of each one.
+    /// The response starts with the number of keys returned, followed by as many
+    /// [compressed key | chain code] as fit in [`AppContext::response`], in the same order;
+    /// the host is expected to request the remaining accounts afterwards.
+    /// It's usually longer than a single APDU, see [`crate::utils::ResponseStream`].
+    ///
+    /// The OS derives every key from the seed, so there's no intermediate node
+    /// to reuse, but no UI is constructed and all keys share a single exchange.
+    #[inline(never)]
+    fn handle_bulk(ctx: &mut AppContext, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+        sys::zemu_log_stack("GetExtendedPublicKey::handle_bulk\x00");
+
+        if buffer.p1() != 0 {
+            return Err(Error::CommandNotAllowed);
+        }
+
+        let cdata = buffer.payload().map_err(|_| Error::DataInvalid)?;
+
+        let prefix_len = 1 + 4 * *cdata.first().ok_or(Error::DataInvalid)? as usize;
+        let prefix = cdata.get(..prefix_len).ok_or(Error::DataInvalid)?;
+        let prefix = BIP32Path::<{ MAX_BIP32_PATH_DEPTH - 1 }>::read(prefix)
+            .map_err(|_| Error::DataInvalid)?;
+
+        let cdata = &cdata[prefix_len..];
+        let num_accounts = *cdata.first().ok_or(Error::DataInvalid)? as usize;
+        let accounts = &cdata[1..];
+        if num_accounts == 0 || accounts.len() != 4 * num_accounts {
+            return Err(Error::DataInvalid);
+        }
+
+        // leave room for the count
+        let fit = ctx.response.room().saturating_sub(1) / BULK_ENTRY_LEN;
+        let accounts = accounts.chunks_exact(4).take(fit);
+
+        ctx.response.write(&[accounts.len() as u8])?;
+        for account in accounts {
+            let account = u32::from_be_bytes(account.try_into().apdu_unwrap());
+            let path = prefix.components().iter().copied().chain(Some(account));
+            let path =
+                BIP32Path::<MAX_BIP32_PATH_DEPTH>::new(path).map_err(|_| Error::DataInvalid)?;
+
+            let mut key = MaybeUninit::uninit();
+            let mut cc = [0; CHAIN_CODE_LEN];
+            GetPublicKey::new_key_into(&path, &mut key, Some(&mut cc))
+                .map_err(|_| Error::ExecutionError)?;
+            //safe: initialized
+            let key = unsafe { key.assume_init() };
+
+            ctx.response.write(key.as_ref())?;
+            ctx.response.write(&cc)?;
+        }
+
+        Ok(())
+    }
 }
 
 impl ApduHandler for GetExtendedPublicKey {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        ctx: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("GetExtendedPublicKey::handle\x00");
 
         *tx = 0;
 
+        if buffer.p2() == P2_BULK {
+            return Self::handle_bulk(ctx, buffer);
+        }
+
         let req_confirmation = buffer.p1() >= 1;
 
         let mut cdata = buffer.payload().map_err(|_| Error::DataInvalid)?;
@@ -0,0 +1,43 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use crate::constants::ApduError;
+use crate::dispatcher::ApduHandler;
+use crate::handlers::resources::AppContext;
+use crate::utils::ApduBufferRead;
+
+/// Retrieves the next frame of a response longer than one APDU,
+/// see [`crate::utils::ResponseStream`]
+///
+/// The frame itself is written by the dispatcher
+pub struct GetResponse;
+
+impl ApduHandler for GetResponse {
+    #[inline(never)]
+    fn handle(
+        ctx: &mut AppContext,
+        _: &mut u32,
+        tx: &mut u32,
+        _: ApduBufferRead<'_>,
+    ) -> Result<(), ApduError> {
+        *tx = 0;
+
+        if ctx.response.is_empty() {
+            return Err(ApduError::ApduCodeConditionsNotSatisfied);
+        }
+
+        Ok(())
+    }
+}
@@ -15,13 +15,19 @@
 ********************************************************************************/
 use crate::constants::{version::*, ApduError};
 use crate::dispatcher::ApduHandler;
+use crate::handlers::resources::AppContext;
 use crate::utils::ApduBufferRead;
 
 pub struct GetVersion {}
 
 impl ApduHandler for GetVersion {
     #[inline(never)]
-    fn handle(_: &mut u32, tx: &mut u32, apdu_buffer: ApduBufferRead<'_>) -> Result<(), ApduError> {
+    fn handle(
+        _: &mut AppContext,
+        _: &mut u32,
+        tx: &mut u32,
+        apdu_buffer: ApduBufferRead<'_>,
+    ) -> Result<(), ApduError> {
         crate::sys::zemu_log_stack("GetVersion\x00");
         *tx = 0;
 
@@ -25,7 +25,7 @@ use crate::{
     },
     crypto,
     dispatcher::ApduHandler,
-    handlers::handle_ui_message,
+    handlers::{handle_ui_message, resources::AppContext},
     sys::{self, PIC},
     utils::{hex_encode, ApduBufferRead, ApduPanic},
 };
@@ -43,7 +43,12 @@ impl WalletId {
 
 impl ApduHandler for WalletId {
     #[inline(never)]
-    fn handle(flags: &mut u32, tx: &mut u32, buffer: ApduBufferRead<'_>) -> Result<(), Error> {
+    fn handle(
+        _: &mut AppContext,
+        flags: &mut u32,
+        tx: &mut u32,
+        buffer: ApduBufferRead<'_>,
+    ) -> Result<(), Error> {
         sys::zemu_log_stack("WalletId::handle\x00");
 
         *tx = 0;
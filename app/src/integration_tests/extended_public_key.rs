@@ -18,7 +18,6 @@ use super::prelude::*;
 use constants::INS_GET_EXTENDED_PUBLIC_KEY as INS;
 
 #[test]
-#[cfg_attr(not(miri), file_serial(path))]
 fn extended_public_key() {
     let mut flags = 0u32;
     let mut tx = 0u32;
@@ -36,3 +35,63 @@ fn extended_public_key() {
     //secp256k1 pubkey and 32 bytes for chain code + 2 for response code
     assert_eq!(tx as usize, 1 + pk_len + 32 + 2);
 }
+
+#[test]
+fn extended_public_keys_bulk() {
+    use crate::handlers::public_key::P2_BULK;
+
+    let mut flags = 0u32;
+    let mut tx = 0u32;
+    let mut buffer = [0u8; 260];
+
+    let prefix = [0x8000_0000u32 + 44, 0x8000_0000 + 9000];
+    let accounts = [0x8000_0000u32, 0x8000_0001, 0x8000_0002, 0x8000_0003];
+
+    let mut payload = vec![prefix.len() as u8];
+    prefix
+        .iter()
+        .for_each(|n| payload.extend_from_slice(&n.to_be_bytes()));
+    payload.push(accounts.len() as u8);
+    accounts
+        .iter()
+        .for_each(|n| payload.extend_from_slice(&n.to_be_bytes()));
+
+    buffer[..5].copy_from_slice(&[CLA, INS, 0, P2_BULK, payload.len() as u8]);
+    buffer[5..][..payload.len()].copy_from_slice(&payload);
+    let rx = 5 + payload.len() as u32;
+
+    let first = handle_apdu(&mut flags, &mut tx, rx, &mut buffer);
+    //all keys don't fit in a 260 bytes buffer
+    assert_error_code!(tx, buffer, ApduError::MoreDataAvailable);
+    assert_eq!(tx as usize, 255 + 2);
+    let mut out = first[..tx as usize - 2].to_vec();
+
+    //retrieve the rest
+    buffer[..5].copy_from_slice(&[CLA, constants::INS_GET_RESPONSE, 0, 0, 0]);
+    let rest = handle_apdu(&mut flags, &mut tx, 5, &mut buffer);
+    assert_error_code!(tx, buffer, ApduError::Success);
+    out.extend_from_slice(&rest[..tx as usize - 2]);
+
+    //nothing left
+    buffer[..5].copy_from_slice(&[CLA, constants::INS_GET_RESPONSE, 0, 0, 0]);
+    handle_apdu(&mut flags, &mut tx, 5, &mut buffer);
+    assert_error_code!(tx, buffer, ApduError::ApduCodeConditionsNotSatisfied);
+
+    let count = out[0] as usize;
+    assert_eq!(count, accounts.len());
+    assert_eq!(out.len(), 1 + count * (33 + 32));
+
+    //each entry matches the single key export
+    for (i, entry) in out[1..].chunks_exact(33 + 32).take(count).enumerate() {
+        let mut single = [0u8; 260];
+        single[..3].copy_from_slice(&[CLA, INS, 0]);
+        prepare_buffer::<3>(&mut single, &[44, 9000, i as u32], Some(&[]), Some(&[]));
+
+        let mut tx = 0;
+        let expected = handle_apdu(&mut flags, &mut tx, 5, &mut single);
+        assert_error_code!(tx, single, ApduError::Success);
+
+        assert_eq!(expected[0], 33);
+        assert_eq!(&expected[1..][..33 + 32], entry);
+    }
+}
@@ -54,7 +54,6 @@ fn addr_len(hrp: Option<&[u8]>, chain_id: Option<&[u8]>) -> usize {
 }
 
 #[test]
-#[cfg_attr(not(miri), file_serial(path))]
 fn public_key() {
     let mut flags = 0u32;
     let mut tx = 0u32;
@@ -73,7 +72,6 @@ fn public_key() {
 }
 
 #[test]
-#[cfg_attr(not(miri), file_serial(path))]
 fn public_key_with_hrp() {
     let mut flags = 0u32;
     let mut tx = 0u32;
@@ -94,7 +92,6 @@ fn public_key_with_hrp() {
 }
 
 #[test]
-#[cfg_attr(not(miri), file_serial(path))]
 #[should_panic = "DataInvalid"]
 fn public_key_with_too_long_hrp() {
     let mut flags = 0u32;
@@ -116,7 +113,6 @@ fn public_key_with_too_long_hrp() {
 }
 
 #[test]
-#[cfg_attr(not(miri), file_serial(path))]
 fn public_key_with_long_hrp() {
     let mut flags = 0u32;
     let mut tx = 0u32;
@@ -137,7 +133,6 @@ fn public_key_with_long_hrp() {
 }
 
 #[test]
-#[cfg_attr(not(miri), file_serial(path))]
 fn public_key_with_chainid() {
     let mut flags = 0u32;
     let mut tx = 0u32;
@@ -161,7 +156,6 @@ fn public_key_with_chainid() {
 }
 
 #[test]
-#[cfg_attr(not(miri), file_serial(path))]
 #[should_panic = "DataInvalid"]
 fn public_key_with_bad_chainid() {
     let mut flags = 0u32;
@@ -303,3 +303,65 @@ impl AvaxSign {
         })
     }
 }
+
+#[test]
+fn sequenced_upload() {
+    use crate::utils::{crc32, SEQUENCED_PAYLOAD};
+
+    const ROOT: [u32; 3] = [0x8000_0000 + 44, 0x8000_0000 + 9000, 0x8000_0000];
+    const CHUNK_LEN: usize = 200;
+
+    let op = AvaxSign::new(ROOT, &[[0, 0]], P_CREATE_CHAIN, &[]);
+    let msg = op.msg_to_send();
+
+    // reference, uploaded as usual
+    let mut plain = op.get_chunks();
+    let last = plain.len() - 1;
+    let expected = plain
+        .iter_mut()
+        .map(|chunk| handle_apdu(&mut 0, &mut 0, 260, chunk))
+        .nth(last)
+        .unwrap();
+
+    let sequenced = |offset: usize, data: &[u8], p1: u8| {
+        let mut buf = op.get_chunks()[0];
+        buf[APDU_INDEX_P1] = p1 | SEQUENCED_PAYLOAD;
+        buf[APDU_INDEX_LEN] = (6 + data.len()) as u8;
+        buf[APDU_INDEX_LEN + 1..][..2].copy_from_slice(&(offset as u16).to_be_bytes());
+        buf[APDU_INDEX_LEN + 3..][..4].copy_from_slice(&crc32(data).to_be_bytes());
+        buf[APDU_INDEX_LEN + 7..][..data.len()].copy_from_slice(data);
+        buf
+    };
+    let acked = |response: &[u8]| {
+        assert_eq!(&response[2..], &[0x90, 0x00]);
+        u16::from_be_bytes([response[0], response[1]]) as usize
+    };
+
+    let mut init = op.get_chunks()[0];
+    handle_apdu(&mut 0, &mut 0, 260, &mut init);
+
+    let chunks = msg.chunks(CHUNK_LEN).collect::<Vec<_>>();
+    let (last_chunk, chunks) = chunks.split_last().unwrap();
+
+    let mut offset = 0;
+    for chunk in chunks {
+        // skipping a chunk is caught right away
+        let mut skipped = sequenced(offset + CHUNK_LEN, chunk, PacketType::Add as u8);
+        let response = handle_apdu(&mut 0, &mut 0, 260, &mut skipped);
+        assert_eq!(response, &[0x6A, 0x80]);
+
+        let mut next = sequenced(offset, chunk, PacketType::Add as u8);
+        let response = handle_apdu(&mut 0, &mut 0, 260, &mut next);
+        assert_eq!(acked(&response), offset + chunk.len());
+
+        // sent again, as if the response was lost
+        let mut next = sequenced(offset, chunk, PacketType::Add as u8);
+        let response = handle_apdu(&mut 0, &mut 0, 260, &mut next);
+        assert_eq!(acked(&response), offset + chunk.len());
+
+        offset += chunk.len();
+    }
+
+    let mut last = sequenced(offset, last_chunk, PacketType::Last as u8);
+    assert_eq!(handle_apdu(&mut 0, &mut 0, 260, &mut last), expected);
+}
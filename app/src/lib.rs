@@ -40,6 +40,12 @@ use utils::ApduPanic;
 use handlers::ZPacketType as PacketType;
 mod crypto;
 
+#[cfg(fuzzing)]
+pub mod fuzzing;
+
+#[cfg(armbench)]
+pub mod armbench;
+
 cfg_if::cfg_if! {
     if #[cfg(fuzzing)] {
         pub use dispatcher::handle_apdu;
@@ -48,6 +54,7 @@ cfg_if::cfg_if! {
     }
 }
 
+use handlers::resources::AppContext;
 use sys::{check_canary, zemu_log};
 
 /// # Safety
@@ -66,7 +73,29 @@ pub unsafe extern "C" fn rs_handle_apdu(
     let data = std::slice::from_raw_parts_mut(buffer, buffer_len as usize);
     zemu_log("rs_handle_apdu\n\x00");
 
+    // ticker events can be dispatched while an APDU is being handled,
+    // see `rs_idle_tick`
+    AppContext::current().handling_apdu = true;
     handle_apdu(flags, tx, rx, data);
+    AppContext::current().handling_apdu = false;
+
+    check_canary();
+}
+
+/// # Safety
+///
+/// This function is called by the C stub on every ticker event,
+/// to run the work queued in [`handlers::idle::IdleTasks`]
+#[no_mangle]
+pub unsafe extern "C" fn rs_idle_tick() {
+    let ctx = AppContext::current();
+    // the handler owns the context, only the flag is read
+    if ctx.handling_apdu {
+        return;
+    }
+
+    let _span = utils::trace::span(utils::trace::TraceId::Idle);
+    ctx.idle.step();
 
     check_canary();
 }
@@ -26,6 +26,7 @@ mod defer;
 mod error;
 mod initial_state;
 mod inputs;
+mod layout;
 mod message;
 mod network_info;
 mod node_id;
@@ -43,25 +44,40 @@ mod validator;
 #[cfg(feature = "banff")]
 mod proof_of_possession;
 
+#[cfg(feature = "policy")]
+mod policy;
+
 #[cfg(test)]
 mod snapshots_common;
 
+#[cfg(test)]
+pub mod generators;
+
 pub use address::*;
 pub use asset_id::AssetId;
 pub use avm_output::AvmOutput;
 pub use constants::*;
 pub use coreth::{
-    bytes_to_u64, data::EthData, export_tx::ExportTx, import_tx::ImportTx, native::EthTransaction,
+    bytes_to_u64,
+    data::{CallDataInfo, EthData},
+    export_tx::ExportTx,
+    import_tx::ImportTx,
+    native::EthTransaction,
     PersonalMsg,
 };
 pub use defer::Defer;
 pub use error::ParserError;
 pub use initial_state::{FxId, InitialState};
 pub use inputs::{Input, SECPTransferInput, TransferableInput};
-pub use message::{AvaxMessage, Message};
+pub use layout::{ETH_TX_SIZE_BUDGET, TX_SIZE_BUDGET};
+pub use message::{AvaxMessage, Message, MAX_ASCII_LEN};
 pub use network_info::*;
 pub use node_id::*;
 pub use object_list::ObjectList;
+#[cfg(any(test, fuzzing))]
+pub use object_list::{parsed_objects, reset_parsed_objects};
+#[cfg(fuzzing)]
+pub use object_list::listed_objects;
 pub use operations::{Operation, TransferableOp};
 pub use outputs::{
     NFTMintOutput, NFTTransferOutput, Output, OutputType, SECPMintOutput, SECPOutputOwners,
@@ -78,6 +94,12 @@ pub use validator::*;
 #[cfg(feature = "erc721")]
 pub use coreth::{data::ERC721Info, nft_info::NftInfo};
 
+#[cfg(feature = "known-calls")]
+pub use coreth::data::{AbiKind, AbiParam, KnownCall};
+
+#[cfg(feature = "policy")]
+pub use policy::{Policy, PolicyCheck};
+
 ///This trait defines the interface useful in the UI context
 /// so that all the different OperationTypes or other items can handle their own UI
 pub trait DisplayableItem {
@@ -138,4 +160,23 @@ pub trait FromBytes<'b>: Sized {
         input: &'b [u8],
         out: &mut MaybeUninit<Self>,
     ) -> Result<&'b [u8], nom::Err<ParserError>>;
+
+    ///Checks that `input` starts with a valid serialized object,
+    ///without keeping it around
+    ///
+    /// returns the remaining bytes on success, like [`FromBytes::from_bytes_into`]
+    ///
+    /// This is what [`ObjectList`] and [`Defer`] use to find out
+    /// the length of their objects, so implementors that can check
+    /// their input without building the object (fixed-size fields, slices...)
+    /// are encouraged to override it, to save the stack and the writes
+    /// of the throwaway object.
+    ///
+    /// The default implementation parses the object and discards it,
+    /// and any override must accept and reject exactly the same inputs
+    #[inline(never)]
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        let mut out = MaybeUninit::uninit();
+        Self::from_bytes_into(input, &mut out)
+    }
 }
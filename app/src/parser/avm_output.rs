@@ -13,7 +13,7 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use core::ops::Deref;
+use core::ops::{Deref, DerefMut};
 
 use crate::parser::{
     error::ParserError, DisplayableItem, FromBytes, NFTMintOutput, NFTTransferOutput, Output,
@@ -42,6 +42,12 @@ impl<'b> Deref for AvmOutput<'b> {
     }
 }
 
+impl<'b> DerefMut for AvmOutput<'b> {
+    fn deref_mut(&mut self) -> &mut Self::Target {
+        &mut self.0
+    }
+}
+
 impl<'b> FromBytes<'b> for AvmOutput<'b> {
     #[inline(never)]
     fn from_bytes_into(
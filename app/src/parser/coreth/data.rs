@@ -16,9 +16,10 @@
 
 use core::mem::MaybeUninit;
 
-use zemu_sys::ViewError;
-
-use crate::parser::{Address, DisplayableItem, ParserError};
+use crate::{
+    handlers::resources::AppContext,
+    parser::{Address, ParserError, ETH_ARG_LEN, U32_SIZE},
+};
 
 mod asset_call;
 mod contract_call;
@@ -34,14 +35,35 @@ mod erc721;
 #[cfg(feature = "erc721")]
 pub use erc721::{ERC721Info, ERC721};
 
+#[cfg(feature = "known-calls")]
+mod known_call;
+#[cfg(feature = "known-calls")]
+pub use known_call::{AbiKind, AbiParam, KnownCall, KnownContractCall};
+
 use super::native::parse_rlp_item;
 pub use asset_call::AssetCall;
 pub use contract_call::ContractCall;
 pub use deploy::Deploy;
 
+#[derive(Clone, Copy, PartialEq, Eq)]
+#[cfg_attr(test, derive(Debug))]
+pub struct CallDataInfo;
+
+impl CallDataInfo {
+    /// Returns the full length of the calldata
+    /// if it was cropped while uploaded to the device
+    pub fn cropped_len() -> Option<usize> {
+        match unsafe { AppContext::current() }.eth_stream.acquire(Self) {
+            Ok(Some(stream)) => stream.cropped_len(),
+            _ => None,
+        }
+    }
+}
+
 #[avalanche_app_derive::enum_init]
 #[derive(Clone, Copy, PartialEq, Eq)]
 #[cfg_attr(any(test, feature = "derive-debug"), derive(Debug))]
+#[derive(avalanche_app_derive::DisplayableItem)]
 pub enum EthData<'b> {
     None, // empty data
     Deploy(Deploy<'b>),
@@ -51,6 +73,8 @@ pub enum EthData<'b> {
     Erc20(ERC20<'b>),
     #[cfg(feature = "erc721")]
     Erc721(ERC721<'b>),
+    #[cfg(feature = "known-calls")]
+    KnownCall(KnownContractCall<'b>),
 }
 
 impl<'b> EthData<'b> {
@@ -61,6 +85,12 @@ impl<'b> EthData<'b> {
     ) -> Result<&'b [u8], ParserError> {
         // parse the rlp data
         let (rem, data) = parse_rlp_item(input)?;
+
+        if let Some(len) = CallDataInfo::cropped_len() {
+            Self::parse_cropped(to, data, len, out)?;
+            return Ok(rem);
+        }
+
         match (to, data.is_empty()) {
             (None, true) => {
                 // invalid condition as no address means
@@ -82,29 +112,48 @@ impl<'b> EthData<'b> {
                     Self::parse_asset_call(data, out)?
                 } else {
                     // chain contract parsing, prioritizing ERC-721
-                    // if it fails try ERC-20, otherwise default to
-                    // a generic contract call
-                    cfg_if::cfg_if! {
-                        if #[cfg(all(feature = "erc721", feature = "erc20"))] {
-                            Self::parse_erc721(to, data, out)
-                                .or_else(|_| Self::parse_erc20(data, out))
-                                .or_else(|_| Self::parse_contract_call(data, out))?;
-                        } else if #[cfg(feature = "erc721")] {
-                            Self::parse_erc721(to, data, out)
-                                .or_else(|_| Self::parse_contract_call(data, out))?;
-                        } else if #[cfg(feature = "erc20")] {
-                            Self::parse_erc20(data, out)
-                                .or_else(|_| Self::parse_contract_call(data, out))?;
-                        } else {
-                            Self::parse_contract_call(data, out)?;
-                        }
-                    }
+                    // if it fails try ERC-20 and the known calls,
+                    // otherwise default to a generic contract call
+                    Self::parse_erc721(to, data, out)
+                        .or_else(|_| Self::parse_erc20(data, out))
+                        .or_else(|_| Self::parse_known_call(data, out))
+                        .or_else(|_| Self::parse_contract_call(data, out))?;
                 }
             }
         };
         Ok(rem)
     }
 
+    /// Only the first bytes of the calldata were kept,
+    /// so it can just be shown as a deploy or a generic contract call
+    fn parse_cropped(
+        to: &Option<Address<'b>>,
+        data: &'b [u8],
+        full_len: usize,
+        out: &mut MaybeUninit<Self>,
+    ) -> Result<(), ParserError> {
+        match to {
+            None => Self::parse_deploy(data, out),
+            Some(to) => {
+                // asset calls have to be verified entirely
+                if AssetCall::is_asset_call(to, data) {
+                    return Err(ParserError::InvalidAssetCall);
+                }
+
+                // the contract call parser can only check
+                // the arguments of the kept bytes
+                let args_len = full_len
+                    .checked_sub(U32_SIZE)
+                    .ok_or(ParserError::UnexpectedBufferEnd)?;
+                if args_len % ETH_ARG_LEN != 0 {
+                    return Err(ParserError::UnexpectedBufferEnd);
+                }
+
+                Self::parse_contract_call(data, out)
+            }
+        }
+    }
+
     fn parse_none(out: &mut MaybeUninit<Self>) {
         out.write(Self::None);
     }
@@ -138,6 +187,11 @@ impl<'b> EthData<'b> {
         Self::init_as_erc_20(|erc20| ERC20::parse_into(data, erc20), out)
     }
 
+    #[cfg(not(feature = "erc20"))]
+    fn parse_erc20(_: &'b [u8], _: &mut MaybeUninit<Self>) -> Result<(), ParserError> {
+        Err(ParserError::InvalidEthSelector)
+    }
+
     #[cfg(feature = "erc721")]
     fn parse_erc721(
         contract_address: &Address<'b>,
@@ -154,45 +208,34 @@ impl<'b> EthData<'b> {
         )
     }
 
-    fn parse_contract_call(data: &'b [u8], out: &mut MaybeUninit<Self>) -> Result<(), ParserError> {
+    #[cfg(not(feature = "erc721"))]
+    fn parse_erc721(
+        _: &Address<'b>,
+        _: &'b [u8],
+        _: &mut MaybeUninit<Self>,
+    ) -> Result<(), ParserError> {
+        Err(ParserError::InvalidEthSelector)
+    }
+
+    #[cfg(feature = "known-calls")]
+    fn parse_known_call(data: &'b [u8], out: &mut MaybeUninit<Self>) -> Result<(), ParserError> {
         if data.is_empty() {
             return Err(ParserError::NoData);
         }
 
-        Self::init_as_contract_call(|cc| ContractCall::parse_into(data, cc), out)
+        Self::init_as_known_call(|call| KnownContractCall::parse_into(data, call), out)
     }
-}
 
-impl<'b> DisplayableItem for EthData<'b> {
-    fn num_items(&self) -> Result<u8, ViewError> {
-        match self {
-            Self::None => Ok(0),
-            Self::Deploy(d) => d.num_items(),
-            Self::AssetCall(d) => d.num_items(),
-            #[cfg(feature = "erc20")]
-            Self::Erc20(d) => d.num_items(),
-            #[cfg(feature = "erc721")]
-            Self::Erc721(d) => d.num_items(),
-            Self::ContractCall(d) => d.num_items(),
-        }
+    #[cfg(not(feature = "known-calls"))]
+    fn parse_known_call(_: &'b [u8], _: &mut MaybeUninit<Self>) -> Result<(), ParserError> {
+        Err(ParserError::InvalidEthSelector)
     }
 
-    fn render_item(
-        &self,
-        item_n: u8,
-        title: &mut [u8],
-        message: &mut [u8],
-        page: u8,
-    ) -> Result<u8, ViewError> {
-        match self {
-            Self::None => Err(ViewError::NoData),
-            Self::Deploy(d) => d.render_item(item_n, title, message, page),
-            Self::AssetCall(d) => d.render_item(item_n, title, message, page),
-            #[cfg(feature = "erc20")]
-            Self::Erc20(d) => d.render_item(item_n, title, message, page),
-            #[cfg(feature = "erc721")]
-            Self::Erc721(d) => d.render_item(item_n, title, message, page),
-            Self::ContractCall(d) => d.render_item(item_n, title, message, page),
+    fn parse_contract_call(data: &'b [u8], out: &mut MaybeUninit<Self>) -> Result<(), ParserError> {
+        if data.is_empty() {
+            return Err(ParserError::NoData);
         }
+
+        Self::init_as_contract_call(|cc| ContractCall::parse_into(data, cc), out)
     }
 }
@@ -22,7 +22,7 @@ use zemu_sys::ViewError;
 
 use crate::{
     checked_add,
-    handlers::{handle_ui_message, resources::NFT_INFO},
+    handlers::{handle_ui_message, resources::AppContext},
     parser::{
         Address, AssetId, DisplayableItem, FromBytes, NftInfo, ParserError, ADDRESS_LEN,
         ETH_ARG_LEN,
@@ -36,7 +36,7 @@ pub struct ERC721Info;
 
 impl ERC721Info {
     pub fn get_nft_info() -> Result<&'static NftInfo, ParserError> {
-        match unsafe { NFT_INFO.acquire(Self) } {
+        match unsafe { AppContext::current() }.nft_info.acquire(Self) {
             Ok(Some(some)) => Ok(some),
             _ => Err(ParserError::NftInfoNotProvided),
         }
@@ -45,9 +45,10 @@ impl ERC721Info {
     #[cfg(test)]
     pub fn set_info(info: NftInfo) -> Result<(), ParserError> {
         // store the information use to parse erc721 token
-        unsafe {
-            NFT_INFO.lock(Self).replace(info);
-        }
+        unsafe { AppContext::current() }
+            .nft_info
+            .lock(Self)
+            .replace(info);
         Ok(())
     }
 }
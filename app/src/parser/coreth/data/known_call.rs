@@ -0,0 +1,444 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use core::{convert::TryFrom, mem::MaybeUninit};
+
+use bolos::{pic_str, PIC};
+use nom::number::complete::be_u32;
+use zemu_sys::ViewError;
+
+use crate::{
+    handlers::{eth::u256, handle_ui_message},
+    parser::{DisplayableItem, ParserError, ADDRESS_LEN, ETH_ARG_LEN},
+    utils::hex_encode,
+};
+
+/// ABI type of a parameter of a [`KnownCall`]
+#[derive(Clone, Copy, PartialEq, Eq)]
+#[cfg_attr(any(test, feature = "derive-debug"), derive(Debug))]
+pub enum AbiKind {
+    Address,
+    Bool,
+    /// Unsigned integer of the given bits
+    Uint(u16),
+    /// Fixed size byte array of the given length
+    FixedBytes(u8),
+    AddressArray,
+    UintArray(u16),
+}
+
+impl AbiKind {
+    fn is_array(&self) -> bool {
+        matches!(self, Self::AddressArray | Self::UintArray(_))
+    }
+
+    /// Checks the padding of a word encoding a value of this type,
+    /// or of its elements for arrays
+    fn is_valid(&self, word: &[u8]) -> bool {
+        let (padding, value) = match *self {
+            Self::Address | Self::AddressArray => word.split_at(ETH_ARG_LEN - ADDRESS_LEN),
+            Self::Bool => word.split_at(ETH_ARG_LEN - 1),
+            Self::Uint(bits) | Self::UintArray(bits) => {
+                word.split_at(ETH_ARG_LEN - bits as usize / 8)
+            }
+            // padded on the right instead
+            Self::FixedBytes(len) => {
+                let (value, padding) = word.split_at(len as usize);
+                (padding, value)
+            }
+        };
+
+        let bool_ok = *self != Self::Bool || value[0] <= 1;
+
+        bool_ok && padding.iter().all(|b| *b == 0)
+    }
+}
+
+/// A parameter of a [`KnownCall`]
+#[derive(Clone, Copy, PartialEq, Eq)]
+#[cfg_attr(any(test, feature = "derive-debug"), derive(Debug))]
+pub struct AbiParam {
+    pub name: &'static [u8],
+    pub kind: AbiKind,
+}
+
+avalanche_app_derive::known_calls! {
+    /// Contract functions commonly called on the C-Chain
+    /// whose arguments can be shown
+    #[cfg_attr(any(test, feature = "derive-debug"), derive(Debug))]
+    pub enum KnownCall {
+        // WAVAX
+        "deposit()",
+        "withdraw(uint256 wad)",
+        // Uniswap V2 like routers (Trader Joe, Pangolin)
+        "swapExactTokensForTokens(uint256 amountIn, uint256 amountOutMin, address[] path, address to, uint256 deadline)",
+        "swapTokensForExactTokens(uint256 amountOut, uint256 amountInMax, address[] path, address to, uint256 deadline)",
+        "swapExactAVAXForTokens(uint256 amountOutMin, address[] path, address to, uint256 deadline)",
+        "swapAVAXForExactTokens(uint256 amountOut, address[] path, address to, uint256 deadline)",
+        "swapExactTokensForAVAX(uint256 amountIn, uint256 amountOutMin, address[] path, address to, uint256 deadline)",
+        "swapTokensForExactAVAX(uint256 amountOut, uint256 amountInMax, address[] path, address to, uint256 deadline)",
+        "addLiquidityAVAX(address token, uint256 amountTokenDesired, uint256 amountTokenMin, uint256 amountAVAXMin, address to, uint256 deadline)",
+        "removeLiquidityAVAX(address token, uint256 liquidity, uint256 amountTokenMin, uint256 amountAVAXMin, address to, uint256 deadline)",
+        // liquid staking (sAVAX)
+        "submit()",
+        "requestUnlock(uint256 shareAmount)",
+        "redeem(uint256 unlockIndex)",
+        "cancelUnlockRequest(uint256 unlockIndex)",
+    }
+}
+
+/// A call to a [`KnownCall`] function, with its arguments
+/// decoded following the ABI layout of the function
+#[derive(Clone, Copy, PartialEq, Eq)]
+#[cfg_attr(any(test, feature = "derive-debug"), derive(Debug))]
+pub struct KnownContractCall<'b> {
+    function: KnownCall,
+    args: &'b [u8],
+}
+
+impl<'b> KnownContractCall<'b> {
+    pub fn parse_into(data: &'b [u8], output: &mut MaybeUninit<Self>) -> Result<(), ParserError> {
+        let (args, selector) = be_u32(data)?;
+        let function = KnownCall::from_selector(selector).ok_or(ParserError::InvalidEthSelector)?;
+
+        let this = Self { function, args };
+
+        // check every value and that there are no trailing bytes,
+        // so what's shown is all there is
+        let mut end = function
+            .num_params()
+            .checked_mul(ETH_ARG_LEN)
+            .ok_or(ParserError::ValueOutOfRange)?;
+        let mut num_items = 1u8;
+
+        for i in 0..function.num_params() {
+            let (param, values) = this.param(i)?;
+
+            if values.len() % ETH_ARG_LEN != 0 {
+                return Err(ParserError::UnexpectedBufferEnd);
+            }
+            if !values.chunks(ETH_ARG_LEN).all(|w| param.kind.is_valid(w)) {
+                return Err(ParserError::InvalidEthMessage);
+            }
+
+            if param.kind.is_array() {
+                let values_end = values.as_ptr() as usize - args.as_ptr() as usize + values.len();
+                end = end.max(values_end);
+            }
+
+            let items = u8::try_from(values.len() / ETH_ARG_LEN)
+                .map_err(|_| ParserError::ValueOutOfRange)?;
+            num_items = num_items
+                .checked_add(items)
+                .ok_or(ParserError::ValueOutOfRange)?;
+        }
+
+        if end != args.len() {
+            return Err(ParserError::UnexpectedBufferEnd);
+        }
+
+        output.write(this);
+
+        Ok(())
+    }
+
+    /// Returns the parameter `index` along with the words of its value,
+    /// which for arrays are the elements
+    fn param(&self, index: usize) -> Result<(AbiParam, &'b [u8]), ParserError> {
+        let param = self
+            .function
+            .param(index)
+            .ok_or(ParserError::ValueOutOfRange)?;
+
+        let head = index * ETH_ARG_LEN;
+        let word = self
+            .args
+            .get(head..head + ETH_ARG_LEN)
+            .ok_or(ParserError::UnexpectedBufferEnd)?;
+
+        if !param.kind.is_array() {
+            return Ok((param, word));
+        }
+
+        // the head holds the offset of the length,
+        // followed by the elements
+        let offset = Self::word_as_usize(word)?;
+        let len_word = offset
+            .checked_add(ETH_ARG_LEN)
+            .and_then(|end| self.args.get(offset..end))
+            .ok_or(ParserError::UnexpectedBufferEnd)?;
+        let len = Self::word_as_usize(len_word)?;
+
+        let start = offset + ETH_ARG_LEN;
+        let values = len
+            .checked_mul(ETH_ARG_LEN)
+            .and_then(|size| start.checked_add(size))
+            .and_then(|end| self.args.get(start..end))
+            .ok_or(ParserError::UnexpectedBufferEnd)?;
+
+        Ok((param, values))
+    }
+
+    fn word_as_usize(word: &[u8]) -> Result<usize, ParserError> {
+        let (padding, value) = word.split_at(ETH_ARG_LEN - 4);
+        if padding.iter().any(|b| *b != 0) {
+            return Err(ParserError::ValueOutOfRange);
+        }
+
+        let (_, value) = be_u32(value)?;
+        Ok(value as usize)
+    }
+
+    fn render_title(name: &[u8], element: Option<usize>, title: &mut [u8]) {
+        use lexical_core::{write as itoa, Number};
+
+        // keep the null terminator
+        let max = title.len().saturating_sub(1);
+        let mut sz = 0;
+        let mut push = |bytes: &[u8]| {
+            let len = bytes.len().min(max - sz);
+            title[sz..sz + len].copy_from_slice(&bytes[..len]);
+            sz += len;
+        };
+
+        push(name);
+        if let Some(i) = element {
+            let mut buffer = [0; u64::FORMATTED_SIZE_DECIMAL];
+
+            push(pic_str!(b"["));
+            push(itoa(i as u64, &mut buffer));
+            push(pic_str!(b"]"));
+        }
+    }
+
+    fn render_value(
+        kind: AbiKind,
+        word: &[u8],
+        message: &mut [u8],
+        page: u8,
+    ) -> Result<u8, ViewError> {
+        match kind {
+            AbiKind::Address | AbiKind::AddressArray => {
+                Self::render_hex(&word[ETH_ARG_LEN - ADDRESS_LEN..], message, page)
+            }
+            AbiKind::FixedBytes(len) => Self::render_hex(&word[..len as usize], message, page),
+            AbiKind::Bool => {
+                let value = if word[ETH_ARG_LEN - 1] == 1 {
+                    pic_str!(b"true"!)
+                } else {
+                    pic_str!(b"false"!)
+                };
+
+                handle_ui_message(value, message, page)
+            }
+            AbiKind::Uint(_) | AbiKind::UintArray(_) => {
+                let mut bytes = [0; u256::FORMATTED_SIZE_DECIMAL + 1];
+                let bytes = u256::pic_from_big_endian()(word).to_lexical(&mut bytes);
+
+                handle_ui_message(bytes, message, page)
+            }
+        }
+    }
+
+    fn render_hex(value: &[u8], message: &mut [u8], page: u8) -> Result<u8, ViewError> {
+        let prefix = pic_str!(b"0x"!);
+        let mut out = [0; ETH_ARG_LEN * 2 + 2];
+        out[..prefix.len()].copy_from_slice(prefix);
+
+        let sz = prefix.len()
+            + hex_encode(value, &mut out[prefix.len()..]).map_err(|_| ViewError::Unknown)?;
+
+        handle_ui_message(&out[..sz], message, page)
+    }
+}
+
+impl<'b> DisplayableItem for KnownContractCall<'b> {
+    fn num_items(&self) -> Result<u8, ViewError> {
+        let mut items = 1u8;
+        for i in 0..self.function.num_params() {
+            let (_, values) = self.param(i).map_err(|_| ViewError::Unknown)?;
+            items = items
+                .checked_add((values.len() / ETH_ARG_LEN) as u8)
+                .ok_or(ViewError::Unknown)?;
+        }
+
+        Ok(items)
+    }
+
+    #[inline(never)]
+    fn render_item(
+        &self,
+        item_n: u8,
+        title: &mut [u8],
+        message: &mut [u8],
+        page: u8,
+    ) -> Result<u8, ViewError> {
+        if item_n == 0 {
+            let label = pic_str!(b"Method");
+            title[..label.len()].copy_from_slice(label);
+
+            return handle_ui_message(self.function.name(), message, page);
+        }
+
+        // find the value the item belongs to
+        let mut item = (item_n - 1) as usize;
+        for i in 0..self.function.num_params() {
+            let (param, values) = self.param(i).map_err(|_| ViewError::Unknown)?;
+            let len = values.len() / ETH_ARG_LEN;
+
+            if item < len {
+                let element = param.kind.is_array().then_some(item);
+                Self::render_title(param.name, element, title);
+
+                let word = &values[item * ETH_ARG_LEN..][..ETH_ARG_LEN];
+                return Self::render_value(param.kind, word, message, page);
+            }
+
+            item -= len;
+        }
+
+        Err(ViewError::NoData)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::{string::String, vec::Vec};
+
+    fn word(value: &[u8]) -> [u8; ETH_ARG_LEN] {
+        let mut word = [0; ETH_ARG_LEN];
+        word[ETH_ARG_LEN - value.len()..].copy_from_slice(value);
+        word
+    }
+
+    fn call(selector: u32, words: &[[u8; ETH_ARG_LEN]]) -> Vec<u8> {
+        let mut data = selector.to_be_bytes().to_vec();
+        words.iter().for_each(|w| data.extend_from_slice(w));
+        data
+    }
+
+    fn parse(data: &[u8]) -> Result<KnownContractCall<'_>, ParserError> {
+        let mut out = MaybeUninit::uninit();
+        KnownContractCall::parse_into(data, &mut out)?;
+        Ok(unsafe { out.assume_init() })
+    }
+
+    fn items(call: &KnownContractCall) -> Vec<String> {
+        (0..call.num_items().unwrap())
+            .map(|i| {
+                let mut title = [0; 32];
+                let mut message = [0; 128];
+                call.render_item(i, &mut title, &mut message, 0).unwrap();
+
+                let str = |b: &[u8]| {
+                    let len = b.iter().position(|b| *b == 0).unwrap_or(b.len());
+                    String::from_utf8(b[..len].to_vec()).unwrap()
+                };
+                std::format!("{}: {}", str(&title), str(&message))
+            })
+            .collect()
+    }
+
+    #[test]
+    fn selectors() {
+        for (selector, function) in [
+            (0xd0e30db0, KnownCall::Deposit),
+            (0x2e1a7d4d, KnownCall::Withdraw),
+            (0x38ed1739, KnownCall::SwapExactTokensForTokens),
+            (0xa2a1623d, KnownCall::SwapExactAvaxForTokens),
+            (0x5bcb2fc6, KnownCall::Submit),
+        ] {
+            assert_eq!(function.selector(), selector);
+            assert_eq!(KnownCall::from_selector(selector), Some(function));
+        }
+
+        // ERC-20 transfer
+        assert_eq!(KnownCall::from_selector(0xa9059cbb), None);
+    }
+
+    #[test]
+    fn withdraw() {
+        let data = call(0x2e1a7d4d, &[word(&[0x03, 0xe8])]);
+        let call = parse(&data).unwrap();
+
+        assert_eq!(items(&call), ["Method: withdraw", "wad: 1000"]);
+
+        // missing or extra arguments
+        assert!(parse(&data[..data.len() - 1]).is_err());
+        assert!(parse(&[&data[..], &word(&[])].concat()).is_err());
+    }
+
+    #[test]
+    fn swap_path() {
+        let path = [word(&[0xAA; ADDRESS_LEN]), word(&[0xBB; ADDRESS_LEN])];
+        let data = call(
+            0xa2a1623d,
+            &[
+                word(&[5]),
+                // offset of the path
+                word(&[4 * 32]),
+                word(&[0xCC; ADDRESS_LEN]),
+                word(&[0x64]),
+                word(&[2]),
+                path[0],
+                path[1],
+            ],
+        );
+        let call = parse(&data).unwrap();
+
+        let items = items(&call);
+        assert_eq!(items.len(), 6);
+        assert_eq!(items[1], "amountOutMin: 5");
+        assert_eq!(
+            items[2],
+            std::format!("path[0]: 0x{}", "aa".repeat(ADDRESS_LEN))
+        );
+        assert!(items[3].starts_with("path[1]: 0xbb"));
+        assert_eq!(items[5], "deadline: 100");
+
+        // path out of bounds
+        let mut bad = data.clone();
+        bad[4 + 2 * 32 - 1] = 5 * 32;
+        assert!(parse(&bad).is_err());
+
+        // dirty address padding
+        let mut bad = data.clone();
+        bad[4 + 2 * 32] = 1;
+        assert!(parse(&bad).is_err());
+    }
+
+    // the calldata of the pangolin_contract_call case of zemu/tests/eth_legacy.test.ts,
+    // these are the screens its snapshots show on `full` builds
+    #[test]
+    fn pangolin_swap() {
+        const DATA: &str = "8a657e670000000000000000000000000000000000000000000000000de0b6b3a76400000000000000000000000000000000000000000000000000000000000000000080000000000000000000000000c7b9b39ab3081ac34fc4324e3f648b55528871970000000000000000000000000000000000000000000000000000017938e114be0000000000000000000000000000000000000000000000000000000000000002000000000000000000000000b31f66aa3c1e785363f0875a1b74e27b85fd66c7000000000000000000000000ba7deebbfc5fa1100fb055a87773e1e99cd3507a";
+
+        let data = hex::decode(DATA).unwrap();
+        let call = parse(&data).unwrap();
+
+        assert_eq!(
+            items(&call),
+            [
+                "Method: swapAVAXForExactTokens",
+                "amountOut: 1000000000000000000",
+                "path[0]: 0xb31f66aa3c1e785363f0875a1b74e27b85fd66c7",
+                "path[1]: 0xba7deebbfc5fa1100fb055a87773e1e99cd3507a",
+                "to: 0xc7b9b39ab3081ac34fc4324e3f648b5552887197",
+                "deadline: 1620156945598",
+            ]
+        );
+    }
+}
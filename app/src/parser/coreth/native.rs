@@ -20,10 +20,7 @@ use zemu_sys::ViewError;
 
 use crate::{
     handlers::{eth::u256, handle_ui_message},
-    parser::{
-        intstr_to_fpstr_inplace, DisplayableItem, FromBytes, ParserError, EIP1559_TX, EIP2930_TX,
-        U64_SIZE,
-    },
+    parser::{intstr_to_fpstr_inplace, FromBytes, ParserError, EIP1559_TX, EIP2930_TX, U64_SIZE},
 };
 
 mod legacy;
@@ -161,6 +158,7 @@ impl EthTransaction__Type {
 // as it would cause unalignment issues
 // with the OutputType tag
 #[cfg_attr(test, derive(Debug))]
+#[derive(avalanche_app_derive::DisplayableItem)]
 pub enum EthTransaction<'b> {
     Legacy(Legacy<'b>),
     Eip1559(Eip1559<'b>),
@@ -185,25 +183,44 @@ impl<'b> EthTransaction<'b> {
     }
 }
 
-impl<'b> FromBytes<'b> for EthTransaction<'b> {
-    fn from_bytes_into(
-        input: &'b [u8],
+impl<'b> EthTransaction<'b> {
+    /// Parses the items of the rlp list of a transaction,
+    /// without the type and the list header
+    ///
+    /// `tx_type` is the EIP-2718 type, None for legacy transactions,
+    /// see [`Self::raw_tx_type`].
+    /// It can't be told from the items, as a legacy transaction
+    /// starts with its nonce, which could be a valid type.
+    ///
+    /// This is how transactions are kept while uploaded to the device,
+    /// see `handlers::eth::signing::TxStream`
+    #[inline(never)]
+    pub fn from_body_into(
+        tx_type: Option<u8>,
+        tx_bytes: &'b [u8],
         out: &mut core::mem::MaybeUninit<Self>,
     ) -> Result<&'b [u8], nom::Err<ParserError>> {
-        // get transaction data as the eip2718 defines transactions structure as follow:
-        // version || rlp[tx_fields]
-        // version for eip1559 = 2,
-        // for eip2930 = 1,
-        // for legacy it does not have a version
-        let (rem, tx_type) = EthTransaction__Type::from_bytes(input)?;
-
-        // parse rlp[] part in order to get the transaction bytes
-        let (rem, tx_bytes) = parse_rlp_item(rem)?;
+        let tx_type = match tx_type {
+            None => EthTransaction__Type::Legacy,
+            Some(EIP1559_TX) => EthTransaction__Type::Eip1559,
+            Some(EIP2930_TX) => EthTransaction__Type::Eip2930,
+            Some(_) => return Err(ParserError::InvalidTransactionType.into()),
+        };
 
         if tx_bytes.is_empty() {
             return Err(ParserError::UnexpectedBufferEnd.into());
         }
 
+        Self::parse_fields_into(tx_type, tx_bytes, out)?;
+
+        Ok(&[])
+    }
+
+    fn parse_fields_into(
+        tx_type: EthTransaction__Type,
+        tx_bytes: &'b [u8],
+        out: &mut core::mem::MaybeUninit<Self>,
+    ) -> Result<(), nom::Err<ParserError>> {
         match tx_type {
             EthTransaction__Type::Legacy => {
                 let out = out.as_mut_ptr() as *mut Legacy__Variant;
@@ -254,31 +271,33 @@ impl<'b> FromBytes<'b> for EthTransaction<'b> {
                 }
             }
         }
-        Ok(rem)
+
+        Ok(())
     }
 }
 
-impl<'b> DisplayableItem for EthTransaction<'b> {
-    fn num_items(&self) -> Result<u8, ViewError> {
-        match self {
-            Self::Legacy(t) => t.num_items(),
-            Self::Eip1559(t) => t.num_items(),
-            Self::Eip2930(t) => t.num_items(),
-        }
-    }
+impl<'b> FromBytes<'b> for EthTransaction<'b> {
+    fn from_bytes_into(
+        input: &'b [u8],
+        out: &mut core::mem::MaybeUninit<Self>,
+    ) -> Result<&'b [u8], nom::Err<ParserError>> {
+        // get transaction data as the eip2718 defines transactions structure as follow:
+        // version || rlp[tx_fields]
+        // version for eip1559 = 2,
+        // for eip2930 = 1,
+        // for legacy it does not have a version
+        let (rem, tx_type) = EthTransaction__Type::from_bytes(input)?;
 
-    fn render_item(
-        &self,
-        item_n: u8,
-        title: &mut [u8],
-        message: &mut [u8],
-        page: u8,
-    ) -> Result<u8, ViewError> {
-        match self {
-            Self::Legacy(t) => t.render_item(item_n, title, message, page),
-            Self::Eip1559(t) => t.render_item(item_n, title, message, page),
-            Self::Eip2930(t) => t.render_item(item_n, title, message, page),
+        // parse rlp[] part in order to get the transaction bytes
+        let (rem, tx_bytes) = parse_rlp_item(rem)?;
+
+        if tx_bytes.is_empty() {
+            return Err(ParserError::UnexpectedBufferEnd.into());
         }
+
+        Self::parse_fields_into(tx_type, tx_bytes, out)?;
+
+        Ok(rem)
     }
 }
 
@@ -289,6 +308,7 @@ mod tests {
     use zemu_sys::Viewable;
 
     use super::*;
+    use crate::parser::DisplayableItem;
 
     impl Viewable for EthTransaction<'static> {
         fn num_items(&mut self) -> Result<u8, zemu_sys::ViewError> {
@@ -314,6 +334,45 @@ mod tests {
         }
     }
 
+    fn parse_body(tx_type: Option<u8>, body: &[u8]) -> EthTransaction<'_> {
+        let mut tx = core::mem::MaybeUninit::uninit();
+        EthTransaction::from_body_into(tx_type, body, &mut tx).unwrap();
+        unsafe { tx.assume_init() }
+    }
+
+    #[test]
+    fn parse_legacy_tx_body() {
+        let data = "ed018504e3b292008252089428ee52a8f3d6e5d15f8b131996950d7f296c7952872bd72a248740008082a86a8080";
+        let mut data = hex::decode(data).unwrap();
+
+        // the nonce, right after the list header, is a single byte item
+        // which could be mistaken for a tx type
+        for nonce in [0x80, 0x01, 0x02, 0x7F] {
+            data[1] = nonce;
+
+            let (_, tx) = EthTransaction::from_bytes(&data).unwrap();
+            assert!(matches!(tx, EthTransaction::Legacy(_)));
+
+            // skip the rlp list header
+            let body = parse_body(None, &data[1..]);
+            assert_eq!(tx, body);
+        }
+    }
+
+    #[test]
+    fn parse_typed_tx_body() {
+        // legacy tx above, with an empty access list, as EIP-2930
+        let data = "01ec82a86a018504e3b292008252089428ee52a8f3d6e5d15f8b131996950d7f296c7952872bd72a2487400080c0";
+        let data = hex::decode(data).unwrap();
+
+        let (_, tx) = EthTransaction::from_bytes(&data).unwrap();
+        assert!(matches!(tx, EthTransaction::Eip2930(_)));
+
+        // skip the type and the rlp list header
+        let body = parse_body(Some(EIP2930_TX), &data[2..]);
+        assert_eq!(tx, body);
+    }
+
     #[test]
     #[cfg(feature = "full")]
     //isolation is enabled by defalt in miri
@@ -401,6 +401,58 @@ impl<'b> Eip1559<'b> {
         }
     }
 
+    #[inline(never)]
+    #[cfg(feature = "known-calls")]
+    fn render_known_call(
+        &self,
+        item_n: u8,
+        title: &mut [u8],
+        message: &mut [u8],
+        page: u8,
+    ) -> Result<u8, ViewError> {
+        let call = match self.data {
+            EthData::KnownCall(call) => call,
+            _ => unsafe { core::hint::unreachable_unchecked() },
+        };
+
+        let num_items = call.num_items()?;
+        if item_n < num_items {
+            return call.render_item(item_n, title, message, page);
+        }
+
+        // the transfer is only shown for payable calls
+        let render_funding = !self.value.is_empty();
+        match item_n - num_items + !render_funding as u8 {
+            0 => {
+                let label = pic_str!(b"Transfer");
+                title[..label.len()].copy_from_slice(label);
+
+                let curr = pic_str!(b"AVAX "!);
+                let (prefix, message) = message.split_at_mut(curr.len());
+                prefix.copy_from_slice(curr);
+
+                render_u256(&self.value, WEI_AVAX_DIGITS, message, page)
+            }
+            1 => {
+                let label = pic_str!(b"Contract");
+                title[..label.len()].copy_from_slice(label);
+
+                // should not panic as address was check
+                self.to
+                    .as_ref()
+                    .apdu_unwrap()
+                    .render_eth_address(message, page)
+            }
+            2 => {
+                let label = pic_str!(b"Maximun Fee(GWEI)");
+                title[..label.len()].copy_from_slice(label);
+
+                self.render_fee(message, page)
+            }
+            _ => Err(ViewError::NoData),
+        }
+    }
+
     fn render_fee(&self, message: &mut [u8], page: u8) -> Result<u8, ViewError> {
         let mut bytes = [0; u256::FORMATTED_SIZE_DECIMAL + 2];
 
@@ -438,6 +490,14 @@ impl<'b> DisplayableItem for Eip1559<'b> {
             // address, fee
             #[cfg(feature = "erc721")]
             EthData::Erc721(d) => checked_add!(ViewError::Unknown, 2u8, d.num_items()?),
+            // call items, transfer (if value != zero), contract address, fee
+            #[cfg(feature = "known-calls")]
+            EthData::KnownCall(d) => checked_add!(
+                ViewError::Unknown,
+                2u8,
+                d.num_items()?,
+                !self.value.is_empty() as u8
+            ),
         }
     }
 
@@ -457,6 +517,8 @@ impl<'b> DisplayableItem for Eip1559<'b> {
             EthData::Erc20(..) => self.render_erc20_call(item_n, title, message, page),
             #[cfg(feature = "erc721")]
             EthData::Erc721(..) => self.render_erc721_call(item_n, title, message, page),
+            #[cfg(feature = "known-calls")]
+            EthData::KnownCall(..) => self.render_known_call(item_n, title, message, page),
         }
     }
 }
@@ -34,6 +34,17 @@ impl<'b> PersonalMsg<'b> {
     fn msg(&self) -> &[u8] {
         self.0.msg()
     }
+
+    /// Parses the message from its preview, see [`Message::preview_from_bytes_into`]
+    pub fn preview_from_bytes_into(
+        input: &'b [u8],
+        out: &mut MaybeUninit<Self>,
+    ) -> Result<&'b [u8], nom::Err<crate::parser::ParserError>> {
+        let out = out.as_mut_ptr();
+
+        let msg = unsafe { &mut *addr_of_mut!((*out).0).cast() };
+        Message::preview_from_bytes_into(input, msg)
+    }
 }
 
 impl<'b> FromBytes<'b> for PersonalMsg<'b> {
@@ -14,7 +14,7 @@
 *  limitations under the License.
 ********************************************************************************/
 
-use core::ops::Deref;
+use core::ops::{Deref, DerefMut};
 
 use core::{mem::MaybeUninit, ptr::addr_of_mut};
 use nom::number::complete::{be_u32, be_u64};
@@ -49,6 +49,12 @@ impl<'b> Deref for EOutput<'b> {
     }
 }
 
+impl<'b> DerefMut for EOutput<'b> {
+    fn deref_mut(&mut self) -> &mut Self::Target {
+        &mut self.0
+    }
+}
+
 impl<'b> FromBytes<'b> for EOutput<'b> {
     #[inline(never)]
     fn from_bytes_into(
@@ -67,8 +67,7 @@ where
     ) -> Result<&'b [u8], nom::Err<ParserError>> {
         let len = input.len();
 
-        let mut object = MaybeUninit::uninit();
-        let left = Obj::from_bytes_into(input, &mut object)?;
+        let left = Obj::validate(input)?;
 
         let (_, data) = take(len - left.len())(input)?;
 
@@ -79,6 +78,10 @@ where
 
         Ok(left)
     }
+
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        Obj::validate(input)
+    }
 }
 
 impl<'b, Obj> DisplayableItem for Defer<'b, Obj>
@@ -0,0 +1,426 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! [`proptest`] strategies producing well-formed, encoded transaction parts
+//!
+//! Each strategy yields the bytes of the object, ready to be parsed,
+//! with its size bounded by the given ranges so that callers can
+//! build synthetic transactions of the shape they're interested in.
+use std::prelude::v1::*;
+
+use proptest::{collection::vec, prelude::*, sample::SizeRange};
+
+use crate::parser::{
+    SECPOutputOwners, SECPTransferInput, SECPTransferOutput, ADDRESS_LEN, AVM_OPERATION_TX,
+    TRANSFER_TX,
+};
+
+const ASSET_ID_LEN: usize = 32;
+const TX_ID_LEN: usize = 32;
+const NFT_TRANSFER_OP: u32 = 0x0d;
+
+/// Network and blockchain id of the fuji X-chain
+pub const FUJI_X_HEADER: [u8; 36] = [
+    0x00, 0x00, 0x00, 0x05, 0xab, 0x68, 0xeb, 0x1e, 0xe1, 0x42, 0xa0, 0x5c, 0xfe, 0x76, 0x8c, 0x36,
+    0xe1, 0x1f, 0x0b, 0x59, 0x6d, 0xb5, 0xa3, 0xc6, 0xc7, 0x7a, 0xab, 0xe6, 0x65, 0xda, 0xd9, 0xe6,
+    0x38, 0xca, 0x94, 0xf7,
+];
+
+/// Largest amount of a generated output, small enough for
+/// the sum of all outputs to be covered by any generated input
+pub const MAX_OUTPUT_AMOUNT: u64 = 1_000_000_000;
+const MIN_INPUT_AMOUNT: u64 = 1 << 40;
+
+fn push_list(out: &mut Vec<u8>, items: &[Vec<u8>]) {
+    out.extend_from_slice(&(items.len() as u32).to_be_bytes());
+    items.iter().for_each(|item| out.extend_from_slice(item));
+}
+
+fn addresses(num: impl Into<SizeRange>) -> impl Strategy<Value = Vec<[u8; ADDRESS_LEN]>> {
+    vec(any::<[u8; ADDRESS_LEN]>(), num)
+}
+
+// locktime | threshold | addresses
+fn owners_body(num_addresses: impl Into<SizeRange>) -> impl Strategy<Value = Vec<u8>> {
+    (any::<u64>(), addresses(num_addresses))
+        .prop_flat_map(|(locktime, addresses)| {
+            (Just(locktime), 0..=addresses.len() as u32, Just(addresses))
+        })
+        .prop_map(|(locktime, threshold, addresses)| {
+            let mut out = locktime.to_be_bytes().to_vec();
+            out.extend_from_slice(&threshold.to_be_bytes());
+            out.extend_from_slice(&(addresses.len() as u32).to_be_bytes());
+            addresses.iter().for_each(|a| out.extend_from_slice(a));
+            out
+        })
+}
+
+/// A [`SECPOutputOwners`] with the given number of addresses
+pub fn secp_output_owners(num_addresses: impl Into<SizeRange>) -> impl Strategy<Value = Vec<u8>> {
+    owners_body(num_addresses).prop_map(|body| {
+        let mut out = SECPOutputOwners::TYPE_ID.to_be_bytes().to_vec();
+        out.extend(body);
+        out
+    })
+}
+
+/// A [`SECPTransferOutput`] with the given number of addresses
+pub fn secp_transfer_output(num_addresses: impl Into<SizeRange>) -> impl Strategy<Value = Vec<u8>> {
+    // an output with no addresses can't have a threshold
+    let num_addresses = num_addresses.into();
+    let min = core::cmp::max(1, num_addresses.start());
+    let max = core::cmp::max(min, num_addresses.end_incl());
+
+    (1..=MAX_OUTPUT_AMOUNT, owners_body(min..=max)).prop_map(|(amount, body)| {
+        let mut out = SECPTransferOutput::TYPE_ID.to_be_bytes().to_vec();
+        out.extend_from_slice(&amount.to_be_bytes());
+        out.extend(body);
+        out
+    })
+}
+
+/// A `TransferableOutput` of a [`SECPTransferOutput`]
+pub fn transferable_output(num_addresses: impl Into<SizeRange>) -> impl Strategy<Value = Vec<u8>> {
+    (
+        any::<[u8; ASSET_ID_LEN]>(),
+        secp_transfer_output(num_addresses),
+    )
+        .prop_map(|(asset_id, output)| {
+            let mut out = asset_id.to_vec();
+            out.extend(output);
+            out
+        })
+}
+
+/// A `TransferableInput` of a [`SECPTransferInput`],
+/// with the given number of address indices
+pub fn transferable_input(num_indices: impl Into<SizeRange>) -> impl Strategy<Value = Vec<u8>> {
+    (
+        any::<[u8; TX_ID_LEN]>(),
+        any::<u32>(),
+        any::<[u8; ASSET_ID_LEN]>(),
+        MIN_INPUT_AMOUNT..=2 * MIN_INPUT_AMOUNT,
+        vec(any::<u32>(), num_indices),
+    )
+        .prop_map(|(tx_id, utxo_index, asset_id, amount, indices)| {
+            let mut out = tx_id.to_vec();
+            out.extend_from_slice(&utxo_index.to_be_bytes());
+            out.extend_from_slice(&asset_id);
+            out.extend_from_slice(&SECPTransferInput::TYPE_ID.to_be_bytes());
+            out.extend_from_slice(&amount.to_be_bytes());
+            out.extend_from_slice(&(indices.len() as u32).to_be_bytes());
+            indices
+                .iter()
+                .for_each(|i| out.extend_from_slice(&i.to_be_bytes()));
+            out
+        })
+}
+
+/// Shape of a generated transaction
+#[derive(Debug, Clone, Copy)]
+pub struct Shape {
+    pub outputs: usize,
+    pub inputs: usize,
+    /// Addresses of each output
+    pub addresses: usize,
+}
+
+/// `BaseTxFields` with exactly the outputs, inputs and addresses of `shape`
+pub fn base_tx_fields(shape: Shape) -> impl Strategy<Value = Vec<u8>> {
+    (
+        vec(transferable_output(shape.addresses), shape.outputs),
+        // there's always at least one input, to pay for the outputs
+        vec(transferable_input(1..4), core::cmp::max(1, shape.inputs)),
+        vec(any::<u8>(), 0..=256),
+    )
+        .prop_map(|(outputs, inputs, memo)| {
+            let mut out = Vec::new();
+            push_list(&mut out, &outputs);
+            push_list(&mut out, &inputs);
+            out.extend_from_slice(&(memo.len() as u32).to_be_bytes());
+            out.extend(memo);
+            out
+        })
+}
+
+/// An X-chain `Transfer` transaction, including the codec
+pub fn transfer_tx(shape: Shape) -> impl Strategy<Value = Vec<u8>> {
+    base_tx_fields(shape).prop_map(|base| {
+        let mut out = vec![0, 0];
+        out.extend_from_slice(&TRANSFER_TX.to_be_bytes());
+        out.extend_from_slice(&FUJI_X_HEADER);
+        out.extend(base);
+        out
+    })
+}
+
+/// A `TransferableOp` of a `NFTTransferOperation`
+/// spending `num_utxos`, with the given number of addresses
+pub fn nft_transfer_op(
+    num_utxos: impl Into<SizeRange>,
+    num_addresses: impl Into<SizeRange>,
+) -> impl Strategy<Value = Vec<u8>> {
+    (
+        any::<[u8; ASSET_ID_LEN]>(),
+        vec((any::<[u8; TX_ID_LEN]>(), any::<u32>()), num_utxos),
+        vec(any::<u32>(), 0..4),
+        any::<u32>(),
+        "[a-zA-Z0-9 ]{0,64}",
+        owners_body(num_addresses),
+    )
+        .prop_map(|(asset_id, utxos, indices, group_id, payload, owners)| {
+            let mut out = asset_id.to_vec();
+
+            out.extend_from_slice(&(utxos.len() as u32).to_be_bytes());
+            for (tx_id, idx) in utxos {
+                out.extend_from_slice(&tx_id);
+                out.extend_from_slice(&idx.to_be_bytes());
+            }
+
+            out.extend_from_slice(&NFT_TRANSFER_OP.to_be_bytes());
+            out.extend_from_slice(&(indices.len() as u32).to_be_bytes());
+            indices
+                .iter()
+                .for_each(|i| out.extend_from_slice(&i.to_be_bytes()));
+
+            // NFTTransferOutput, without the type
+            out.extend_from_slice(&group_id.to_be_bytes());
+            out.extend_from_slice(&(payload.len() as u32).to_be_bytes());
+            out.extend_from_slice(payload.as_bytes());
+            out.extend(owners);
+            out
+        })
+}
+
+/// An X-chain `OperationTx`, including the codec,
+/// with `num_ops` operations spending `num_utxos` each
+pub fn operation_tx(
+    shape: Shape,
+    num_ops: usize,
+    num_utxos: usize,
+) -> impl Strategy<Value = Vec<u8>> {
+    (
+        base_tx_fields(shape),
+        vec(nft_transfer_op(num_utxos, shape.addresses), num_ops),
+    )
+        .prop_map(|(base, ops)| {
+            let mut out = vec![0, 0];
+            out.extend_from_slice(&AVM_OPERATION_TX.to_be_bytes());
+            out.extend_from_slice(&FUJI_X_HEADER);
+            out.extend(base);
+            push_list(&mut out, &ops);
+            out
+        })
+}
+
+/// Generates a single value out of `strategy`, deterministically
+pub fn sample<S: Strategy>(strategy: S) -> S::Value {
+    use proptest::{
+        strategy::ValueTree,
+        test_runner::{Config, RngAlgorithm, TestRng, TestRunner},
+    };
+
+    let rng = TestRng::from_seed(RngAlgorithm::ChaCha, &[0x42; 32]);
+    let mut runner = TestRunner::new_with_rng(Config::default(), rng);
+
+    strategy
+        .new_tree(&mut runner)
+        .expect("generate value")
+        .current()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    use crate::parser::{
+        parsed_objects, reset_parsed_objects, snapshots_common::with_leaked, DisplayableItem,
+        Transaction,
+    };
+
+    /// Work done for a transaction, in objects parsed by [`crate::parser::ObjectList`]
+    #[derive(Debug, Clone, Copy)]
+    struct Cost {
+        bytes: usize,
+        parse: usize,
+        review: usize,
+        pages: usize,
+    }
+
+    impl Cost {
+        fn review_per_page(&self) -> usize {
+            self.review / self.pages
+        }
+    }
+
+    fn measure(data: Vec<u8>) -> Cost {
+        let bytes = data.len();
+
+        let test = |data| {
+            reset_parsed_objects();
+            let tx = Transaction::new(data).expect("parse generated tx");
+            let parse = parsed_objects();
+
+            reset_parsed_objects();
+            let mut driver = zuit::MockDriver::<_, 18, 1024>::new(tx);
+            driver.drive();
+            let review = parsed_objects();
+
+            let pages = driver.out_ui().iter().map(|item| item.len()).sum();
+
+            Cost {
+                bytes,
+                parse,
+                review,
+                pages,
+            }
+        };
+
+        unsafe { with_leaked(data, test) }
+    }
+
+    /// Measures the transactions generated for each size,
+    /// asserting that doubling the size never more than doubles `cost`
+    fn assert_linear<S: Strategy<Value = Vec<u8>>>(
+        name: &str,
+        sizes: &[usize],
+        tx: impl Fn(usize) -> S,
+        cost: impl Fn(&Cost) -> usize,
+    ) {
+        let costs = sizes
+            .iter()
+            .map(|&n| (n, measure(sample(tx(n)))))
+            .collect::<Vec<_>>();
+
+        for (n, c) in &costs {
+            std::println!("{}: n = {} {:?}", name, n, c);
+        }
+
+        for pair in costs.windows(2) {
+            let ((n, prev), (next_n, next)) = (pair[0], pair[1]);
+            assert_eq!(next_n, 2 * n, "sizes should double");
+
+            assert!(
+                cost(&next) <= 2 * cost(&prev),
+                "{}: cost grows superlinearly from {:?} to {:?}",
+                name,
+                prev,
+                next
+            );
+        }
+    }
+
+    fn shape(outputs: usize, addresses: usize) -> Shape {
+        Shape {
+            outputs,
+            inputs: outputs,
+            addresses,
+        }
+    }
+
+    const SIZES: &[usize] = &[1, 2, 4, 8, 16, 32, 64];
+
+    #[test]
+    #[cfg_attr(miri, ignore)]
+    fn transfer_scaling() {
+        assert_linear(
+            "parse/outputs",
+            SIZES,
+            |n| transfer_tx(shape(n, 1)),
+            |c| c.parse,
+        );
+
+        // every item looks its output up from the last one,
+        // so the whole review is linear, not only each page
+        assert_linear(
+            "review/outputs",
+            SIZES,
+            |n| transfer_tx(shape(n, 1)),
+            |c| c.review,
+        );
+
+        assert_linear(
+            "review/addresses",
+            SIZES,
+            |n| transfer_tx(shape(2, n)),
+            |c| c.review,
+        );
+    }
+
+    #[test]
+    #[cfg_attr(miri, ignore)]
+    fn operation_scaling() {
+        let sizes = &SIZES[..6];
+
+        assert_linear(
+            "parse/operations",
+            sizes,
+            |n| operation_tx(shape(1, 1), n, 1),
+            |c| c.parse,
+        );
+
+        assert_linear(
+            "parse/utxos",
+            sizes,
+            |n| operation_tx(shape(1, 1), 2, n),
+            |c| c.parse,
+        );
+
+        assert_linear(
+            "review/operations",
+            sizes,
+            |n| operation_tx(shape(1, 1), n, 1),
+            Cost::review_per_page,
+        );
+    }
+
+    #[cfg(not(miri))]
+    proptest! {
+        #[test]
+        fn generated_transfer(
+            tx in (0..16usize, 0..16usize, 1..8usize)
+                .prop_flat_map(|(outputs, inputs, addresses)| {
+                    transfer_tx(Shape { outputs, inputs, addresses })
+                })
+        ) {
+            let tx = Transaction::new(&tx).expect("parse generated tx");
+            prop_assert!(matches!(tx, Transaction::Transfer(_)));
+            prop_assert!(tx.num_items().is_ok());
+        }
+
+        #[test]
+        fn generated_operation(
+            tx in (0..8usize, 1..8usize, 0..8usize, 1..8usize)
+                .prop_flat_map(|(outputs, addresses, ops, utxos)| {
+                    let shape = Shape { outputs, inputs: 1, addresses };
+                    operation_tx(shape, ops, utxos)
+                })
+        ) {
+            let tx = Transaction::new(&tx).expect("parse generated tx");
+            prop_assert!(matches!(tx, Transaction::XOperation(_)));
+            prop_assert!(tx.num_items().is_ok());
+        }
+
+        #[test]
+        fn generated_owners(owners in secp_output_owners(0..32)) {
+            use core::mem::MaybeUninit;
+            use crate::parser::FromBytes;
+
+            let mut out = MaybeUninit::uninit();
+            let rem = SECPOutputOwners::from_bytes_into(&owners, &mut out).expect("parse owners");
+            prop_assert!(rem.is_empty());
+        }
+    }
+}
@@ -68,4 +68,11 @@ impl<'b> FromBytes<'b> for InitialState<'b> {
 
         Ok(rem)
     }
+
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        let (rem, id) = be_u32(input)?;
+        FxId::try_from(id)?;
+
+        ObjectList::<AvmOutput>::validate(rem)
+    }
 }
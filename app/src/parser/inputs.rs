@@ -198,6 +198,7 @@ struct SECPTransferVariant<'b>(InputType, SECPTransferInput<'b>);
 // with the InputType tag
 #[repr(u8)]
 #[cfg_attr(test, derive(Debug))]
+#[derive(avalanche_app_derive::DisplayableItem)]
 pub enum Input<'b> {
     SECPTransfer(SECPTransferInput<'b>),
 }
@@ -241,27 +242,6 @@ impl<'b> FromBytes<'b> for Input<'b> {
     }
 }
 
-impl<'a> DisplayableItem for Input<'a> {
-    fn num_items(&self) -> Result<u8, ViewError> {
-        match self {
-            Self::SECPTransfer(t) => t.num_items(),
-        }
-    }
-
-    #[inline(never)]
-    fn render_item(
-        &self,
-        item_n: u8,
-        title: &mut [u8],
-        message: &mut [u8],
-        page: u8,
-    ) -> Result<u8, ViewError> {
-        match self {
-            Self::SECPTransfer(t) => t.render_item(item_n, title, message, page),
-        }
-    }
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -0,0 +1,173 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Memory budgets of the parsed transactions
+//!
+//! A parsed transaction lives in RAM for the whole review, next to its hash,
+//! and is built on the stack first, so its size is checked at compile time.
+//! The device targets are all 32-bit, and so are the builds of `armbench`.
+//! The budgets of 64-bit hosts are twice as large, as most of a
+//! transaction are slices and offsets, but they are still checked by
+//! every host build, `cargo test` included.
+//!
+//! `make rust_type_sizes` (or `just type-sizes` for every device)
+//! prints the layout computed by rustc for each target, while
+//! the test below reports the size of every parser struct on the host.
+
+use core::mem::size_of;
+
+use super::{EthTransaction, Transaction};
+
+cfg_if::cfg_if! {
+    if #[cfg(target_pointer_width = "32")] {
+        /// Upper bound for the size of [`Transaction`] on the device
+        pub const TX_SIZE_BUDGET: usize = 160;
+
+        /// Upper bound for the size of [`EthTransaction`] on the device
+        pub const ETH_TX_SIZE_BUDGET: usize = 128;
+    } else {
+        /// Upper bound for the size of [`Transaction`] on the host
+        pub const TX_SIZE_BUDGET: usize = 2 * 160;
+
+        /// Upper bound for the size of [`EthTransaction`] on the host
+        pub const ETH_TX_SIZE_BUDGET: usize = 2 * 128;
+    }
+}
+
+const _: () = {
+    assert!(size_of::<Transaction>() <= TX_SIZE_BUDGET);
+    assert!(size_of::<EthTransaction>() <= ETH_TX_SIZE_BUDGET);
+};
+
+#[cfg(test)]
+mod tests {
+    use std::{prelude::v1::*, println};
+
+    use core::mem::align_of;
+
+    use super::*;
+    use crate::parser::*;
+
+    struct Entry {
+        name: &'static str,
+        size: usize,
+        align: usize,
+    }
+
+    fn entry<T>() -> Entry {
+        Entry {
+            name: core::any::type_name::<T>(),
+            size: size_of::<T>(),
+            align: align_of::<T>(),
+        }
+    }
+
+    fn print(title: &str, entries: &[Entry]) {
+        println!("{title}");
+        for e in entries {
+            println!("{:>6} {:>3} {}", e.size, e.align, e.name);
+        }
+    }
+
+    fn transactions() -> Vec<Entry> {
+        let mut entries = std::vec![
+            entry::<AvmImportTx>(),
+            entry::<AvmExportTx>(),
+            entry::<OperationTx>(),
+            entry::<PvmImportTx>(),
+            entry::<PvmExportTx>(),
+            entry::<ImportTx>(),
+            entry::<ExportTx>(),
+            entry::<Transfer>(),
+        ];
+
+        #[cfg(feature = "create-asset")]
+        entries.push(entry::<CreateAssetTx>());
+        #[cfg(feature = "add-validator")]
+        entries.push(entry::<AddValidatorTx>());
+        #[cfg(feature = "add-delegator")]
+        entries.push(entry::<AddDelegatorTx>());
+        #[cfg(feature = "create-chain")]
+        entries.push(entry::<CreateChainTx>());
+        #[cfg(feature = "create-subnet")]
+        entries.push(entry::<CreateSubnetTx>());
+        #[cfg(feature = "add-subnet-validator")]
+        entries.push(entry::<AddSubnetValidatorTx>());
+        #[cfg(feature = "banff")]
+        entries.extend([
+            entry::<RemoveSubnetValidatorTx>(),
+            entry::<TransformSubnetTx>(),
+            entry::<AddPermissionlessValidatorTx>(),
+            entry::<AddPermissionlessDelegatorTx>(),
+        ]);
+
+        entries
+    }
+
+    fn eth_transactions() -> Vec<Entry> {
+        std::vec![
+            entry::<crate::parser::coreth::Legacy>(),
+            entry::<crate::parser::coreth::Eip1559>(),
+            entry::<crate::parser::coreth::Eip2930>(),
+        ]
+    }
+
+    fn components() -> Vec<Entry> {
+        let mut entries = std::vec![
+            entry::<Header>(),
+            entry::<BaseTxFields<PvmOutput>>(),
+            entry::<BaseTxFields<AvmOutput>>(),
+            entry::<ObjectList<TransferableOutput<PvmOutput>>>(),
+            entry::<TransferableOutput<PvmOutput>>(),
+            entry::<TransferableInput>(),
+            entry::<Output>(),
+            entry::<SECPOutputOwners>(),
+            entry::<Defer<SECPOutputOwners>>(),
+            entry::<Validator>(),
+            entry::<SubnetAuth>(),
+            entry::<EthData>(),
+        ];
+
+        #[cfg(feature = "known-calls")]
+        entries.push(entry::<crate::parser::coreth::KnownContractCall>());
+
+        entries
+    }
+
+    #[test]
+    fn type_sizes() {
+        let txs = transactions();
+        let eth = eth_transactions();
+
+        print("transactions", &txs);
+        print("eth transactions", &eth);
+        print("components", &components());
+
+        let tx = entry::<Transaction>();
+        let eth_tx = entry::<EthTransaction>();
+        print("enums", &[tx, eth_tx]);
+
+        // enum_init only adds the tag, padded to the alignment of the variants
+        for (entries, size) in [
+            (&txs, size_of::<Transaction>()),
+            (&eth, size_of::<EthTransaction>()),
+        ] {
+            let largest = entries.iter().map(|e| e.size).max().unwrap();
+            let align = entries.iter().map(|e| e.align).max().unwrap();
+
+            assert!(size <= largest + align);
+        }
+    }
+}
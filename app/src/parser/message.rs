@@ -24,24 +24,53 @@ use zemu_sys::ViewError;
 use crate::{
     handlers::handle_ui_message,
     parser::{error::ParserError, DisplayableItem, FromBytes},
-    utils::ApduPanic,
 };
 use bolos::{pic_str, PIC};
 
 // eth app truncates an ascii
 // message to around this size.
-const MAX_ASCII_LEN: usize = 103;
+pub const MAX_ASCII_LEN: usize = 103;
 
 #[derive(Clone, Copy, PartialEq, Eq)]
 #[cfg_attr(test, derive(Debug))]
-pub struct Message<'b>(&'b [u8]);
+pub struct Message<'b> {
+    // the message, or only its first bytes
+    // if parsed from a preview
+    msg: &'b [u8],
+    len: u32,
+}
 
 impl<'b> Message<'b> {
     pub fn msg(&self) -> &[u8] {
-        // wont panic as this check was done when parsing
-        be_u32::<_, ParserError>(self.0)
-            .map(|(msg, _)| msg)
-            .apdu_unwrap()
+        self.msg
+    }
+
+    /// Parses a message of which only the first bytes were kept,
+    /// structured as: msg.len() as 4-bytes big-endian integer | msg preview
+    ///
+    /// The preview is made of the first [`MAX_ASCII_LEN`] bytes of the message,
+    /// which are all that is shown, see [`crate::utils::MsgStream`]
+    pub fn preview_from_bytes_into(
+        input: &'b [u8],
+        out: &mut MaybeUninit<Self>,
+    ) -> Result<&'b [u8], nom::Err<ParserError>> {
+        crate::sys::zemu_log_stack("Message::preview_from_bytes_into\x00");
+
+        if !input.is_ascii() {
+            return Err(ParserError::InvalidEthMessage.into());
+        }
+
+        let (rem, len) = be_u32(input)?;
+        let (rem, msg) = take(core::cmp::min(len as usize, MAX_ASCII_LEN))(rem)?;
+
+        let out = out.as_mut_ptr();
+
+        unsafe {
+            addr_of_mut!((*out).msg).write(msg);
+            addr_of_mut!((*out).len).write(len);
+        }
+
+        Ok(rem)
     }
 
     fn render_msg(&self, message: &mut [u8], page: u8) -> Result<u8, ViewError> {
@@ -61,7 +90,7 @@ impl<'b> Message<'b> {
             }
         });
 
-        let mut copy_len = if msg.len() > MAX_ASCII_LEN {
+        let mut copy_len = if self.len as usize > MAX_ASCII_LEN {
             render_msg[MAX_ASCII_LEN..].copy_from_slice(&suffix[..]);
             MAX_ASCII_LEN
         } else {
@@ -99,12 +128,13 @@ impl<'b> FromBytes<'b> for Message<'b> {
             return Err(ParserError::InvalidEthMessage.into());
         }
 
-        let (rem, msg) = take(super::U32_SIZE + len as usize)(input)?;
+        let (rem, msg) = take(len as usize)(msg)?;
 
         let out = out.as_mut_ptr();
 
         unsafe {
-            addr_of_mut!((*out).0).write(msg);
+            addr_of_mut!((*out).msg).write(msg);
+            addr_of_mut!((*out).len).write(len);
         }
 
         Ok(rem)
@@ -146,6 +176,20 @@ impl<'b> AvaxMessage<'b> {
         Ok(unsafe { this.assume_init() })
     }
 
+    /// Creates a message from its preview, see [`Message::preview_from_bytes_into`]
+    ///
+    /// The header is expected to have been checked already,
+    /// so it's not part of `data`
+    pub fn from_preview(data: &'b [u8]) -> Result<Self, ParserError> {
+        let mut this = MaybeUninit::<Self>::uninit();
+        let out = this.as_mut_ptr();
+
+        let msg = unsafe { &mut *addr_of_mut!((*out).data).cast() };
+        let _ = Message::preview_from_bytes_into(data, msg)?;
+
+        Ok(unsafe { this.assume_init() })
+    }
+
     pub fn msg(&self) -> &[u8] {
         self.data.msg()
     }
@@ -226,4 +270,31 @@ mod tests {
         let m = std::str::from_utf8(tx.msg()).unwrap();
         assert_eq!(m, DATA);
     }
+
+    #[test]
+    fn parse_msg_preview() {
+        let long = "a".repeat(MAX_ASCII_LEN * 2);
+        let msg_len = (long.len() as u32).to_be_bytes();
+
+        let mut data = std::vec![];
+        data.extend_from_slice(&msg_len[..]);
+        data.extend_from_slice(&long.as_bytes()[..MAX_ASCII_LEN]);
+
+        let preview = AvaxMessage::from_preview(&data).unwrap();
+        assert_eq!(preview.msg(), &long.as_bytes()[..MAX_ASCII_LEN]);
+
+        // the preview renders the same as the whole message
+        let mut full = std::vec::Vec::from(HEADER.as_bytes());
+        full.extend_from_slice(&msg_len[..]);
+        full.extend_from_slice(long.as_bytes());
+        let (_, full) = AvaxMessage::from_bytes(&full).unwrap();
+
+        let (mut title, mut a, mut b) = ([0; 30], [0; 200], [0; 200]);
+        preview.render_item(1, &mut title, &mut a, 0).unwrap();
+        full.render_item(1, &mut title, &mut b, 0).unwrap();
+        assert_eq!(a, b);
+
+        // not enough bytes for the preview
+        assert!(AvaxMessage::from_preview(&data[..MAX_ASCII_LEN]).is_err());
+    }
 }
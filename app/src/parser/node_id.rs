@@ -59,6 +59,11 @@ impl<'b> FromBytes<'b> for NodeId<'b> {
 
         Ok(rem)
     }
+
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<super::ParserError>> {
+        let (rem, _) = take(NODE_ID_LEN)(input)?;
+        Ok(rem)
+    }
 }
 
 impl<'b> DisplayableItem for NodeId<'b> {
@@ -22,6 +22,75 @@ use crate::{
     utils::ApduPanic,
 };
 
+cfg_if::cfg_if! {
+    if #[cfg(fuzzing)] {
+        use core::sync::atomic::{AtomicUsize, Ordering};
+
+        static PARSED_OBJECTS: AtomicUsize = AtomicUsize::new(0);
+        static LISTED_OBJECTS: AtomicUsize = AtomicUsize::new(0);
+
+        #[inline(always)]
+        fn count_parsed() {
+            PARSED_OBJECTS.fetch_add(1, Ordering::Relaxed);
+        }
+
+        #[inline(always)]
+        fn count_listed(num_objs: usize) {
+            LISTED_OBJECTS.fetch_add(num_objs, Ordering::Relaxed);
+        }
+
+        /// Number of objects parsed by every [`ObjectList`]
+        /// since the last [`reset_parsed_objects`]
+        ///
+        /// Used to spot inputs whose cost grows faster than their size
+        pub fn parsed_objects() -> usize {
+            PARSED_OBJECTS.load(Ordering::Relaxed)
+        }
+
+        /// Number of objects in the lists created
+        /// since the last [`reset_parsed_objects`]
+        ///
+        /// That's the size of the input [`parsed_objects`] is compared with
+        pub fn listed_objects() -> usize {
+            LISTED_OBJECTS.load(Ordering::Relaxed)
+        }
+
+        pub fn reset_parsed_objects() {
+            PARSED_OBJECTS.store(0, Ordering::Relaxed);
+            LISTED_OBJECTS.store(0, Ordering::Relaxed);
+        }
+    } else if #[cfg(test)] {
+        // tests run in parallel, so each thread keeps its own count
+        std::thread_local! {
+            static PARSED_OBJECTS: core::cell::Cell<usize> = core::cell::Cell::new(0);
+        }
+
+        #[inline(always)]
+        fn count_parsed() {
+            PARSED_OBJECTS.with(|n| n.set(n.get() + 1));
+        }
+
+        /// Number of objects parsed by every [`ObjectList`] in this thread
+        /// since the last [`reset_parsed_objects`]
+        pub fn parsed_objects() -> usize {
+            PARSED_OBJECTS.with(|n| n.get())
+        }
+
+        pub fn reset_parsed_objects() {
+            PARSED_OBJECTS.with(|n| n.set(0))
+        }
+
+        #[inline(always)]
+        fn count_listed(_: usize) {}
+    } else {
+        #[inline(always)]
+        fn count_parsed() {}
+
+        #[inline(always)]
+        fn count_listed(_: usize) {}
+    }
+}
+
 #[derive(Educe)]
 #[cfg_attr(test, educe(Debug))]
 #[educe(Clone, Copy, PartialEq, Eq)]
@@ -66,14 +135,7 @@ where
         num_objs: usize,
     ) -> Result<&'b [u8], nom::Err<ParserError>> {
         let mut len = input.len();
-        let mut bytes_left = input;
-        let mut object = MaybeUninit::uninit();
-
-        // we are not saving parsed data but ensuring everything
-        // parsed correctly.
-        for _ in 0..num_objs {
-            bytes_left = Obj::from_bytes_into(bytes_left, &mut object)?;
-        }
+        let bytes_left = Self::validate_with_len(input, num_objs)?;
 
         // this calculates the length in bytes of the list of objects
         // using the amount of bytes left after iterating over each parsed element.
@@ -82,6 +144,7 @@ where
         len -= bytes_left.len();
 
         let (rem, data) = take(len)(input)?;
+        count_listed(num_objs);
 
         //good ptr and no uninit reads
         let out = out.as_mut_ptr();
@@ -112,6 +175,40 @@ where
         Self::new_into_with_len(rem, out, num_objects as _)
     }
 
+    /// Checks that the input starts with `num_objs` valid objects,
+    /// returning the remaining bytes
+    ///
+    /// The objects are only validated, see [`FromBytes::validate`]
+    pub fn validate_with_len(
+        input: &'b [u8],
+        num_objs: usize,
+    ) -> Result<&'b [u8], nom::Err<ParserError>> {
+        let mut bytes_left = input;
+
+        // we are not saving parsed data but ensuring everything
+        // parsed correctly.
+        for _ in 0..num_objs {
+            count_parsed();
+            bytes_left = Obj::validate(bytes_left)?;
+        }
+
+        Ok(bytes_left)
+    }
+
+    /// Checks that the input starts with a valid [`ObjectList`],
+    /// returning the remaining bytes
+    ///
+    /// Same as [`ObjectList::new_into`], without building the list
+    pub fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        if input.is_empty() {
+            return Err(ParserError::UnexpectedBufferEnd.into());
+        }
+
+        let (rem, num_objects) = be_u32(input)?;
+
+        Self::validate_with_len(rem, num_objects as _)
+    }
+
     #[inline(never)]
     /// Parses an object into the given location, returning the amount of bytes read.
     ///
@@ -125,6 +222,7 @@ where
             return None;
         }
 
+        count_parsed();
         //ok to panic as we parsed beforehand
         let rem = Obj::from_bytes_into(data, out).apdu_unwrap();
 
@@ -218,6 +316,11 @@ where
         self.read
     }
 
+    /// Returns the bytes of the objects in the list
+    pub fn data(&self) -> &'b [u8] {
+        self.data
+    }
+
     /// Overwrite the internal cursor position
     ///
     /// Intended to be used as a way to reset the cursor, see below.
@@ -365,4 +468,36 @@ mod tests {
         assert_eq!(list.read, 0);
         assert!(num_items > 0);
     }
+
+    #[test]
+    fn object_list_validate() {
+        let rem = ObjectList::<TransferableOutput<AvmOutput>>::validate(DATA).unwrap();
+        assert!(rem.is_empty());
+
+        // the last output is cut short
+        let short = &DATA[..DATA.len() - 1];
+        assert!(ObjectList::<TransferableOutput<AvmOutput>>::validate(short).is_err());
+        assert!(ObjectList::<TransferableOutput<AvmOutput>>::new(short).is_err());
+    }
+
+    #[test]
+    fn validate_agrees_with_parsing() {
+        use crate::parser::SECPOutputOwners;
+
+        // one owner with a threshold of 1, then 2 (only 1 address)
+        let mut data = std::vec![0, 0, 0, 2];
+        for threshold in [1u8, 2] {
+            data.extend_from_slice(&[0, 0, 0, 0x0b, 0, 0, 0, 0, 0, 0, 0, 0]);
+            data.extend_from_slice(&[0, 0, 0, threshold, 0, 0, 0, 1]);
+            data.extend_from_slice(&[0xAA; crate::parser::ADDRESS_LEN]);
+        }
+
+        let mut one = std::vec![0, 0, 0, 1];
+        one.extend_from_slice(&data[4..4 + 40]);
+        let (rem, _) = ObjectList::<SECPOutputOwners>::new(&one).unwrap();
+        assert_eq!(ObjectList::<SECPOutputOwners>::validate(&one).unwrap(), rem);
+
+        let err = ObjectList::<SECPOutputOwners>::new(&data).unwrap_err();
+        assert_eq!(ObjectList::<SECPOutputOwners>::validate(&data), Err(err));
+    }
 }
@@ -13,7 +13,7 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use core::ops::Deref;
+use core::ops::{Deref, DerefMut};
 
 use crate::parser::{Address, AssetId, DisplayableItem, FromBytes, ParserError};
 use crate::sys::ViewError;
@@ -36,7 +36,7 @@ pub use secp_transfer_output::SECPTransferOutput;
 #[cfg_attr(test, derive(Debug))]
 pub struct TransferableOutput<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     asset_id: AssetId<'b>,
     pub output: O,
@@ -44,7 +44,7 @@ where
 
 impl<'b, O> Deref for TransferableOutput<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     type Target = O::Target;
 
@@ -55,7 +55,7 @@ where
 
 impl<'b, O> TransferableOutput<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     pub fn amount(&self) -> Option<u64> {
         (*self.output).amount()
@@ -73,6 +73,27 @@ where
         self.output().num_addresses()
     }
 
+    /// Overrides the amount of a transfer output,
+    /// used to show the total of a group of outputs
+    pub fn set_amount(&mut self, amount: u64) {
+        if let Output::SECPTransfer(ref mut secp) = *self.output {
+            secp.amount = amount;
+        }
+    }
+
+    /// Tells if both outputs only differ in their amount:
+    /// same asset, addresses, locktime and threshold
+    pub fn same_destination(&self, other: &Self) -> bool {
+        let (Some(amount), Some(_)) = (self.amount(), other.amount()) else {
+            return false;
+        };
+
+        let mut other = *other;
+        other.set_amount(amount);
+
+        *self == other
+    }
+
     // Any output whose address match any of the
     // paths in the change_path list should not be
     // rendered, unless the output contains more
@@ -92,7 +113,7 @@ where
 
 impl<'b, O> FromBytes<'b> for TransferableOutput<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     #[inline(never)]
     fn from_bytes_into(
@@ -116,7 +137,7 @@ where
 
 impl<'b, O> DisplayableItem for TransferableOutput<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     fn num_items(&self) -> Result<u8, ViewError> {
         // the asset_id is not part of the summary we need from objects of this type,
@@ -170,6 +191,7 @@ struct SECPOwnersVariant<'b>(OutputType, SECPOutputOwners<'b>);
 // with the OutputType tag
 #[repr(u8)]
 #[cfg_attr(test, derive(Debug))]
+#[derive(avalanche_app_derive::DisplayableItem)]
 pub enum Output<'b> {
     SECPTransfer(SECPTransferOutput<'b>),
     SECPMint(SECPMintOutput<'b>),
@@ -295,35 +317,6 @@ impl<'b> Output<'b> {
     }
 }
 
-impl<'a> DisplayableItem for Output<'a> {
-    fn num_items(&self) -> Result<u8, ViewError> {
-        match self {
-            Self::SECPTransfer(t) => t.num_items(),
-            Self::SECPMint(m) => m.num_items(),
-            Self::NFTTransfer(t) => t.num_items(),
-            Self::NFTMint(m) => m.num_items(),
-            Self::SECPOwners(o) => o.num_items(),
-        }
-    }
-
-    #[inline(never)]
-    fn render_item(
-        &self,
-        item_n: u8,
-        title: &mut [u8],
-        message: &mut [u8],
-        page: u8,
-    ) -> Result<u8, ViewError> {
-        match self {
-            Self::SECPTransfer(t) => t.render_item(item_n, title, message, page),
-            Self::SECPMint(m) => m.render_item(item_n, title, message, page),
-            Self::NFTTransfer(t) => t.render_item(item_n, title, message, page),
-            Self::NFTMint(m) => m.render_item(item_n, title, message, page),
-            Self::SECPOwners(o) => o.render_item(item_n, title, message, page),
-        }
-    }
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
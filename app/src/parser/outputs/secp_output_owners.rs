@@ -107,6 +107,21 @@ impl<'b> FromBytes<'b> for SECPOutputOwners<'b> {
 
         Ok(rem)
     }
+
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        let (rem, _) = tag(Self::TYPE_ID.to_be_bytes())(input)?;
+
+        let (rem, (_, threshold, addr_len)) = tuple((be_u64, be_u32, be_u32))(rem)?;
+
+        // the addresses are taken whole, so their length is always right
+        let (rem, _) = take(addr_len as usize * ADDRESS_LEN)(rem)?;
+
+        if threshold > addr_len {
+            return Err(ParserError::InvalidThreshold.into());
+        }
+
+        Ok(rem)
+    }
 }
 
 impl<'a> DisplayableItem for SECPOutputOwners<'a> {
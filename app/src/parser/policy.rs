@@ -0,0 +1,486 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use core::{convert::TryFrom, mem::MaybeUninit, ptr::addr_of_mut};
+
+use bolos::{pic_str, PIC};
+use nom::{
+    bytes::complete::{tag, take},
+    number::complete::{be_u32, be_u64, be_u8},
+};
+use zemu_sys::ViewError;
+
+use crate::{
+    checked_add,
+    handlers::handle_ui_message,
+    parser::{
+        nano_avax_to_fp_str, Address, AssetId, DisplayableItem, FromBytes, Header, NetworkId,
+        Output, ParserError, Transaction, TransferableInput, ADDRESS_LEN, ASSET_ID_LEN,
+        MAX_ADDRESS_ENCODED_LEN, U64_SIZE,
+    },
+};
+
+pub const POLICY_VERSION: u8 = 2;
+pub const MAX_POLICY_DESTINATIONS: usize = 16;
+pub const MAX_POLICY_ASSETS: usize = 4;
+
+// transaction types a policy can allow,
+// as bits of `Policy::tx_types`
+pub const POLICY_TX_TRANSFER: u8 = 1 << 0;
+pub const POLICY_TX_X_EXPORT: u8 = 1 << 1;
+pub const POLICY_TX_P_EXPORT: u8 = 1 << 2;
+
+const ASSET_CAP_LEN: usize = ASSET_ID_LEN + U64_SIZE;
+
+/// A set of rules under which transactions are signed
+/// without being reviewed
+///
+/// Structured as:
+/// version | network_id | tx_types | num_destinations | destinations | num_caps | (asset_id | cap)
+#[derive(Clone, Copy, PartialEq, Eq)]
+#[cfg_attr(test, derive(Debug))]
+pub struct Policy<'b> {
+    // transactions of other networks are never allowed
+    network_id: NetworkId,
+    tx_types: u8,
+    // addresses that outputs can be sent to
+    destinations: &'b [[u8; ADDRESS_LEN]],
+    // assets that can be spent, each followed
+    // by the max amount spent in a single transaction
+    caps: &'b [u8],
+}
+
+impl<'b> Policy<'b> {
+    pub fn new(data: &'b [u8]) -> Result<Self, ParserError> {
+        let mut this = MaybeUninit::uninit();
+        let rem = Self::from_bytes_into(data, &mut this)?;
+
+        if !rem.is_empty() {
+            return Err(ParserError::UnexpectedData);
+        }
+
+        Ok(unsafe { this.assume_init() })
+    }
+
+    fn cap_at(&self, idx: usize) -> Option<(AssetId<'b>, u64)> {
+        let data = self.caps.chunks_exact(ASSET_CAP_LEN).nth(idx)?;
+
+        let mut asset_id = MaybeUninit::uninit();
+        let rem = AssetId::from_bytes_into(data, &mut asset_id).ok()?;
+        let (_, cap) = be_u64::<_, ParserError>(rem).ok()?;
+
+        Some((unsafe { asset_id.assume_init() }, cap))
+    }
+
+    // index of the cap of the given asset
+    fn cap_idx(&self, asset_id: &AssetId) -> Option<usize> {
+        self.caps
+            .chunks_exact(ASSET_CAP_LEN)
+            .position(|cap| cap[..ASSET_ID_LEN] == asset_id.id()[..])
+    }
+
+    fn num_caps(&self) -> usize {
+        self.caps.len() / ASSET_CAP_LEN
+    }
+
+    /// Returns true if `tx` can be signed without review
+    #[inline(never)]
+    pub fn allows(&self, tx: &Transaction) -> bool {
+        let tx_type = match tx {
+            Transaction::Transfer(_) => POLICY_TX_TRANSFER,
+            Transaction::XExport(_) => POLICY_TX_X_EXPORT,
+            Transaction::PExport(_) => POLICY_TX_P_EXPORT,
+            _ => return false,
+        };
+
+        if self.tx_types & tx_type == 0 {
+            return false;
+        }
+
+        let mut check = PolicyCheck::new(self);
+        tx.check_policy(&mut check);
+
+        check.finish()
+    }
+}
+
+impl<'b> FromBytes<'b> for Policy<'b> {
+    #[inline(never)]
+    fn from_bytes_into(
+        input: &'b [u8],
+        out: &mut MaybeUninit<Self>,
+    ) -> Result<&'b [u8], nom::Err<ParserError>> {
+        crate::sys::zemu_log_stack("Policy::from_bytes_into\x00");
+
+        let (rem, _) = tag([POLICY_VERSION])(input)?;
+        let (rem, network_id) = be_u32(rem)?;
+        let network_id = NetworkId::try_from(network_id)?;
+        let (rem, tx_types) = be_u8(rem)?;
+
+        let (rem, num_destinations) = be_u8(rem)?;
+        if num_destinations as usize > MAX_POLICY_DESTINATIONS {
+            return Err(ParserError::UnexpectedNumberItems.into());
+        }
+        let (rem, destinations) = take(num_destinations as usize * ADDRESS_LEN)(rem)?;
+        let destinations = bytemuck::try_cast_slice(destinations)
+            .map_err(|_| ParserError::InvalidAddressLength)?;
+
+        let (rem, num_caps) = be_u8(rem)?;
+        if num_caps as usize > MAX_POLICY_ASSETS {
+            return Err(ParserError::UnexpectedNumberItems.into());
+        }
+        let (rem, caps) = take(num_caps as usize * ASSET_CAP_LEN)(rem)?;
+
+        //good ptr and no uninit reads
+        let out = out.as_mut_ptr();
+        unsafe {
+            addr_of_mut!((*out).network_id).write(network_id);
+            addr_of_mut!((*out).tx_types).write(tx_types);
+            addr_of_mut!((*out).destinations).write(destinations);
+            addr_of_mut!((*out).caps).write(caps);
+        }
+
+        Ok(rem)
+    }
+}
+
+impl<'b> DisplayableItem for Policy<'b> {
+    fn num_items(&self) -> Result<u8, ViewError> {
+        // allowed transactions, destinations
+        // and 2 items per asset: the id and the cap
+        checked_add!(
+            ViewError::Unknown,
+            1u8,
+            self.destinations.len() as u8,
+            self.num_caps() as u8 * 2
+        )
+    }
+
+    #[inline(never)]
+    fn render_item(
+        &self,
+        item_n: u8,
+        title: &mut [u8],
+        message: &mut [u8],
+        page: u8,
+    ) -> Result<u8, ViewError> {
+        let num_destinations = self.destinations.len() as u8;
+
+        match item_n {
+            0 => {
+                let label = pic_str!(b"Auto-sign");
+                title[..label.len()].copy_from_slice(label);
+
+                let names = [
+                    (POLICY_TX_TRANSFER, pic_str!(b"Transfer"!)),
+                    (POLICY_TX_X_EXPORT, pic_str!(b"X Export"!)),
+                    (POLICY_TX_P_EXPORT, pic_str!(b"P Export"!)),
+                ];
+
+                let separator = pic_str!(b", "!);
+                let mut content = [0; 32];
+                let mut len = 0;
+                for (bit, name) in names.iter() {
+                    if self.tx_types & bit == 0 {
+                        continue;
+                    }
+
+                    if len > 0 {
+                        content[len..len + separator.len()].copy_from_slice(&separator[..]);
+                        len += separator.len();
+                    }
+                    content[len..len + name.len()].copy_from_slice(&name[..]);
+                    len += name.len();
+                }
+
+                if len == 0 {
+                    let none = pic_str!(b"None"!);
+                    content[..none.len()].copy_from_slice(&none[..]);
+                    len = none.len();
+                }
+
+                handle_ui_message(&content[..len], message, page)
+            }
+            x @ 1.. if x <= num_destinations => {
+                let label = pic_str!(b"Destination");
+                title[..label.len()].copy_from_slice(label);
+
+                let data = &self.destinations[x as usize - 1];
+                let mut address = MaybeUninit::uninit();
+                Address::from_bytes_into(data, &mut address).map_err(|_| ViewError::Unknown)?;
+
+                // as shown when reviewing a transaction of the network
+                let mut encoded = [0; MAX_ADDRESS_ENCODED_LEN];
+                let len = unsafe { address.assume_init() }
+                    .encode_into(self.network_id.hrp(), &mut encoded[..])
+                    .map_err(|_| ViewError::Unknown)?;
+
+                handle_ui_message(&encoded[..len], message, page)
+            }
+            x => {
+                let idx = (x - num_destinations - 1) as usize;
+                let (asset_id, cap) = self.cap_at(idx / 2).ok_or(ViewError::NoData)?;
+
+                if idx % 2 == 0 {
+                    return asset_id.render_item(0, title, message, page);
+                }
+
+                use lexical_core::Number;
+
+                let label = pic_str!(b"Max amount");
+                title[..label.len()].copy_from_slice(label);
+
+                let mut buffer = [0; u64::FORMATTED_SIZE_DECIMAL + 2];
+                let cap =
+                    nano_avax_to_fp_str(cap, &mut buffer[..]).map_err(|_| ViewError::Unknown)?;
+
+                handle_ui_message(cap, message, page)
+            }
+        }
+    }
+}
+
+/// Running evaluation of a [`Policy`] over the inputs and outputs of a transaction
+///
+/// What a transaction spends, per asset, is its inputs minus the outputs
+/// returning to the wallet, which covers the fee too.
+pub struct PolicyCheck<'p> {
+    policy: &'p Policy<'p>,
+    // amounts by asset, following the policy caps order
+    inputs: [u64; MAX_POLICY_ASSETS],
+    change: [u64; MAX_POLICY_ASSETS],
+    allowed: bool,
+}
+
+impl<'p> PolicyCheck<'p> {
+    fn new(policy: &'p Policy<'p>) -> Self {
+        Self {
+            policy,
+            inputs: [0; MAX_POLICY_ASSETS],
+            change: [0; MAX_POLICY_ASSETS],
+            allowed: true,
+        }
+    }
+
+    /// Marks the transaction as not allowed
+    pub fn reject(&mut self) {
+        self.allowed = false;
+    }
+
+    /// Rejects transactions of a network other than the policy's
+    pub fn header(&mut self, header: &Header) {
+        if header.network_id() != Ok(self.policy.network_id) {
+            self.reject();
+        }
+    }
+
+    fn add(total: &mut u64, amount: Option<u64>) -> bool {
+        match amount.and_then(|amount| total.checked_add(amount)) {
+            Some(sum) => {
+                *total = sum;
+                true
+            }
+            None => false,
+        }
+    }
+
+    pub fn input(&mut self, input: &TransferableInput) {
+        let idx = match self.policy.cap_idx(input.asset_id()) {
+            Some(idx) => idx,
+            None => return self.reject(),
+        };
+
+        if !Self::add(&mut self.inputs[idx], input.amount()) {
+            self.reject();
+        }
+    }
+
+    /// Every output has to be a transfer that can be spent right away,
+    /// so neither `stake_locked` nor with a locktime, as there's no clock
+    /// on the device to tell if it already passed.
+    ///
+    /// `is_change` tells if the output returns to the wallet,
+    /// otherwise all of its addresses have to be allowed destinations
+    pub fn output(
+        &mut self,
+        asset_id: &AssetId,
+        output: &Output,
+        stake_locked: bool,
+        is_change: bool,
+    ) {
+        let idx = match self.policy.cap_idx(asset_id) {
+            Some(idx) => idx,
+            None => return self.reject(),
+        };
+
+        let secp = match output.secp_transfer() {
+            Some(secp) if secp.locktime == 0 && !stake_locked => secp,
+            _ => return self.reject(),
+        };
+
+        if is_change {
+            if !Self::add(&mut self.change[idx], Some(secp.amount)) {
+                self.reject();
+            }
+
+            return;
+        }
+
+        let destinations = self.policy.destinations;
+        if !secp
+            .addresses
+            .iter()
+            .all(|address| destinations.contains(address))
+        {
+            self.reject();
+        }
+    }
+
+    fn finish(self) -> bool {
+        if !self.allowed {
+            return false;
+        }
+
+        (0..self.policy.num_caps()).all(|idx| {
+            let cap = self.policy.cap_at(idx).map(|(_, cap)| cap);
+
+            match (self.inputs[idx].checked_sub(self.change[idx]), cap) {
+                (Some(spent), Some(cap)) => spent <= cap,
+                _ => false,
+            }
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::SECPTransferOutput;
+
+    const AVAX_ASSET_ID: [u8; ASSET_ID_LEN] = [
+        0x3d, 0x9b, 0xda, 0xc0, 0xed, 0x1d, 0x76, 0x13, 0x30, 0xcf, 0x68, 0x0e, 0xfd, 0xeb, 0x1a,
+        0x42, 0x15, 0x9e, 0xb3, 0x87, 0xd6, 0xd2, 0x95, 0x0c, 0x96, 0xf7, 0xd2, 0x8f, 0x61, 0xbb,
+        0xe2, 0xaa,
+    ];
+
+    fn policy_bytes(destinations: &[[u8; ADDRESS_LEN]], cap: u64) -> std::vec::Vec<u8> {
+        let mut data = std::vec![POLICY_VERSION];
+        data.extend_from_slice(&crate::parser::NETWORK_ID_MAINNET.to_be_bytes());
+        data.push(POLICY_TX_TRANSFER | POLICY_TX_P_EXPORT);
+        data.push(destinations.len() as u8);
+        destinations.iter().for_each(|d| data.extend_from_slice(d));
+        data.push(1);
+        data.extend_from_slice(&AVAX_ASSET_ID);
+        data.extend_from_slice(&cap.to_be_bytes());
+        data
+    }
+
+    #[test]
+    fn parse_policy() {
+        let data = policy_bytes(&[[1; ADDRESS_LEN], [2; ADDRESS_LEN]], 1_000_000_000);
+        let policy = Policy::new(&data).unwrap();
+
+        assert_eq!(policy.destinations.len(), 2);
+        assert_eq!(policy.num_items().unwrap(), 5);
+
+        let (asset_id, cap) = policy.cap_at(0).unwrap();
+        assert_eq!(asset_id.id(), &AVAX_ASSET_ID);
+        assert_eq!(cap, 1_000_000_000);
+        assert!(policy.cap_at(1).is_none());
+
+        // trailing data
+        let mut longer = data.clone();
+        longer.push(0);
+        assert!(Policy::new(&longer).is_err());
+
+        // too many destinations
+        let many = [[0; ADDRESS_LEN]; MAX_POLICY_DESTINATIONS + 1];
+        assert!(Policy::new(&policy_bytes(&many, 0)).is_err());
+    }
+
+    #[test]
+    fn policy_unknown_network() {
+        let mut data = policy_bytes(&[[1; ADDRESS_LEN]], 0);
+        data[1..5].copy_from_slice(&u32::MAX.to_be_bytes());
+        assert!(Policy::new(&data).is_err());
+    }
+
+    fn transfer(amount: u64, locktime: u64, addresses: &[[u8; ADDRESS_LEN]]) -> Output<'_> {
+        Output::SECPTransfer(SECPTransferOutput {
+            amount,
+            locktime,
+            threshold: 1,
+            addresses,
+        })
+    }
+
+    #[test]
+    fn policy_outputs() {
+        let destination = [[1; ADDRESS_LEN]];
+        let other = [[2; ADDRESS_LEN]];
+
+        let data = policy_bytes(&destination, 100);
+        let policy = Policy::new(&data).unwrap();
+        let mut avax = MaybeUninit::uninit();
+        AssetId::from_bytes_into(&AVAX_ASSET_ID, &mut avax).unwrap();
+        let avax = unsafe { avax.assume_init() };
+
+        let check_output = |output: &Output, stake_locked, is_change| {
+            let mut check = PolicyCheck::new(&policy);
+            check.output(&avax, output, stake_locked, is_change);
+            check.allowed
+        };
+
+        assert!(check_output(&transfer(10, 0, &destination), false, false));
+        assert!(!check_output(&transfer(10, 0, &other), false, false));
+        // change can go anywhere in the wallet
+        assert!(check_output(&transfer(10, 0, &other), false, true));
+
+        // but can't be locked, no more than the other outputs
+        for &is_change in &[false, true] {
+            assert!(!check_output(
+                &transfer(10, 1, &destination),
+                false,
+                is_change
+            ));
+            assert!(!check_output(
+                &transfer(10, 0, &destination),
+                true,
+                is_change
+            ));
+        }
+    }
+
+    #[test]
+    fn policy_caps() {
+        let data = policy_bytes(&[[1; ADDRESS_LEN]], 100);
+        let policy = Policy::new(&data).unwrap();
+
+        // spent is inputs minus change
+        let mut check = PolicyCheck::new(&policy);
+        check.inputs[0] = 150;
+        check.change[0] = 50;
+        assert!(check.finish());
+
+        let mut check = PolicyCheck::new(&policy);
+        check.inputs[0] = 151;
+        check.change[0] = 50;
+        assert!(!check.finish());
+
+        let mut check = PolicyCheck::new(&policy);
+        check.reject();
+        assert!(!check.finish());
+    }
+}
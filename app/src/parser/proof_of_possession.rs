@@ -69,6 +69,11 @@ impl<'b> FromBytes<'b> for ProofOfPossession<'b> {
 
         Ok(rem)
     }
+
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        let (rem, _) = take(BLS_PUBKEY_LEN + BLS_SIGNATURE_LEN)(input)?;
+        Ok(rem)
+    }
 }
 
 #[avalanche_app_derive::enum_init]
@@ -21,7 +21,7 @@ use crate::{
         FORMATTED_STR_DATE_LEN,
     },
 };
-use core::ops::Deref;
+use core::ops::{Deref, DerefMut};
 
 use core::{mem::MaybeUninit, ptr::addr_of_mut};
 use nom::{
@@ -52,6 +52,12 @@ impl<'b> Deref for PvmOutput<'b> {
     }
 }
 
+impl<'b> DerefMut for PvmOutput<'b> {
+    fn deref_mut(&mut self) -> &mut Self::Target {
+        &mut self.output
+    }
+}
+
 impl<'b> PvmOutput<'b> {
     const LOCKED_OUTPUT_TAG: u32 = 0x00000016;
 
@@ -65,4 +65,12 @@ impl<'b> FromBytes<'b> for SubnetAuth<'b> {
 
         Ok(rem)
     }
+
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        let (rem, _) = tag(Self::TYPE_ID.to_be_bytes())(input)?;
+        let (rem, num_indices) = be_u32(rem)?;
+
+        let (rem, _) = take(num_indices as usize * U32_SIZE)(rem)?;
+        Ok(rem)
+    }
 }
@@ -30,7 +30,7 @@ mod tx_header;
 
 pub use base_export::BaseExport;
 pub use base_import::BaseImport;
-pub use base_tx_fields::BaseTxFields;
+pub use base_tx_fields::{BaseTxFields, OutputCursor};
 pub use transfer::Transfer;
 pub use tx_header::{Header, BLOCKCHAIN_ID_LEN};
 
@@ -38,9 +38,9 @@ mod avm;
 mod pvm;
 
 use crate::parser::{
-    DisplayableItem, ExportTx as EvmExport, ImportTx as EvmImport, EVM_IMPORT_TX, PVM_EXPORT_TX,
-    PVM_IMPORT_TX,
+    ExportTx as EvmExport, ImportTx as EvmImport, EVM_IMPORT_TX, PVM_EXPORT_TX, PVM_IMPORT_TX,
 };
+use crate::utils::trace::{self, TraceId};
 pub use avm::{AvmExportTx, AvmImportTx, OperationTx};
 pub use pvm::{PvmExportTx, PvmImportTx};
 
@@ -157,6 +157,7 @@ impl TryFrom<(u32, NetworkInfo)> for Transaction__Type {
 #[avalanche_app_derive::enum_init]
 #[derive(Clone, Copy, PartialEq, Eq)]
 #[cfg_attr(test, derive(Debug))]
+#[derive(avalanche_app_derive::DisplayableItem)]
 pub enum Transaction<'b> {
     XImport(AvmImportTx<'b>),
     XExport(AvmExportTx<'b>),
@@ -207,6 +208,8 @@ impl<'b> Transaction<'b> {
     }
 
     pub fn new_into(input: &'b [u8], this: &mut MaybeUninit<Self>) -> Result<(), ParserError> {
+        let _span = trace::span(TraceId::Parse);
+
         let (rem, codec) = be_u16(input)?;
 
         if codec != 0 {
@@ -239,6 +242,16 @@ impl<'b> Transaction<'b> {
         }
     }
 
+    #[cfg(feature = "policy")]
+    pub fn check_policy(&'b self, check: &mut crate::parser::PolicyCheck) {
+        match self {
+            Self::Transfer(tx) => tx.check_policy(check),
+            Self::XExport(tx) => tx.check_policy(check),
+            Self::PExport(tx) => tx.check_policy(check),
+            _ => check.reject(),
+        }
+    }
+
     fn parse(
         input: &'b [u8],
         out: &mut MaybeUninit<Self>,
@@ -325,80 +338,6 @@ impl<'b> Transaction<'b> {
     }
 }
 
-impl<'b> DisplayableItem for Transaction<'b> {
-    fn num_items(&self) -> Result<u8, zemu_sys::ViewError> {
-        match self {
-            Self::XImport(tx) => tx.num_items(),
-            Self::XExport(tx) => tx.num_items(),
-            Self::XOperation(tx) => tx.num_items(),
-            Self::PImport(tx) => tx.num_items(),
-            Self::PExport(tx) => tx.num_items(),
-            Self::CImport(tx) => tx.num_items(),
-            Self::CExport(tx) => tx.num_items(),
-            Self::Transfer(tx) => tx.num_items(),
-            #[cfg(feature = "create-asset")]
-            Self::XAsset(tx) => tx.num_items(),
-            #[cfg(feature = "add-validator")]
-            Self::Validator(tx) => tx.num_items(),
-            #[cfg(feature = "add-subnet-validator")]
-            Self::SubnetValidator(tx) => tx.num_items(),
-            #[cfg(feature = "add-delegator")]
-            Self::Delegator(tx) => tx.num_items(),
-            #[cfg(feature = "create-chain")]
-            Self::CreateChain(tx) => tx.num_items(),
-            #[cfg(feature = "create-subnet")]
-            Self::CreateSubnet(tx) => tx.num_items(),
-            #[cfg(feature = "banff")]
-            Self::RemoveSubnetValidator(tx) => tx.num_items(),
-            #[cfg(feature = "banff")]
-            Self::TransformSubnet(tx) => tx.num_items(),
-            #[cfg(feature = "banff")]
-            Self::PermissionlessValidator(tx) => tx.num_items(),
-            #[cfg(feature = "banff")]
-            Self::PermissionlessDelegator(tx) => tx.num_items(),
-        }
-    }
-
-    fn render_item(
-        &self,
-        item_n: u8,
-        title: &mut [u8],
-        message: &mut [u8],
-        page: u8,
-    ) -> Result<u8, zemu_sys::ViewError> {
-        match self {
-            Self::XImport(tx) => tx.render_item(item_n, title, message, page),
-            Self::XExport(tx) => tx.render_item(item_n, title, message, page),
-            Self::XOperation(tx) => tx.render_item(item_n, title, message, page),
-            Self::PImport(tx) => tx.render_item(item_n, title, message, page),
-            Self::PExport(tx) => tx.render_item(item_n, title, message, page),
-            Self::CImport(tx) => tx.render_item(item_n, title, message, page),
-            Self::CExport(tx) => tx.render_item(item_n, title, message, page),
-            Self::Transfer(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "create-asset")]
-            Self::XAsset(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "add-validator")]
-            Self::Validator(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "add-subnet-validator")]
-            Self::SubnetValidator(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "add-delegator")]
-            Self::Delegator(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "create-chain")]
-            Self::CreateChain(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "create-subnet")]
-            Self::CreateSubnet(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "banff")]
-            Self::RemoveSubnetValidator(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "banff")]
-            Self::TransformSubnet(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "banff")]
-            Self::PermissionlessValidator(tx) => tx.render_item(item_n, title, message, page),
-            #[cfg(feature = "banff")]
-            Self::PermissionlessDelegator(tx) => tx.render_item(item_n, title, message, page),
-        }
-    }
-}
-
 #[cfg(test)]
 mod tests {
     use std::prelude::v1::*;
@@ -406,6 +345,7 @@ mod tests {
     use zemu_sys::Viewable;
 
     use super::*;
+    use crate::parser::DisplayableItem;
 
     /// This is only to be used for testing, hence why
     /// it's present inside the `mod test` block only
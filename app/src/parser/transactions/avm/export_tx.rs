@@ -102,6 +102,12 @@ impl<'b> AvmExportTx<'b> {
     pub fn disable_output_if(&mut self, address: &[u8]) {
         self.0.disable_output_if(address);
     }
+
+    #[cfg(feature = "policy")]
+    pub fn check_policy(&'b self, check: &mut crate::parser::PolicyCheck) {
+        // X-chain outputs can't be stake locked
+        self.0.check_policy(check, |_| false);
+    }
 }
 
 #[cfg(test)]
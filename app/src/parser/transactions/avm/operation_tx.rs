@@ -156,6 +156,11 @@ impl<'b> OperationTx<'b> {
                 handle_ui_message(&encoded[..addr_len], message, page)
             }
 
+            // the total of its group, in expert mode
+            x if x == num_inner_items => {
+                self.base_tx.render_group_total(&obj, title, message, page)
+            }
+
             _ => Err(ViewError::NoData),
         }
     }
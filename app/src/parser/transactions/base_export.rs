@@ -13,7 +13,7 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use core::ops::Deref;
+use core::ops::DerefMut;
 
 use bolos::{pic_str, PIC};
 use core::{convert::TryFrom, mem::MaybeUninit, ptr::addr_of_mut};
@@ -37,7 +37,7 @@ const EXPORT_TX_DESCRIPTION_LEN: usize = 13; //X to C Chain
 #[cfg_attr(test, derive(Debug))]
 pub struct BaseExport<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     pub tx_header: Header<'b>,
     pub base_tx: BaseTxFields<'b, O>,
@@ -51,7 +51,7 @@ where
 
 impl<'b, O> FromBytes<'b> for BaseExport<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     #[inline(never)]
     fn from_bytes_into(
@@ -103,7 +103,7 @@ where
 
 impl<'b, O> BaseExport<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     pub fn disable_output_if(&mut self, address: &[u8]) {
         self.base_tx.disable_output_if(address);
@@ -132,6 +132,24 @@ where
         self.renderable_out = render;
     }
 
+    /// See [`BaseTxFields::check_policy`]
+    #[cfg(feature = "policy")]
+    pub fn check_policy(
+        &'b self,
+        check: &mut crate::parser::PolicyCheck,
+        stake_locked: impl Fn(&O) -> bool,
+    ) {
+        check.header(&self.tx_header);
+        self.base_tx.check_policy(check, &stake_locked);
+
+        let mut idx = 0;
+        self.outputs.iterate_with(|o| {
+            let is_change = self.renderable_out & (1 << idx) == 0;
+            check.output(o.asset_id(), o.output(), stake_locked(&o.output), is_change);
+            idx += 1;
+        });
+    }
+
     // Use the info contained in the transaction header
     // to get the corresponding hrp, useful to encode addresses
     pub fn chain_hrp(&self) -> Result<&'static str, ParserError> {
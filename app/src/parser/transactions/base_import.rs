@@ -13,7 +13,7 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use core::ops::Deref;
+use core::ops::DerefMut;
 
 use bolos::{pic_str, PIC};
 use core::{convert::TryFrom, mem::MaybeUninit, ptr::addr_of_mut};
@@ -41,7 +41,7 @@ const IMPORT_DESCRIPTION_LEN: usize = 8;
 #[cfg_attr(test, derive(Debug))]
 pub struct BaseImport<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     pub tx_header: Header<'b>,
     pub base_tx: BaseTxFields<'b, O>,
@@ -51,7 +51,7 @@ where
 
 impl<'b, O> FromBytes<'b> for BaseImport<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     #[inline(never)]
     fn from_bytes_into(
@@ -95,7 +95,7 @@ where
 
 impl<'b, O> BaseImport<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     pub fn disable_output_if(&mut self, address: &[u8]) {
         self.base_tx.disable_output_if(address);
@@ -170,9 +170,9 @@ where
         message: &mut [u8],
         page: u8,
     ) -> Result<u8, zemu_sys::ViewError> {
-        let (obj, obj_item_n) = self.get_output_with_item(item_n)?;
+        let (output, obj_item_n) = self.get_output_with_item(item_n)?;
         // Base Import/Export only supports secp_transfer types
-        let obj = (*obj).secp_transfer().ok_or(ViewError::NoData)?;
+        let obj = (*output).secp_transfer().ok_or(ViewError::NoData)?;
 
         // get the number of items for the obj wrapped up by PvmOutput
         let num_inner_items = obj.num_items()?;
@@ -204,6 +204,10 @@ where
 
                 handle_ui_message(&encoded[..addr_len], message, page)
             }
+            // the total of its group, in expert mode
+            x if x == num_inner_items => self
+                .base_tx
+                .render_group_total(&output, title, message, page),
             _ => Err(ViewError::NoData),
         }
     }
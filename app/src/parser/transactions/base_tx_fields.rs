@@ -13,24 +13,82 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use core::ops::Deref;
+use core::ops::DerefMut;
 
 use core::{mem::MaybeUninit, ptr::addr_of_mut};
 use nom::{bytes::complete::take, number::complete::be_u32};
 use zemu_sys::ViewError;
 
+use crate::handlers::{handle_ui_message, resources::AppContext};
 use crate::parser::{
-    DisplayableItem, FromBytes, ObjectList, Output, OutputIdx, ParserError, TransferableInput,
-    TransferableOutput,
+    nano_avax_to_fp_str, DisplayableItem, FromBytes, ObjectList, Output, OutputIdx, ParserError,
+    TransferableInput, TransferableOutput,
 };
+use crate::utils::is_app_mode_expert;
 
 const MAX_MEMO_LEN: usize = 256;
 
+/// Where the last output looked up in the ui stage is,
+/// kept in [`AppContext::output_cursor`]
+///
+/// The items are reviewed in order, so starting the next lookup
+/// from here keeps the whole review linear in the number of outputs,
+/// instead of parsing the list again from its start for every item.
+#[derive(Clone, Copy, PartialEq, Eq)]
+pub struct OutputCursor {
+    // the outputs and which of them are shown this is for,
+    // the address is only compared, never read through
+    list: *const u8,
+    len: usize,
+    shown: OutputIdx,
+    // the number of items of the shown outputs, once counted
+    num_items: Option<u8>,
+    // index, offset in the list and first item of the output
+    idx: u32,
+    offset: usize,
+    item: u8,
+}
+
+impl OutputCursor {
+    /// The cursor for the given outputs, at the first one if there's none yet
+    fn get(list: &[u8], shown: OutputIdx) -> Self {
+        //safe: the context isn't accessed by the caller while this runs
+        match unsafe { AppContext::current() }.output_cursor {
+            Some(c) if c.list == list.as_ptr() && c.len == list.len() && c.shown == shown => c,
+            _ => Self {
+                list: list.as_ptr(),
+                len: list.len(),
+                shown,
+                num_items: None,
+                idx: 0,
+                offset: 0,
+                item: 0,
+            },
+        }
+    }
+
+    fn rewind(&mut self) {
+        self.idx = 0;
+        self.offset = 0;
+        self.item = 0;
+    }
+
+    fn store(self) {
+        //safe: the context isn't accessed by the caller while this runs
+        unsafe { AppContext::current() }.output_cursor = Some(self);
+    }
+
+    fn clear() {
+        //safe: the context isn't accessed by the caller while this runs
+        unsafe { AppContext::current() }.output_cursor = None;
+    }
+}
+
 #[derive(Clone, Copy, PartialEq, Eq)]
 #[cfg_attr(test, derive(Debug))]
 pub struct BaseTxFields<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     // lazy parsing of inputs/outpus
     pub outputs: ObjectList<'b, TransferableOutput<'b, O>>,
@@ -38,6 +96,15 @@ where
     // in the ui stage.
     // this is set during the parsing stage.
     renderable_out: OutputIdx,
+    // a bit-wise idx of the outputs that only differ in their amount
+    // from an earlier one, outside expert mode they are folded
+    // into that output, which shows the total amount.
+    // this is set during the parsing stage.
+    folded_out: OutputIdx,
+    // a bit-wise idx of the outputs others are folded into,
+    // in expert mode they are followed by the total of their group.
+    // this is set during the parsing stage.
+    grouped_out: OutputIdx,
     // inputs can be generic as well.
     // but so far, there is only one input
     // across all chains and their transactions.
@@ -49,7 +116,7 @@ where
 
 impl<'b, O> BaseTxFields<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     pub fn disable_output_if(&mut self, address: &[u8]) {
         // skip filtering out outputs if there is only one
@@ -82,6 +149,26 @@ where
         self.renderable_out = render;
     }
 
+    /// Evaluates the policy over the inputs and outputs,
+    /// outputs that are not rendered are returning to the wallet
+    ///
+    /// `stake_locked` tells if an output is locked beyond its locktime
+    #[cfg(feature = "policy")]
+    pub fn check_policy(
+        &'b self,
+        check: &mut crate::parser::PolicyCheck,
+        stake_locked: impl Fn(&O) -> bool,
+    ) {
+        self.inputs.iterate_with(|i| check.input(i));
+
+        let mut idx = 0;
+        self.outputs.iterate_with(|o| {
+            let is_change = self.renderable_out & (1 << idx) == 0;
+            check.output(o.asset_id(), o.output(), stake_locked(&o.output), is_change);
+            idx += 1;
+        });
+    }
+
     pub fn sum_inputs_amount(&self) -> Result<u64, ParserError> {
         self.inputs
             .iter()
@@ -108,7 +195,173 @@ where
         &self.inputs
     }
 
+    // Outputs to show in the ui stage, outputs folded into
+    // an earlier one are only shown in expert mode.
+    fn shown_outputs(&self) -> OutputIdx {
+        if is_app_mode_expert() {
+            self.renderable_out
+        } else {
+            self.renderable_out & !self.folded_out
+        }
+    }
+
+    // Outputs followed by the total of their group in the ui stage,
+    // only in expert mode, as otherwise they show it instead of their amount
+    fn group_summaries(&self) -> OutputIdx {
+        if is_app_mode_expert() {
+            self.grouped_out
+        } else {
+            0
+        }
+    }
+
+    // A byte that sums up where a transfer output goes, the same for
+    // every output that only differs in its amount.
+    // it's a truncated FNV-1a of the asset, locktime, threshold and addresses
+    fn destination_digest(o: &TransferableOutput<'b, O>) -> u8 {
+        // only transfer outputs have an amount, the others are never folded
+        let Some(secp) = o.output().secp_transfer() else {
+            return 0;
+        };
+
+        let mut hash = 0x811c_9dc5u32;
+        let mut add = |bytes: &[u8]| {
+            for b in bytes {
+                hash = (hash ^ *b as u32).wrapping_mul(0x0100_0193);
+            }
+        };
+
+        add(&o.asset_id().id()[..]);
+        add(&secp.locktime.to_be_bytes());
+        add(&secp.threshold.to_be_bytes());
+        secp.addresses.iter().for_each(|address| add(&address[..]));
+
+        hash as u8
+    }
+
+    // Marks every transfer output that goes to the same destination
+    // as an earlier one, see `TransferableOutput::same_destination`,
+    // along with the first output of each destination, which leads its group.
+    fn repeated_outputs(&self) -> (OutputIdx, OutputIdx) {
+        // outputs is defined as an Object List of TransferableOutputs,
+        // when parsing transactions we ensure that it is not longer than
+        // 64, so there's room for all of them
+        // and folded |= 1 << idx never overflows.
+        const MAX_OUTPUTS: usize = OutputIdx::BITS as usize;
+
+        // the digest of each output and where it starts in the list,
+        // an output is only compared with the earlier ones
+        // with the same digest, parsing them again from there,
+        // instead of going through the whole list for each output
+        let mut digests = [0u8; MAX_OUTPUTS];
+        let mut offsets = [0u16; MAX_OUTPUTS];
+        let mut folded: OutputIdx = 0;
+        let mut leaders: OutputIdx = 0;
+
+        let mut list = self.outputs;
+        let mut out = MaybeUninit::uninit();
+        let mut prev = MaybeUninit::uninit();
+        let mut idx = 0;
+
+        unsafe {
+            list.set_data_index(0);
+        }
+
+        loop {
+            let offset = list.data_index();
+            if list.parse_next(&mut out).is_none() {
+                break;
+            }
+            // valid read as memory was initialized
+            let o = unsafe { out.assume_init_ref() };
+            let digest = Self::destination_digest(o);
+
+            // outputs without an amount are never folded
+            let candidates = if o.amount().is_some() { idx } else { 0 };
+
+            for earlier in 0..candidates {
+                if digests[earlier] != digest {
+                    continue;
+                }
+
+                let mut list = self.outputs;
+                // safe: the offset is where that output starts
+                unsafe {
+                    list.set_data_index(offsets[earlier] as usize);
+                }
+                if list.parse_next(&mut prev).is_none() {
+                    break;
+                }
+
+                // valid read as memory was initialized,
+                // the earliest output of the group is the first match
+                if unsafe { prev.assume_init_ref() }.same_destination(o) {
+                    folded |= 1 << idx;
+                    leaders |= 1 << earlier;
+                    break;
+                }
+            }
+
+            // the transaction fits in the upload buffer,
+            // which is less than 64KiB
+            digests[idx] = digest;
+            offsets[idx] = offset as u16;
+            idx += 1;
+        }
+
+        (folded, leaders)
+    }
+
+    // Sum of the amounts of the outputs in the same group as `leader`,
+    // the output at `idx` and `offset` in the list.
+    //
+    // Only the outputs folded after the leader can be in its group,
+    // so the list is only scanned up to the last of them.
+    fn group_amount(
+        &self,
+        leader: &TransferableOutput<'b, O>,
+        idx: u32,
+        offset: usize,
+    ) -> Result<u64, ParserError> {
+        let mut total = leader.amount();
+        let mut folded = self.folded_out.checked_shr(idx + 1).unwrap_or(0);
+
+        let mut list = self.outputs;
+        let mut out = MaybeUninit::uninit();
+        // safe: `offset` is where the leader starts,
+        // so it skips over it
+        unsafe {
+            list.set_data_index(offset);
+        }
+        list.parse_next(&mut out)
+            .ok_or(ParserError::UnexpectedError)?;
+
+        while folded != 0 {
+            list.parse_next(&mut out)
+                .ok_or(ParserError::UnexpectedError)?;
+            // valid read as memory was initialized
+            let o = unsafe { out.assume_init_ref() };
+
+            if folded & 1 == 1 && leader.same_destination(o) {
+                total = total.and_then(|t| t.checked_add(o.amount()?));
+            }
+            folded >>= 1;
+        }
+
+        total.ok_or(ParserError::OperationOverflows)
+    }
+
     pub fn base_outputs_num_items(&'b self) -> Result<u8, ViewError> {
+        let shown = self.shown_outputs();
+        let summaries = self.group_summaries();
+
+        // this is asked for every item rendered,
+        // so it's only counted once for the outputs shown
+        let mut cursor = OutputCursor::get(self.outputs.data(), shown);
+        if let Some(items) = cursor.num_items {
+            return Ok(items);
+        }
+
         let mut items = 0;
         let mut idx = 0;
 
@@ -121,12 +374,14 @@ where
         // 64, as we use that value as a limit for the bitwise operation,
         // this ensures that render ^= 1 << idx never overflows.
         self.outputs.iterate_with(|o| {
-            let render = self.renderable_out & (1 << idx);
+            let render = shown & (1 << idx);
             if render > 0 {
-                match o
-                    .num_items()
-                    .and_then(|a| a.checked_add(items).ok_or(ViewError::Unknown))
-                {
+                let summary = (summaries >> idx) as u8 & 1;
+                match o.num_items().and_then(|a| {
+                    a.checked_add(summary)
+                        .and_then(|a| a.checked_add(items))
+                        .ok_or(ViewError::Unknown)
+                }) {
                     Ok(i) => items = i,
                     Err(_) => err = Some(ViewError::Unknown),
                 }
@@ -137,60 +392,124 @@ where
         if err.is_some() {
             return Err(ViewError::Unknown);
         }
+
+        cursor.num_items = Some(items);
+        cursor.store();
+
         Ok(items)
     }
 
     // Gets the obj that contain the item_n, along with the index
     // of the item. Returns an error otherwise
+    //
+    // In expert mode, the output leading a group has one more item
+    // after its own ones: the total of the group, see `render_group_total`
     pub fn base_output_with_item(
         &'b self,
         item_n: u8,
     ) -> Result<(TransferableOutput<O>, u8), ParserError> {
-        let mut count = 0usize;
-        let mut obj_item_n = 0;
+        let shown = self.shown_outputs();
+        let summaries = self.group_summaries();
+
+        // the lookup starts at the output of the last one,
+        // unless the item is before it
+        let mut cursor = OutputCursor::get(self.outputs.data(), shown);
+        if item_n < cursor.item {
+            cursor.rewind();
+        }
+
+        let mut list = self.outputs;
+        // safe: the cursor is at the start of an output of this same list
+        unsafe {
+            list.set_data_index(cursor.offset);
+        }
 
         // index to check for renderable outputs.
         // we can omit this and be "fancy" with iterators but
         // they consume a lot of stack.
         // causing stack overflows in nanos
-        let mut idx = 0;
+        let mut idx = cursor.idx;
+        // first item of the output at idx
+        let mut item = cursor.item;
+        let mut out = MaybeUninit::uninit();
+
         // gets the output that contains item_n
         // and its corresponding index
-        let filter = |o: &TransferableOutput<'b, O>| -> bool {
-            // filter out
-            let render = self.renderable_out & (1 << idx) > 0;
-            idx += 1;
-
-            if !render {
-                return false;
-            }
-
-            let Ok(n) = o.num_items() else {
-                return false;
-            };
+        let (mut obj, offset, own) = loop {
+            let offset = list.data_index();
+            list.parse_next(&mut out)
+                .ok_or(ParserError::DisplayIdxOutOfRange)?;
+            // valid read as memory was initialized
+            let o = unsafe { out.assume_init_ref() };
 
-            for index in 0..n {
-                obj_item_n = index;
-                if count == item_n as usize {
-                    return true;
+            if shown & (1 << idx) > 0 {
+                let own = o.num_items().unwrap_or(0);
+                let n = own
+                    .checked_add((summaries >> idx) as u8 & 1)
+                    .ok_or(ParserError::DisplayIdxOutOfRange)?;
+                if item_n - item < n {
+                    break (*o, offset, own);
                 }
-                count += 1;
+                item = item
+                    .checked_add(n)
+                    .ok_or(ParserError::DisplayIdxOutOfRange)?;
             }
-            false
+            idx += 1;
         };
 
-        let obj = self
-            .outputs()
-            .get_obj_if(filter)
-            .ok_or(ParserError::DisplayIdxOutOfRange)?;
+        cursor.idx = idx;
+        cursor.offset = offset;
+        cursor.item = item;
+        cursor.store();
+
+        // outside expert mode the outputs folded into this one are not shown,
+        // so it shows the total amount of the group instead,
+        // in expert mode that's the item after its own ones
+        let obj_item_n = item_n - item;
+        let total = if is_app_mode_expert() {
+            obj_item_n == own
+        } else {
+            true
+        };
+        if total && obj.amount().is_some() {
+            let total = self.group_amount(&obj, idx, offset)?;
+            obj.set_amount(total);
+        }
 
         Ok((obj, obj_item_n))
     }
+
+    /// Renders the total amount of the group `obj` leads,
+    /// the item after its own ones in expert mode
+    pub fn render_group_total(
+        &self,
+        obj: &TransferableOutput<'b, O>,
+        title: &mut [u8],
+        message: &mut [u8],
+        page: u8,
+    ) -> Result<u8, ViewError> {
+        use bolos::{pic_str, PIC};
+        use lexical_core::Number;
+
+        let label = pic_str!(b"Total");
+        title[..label.len()].copy_from_slice(label);
+
+        let amount = obj.amount().ok_or(ViewError::NoData)?;
+        let avax = pic_str!(b" AVAX");
+        let mut buffer = [0; u64::FORMATTED_SIZE_DECIMAL + 2 + 5];
+
+        let len = nano_avax_to_fp_str(amount, &mut buffer[..])
+            .map_err(|_| ViewError::Unknown)?
+            .len();
+        buffer[len..][..avax.len()].copy_from_slice(avax);
+
+        handle_ui_message(&buffer[..len + avax.len()], message, page)
+    }
 }
 
 impl<'b, O> FromBytes<'b> for BaseTxFields<'b, O>
 where
-    O: FromBytes<'b> + DisplayableItem + Deref<Target = Output<'b>> + 'b,
+    O: FromBytes<'b> + DisplayableItem + DerefMut<Target = Output<'b>> + Copy + PartialEq + 'b,
 {
     #[inline(never)]
     fn from_bytes_into(
@@ -229,8 +548,129 @@ where
             addr_of_mut!((*out).memo).write(memo);
             // by default all outputs are renderable
             addr_of_mut!((*out).renderable_out).write(OutputIdx::MAX);
+            addr_of_mut!((*out).folded_out).write(0);
+            addr_of_mut!((*out).grouped_out).write(0);
+        }
+
+        // the cursor of a previous transaction could be
+        // for these same bytes, but not these outputs
+        OutputCursor::clear();
+
+        // all fields are initialized at this point
+        let (folded, grouped) = unsafe { (*out).repeated_outputs() };
+        unsafe {
+            addr_of_mut!((*out).folded_out).write(folded);
+            addr_of_mut!((*out).grouped_out).write(grouped);
         }
 
         Ok(rem)
     }
 }
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::{AvmOutput, SECPTransferOutput};
+    use std::{vec, vec::Vec};
+
+    fn transfer_output(asset: u8, amount: u64, address: u8) -> Vec<u8> {
+        let mut out = vec![asset; 32];
+        out.extend_from_slice(&SECPTransferOutput::TYPE_ID.to_be_bytes());
+        out.extend_from_slice(&amount.to_be_bytes());
+        // locktime
+        out.extend_from_slice(&0u64.to_be_bytes());
+        // threshold and a single address
+        out.extend_from_slice(&1u32.to_be_bytes());
+        out.extend_from_slice(&1u32.to_be_bytes());
+        out.extend_from_slice(&[address; 20]);
+        out
+    }
+
+    #[test]
+    fn fold_repeated_outputs() {
+        let outputs = [
+            transfer_output(1, 100, 0xA),
+            transfer_output(1, 200, 0xB),
+            transfer_output(1, 300, 0xA),
+            transfer_output(2, 400, 0xA),
+        ];
+
+        let mut data = (outputs.len() as u32).to_be_bytes().to_vec();
+        outputs.iter().for_each(|o| data.extend_from_slice(o));
+        // no inputs and an empty memo
+        data.extend_from_slice(&[0; 8]);
+
+        let (_, base) = BaseTxFields::<AvmOutput>::from_bytes(&data).unwrap();
+
+        // only the third output goes to the same place as an earlier one
+        assert_eq!(base.folded_out, 0b0100);
+        assert_eq!(base.grouped_out, 0b0001);
+
+        let first = base.outputs.iter().next().unwrap();
+        assert_eq!(base.group_amount(&first, 0, 0).unwrap(), 400);
+
+        let offset = outputs[..3].iter().map(Vec::len).sum();
+        let last = base.outputs.iter().nth(3).unwrap();
+        assert_eq!(base.group_amount(&last, 3, offset).unwrap(), 400);
+    }
+
+    #[test]
+    fn group_total_after_leader() {
+        let outputs = [
+            transfer_output(1, 100, 0xA),
+            transfer_output(1, 200, 0xB),
+            transfer_output(1, 300, 0xA),
+        ];
+
+        let mut data = (outputs.len() as u32).to_be_bytes().to_vec();
+        outputs.iter().for_each(|o| data.extend_from_slice(o));
+        data.extend_from_slice(&[0; 8]);
+
+        let (_, base) = BaseTxFields::<AvmOutput>::from_bytes(&data).unwrap();
+        let lookup = |item_n| {
+            base.base_output_with_item(item_n)
+                .map(|(o, idx)| (o.amount().unwrap(), idx))
+                .ok()
+        };
+
+        // tests run in expert mode, so every output is shown
+        // and the first one is followed by the total of its group
+        assert_eq!(base.base_outputs_num_items().unwrap(), 7);
+
+        assert_eq!(lookup(0), Some((100, 0)));
+        assert_eq!(lookup(2), Some((400, 2)));
+        assert_eq!(lookup(3), Some((200, 0)));
+        assert_eq!(lookup(5), Some((300, 0)));
+        assert_eq!(lookup(7), None);
+    }
+
+    #[test]
+    fn output_items_in_any_order() {
+        let outputs = [
+            transfer_output(1, 100, 0xA),
+            transfer_output(1, 200, 0xB),
+            transfer_output(2, 300, 0xC),
+        ];
+
+        let mut data = (outputs.len() as u32).to_be_bytes().to_vec();
+        outputs.iter().for_each(|o| data.extend_from_slice(o));
+        data.extend_from_slice(&[0; 8]);
+
+        let (_, base) = BaseTxFields::<AvmOutput>::from_bytes(&data).unwrap();
+        let lookup = |item_n| {
+            base.base_output_with_item(item_n)
+                .map(|(o, idx)| (o.amount().unwrap(), idx))
+                .ok()
+        };
+
+        // an amount and an address for each output
+        assert_eq!(base.base_outputs_num_items().unwrap(), 6);
+
+        // going back starts over from the first output
+        for item_n in [0, 1, 2, 5, 3, 4, 0, 6, 4] {
+            let amount = [100, 200, 300].get(item_n as usize / 2);
+            let expected = amount.map(|&amount| (amount, item_n % 2));
+            assert_eq!(lookup(item_n), expected, "item {}", item_n);
+        }
+    }
+}
@@ -23,9 +23,9 @@ use crate::{
     checked_add,
     handlers::handle_ui_message,
     parser::{
-        nano_avax_to_fp_str, Address, BaseTxFields, DisplayableItem, FromBytes, Header, ObjectList,
-        OutputIdx, ParserError, PvmOutput, SECPOutputOwners, Stake, TransferableOutput, Validator,
-        MAX_ADDRESS_ENCODED_LEN, PVM_ADD_DELEGATOR,
+        nano_avax_to_fp_str, Address, BaseTxFields, Defer, DisplayableItem, FromBytes, Header,
+        ObjectList, OutputIdx, ParserError, PvmOutput, SECPOutputOwners, Stake, TransferableOutput,
+        Validator, MAX_ADDRESS_ENCODED_LEN, PVM_ADD_DELEGATOR,
     },
 };
 
@@ -43,7 +43,7 @@ pub struct AddDelegatorTx<'b> {
     // in the ui stage.
     // this is set during the parsing stage
     renderable_out: OutputIdx,
-    pub rewards_owner: SECPOutputOwners<'b>,
+    pub rewards_owner: Defer<'b, SECPOutputOwners<'b>>,
 }
 
 impl<'b> FromBytes<'b> for AddDelegatorTx<'b> {
@@ -96,7 +96,7 @@ impl<'b> FromBytes<'b> for AddDelegatorTx<'b> {
 
         // rewards_owner
         let rewards_owner = unsafe { &mut *addr_of_mut!((*out).rewards_owner).cast() };
-        let rem = SECPOutputOwners::from_bytes_into(rem, rewards_owner)?;
+        let rem = Defer::<SECPOutputOwners>::from_bytes_into(rem, rewards_owner)?;
         unsafe {
             // by default all outputs are renderable
             addr_of_mut!((*out).renderable_out).write(OutputIdx::MAX);
@@ -112,7 +112,7 @@ impl<'b> DisplayableItem for AddDelegatorTx<'b> {
         // rewards_to, stake items and fee
         //
         let validator_items = self.validator.num_items()?;
-        let rewards_items = self.rewards_owner.addresses.len() as u8;
+        let rewards_items = self.rewards_owner.read().addresses.len() as u8;
         let base_outputs = self.base_tx.base_outputs_num_items()?;
         let stake_items = self.num_stake_items()?;
 
@@ -326,6 +326,10 @@ impl<'b> AddDelegatorTx<'b> {
 
                 handle_ui_message(&encoded[..addr_len], message, page)
             }
+            // the total of its group, in expert mode
+            x if x == obj.num_items()? => {
+                self.base_tx.render_group_total(&obj, title, message, page)
+            }
             // by default we call the objects impl here,
             // if it is a locked output, that info will be shown otherwise,
             // this returns an error
@@ -356,6 +360,7 @@ impl<'b> AddDelegatorTx<'b> {
         // render owner addresses
         let hrp = self.tx_header.hrp().map_err(|_| ViewError::Unknown)?;
         self.rewards_owner
+            .read()
             .render_address_with_hrp(hrp, addr_idx, message, page)
     }
 
@@ -369,7 +374,7 @@ impl<'b> AddDelegatorTx<'b> {
         use lexical_core::Number;
 
         let mut buffer = [0; u64::FORMATTED_SIZE_DECIMAL + 2];
-        let num_addresses = self.rewards_owner.addresses.len() as u8;
+        let num_addresses = self.rewards_owner.read().addresses.len() as u8;
 
         match_ranges! {
             match item_n alias x {
@@ -22,10 +22,10 @@ use crate::{
     checked_add,
     handlers::handle_ui_message,
     parser::{
-        intstr_to_fpstr_inplace, nano_avax_to_fp_str, u64_to_str, Address, BaseTxFields,
-        DisplayableItem, FromBytes, Header, ObjectList, OutputIdx, ParserError, PvmOutput,
-        SECPOutputOwners, Stake, TransferableOutput, Validator, DELEGATION_FEE_DIGITS,
-        MAX_ADDRESS_ENCODED_LEN, PVM_ADD_VALIDATOR,
+        nano_avax_to_fp_str, u64_to_fp_str, Address, BaseTxFields, Defer, DisplayableItem,
+        FromBytes, Header, ObjectList, OutputIdx, ParserError, PvmOutput, SECPOutputOwners, Stake,
+        TransferableOutput, Validator, DELEGATION_FEE_DIGITS, MAX_ADDRESS_ENCODED_LEN,
+        PVM_ADD_VALIDATOR,
     },
 };
 
@@ -43,7 +43,7 @@ pub struct AddValidatorTx<'b> {
     // this is set during the parsing stage
     renderable_out: OutputIdx,
     pub stake: ObjectList<'b, TransferableOutput<'b, PvmOutput<'b>>>,
-    pub rewards_owner: SECPOutputOwners<'b>,
+    pub rewards_owner: Defer<'b, SECPOutputOwners<'b>>,
     pub shares: u32,
 }
 
@@ -98,7 +98,7 @@ impl<'b> FromBytes<'b> for AddValidatorTx<'b> {
 
         // rewards_owner
         let rewards_owner = unsafe { &mut *addr_of_mut!((*out).rewards_owner).cast() };
-        let rem = SECPOutputOwners::from_bytes_into(rem, rewards_owner)?;
+        let rem = Defer::<SECPOutputOwners>::from_bytes_into(rem, rewards_owner)?;
 
         // shares
         let (rem, shares) = be_u32(rem)?;
@@ -119,7 +119,7 @@ impl<'b> DisplayableItem for AddValidatorTx<'b> {
         // tx_info, base_tx items, validator_items(4),
         // fee, fee_delegation, rewards_to and stake items
         let base = self.base_tx.base_outputs_num_items()?;
-        let rewards = self.rewards_owner.num_addresses() as u8;
+        let rewards = self.rewards_owner.read().num_addresses() as u8;
         let stake = self.num_stake_items()?;
         let validator = self.validator.num_items()?;
 
@@ -325,6 +325,10 @@ impl<'b> AddValidatorTx<'b> {
 
                 handle_ui_message(&encoded[..addr_len], message, page)
             }
+            // the total of its group, in expert mode
+            x if x == obj.num_items()? => {
+                self.base_tx.render_group_total(&obj, title, message, page)
+            }
             // by default we call the objects impl here,
             // if it is a locked output, that info will be shown otherwise,
             // this returns an error
@@ -355,6 +359,7 @@ impl<'b> AddValidatorTx<'b> {
         // render owner addresses
         let hrp = self.tx_header.hrp().map_err(|_| ViewError::Unknown)?;
         self.rewards_owner
+            .read()
             .render_address_with_hrp(hrp, addr_idx, message, page)
     }
 
@@ -368,7 +373,7 @@ impl<'b> AddValidatorTx<'b> {
         use lexical_core::Number;
 
         let mut buffer = [0; u64::FORMATTED_SIZE_DECIMAL + 2];
-        let num_addresses = self.rewards_owner.addresses.len() as u8;
+        let num_addresses = self.rewards_owner.read().addresses.len() as u8;
 
         match_ranges! {
             match item_n alias x {
@@ -376,9 +381,7 @@ impl<'b> AddValidatorTx<'b> {
                 until 1 => {
                     let label = pic_str!(b"Delegate fee(%)");
                     title[..label.len()].copy_from_slice(label);
-                    u64_to_str(self.shares as _, &mut buffer[..]).map_err(|_| ViewError::Unknown)?;
-
-                    let buffer = intstr_to_fpstr_inplace(&mut buffer[..], DELEGATION_FEE_DIGITS)
+                    let buffer = u64_to_fp_str(self.shares as _, DELEGATION_FEE_DIGITS, &mut buffer[..])
                         .map_err(|_| ViewError::Unknown)?;
 
                     handle_ui_message(buffer, message, page)
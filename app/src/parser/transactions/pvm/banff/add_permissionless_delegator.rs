@@ -23,9 +23,9 @@ use crate::{
     checked_add,
     handlers::handle_ui_message,
     parser::{
-        nano_avax_to_fp_str, Address, BaseTxFields, DisplayableItem, FromBytes, Header, ObjectList,
-        OutputIdx, ParserError, PvmOutput, SECPOutputOwners, Stake, SubnetId, TransferableOutput,
-        Validator, MAX_ADDRESS_ENCODED_LEN, PVM_ADD_PERMISSIONLESS_DELEGATOR,
+        nano_avax_to_fp_str, Address, BaseTxFields, Defer, DisplayableItem, FromBytes, Header,
+        ObjectList, OutputIdx, ParserError, PvmOutput, SECPOutputOwners, Stake, SubnetId,
+        TransferableOutput, Validator, MAX_ADDRESS_ENCODED_LEN, PVM_ADD_PERMISSIONLESS_DELEGATOR,
     },
 };
 
@@ -45,7 +45,7 @@ pub struct AddPermissionlessDelegatorTx<'b> {
     // in the ui stage.
     // this is set during the parsing stage
     renderable_out: OutputIdx,
-    pub rewards_owner: SECPOutputOwners<'b>,
+    pub rewards_owner: Defer<'b, SECPOutputOwners<'b>>,
 }
 
 impl<'b> FromBytes<'b> for AddPermissionlessDelegatorTx<'b> {
@@ -102,7 +102,7 @@ impl<'b> FromBytes<'b> for AddPermissionlessDelegatorTx<'b> {
 
         // rewards_owner
         let rewards_owner = unsafe { &mut *addr_of_mut!((*out).rewards_owner).cast() };
-        let rem = SECPOutputOwners::from_bytes_into(rem, rewards_owner)?;
+        let rem = Defer::<SECPOutputOwners>::from_bytes_into(rem, rewards_owner)?;
         unsafe {
             // by default all outputs are renderable
             addr_of_mut!((*out).renderable_out).write(OutputIdx::MAX);
@@ -119,7 +119,7 @@ impl<'b> DisplayableItem for AddPermissionlessDelegatorTx<'b> {
         // stake items and fee
         let base_outputs = self.base_tx.base_outputs_num_items()?;
         let validator_items = self.validator.num_items()?;
-        let owners = self.rewards_owner.addresses.len() as u8;
+        let owners = self.rewards_owner.read().addresses.len() as u8;
         let stake = self.num_stake_items()?;
 
         checked_add!(
@@ -335,6 +335,10 @@ impl<'b> AddPermissionlessDelegatorTx<'b> {
 
                 handle_ui_message(&encoded[..addr_len], message, page)
             }
+            // the total of its group, in expert mode
+            x if x == obj.num_items()? => {
+                self.base_tx.render_group_total(&obj, title, message, page)
+            }
             // by default we call the objects impl here,
             // if it is a locked output, that info will be shown otherwise,
             // this returns an error
@@ -365,6 +369,7 @@ impl<'b> AddPermissionlessDelegatorTx<'b> {
         title[..label.len()].copy_from_slice(label);
 
         self.rewards_owner
+            .read()
             .render_address_with_hrp(hrp, addr_idx, message, page)
     }
 
@@ -378,7 +383,7 @@ impl<'b> AddPermissionlessDelegatorTx<'b> {
         use lexical_core::Number;
 
         let mut buffer = [0; u64::FORMATTED_SIZE_DECIMAL + 2];
-        let num_addresses = self.rewards_owner.addresses.len() as u8;
+        let num_addresses = self.rewards_owner.read().addresses.len() as u8;
 
         match_ranges! {
             match item_n alias x {
@@ -503,7 +508,7 @@ mod tests {
             AddPermissionlessDelegatorTx::from_bytes(SIMPLE_ADD_PERMISSIONLESS_DELEGATOR).unwrap();
         assert_eq!(tx.validator.stake(), 2000000000000);
         assert_eq!(tx.subnet_id, SubnetId::PRIMARY_NETWORK);
-        assert_eq!(tx.rewards_owner.locktime, 0);
+        assert_eq!(tx.rewards_owner.read().locktime, 0);
 
         let (_, tx) =
             AddPermissionlessDelegatorTx::from_bytes(COMPLEX_ADD_PERMISSIONLESS_DELEGATOR).unwrap();
@@ -543,7 +548,7 @@ mod tests {
             tx.stake.iter().next().expect("1 stake out").asset_id().id(),
             asset_id
         );
-        assert_eq!(tx.rewards_owner.locktime, 0);
+        assert_eq!(tx.rewards_owner.read().locktime, 0);
 
         let (_, tx) =
             AddPermissionlessDelegatorTx::from_bytes(COMPLEX_ADD_SUBNET_PERMISSIONLESS_DELEGATOR)
@@ -572,6 +577,6 @@ mod tests {
                 .id(),
             asset_id
         );
-        assert_eq!(tx.rewards_owner.locktime, 0);
+        assert_eq!(tx.rewards_owner.read().locktime, 0);
     }
 }
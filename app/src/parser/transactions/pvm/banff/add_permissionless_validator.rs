@@ -22,10 +22,10 @@ use crate::{
     checked_add,
     handlers::handle_ui_message,
     parser::{
-        intstr_to_fpstr_inplace, nano_avax_to_fp_str, proof_of_possession::BLSSigner, u64_to_str,
-        Address, BaseTxFields, DisplayableItem, FromBytes, Header, ObjectList, OutputIdx,
-        ParserError, PvmOutput, SECPOutputOwners, Stake, SubnetId, TransferableOutput, Validator,
-        DELEGATION_FEE_DIGITS, MAX_ADDRESS_ENCODED_LEN, PVM_ADD_PERMISSIONLESS_VALIDATOR,
+        nano_avax_to_fp_str, proof_of_possession::BLSSigner, u64_to_fp_str, Address, BaseTxFields,
+        Defer, DisplayableItem, FromBytes, Header, ObjectList, OutputIdx, ParserError, PvmOutput,
+        SECPOutputOwners, Stake, SubnetId, TransferableOutput, Validator, DELEGATION_FEE_DIGITS,
+        MAX_ADDRESS_ENCODED_LEN, PVM_ADD_PERMISSIONLESS_VALIDATOR,
     },
 };
 
@@ -45,8 +45,8 @@ pub struct AddPermissionlessValidatorTx<'b> {
     // this is set during the parsing stage
     renderable_out: OutputIdx,
     pub stake: ObjectList<'b, TransferableOutput<'b, PvmOutput<'b>>>,
-    pub validator_rewards_owner: SECPOutputOwners<'b>,
-    pub delegator_rewards_owner: SECPOutputOwners<'b>,
+    pub validator_rewards_owner: Defer<'b, SECPOutputOwners<'b>>,
+    pub delegator_rewards_owner: Defer<'b, SECPOutputOwners<'b>>,
     pub shares: u32,
 }
 
@@ -110,12 +110,12 @@ impl<'b> FromBytes<'b> for AddPermissionlessValidatorTx<'b> {
         // validator rewards_owner
         let validator_rewards_owner =
             unsafe { &mut *addr_of_mut!((*out).validator_rewards_owner).cast() };
-        let rem = SECPOutputOwners::from_bytes_into(rem, validator_rewards_owner)?;
+        let rem = Defer::<SECPOutputOwners>::from_bytes_into(rem, validator_rewards_owner)?;
 
         // delegator rewards_owner
         let delegator_rewards_owner =
             unsafe { &mut *addr_of_mut!((*out).delegator_rewards_owner).cast() };
-        let rem = SECPOutputOwners::from_bytes_into(rem, delegator_rewards_owner)?;
+        let rem = Defer::<SECPOutputOwners>::from_bytes_into(rem, delegator_rewards_owner)?;
 
         // shares
         let (rem, shares) = be_u32(rem)?;
@@ -139,8 +139,8 @@ impl<'b> DisplayableItem for AddPermissionlessValidatorTx<'b> {
         let base = self.base_tx.base_outputs_num_items()?;
         let validator = self.validator.num_items()?;
         let signer = self.signer.num_items()?;
-        let validator_rewards = self.validator_rewards_owner.num_addresses() as u8;
-        let delegator_rewards = self.delegator_rewards_owner.num_addresses() as u8;
+        let validator_rewards = self.validator_rewards_owner.read().num_addresses() as u8;
+        let delegator_rewards = self.delegator_rewards_owner.read().num_addresses() as u8;
         let stake = self.num_stake_items()?;
 
         checked_add!(
@@ -360,6 +360,10 @@ impl<'b> AddPermissionlessValidatorTx<'b> {
 
                 handle_ui_message(&encoded[..addr_len], message, page)
             }
+            // the total of its group, in expert mode
+            x if x == obj.num_items()? => {
+                self.base_tx.render_group_total(&obj, title, message, page)
+            }
             // by default we call the objects impl here,
             // if it is a locked output, that info will be shown otherwise,
             // this returns an error
@@ -385,8 +389,8 @@ impl<'b> AddPermissionlessValidatorTx<'b> {
         page: u8,
     ) -> Result<u8, zemu_sys::ViewError> {
         let hrp = self.tx_header.hrp().map_err(|_| ViewError::Unknown)?;
-        let validators = self.validator_rewards_owner.num_addresses();
-        let delegators = self.delegator_rewards_owner.num_addresses();
+        let validators = self.validator_rewards_owner.read().num_addresses();
+        let delegators = self.delegator_rewards_owner.read().num_addresses();
 
         match_ranges! {
             match addr_idx alias x {
@@ -395,14 +399,14 @@ impl<'b> AddPermissionlessValidatorTx<'b> {
                     let label = pic_str!(b"Valida rewards to");
                     title[..label.len()].copy_from_slice(label);
 
-                    self.validator_rewards_owner.render_address_with_hrp(hrp, x, message, page)
+                    self.validator_rewards_owner.read().render_address_with_hrp(hrp, x, message, page)
                 }
                 until delegators => {
                     // FIXME: title truncated
                     let label = pic_str!(b"Delega rewards to");
                     title[..label.len()].copy_from_slice(label);
 
-                    self.delegator_rewards_owner.render_address_with_hrp(hrp, x, message, page)
+                    self.delegator_rewards_owner.read().render_address_with_hrp(hrp, x, message, page)
                 }
                 _ => Err(ViewError::NoData)
             }
@@ -419,8 +423,9 @@ impl<'b> AddPermissionlessValidatorTx<'b> {
         use lexical_core::Number;
 
         let mut buffer = [0; u64::FORMATTED_SIZE_DECIMAL + 2];
-        let num_addresses = (self.validator_rewards_owner.num_addresses()
-            + self.delegator_rewards_owner.num_addresses()) as u8;
+        let num_addresses = (self.validator_rewards_owner.read().num_addresses()
+            + self.delegator_rewards_owner.read().num_addresses())
+            as u8;
 
         match_ranges! {
             match item_n alias x {
@@ -428,9 +433,7 @@ impl<'b> AddPermissionlessValidatorTx<'b> {
                 until 1 => {
                     let label = pic_str!(b"Delegate fee(%)");
                     title[..label.len()].copy_from_slice(label);
-                    u64_to_str(self.shares as _, &mut buffer[..]).map_err(|_| ViewError::Unknown)?;
-
-                    let buffer = intstr_to_fpstr_inplace(&mut buffer[..], DELEGATION_FEE_DIGITS)
+                    let buffer = u64_to_fp_str(self.shares as _, DELEGATION_FEE_DIGITS, &mut buffer[..])
                         .map_err(|_| ViewError::Unknown)?;
 
                     handle_ui_message(buffer, message, page)
@@ -531,8 +534,8 @@ mod tests {
                 .locktime,
             87654321
         );
-        assert_eq!(tx.delegator_rewards_owner.threshold, 0);
-        assert_eq!(tx.validator_rewards_owner.threshold, 1);
+        assert_eq!(tx.delegator_rewards_owner.read().threshold, 0);
+        assert_eq!(tx.validator_rewards_owner.read().threshold, 1);
         assert!(matches!(tx.signer, BLSSigner::Proof(_)));
 
         let subnet_id = SubnetId::new(&[
@@ -17,23 +17,35 @@
 use core::{mem::MaybeUninit, ptr::addr_of_mut};
 
 use bolos::{pic::PIC, pic_str};
-use nom::{
-    bytes::complete::tag,
-    number::complete::{be_u32, be_u64, be_u8},
-};
+use nom::bytes::complete::{tag, take};
 use zemu_sys::ViewError;
 
 use crate::{
     checked_add,
     handlers::handle_ui_message,
     parser::{
-        intstr_to_fpstr_inplace, nano_avax_to_fp_str, u32_to_str, AssetId, BaseTxFields,
+        duration_to_str, nano_avax_to_fp_str, u64_to_fp_str, AssetId, BaseTxFields,
         DisplayableItem, FromBytes, Header, ParserError, PvmOutput, SubnetAuth, SubnetId,
-        DELEGATION_FEE_DIGITS, PVM_TRANSFORM_SUBNET,
+        DELEGATION_FEE_DIGITS, PVM_TRANSFORM_SUBNET, U32_SIZE, U64_SIZE,
     },
     utils::is_app_mode_expert,
 };
 
+// byte offsets of the staking parameters
+const INITIAL_SUPPLY: usize = 0;
+const MAXIMUM_SUPPLY: usize = INITIAL_SUPPLY + U64_SIZE;
+const MIN_CONSUMPTION_RATE: usize = MAXIMUM_SUPPLY + U64_SIZE;
+const MAX_CONSUMPTION_RATE: usize = MIN_CONSUMPTION_RATE + U64_SIZE;
+const MIN_VALIDATOR_STAKE: usize = MAX_CONSUMPTION_RATE + U64_SIZE;
+const MAX_VALIDATOR_STAKE: usize = MIN_VALIDATOR_STAKE + U64_SIZE;
+const MIN_STAKE_DURATION: usize = MAX_VALIDATOR_STAKE + U64_SIZE;
+const MAX_STAKE_DURATION: usize = MIN_STAKE_DURATION + U32_SIZE;
+const MIN_DELEGATION_FEE: usize = MAX_STAKE_DURATION + U32_SIZE;
+const MIN_DELEGATOR_STAKE: usize = MIN_DELEGATION_FEE + U32_SIZE;
+const MAX_VALIDATOR_WEIGHT_FACTOR: usize = MIN_DELEGATOR_STAKE + U64_SIZE;
+const UPTIME_REQUIREMENT: usize = MAX_VALIDATOR_WEIGHT_FACTOR + 1;
+const PARAMS_LEN: usize = UPTIME_REQUIREMENT + U32_SIZE;
+
 #[derive(Clone, Copy, PartialEq, Eq)]
 #[repr(C)]
 #[cfg_attr(test, derive(Debug))]
@@ -44,24 +56,10 @@ pub struct TransformSubnetTx<'b> {
     subnet_id: SubnetId<'b>,
     asset_id: AssetId<'b>,
 
-    initial_supply: u64,
-    maximum_supply: u64,
-
-    min_consumption_rate: u64,
-    max_consumption_rate: u64,
-
-    min_validator_stake: u64,
-    max_validator_stake: u64,
-
-    min_stake_duration: u32,
-    max_stake_duration: u32,
-
-    min_delegation_fee: u32,
-    min_delegator_stake: u64,
-
-    max_validator_weight_factor: u8,
-
-    uptime_requirement: u32,
+    // the staking parameters are fixed-size and only rendered in expert mode,
+    // so they are read from the tx buffer on demand
+    // instead of being kept decoded
+    params: &'b [u8; PARAMS_LEN],
 
     auth: SubnetAuth<'b>,
 }
@@ -89,54 +87,78 @@ impl<'b> FromBytes<'b> for TransformSubnetTx<'b> {
         let asset_id = unsafe { &mut *addr_of_mut!((*out).asset_id).cast() };
         let rem = AssetId::from_bytes_into(rem, asset_id)?;
 
-        let (rem, initial_supply) = be_u64(rem)?;
-        let (rem, maximum_supply) = be_u64(rem)?;
+        let (rem, params) = take(PARAMS_LEN)(rem)?;
+        let params = arrayref::array_ref!(params, 0, PARAMS_LEN);
 
-        let (rem, min_consumption_rate) = be_u64(rem)?;
-        let (rem, max_consumption_rate) = be_u64(rem)?;
+        let auth = unsafe { &mut *addr_of_mut!((*out).auth).cast() };
+        let rem = SubnetAuth::from_bytes_into(rem, auth)?;
 
-        let (rem, min_validator_stake) = be_u64(rem)?;
-        let (rem, max_validator_stake) = be_u64(rem)?;
+        //good ptr and no uninit reads
+        unsafe {
+            addr_of_mut!((*out).params).write(params);
+        }
 
-        let (rem, min_stake_duration) = be_u32(rem)?;
-        let (rem, max_stake_duration) = be_u32(rem)?;
+        Ok(rem)
+    }
+}
 
-        let (rem, min_delegation_fee) = be_u32(rem)?;
-        let (rem, min_delegator_stake) = be_u64(rem)?;
+impl<'b> TransformSubnetTx<'b> {
+    fn param_u64(&self, offset: usize) -> u64 {
+        u64::from_be_bytes(*arrayref::array_ref!(self.params, offset, U64_SIZE))
+    }
 
-        let (rem, max_validator_weight_factor) = be_u8(rem)?;
+    fn param_u32(&self, offset: usize) -> u32 {
+        u32::from_be_bytes(*arrayref::array_ref!(self.params, offset, U32_SIZE))
+    }
 
-        let (rem, uptime_requirement) = be_u32(rem)?;
+    pub fn initial_supply(&self) -> u64 {
+        self.param_u64(INITIAL_SUPPLY)
+    }
 
-        let auth = unsafe { &mut *addr_of_mut!((*out).auth).cast() };
-        let rem = SubnetAuth::from_bytes_into(rem, auth)?;
+    pub fn maximum_supply(&self) -> u64 {
+        self.param_u64(MAXIMUM_SUPPLY)
+    }
 
-        unsafe {
-            addr_of_mut!((*out).initial_supply).write(initial_supply);
-            addr_of_mut!((*out).maximum_supply).write(maximum_supply);
+    pub fn min_consumption_rate(&self) -> u64 {
+        self.param_u64(MIN_CONSUMPTION_RATE)
+    }
 
-            addr_of_mut!((*out).min_consumption_rate).write(min_consumption_rate);
-            addr_of_mut!((*out).max_consumption_rate).write(max_consumption_rate);
+    pub fn max_consumption_rate(&self) -> u64 {
+        self.param_u64(MAX_CONSUMPTION_RATE)
+    }
 
-            addr_of_mut!((*out).min_validator_stake).write(min_validator_stake);
-            addr_of_mut!((*out).max_validator_stake).write(max_validator_stake);
+    pub fn min_validator_stake(&self) -> u64 {
+        self.param_u64(MIN_VALIDATOR_STAKE)
+    }
 
-            addr_of_mut!((*out).min_stake_duration).write(min_stake_duration);
-            addr_of_mut!((*out).max_stake_duration).write(max_stake_duration);
+    pub fn max_validator_stake(&self) -> u64 {
+        self.param_u64(MAX_VALIDATOR_STAKE)
+    }
 
-            addr_of_mut!((*out).min_delegation_fee).write(min_delegation_fee);
-            addr_of_mut!((*out).min_delegator_stake).write(min_delegator_stake);
+    pub fn min_stake_duration(&self) -> u32 {
+        self.param_u32(MIN_STAKE_DURATION)
+    }
 
-            addr_of_mut!((*out).max_validator_weight_factor).write(max_validator_weight_factor);
+    pub fn max_stake_duration(&self) -> u32 {
+        self.param_u32(MAX_STAKE_DURATION)
+    }
 
-            addr_of_mut!((*out).uptime_requirement).write(uptime_requirement);
-        }
+    pub fn min_delegation_fee(&self) -> u32 {
+        self.param_u32(MIN_DELEGATION_FEE)
+    }
 
-        Ok(rem)
+    pub fn min_delegator_stake(&self) -> u64 {
+        self.param_u64(MIN_DELEGATOR_STAKE)
+    }
+
+    pub fn max_validator_weight_factor(&self) -> u8 {
+        self.params[MAX_VALIDATOR_WEIGHT_FACTOR]
+    }
+
+    pub fn uptime_requirement(&self) -> u32 {
+        self.param_u32(UPTIME_REQUIREMENT)
     }
-}
 
-impl<'b> TransformSubnetTx<'b> {
     fn fee(&self) -> Result<u64, ParserError> {
         let sum_inputs = self.base_tx.sum_inputs_amount()?;
 
@@ -165,68 +187,71 @@ impl<'b> TransformSubnetTx<'b> {
                 let label = pic_str!(b"Initial supply");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.initial_supply, &mut buffer);
+                let buffer = itoa(self.initial_supply(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             1 => {
                 let label = pic_str!(b"Maximum supply");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.maximum_supply, &mut buffer);
+                let buffer = itoa(self.maximum_supply(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             2 => {
                 let label = pic_str!(b"Min consumption");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.min_consumption_rate, &mut buffer);
+                let buffer = itoa(self.min_consumption_rate(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             3 => {
                 let label = pic_str!(b"Max consumption");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.max_consumption_rate, &mut buffer);
+                let buffer = itoa(self.max_consumption_rate(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             4 => {
                 let label = pic_str!(b"Min valid. stake");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.min_validator_stake, &mut buffer);
+                let buffer = itoa(self.min_validator_stake(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             5 => {
                 let label = pic_str!(b"Max valid. stake");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.max_validator_stake, &mut buffer);
+                let buffer = itoa(self.max_validator_stake(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             6 => {
                 let label = pic_str!(b"Min stake time");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.min_stake_duration, &mut buffer);
+                let buffer = duration_to_str(self.min_stake_duration() as _, &mut buffer[..])
+                    .map_err(|_| ViewError::Unknown)?;
                 handle_ui_message(buffer, message, page)
             }
             7 => {
                 let label = pic_str!(b"Max stake time");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.max_stake_duration, &mut buffer);
+                let buffer = duration_to_str(self.max_stake_duration() as _, &mut buffer[..])
+                    .map_err(|_| ViewError::Unknown)?;
                 handle_ui_message(buffer, message, page)
             }
             8 => {
                 let label = pic_str!(b"Min delegate fee");
                 title[..label.len()].copy_from_slice(label);
 
-                u32_to_str(self.min_delegation_fee, &mut buffer[..])
-                    .map_err(|_| ViewError::Unknown)?;
-
-                let len = intstr_to_fpstr_inplace(&mut buffer[..], DELEGATION_FEE_DIGITS)
-                    .map_err(|_| ViewError::Unknown)?
-                    .len();
+                let len = u64_to_fp_str(
+                    self.min_delegation_fee() as _,
+                    DELEGATION_FEE_DIGITS,
+                    &mut buffer[..],
+                )
+                .map_err(|_| ViewError::Unknown)?
+                .len();
                 buffer[len] = b'%';
                 let buffer = &mut buffer[..len + 1];
 
@@ -236,7 +261,7 @@ impl<'b> TransformSubnetTx<'b> {
                 let label = pic_str!(b"Min delega. stake");
                 title[..label.len()].copy_from_slice(label);
 
-                let buffer = itoa(self.min_delegator_stake, &mut buffer);
+                let buffer = itoa(self.min_delegator_stake(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             10 => {
@@ -244,20 +269,21 @@ impl<'b> TransformSubnetTx<'b> {
                 title[..label.len()].copy_from_slice(label);
 
                 // TODO: determine how to display properly
-                let buffer = itoa(self.max_validator_weight_factor, &mut buffer);
+                let buffer = itoa(self.max_validator_weight_factor(), &mut buffer);
                 handle_ui_message(buffer, message, page)
             }
             11 => {
                 let label = pic_str!(b"Uptime req.");
                 title[..label.len()].copy_from_slice(label);
 
-                u32_to_str(self.uptime_requirement, &mut buffer[..])
-                    .map_err(|_| ViewError::Unknown)?;
-
                 //the uptime req% shares the same number of digits as the delegation fee% (4)
-                let len = intstr_to_fpstr_inplace(&mut buffer[..], DELEGATION_FEE_DIGITS)
-                    .map_err(|_| ViewError::Unknown)?
-                    .len();
+                let len = u64_to_fp_str(
+                    self.uptime_requirement() as _,
+                    DELEGATION_FEE_DIGITS,
+                    &mut buffer[..],
+                )
+                .map_err(|_| ViewError::Unknown)?
+                .len();
                 buffer[len] = b'%';
                 let buffer = &mut buffer[..len + 1];
 
@@ -344,7 +370,7 @@ mod tests {
     #[test]
     fn parse_transform_subnet_tx() {
         let (_, tx) = TransformSubnetTx::from_bytes(SAMPLE).unwrap();
-        assert_eq!(tx.max_validator_weight_factor, 5);
+        assert_eq!(tx.max_validator_weight_factor(), 5);
 
         let subnet_id = SubnetId::new(&[
             0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
@@ -361,9 +387,9 @@ mod tests {
         let (_, tx) = TransformSubnetTx::from_bytes(SIMPLE_TRANSFORM_SUBNET).unwrap();
         assert_eq!(tx.asset_id.id(), asset_id);
         assert_eq!(tx.subnet_id, subnet_id);
-        assert_eq!(tx.min_consumption_rate, 1_000);
-        assert_eq!(tx.uptime_requirement, 950_000);
-        assert_eq!(tx.max_validator_weight_factor, 1);
+        assert_eq!(tx.min_consumption_rate(), 1_000);
+        assert_eq!(tx.uptime_requirement(), 950_000);
+        assert_eq!(tx.max_validator_weight_factor(), 1);
 
         let (_, tx) = TransformSubnetTx::from_bytes(COMPLEX_TRANSFORM_SUBNET).unwrap();
         assert_eq!(
@@ -379,9 +405,9 @@ mod tests {
         );
         assert_eq!(tx.asset_id.id(), asset_id);
         assert_eq!(tx.subnet_id, subnet_id);
-        assert_eq!(tx.min_consumption_rate, 0);
-        assert_eq!(tx.uptime_requirement, 0);
-        assert_eq!(tx.max_validator_weight_factor, 255);
+        assert_eq!(tx.min_consumption_rate(), 0);
+        assert_eq!(tx.uptime_requirement(), 0);
+        assert_eq!(tx.max_validator_weight_factor(), 255);
     }
 
     #[test]
@@ -118,6 +118,11 @@ impl<'b> PvmExportTx<'b> {
     pub fn disable_output_if(&mut self, address: &[u8]) {
         self.0.disable_output_if(address);
     }
+
+    #[cfg(feature = "policy")]
+    pub fn check_policy(&'b self, check: &mut crate::parser::PolicyCheck) {
+        self.0.check_policy(check, PvmOutput::is_locked);
+    }
 }
 
 #[cfg(test)]
@@ -36,6 +36,13 @@ impl<'b> Transfer<'b> {
         self.base.disable_output_if(address);
     }
 
+    #[cfg(feature = "policy")]
+    pub fn check_policy(&'b self, check: &mut crate::parser::PolicyCheck) {
+        check.header(&self.header);
+        // X-chain outputs can't be stake locked
+        self.base.check_policy(check, |_| false);
+    }
+
     fn render_outputs(
         &self,
         item_n: u8,
@@ -93,6 +100,9 @@ impl<'b> Transfer<'b> {
                 handle_ui_message(&encoded[..addr_len], message, page)
             }
 
+            // the total of its group, in expert mode
+            x if x == num_inner_items => self.base.render_group_total(&obj, title, message, page),
+
             _ => Err(ViewError::NoData),
         }
     }
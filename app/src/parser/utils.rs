@@ -16,8 +16,10 @@
 
 // taken from: https://github.com/Zondax/ledger-tezos/blob/main/rust/app/src/handlers/utils.rs
 //
+mod format;
 mod path_wrapper;
 mod time;
+pub use self::format::{duration_to_str, u64_to_fp_str};
 pub use self::time::{timestamp_to_str_date, TimeError};
 pub use path_wrapper::PathWrapper;
 
@@ -47,15 +49,7 @@ pub const fn cb58_output_len<const I: usize>() -> usize {
 }
 
 pub fn nano_avax_to_fp_str(value: u64, out_str: &mut [u8]) -> Result<&mut [u8], ParserError> {
-    // the number plus '0.'
-    if out_str.len() < u64::FORMATTED_SIZE_DECIMAL + 2 {
-        return Err(ParserError::UnexpectedBufferEnd);
-    }
-
-    u64_to_str(value, &mut out_str[..])?;
-
-    intstr_to_fpstr_inplace(out_str, NANO_AVAX_DECIMAL_DIGITS)
-        .map_err(|_| ParserError::UnexpectedError)
+    u64_to_fp_str(value, NANO_AVAX_DECIMAL_DIGITS, out_str)
 }
 
 macro_rules! num_to_str {
@@ -0,0 +1,254 @@
+/*******************************************************************************
+*   (c) 2021 Zondax GmbH
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Allocation-free number formatting
+//!
+//! Digits are emitted once, right to left, straight at their final
+//! position in the output buffer, instead of being written out and then
+//! shuffled in place to add padding or the decimal point.
+
+use crate::parser::ParserError;
+use crate::sys::PIC;
+
+// seconds in each unit shown for a duration, along with its suffix
+const DURATION_UNITS: &[(u64, u8); 4] = &[(86_400, b'd'), (3_600, b'h'), (60, b'm'), (1, b's')];
+
+/// Returns the number of decimal digits of `n`
+pub fn num_digits(mut n: u64) -> usize {
+    let mut digits = 1;
+    while n >= 10 {
+        n /= 10;
+        digits += 1;
+    }
+    digits
+}
+
+/// Writes the lowest `out.len()` digits of `n` into `out`,
+/// with leading zeroes if `n` is shorter than that
+pub fn write_padded(mut n: u64, out: &mut [u8]) {
+    for digit in out.iter_mut().rev() {
+        *digit = b'0' + (n % 10) as u8;
+        n /= 10;
+    }
+}
+
+/// Formats `value` as a fixed point number with the given `decimals`
+///
+/// Trailing zeroes of the fractional part are skipped,
+/// as well as the decimal point if there is nothing after it.
+/// Returns the subslice of `out` that was written.
+#[inline(never)]
+pub fn u64_to_fp_str(
+    value: u64,
+    decimals: usize,
+    out: &mut [u8],
+) -> Result<&mut [u8], ParserError> {
+    let mut value = value;
+    let mut decimals = decimals;
+
+    // drop the trailing zeroes before writing anything
+    while decimals > 0 && value % 10 == 0 {
+        value /= 10;
+        decimals -= 1;
+    }
+
+    // there is always a digit before the point
+    let int_digits = num_digits(value).saturating_sub(decimals).max(1);
+    if decimals == 0 {
+        let out = out
+            .get_mut(..int_digits)
+            .ok_or(ParserError::UnexpectedBufferEnd)?;
+        write_padded(value, out);
+
+        return Ok(out);
+    }
+
+    let out = out
+        .get_mut(..int_digits + 1 + decimals)
+        .ok_or(ParserError::UnexpectedBufferEnd)?;
+
+    // 10^decimals only overflows if there are more decimals than digits
+    let (int, frac) = match 10u64.checked_pow(decimals as u32) {
+        Some(scale) => (value / scale, value % scale),
+        None => (0, value),
+    };
+
+    let (int_str, frac_str) = out.split_at_mut(int_digits);
+    write_padded(int, int_str);
+    frac_str[0] = b'.';
+    write_padded(frac, &mut frac_str[1..]);
+
+    Ok(out)
+}
+
+/// Formats a number of seconds as days, hours, minutes and seconds,
+/// skipping the units that are zero, i.e: `1d 12h` or `30s`
+///
+/// Returns the subslice of `out` that was written.
+#[inline(never)]
+pub fn duration_to_str(seconds: u64, out: &mut [u8]) -> Result<&mut [u8], ParserError> {
+    let units = PIC::new(DURATION_UNITS).into_inner();
+
+    let mut len = 0;
+    let mut rem = seconds;
+    for &(unit, suffix) in units.iter() {
+        let n = rem / unit;
+        rem %= unit;
+
+        // a zero duration is still shown, as seconds
+        if n == 0 && (unit != 1 || len > 0) {
+            continue;
+        }
+
+        if len > 0 {
+            *out.get_mut(len).ok_or(ParserError::UnexpectedBufferEnd)? = b' ';
+            len += 1;
+        }
+
+        let digits = num_digits(n);
+        let part = out
+            .get_mut(len..len + digits + 1)
+            .ok_or(ParserError::UnexpectedBufferEnd)?;
+        write_padded(n, &mut part[..digits]);
+        part[digits] = suffix;
+
+        len += digits + 1;
+    }
+
+    Ok(&mut out[..len])
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::parser::{intstr_to_fpstr_inplace, u64_to_str};
+    use lexical_core::Number;
+    use proptest::prelude::*;
+
+    const BUFFER_LEN: usize = u64::FORMATTED_SIZE_DECIMAL + 2;
+
+    // the previous two-step formatting, used as reference
+    fn fp_str_inplace(value: u64, decimals: usize, out: &mut [u8]) -> &mut [u8] {
+        u64_to_str(value, &mut out[..]).unwrap();
+        intstr_to_fpstr_inplace(out, decimals).unwrap()
+    }
+
+    fn fp_str_matches(value: u64, decimals: usize) {
+        let mut expected = [0; BUFFER_LEN + 20];
+        let mut buffer = [0; BUFFER_LEN + 20];
+
+        assert_eq!(
+            fp_str_inplace(value, decimals, &mut expected),
+            u64_to_fp_str(value, decimals, &mut buffer).unwrap(),
+            "{value} with {decimals} decimals"
+        );
+    }
+
+    #[test]
+    fn fixed_point() {
+        let suite: &[(u64, usize, &str)] = &[
+            (0, 0, "0"),
+            (0, 9, "0"),
+            (1, 0, "1"),
+            (123, 5, "0.00123"),
+            (100_000, 9, "0.0001"),
+            (123_456, 5, "1.23456"),
+            (2_000_000_000_000, 9, "2000"),
+            (20_000, 4, "2"),
+            (u64::MAX, 9, "18446744073.709551615"),
+            (u64::MAX, 20, "0.18446744073709551615"),
+            (1, 25, "0.0000000000000000000000001"),
+        ];
+
+        for &(value, decimals, expected) in suite {
+            let mut buffer = [0; BUFFER_LEN + 10];
+            let out = u64_to_fp_str(value, decimals, &mut buffer).unwrap();
+            assert_eq!(core::str::from_utf8(out).unwrap(), expected);
+        }
+
+        for &(value, decimals, _) in &suite[..suite.len() - 1] {
+            fp_str_matches(value, decimals);
+        }
+    }
+
+    #[test]
+    fn fixed_point_buffer_too_small() {
+        let mut buffer = [0; 5];
+        assert!(u64_to_fp_str(12_345, 2, &mut buffer).is_err());
+        assert_eq!(u64_to_fp_str(12_340, 3, &mut buffer).unwrap(), b"12.34");
+    }
+
+    #[test]
+    fn durations() {
+        let suite: &[(u64, &str)] = &[
+            (0, "0s"),
+            (1, "1s"),
+            (86_400, "1d"),
+            (90_061, "1d 1h 1m 1s"),
+            (129_600, "1d 12h"),
+            (31_536_000, "365d"),
+            (3_600 + 30, "1h 30s"),
+        ];
+
+        for &(seconds, expected) in suite {
+            let mut buffer = [0; 32];
+            let out = duration_to_str(seconds, &mut buffer).unwrap();
+            assert_eq!(core::str::from_utf8(out).unwrap(), expected);
+        }
+
+        let mut buffer = [0; 4];
+        assert!(duration_to_str(90_061, &mut buffer).is_err());
+    }
+
+    // host timings, only meant to compare both implementations:
+    // `just bench`
+    #[test]
+    #[ignore]
+    fn bench_fixed_point() {
+        use std::{hint::black_box, println, time::Instant};
+
+        const ROUNDS: u64 = 1_000_000;
+        // amounts of every magnitude, from nAVAX to millions of AVAX
+        let value = |i: u64| (i * 0x9E37_79B9) >> (i % 48);
+
+        let start = Instant::now();
+        for i in 0..ROUNDS {
+            let mut buffer = [0; BUFFER_LEN];
+            black_box(fp_str_inplace(black_box(value(i)), 9, &mut buffer));
+        }
+        let inplace = start.elapsed();
+
+        let start = Instant::now();
+        for i in 0..ROUNDS {
+            let mut buffer = [0; BUFFER_LEN];
+            black_box(u64_to_fp_str(black_box(value(i)), 9, &mut buffer).unwrap());
+        }
+        let fused = start.elapsed();
+
+        println!(
+            "fixed point: in place {:?}, fused {:?}",
+            inplace / ROUNDS as u32,
+            fused / ROUNDS as u32
+        );
+    }
+
+    #[cfg(not(miri))]
+    proptest! {
+        #[test]
+        fn fixed_point_matches_inplace(value: u64, decimals in 0usize..20) {
+            fp_str_matches(value, decimals)
+        }
+    }
+}
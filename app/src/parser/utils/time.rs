@@ -13,49 +13,17 @@
 *  See the License for the specific language governing permissions and
 *  limitations under the License.
 ********************************************************************************/
-use crate::parser::{u64_to_str, u8_to_str, FORMATTED_STR_DATE_LEN};
+use super::format::write_padded;
+use crate::parser::FORMATTED_STR_DATE_LEN;
 use crate::sys::{pic_str, PIC};
 use arrayvec::ArrayVec;
 use arrayvec::CapacityError;
 
-use lexical_core::Number;
-
-const MONTH_DAYS: &[u8; 12] = &[31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31];
-
-const YEAR_LOOKUP: &[u32; 400] = &[
-    0, 365, 730, 1096, 1461, 1826, 2191, 2557, 2922, 3287, 3652, 4018, 4383, 4748, 5113, 5479,
-    5844, 6209, 6574, 6940, 7305, 7670, 8035, 8401, 8766, 9131, 9496, 9862, 10227, 10592, 10957,
-    11323, 11688, 12053, 12418, 12784, 13149, 13514, 13879, 14245, 14610, 14975, 15340, 15706,
-    16071, 16436, 16801, 17167, 17532, 17897, 18262, 18628, 18993, 19358, 19723, 20089, 20454,
-    20819, 21184, 21550, 21915, 22280, 22645, 23011, 23376, 23741, 24106, 24472, 24837, 25202,
-    25567, 25933, 26298, 26663, 27028, 27394, 27759, 28124, 28489, 28855, 29220, 29585, 29950,
-    30316, 30681, 31046, 31411, 31777, 32142, 32507, 32872, 33238, 33603, 33968, 34333, 34699,
-    35064, 35429, 35794, 36160, 36525, 36890, 37255, 37621, 37986, 38351, 38716, 39082, 39447,
-    39812, 40177, 40543, 40908, 41273, 41638, 42004, 42369, 42734, 43099, 43465, 43830, 44195,
-    44560, 44926, 45291, 45656, 46021, 46387, 46752, 47117, 47482, 47847, 48212, 48577, 48942,
-    49308, 49673, 50038, 50403, 50769, 51134, 51499, 51864, 52230, 52595, 52960, 53325, 53691,
-    54056, 54421, 54786, 55152, 55517, 55882, 56247, 56613, 56978, 57343, 57708, 58074, 58439,
-    58804, 59169, 59535, 59900, 60265, 60630, 60996, 61361, 61726, 62091, 62457, 62822, 63187,
-    63552, 63918, 64283, 64648, 65013, 65379, 65744, 66109, 66474, 66840, 67205, 67570, 67935,
-    68301, 68666, 69031, 69396, 69762, 70127, 70492, 70857, 71223, 71588, 71953, 72318, 72684,
-    73049, 73414, 73779, 74145, 74510, 74875, 75240, 75606, 75971, 76336, 76701, 77067, 77432,
-    77797, 78162, 78528, 78893, 79258, 79623, 79989, 80354, 80719, 81084, 81450, 81815, 82180,
-    82545, 82911, 83276, 83641, 84006, 84371, 84736, 85101, 85466, 85832, 86197, 86562, 86927,
-    87293, 87658, 88023, 88388, 88754, 89119, 89484, 89849, 90215, 90580, 90945, 91310, 91676,
-    92041, 92406, 92771, 93137, 93502, 93867, 94232, 94598, 94963, 95328, 95693, 96059, 96424,
-    96789, 97154, 97520, 97885, 98250, 98615, 98981, 99346, 99711, 100076, 100442, 100807, 101172,
-    101537, 101903, 102268, 102633, 102998, 103364, 103729, 104094, 104459, 104825, 105190, 105555,
-    105920, 106286, 106651, 107016, 107381, 107747, 108112, 108477, 108842, 109208, 109573, 109938,
-    110303, 110669, 111034, 111399, 111764, 112130, 112495, 112860, 113225, 113591, 113956, 114321,
-    114686, 115052, 115417, 115782, 116147, 116513, 116878, 117243, 117608, 117974, 118339, 118704,
-    119069, 119435, 119800, 120165, 120530, 120895, 121260, 121625, 121990, 122356, 122721, 123086,
-    123451, 123817, 124182, 124547, 124912, 125278, 125643, 126008, 126373, 126739, 127104, 127469,
-    127834, 128200, 128565, 128930, 129295, 129661, 130026, 130391, 130756, 131122, 131487, 131852,
-    132217, 132583, 132948, 133313, 133678, 134044, 134409, 134774, 135139, 135505, 135870, 136235,
-    136600, 136966, 137331, 137696, 138061, 138427, 138792, 139157, 139522, 139888, 140253, 140618,
-    140983, 141349, 141714, 142079, 142444, 142810, 143175, 143540, 143905, 144271, 144636, 145001,
-    145366, 145732,
-];
+// days from 1970-01-01 to 2369-01-01,
+// dates are only supported before that
+const MAX_DAYS: i64 = 145_732;
+
+const SECS_PER_DAY: i64 = 86_400;
 
 #[cfg_attr(any(test, feature = "derive-debug"), derive(Debug))]
 pub enum TimeError {
@@ -69,20 +37,8 @@ impl<T> From<CapacityError<T>> for TimeError {
     }
 }
 
-// this is used to add a leading 0
-// to a single digit number, to "emulate"
-// format!("{:0>2}", 1); which returns 01
-// this is used to format month, days, hours, minutes
-// and seconds when formatting timestamps.
-macro_rules! add_padding {
-    ($num:expr, $string:expr) => {
-        if $num < 10 {
-            $string.try_push(b'0')?;
-        }
-    };
-}
-
 #[cfg_attr(any(test, feature = "derive-debug"), derive(Debug))]
+#[cfg_attr(test, derive(PartialEq, Eq))]
 pub struct Date {
     day: u8,
     month: u8,
@@ -92,64 +48,51 @@ pub struct Date {
     sec: u8,
 }
 
+/// Converts a number of `days` since 1970-01-01
+/// to a (year, month, day) civil date
+///
+/// This is the `civil_from_days` algorithm by Howard Hinnant,
+/// which works on 400-year eras and 153-day month groups, starting
+/// the year on March so that the leap day is the last of it,
+/// without any lookup table or loop.
+pub fn civil_from_days(days: i64) -> (i64, u8, u8) {
+    // shift the epoch to 0000-03-01
+    let z = days + 719_468;
+    let era = z.div_euclid(146_097);
+    // day of era [0, 146096]
+    let doe = z.rem_euclid(146_097);
+    // year of era [0, 399]
+    let yoe = (doe - doe / 1_460 + doe / 36_524 - doe / 146_096) / 365;
+    // day of year, starting at March 1st [0, 365]
+    let doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    // month, starting at March [0, 11]
+    let mp = (5 * doy + 2) / 153;
+
+    let day = doy - (153 * mp + 2) / 5 + 1;
+    let month = if mp < 10 { mp + 3 } else { mp - 9 };
+    let year = yoe + era * 400 + (month <= 2) as i64;
+
+    (year, month as u8, day as u8)
+}
+
 /// Conversts a unix `timestamp`
 /// returns a date
 pub fn timestamp_to_date(timestamp: i64) -> Result<Date, TimeError> {
-    let month_days = PIC::new(MONTH_DAYS).into_inner();
-    let year_lookup = PIC::new(YEAR_LOOKUP).into_inner();
-
-    let mut t = timestamp;
-
-    let tm_sec = (t % 60) as u8;
-    t -= tm_sec as i64;
-    t /= 60;
-
-    let tm_min = (t % 60) as u8;
-    t -= tm_min as i64;
-    t /= 60;
-
-    let tm_hour = (t % 24) as u8;
-    t -= tm_hour as i64;
-    t /= 24;
-
-    // Look up tm_year
-    let mut tm_year = 0;
-
-    while tm_year < year_lookup.len() && year_lookup[tm_year] <= t as _ {
-        tm_year += 1;
-    }
-
-    if tm_year == 0 || tm_year == year_lookup.len() {
+    let days = timestamp.div_euclid(SECS_PER_DAY);
+    if !(0..MAX_DAYS).contains(&days) {
         return Err(TimeError::InvalidTimestamp);
     }
-    tm_year -= 1;
 
-    let mut tm_day: u16 = (t as u32 - year_lookup[tm_year] + 1) as u16;
-    tm_year += 1970;
-
-    // Get day/month
-    let leap = ((tm_year % 4 == 0) && (tm_year % 100 != 0 || tm_year % 400 == 0)) as u8;
-
-    let mut tm_mon = 0;
-    for i in 0..12 {
-        tm_mon = i;
-        let mut tmp = month_days[tm_mon];
-        tmp += if tm_mon == 1 { leap } else { 0 };
-
-        if tm_day <= tmp as _ {
-            break;
-        }
-        tm_day -= tmp as u16;
-    }
-    tm_mon += 1;
+    let secs = timestamp.rem_euclid(SECS_PER_DAY);
+    let (year, month, day) = civil_from_days(days);
 
     Ok(Date {
-        day: tm_day as u8,
-        month: tm_mon as _,
-        year: tm_year as _,
-        hour: tm_hour,
-        min: tm_min,
-        sec: tm_sec,
+        day,
+        month,
+        year: year as _,
+        hour: (secs / 3_600) as _,
+        min: (secs / 60 % 60) as _,
+        sec: (secs % 60) as _,
     })
 }
 
@@ -160,56 +103,31 @@ pub fn timestamp_to_str_date(
 ) -> Result<ArrayVec<u8, FORMATTED_STR_DATE_LEN>, TimeError> {
     let date = timestamp_to_date(timestamp)?;
 
-    let mut date_str = ArrayVec::<_, FORMATTED_STR_DATE_LEN>::new();
-    let mut num_buff = [0; u64::FORMATTED_SIZE_DECIMAL + 2];
-
-    // separators
-    let dash = b'-';
-    let space = b' ';
-    let colon = b':';
-    let utc = pic_str!(b"UTC"!);
-
-    // year, does not require adding leading
-    // zeroes
-    let num =
-        u64_to_str(date.year as _, &mut num_buff[..]).map_err(|_| TimeError::BufferTooSmall)?;
-    date_str.try_extend_from_slice(num)?;
-    date_str.try_push(dash)?;
-    // month
-    add_padding!(date.month, date_str);
-    let num =
-        u8_to_str(date.month as _, &mut num_buff[..]).map_err(|_| TimeError::BufferTooSmall)?;
-    date_str.try_extend_from_slice(num)?;
-    date_str.try_push(dash)?;
-    // day
-    add_padding!(date.day, date_str);
-    let num = u8_to_str(date.day, &mut num_buff[..]).map_err(|_| TimeError::BufferTooSmall)?;
-    date_str.try_extend_from_slice(num)?;
-    date_str.try_push(space)?;
-
-    // time
-    // hour
-    add_padding!(date.hour, date_str);
-    let num = u8_to_str(date.hour, &mut num_buff[..]).map_err(|_| TimeError::BufferTooSmall)?;
-    date_str.try_extend_from_slice(num)?;
-    date_str.try_push(colon)?;
-    // min
-    add_padding!(date.min, date_str);
-    let num = u8_to_str(date.min, &mut num_buff[..]).map_err(|_| TimeError::BufferTooSmall)?;
-    date_str.try_extend_from_slice(num)?;
-    date_str.try_push(colon)?;
-    // seconds
-    add_padding!(date.sec, date_str);
-    let num = u8_to_str(date.sec, &mut num_buff[..]).map_err(|_| TimeError::BufferTooSmall)?;
-    date_str.try_extend_from_slice(num)?;
-    date_str.try_push(space)?;
-
     // it is redundant to have Utc appended at the end
     // as by definition unix-timestamp is Utc, but this
     // keeps compatibility with legacy app
-    date_str.try_extend_from_slice(&utc[..])?;
+    let utc = pic_str!(b"UTC"!);
 
-    Ok(date_str)
+    // every field has a fixed width, years included
+    // as they are always within 1970 and 2368,
+    // so they are written straight at their position:
+    // YYYY-MM-DD hh:mm:ss UTC
+    let mut date_str = [0; FORMATTED_STR_DATE_LEN];
+    write_padded(date.year as _, &mut date_str[0..4]);
+    date_str[4] = b'-';
+    write_padded(date.month as _, &mut date_str[5..7]);
+    date_str[7] = b'-';
+    write_padded(date.day as _, &mut date_str[8..10]);
+    date_str[10] = b' ';
+    write_padded(date.hour as _, &mut date_str[11..13]);
+    date_str[13] = b':';
+    write_padded(date.min as _, &mut date_str[14..16]);
+    date_str[16] = b':';
+    write_padded(date.sec as _, &mut date_str[17..19]);
+    date_str[19] = b' ';
+    date_str[20..].copy_from_slice(&utc[..]);
+
+    Ok(ArrayVec::from(date_str))
 }
 
 #[cfg(test)]
@@ -237,4 +155,95 @@ mod tests {
             assert_eq!(&date_str, test_date);
         }
     }
+
+    #[test]
+    fn civil_dates() {
+        use time::{Duration, OffsetDateTime};
+
+        for days in 0..MAX_DAYS {
+            let date = (OffsetDateTime::UNIX_EPOCH + Duration::days(days)).date();
+            let expected = (date.year() as i64, date.month() as u8, date.day());
+
+            assert_eq!(civil_from_days(days), expected);
+        }
+
+        assert!(timestamp_to_date(-1).is_err());
+        assert!(timestamp_to_date(MAX_DAYS * SECS_PER_DAY - 1).is_ok());
+        assert!(timestamp_to_date(MAX_DAYS * SECS_PER_DAY).is_err());
+    }
+
+    // the previous conversion, scanning a table with
+    // the first day of each year and then the months
+    fn scan_civil_from_days(year_starts: &[i64], days: i64) -> (i64, u8, u8) {
+        const MONTH_DAYS: [i64; 12] = [31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31];
+
+        let mut year = 0;
+        while year < year_starts.len() && year_starts[year] <= days {
+            year += 1;
+        }
+        let mut day = days - year_starts[year - 1];
+        let year = year as i64 + 1969;
+
+        let leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+        let mut month = 0;
+        while month < 12 {
+            let len = MONTH_DAYS[month] + (month == 1 && leap) as i64;
+            if day < len {
+                break;
+            }
+            day -= len;
+            month += 1;
+        }
+
+        (year, month as u8 + 1, day as u8 + 1)
+    }
+
+    // host timings, only meant to compare both conversions:
+    // `just bench`
+    #[test]
+    #[ignore]
+    fn bench_civil_from_days() {
+        use std::{hint::black_box, println, time::Instant, vec::Vec};
+
+        const ROUNDS: i64 = 20;
+
+        let year_starts = (1970..2370)
+            .scan(0, |start, year| {
+                let this = *start;
+                let leap = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+                *start += 365 + leap as i64;
+                Some(this)
+            })
+            .collect::<Vec<_>>();
+
+        let start = Instant::now();
+        for _ in 0..ROUNDS {
+            for days in 0..MAX_DAYS {
+                black_box(scan_civil_from_days(&year_starts, black_box(days)));
+            }
+        }
+        let scan = start.elapsed();
+
+        let start = Instant::now();
+        for _ in 0..ROUNDS {
+            for days in 0..MAX_DAYS {
+                black_box(civil_from_days(black_box(days)));
+            }
+        }
+        let table_free = start.elapsed();
+
+        let n = (ROUNDS * MAX_DAYS) as u32;
+        println!(
+            "civil_from_days: table scan {:?}, table-free {:?}",
+            scan / n,
+            table_free / n
+        );
+
+        for days in 0..MAX_DAYS {
+            assert_eq!(
+                scan_civil_from_days(&year_starts, days),
+                civil_from_days(days)
+            );
+        }
+    }
 }
@@ -77,6 +77,20 @@ impl<'b, W: FromBytes<'b>> FromBytes<'b> for Validator<'b, W> {
 
         Ok(rem)
     }
+
+    fn validate(input: &'b [u8]) -> Result<&'b [u8], nom::Err<ParserError>> {
+        let rem = NodeId::validate(input)?;
+
+        let (rem, (start_time, endtime)) = tuple((be_i64, be_i64))(rem)?;
+
+        let rem = W::validate(rem)?;
+
+        if endtime <= start_time {
+            return Err(ParserError::InvalidTimestamp.into());
+        }
+
+        Ok(rem)
+    }
 }
 
 impl<'b, W: DisplayableItem> DisplayableItem for Validator<'b, W> {
@@ -29,11 +29,30 @@ pub use convert_to_rs::{convert_der_to_rs, ConvertError};
 mod buffer_upload;
 pub use buffer_upload::*;
 
+mod msg_stream;
+pub use msg_stream::MsgStream;
+
+mod paged_buffer;
+pub use paged_buffer::{FlashStats, PagedBuffer};
+
+mod upload_refs;
+pub use upload_refs::{UploadRefs, COMPRESSED_PAYLOAD};
+
+mod response_stream;
+pub use response_stream::ResponseStream;
+
+mod upload_seq;
+pub use upload_seq::{
+    crc32, UploadProgress, SEQUENCED_PAYLOAD, SEQUENCE_ACK_LEN, SEQUENCE_HEADER_LEN,
+};
+
 mod app_mode;
 pub use app_mode::*;
 
 pub mod blind_sign_toggle;
 
+pub mod trace;
+
 #[cfg(test)]
 #[macro_export]
 macro_rules! assert_error_code {
@@ -19,15 +19,12 @@ use crate::{
     constants::ApduError,
     handlers::{
         lock::LockError,
-        resources::{BUFFERAccessors, BUFFER},
+        resources::{AppContext, BUFFERAccessors},
         ZPacketType,
     },
 };
 
-use super::ApduBufferRead;
-
-#[bolos::lazy_static]
-static mut INIT_LEN: usize = 0;
+use super::{ApduBufferRead, COMPRESSED_PAYLOAD, SEQUENCED_PAYLOAD, SEQUENCE_ACK_LEN};
 
 pub struct Uploader {
     accessor: BUFFERAccessors,
@@ -40,11 +37,20 @@ pub enum UploaderError {
     /// PacketType wasn't init, next or last
     PacketTypeInvalid,
 
-    /// Error with `BUFFER` lock
+    /// Error with `AppContext::buffer` lock
     Lock(LockError),
 
-    /// Error writing to `BUFFER`
+    /// Error writing to `AppContext::buffer`
     Nvm(NVMError),
+
+    /// Malformed compressed payload
+    Compression,
+
+    /// Sequenced payload out of order or corrupted
+    Sequence,
+
+    /// Payload doesn't fit in `AppContext::buffer`
+    Capacity,
 }
 
 impl From<LockError> for UploaderError {
@@ -65,7 +71,10 @@ impl From<UploaderError> for ApduError {
             UploaderError::PacketTypeInvalid | UploaderError::PacketTypeParseError => {
                 ApduError::InvalidP1P2
             }
-            UploaderError::Nvm(_) => ApduError::DataInvalid,
+            UploaderError::Nvm(_)
+            | UploaderError::Compression
+            | UploaderError::Sequence
+            | UploaderError::Capacity => ApduError::DataInvalid,
             UploaderError::Lock(e) => e.into(),
         }
     }
@@ -80,16 +89,16 @@ pub struct UploaderOutput {
 
 impl Drop for UploaderOutput {
     fn drop(&mut self) {
-        unsafe {
-            if let Ok(zbuffer) = BUFFER.acquire(self.accessor) {
-                zbuffer.reset();
+        let buffer = unsafe { &mut AppContext::current().buffer };
 
-                //we managed to acquire so we should release too
-                let _ = BUFFER.release(self.accessor);
-            }
+        if let Ok(zbuffer) = buffer.acquire(self.accessor) {
+            zbuffer.reset();
 
-            //couldn't acquire BUFFER so someone is trying to use it
+            //we managed to acquire so we should release too
+            let _ = buffer.release(self.accessor);
         }
+
+        //couldn't acquire BUFFER so someone is trying to use it
     }
 }
 
@@ -103,41 +112,63 @@ impl Uploader {
     #[inline(never)]
     pub fn upload(
         &mut self,
+        ctx: &mut AppContext,
         buffer: &ApduBufferRead<'_>,
     ) -> Result<Option<UploaderOutput>, UploaderError> {
-        let packet_type =
-            ZPacketType::new(buffer.p1()).map_err(|_| UploaderError::PacketTypeParseError)?;
+        // the init packet is always sent as is,
+        // the following ones can be compressed, see `UploadRefs`,
+        // and sequenced, see `UploadProgress`
+        let compressed = buffer.p1() & COMPRESSED_PAYLOAD != 0;
+        let sequenced = buffer.p1() & SEQUENCED_PAYLOAD != 0;
+        let packet_type = ZPacketType::new(buffer.p1() & !(COMPRESSED_PAYLOAD | SEQUENCED_PAYLOAD))
+            .map_err(|_| UploaderError::PacketTypeParseError)?;
 
         if packet_type.is_init() {
-            let zbuffer = unsafe { BUFFER.lock(self.accessor) };
+            let zbuffer = ctx.buffer.lock(self.accessor);
             zbuffer.reset();
+            ctx.upload_refs.reset();
+            ctx.upload_progress.reset();
 
             zbuffer.write(&[buffer.p2()])?;
             if let Ok(payload) = buffer.payload() {
-                unsafe {
-                    *INIT_LEN = payload.len();
-                }
+                ctx.upload_init_len = payload.len();
                 zbuffer.write(payload)?;
             }
 
             Ok(None)
-        } else if packet_type.is_next() {
-            let zbuffer = unsafe { BUFFER.acquire(self.accessor)? };
+        } else {
+            let zbuffer = ctx.buffer.acquire(self.accessor)?;
 
             if let Ok(payload) = buffer.payload() {
-                zbuffer.write(payload)?;
+                let payload = if sequenced {
+                    ctx.upload_progress.check(payload)?
+                } else {
+                    Some(payload)
+                };
+
+                if let Some(payload) = payload {
+                    // a packet is written in full or not at all,
+                    // so a rejected one can be sent again
+                    if compressed {
+                        ctx.upload_refs.expand(zbuffer, payload)?;
+                    } else if zbuffer.len() + payload.len() > zbuffer.capacity() {
+                        return Err(UploaderError::Capacity);
+                    } else {
+                        zbuffer.write(payload)?;
+                    }
+
+                    if sequenced {
+                        ctx.upload_progress.advance(payload)?;
+                    }
+                }
             }
 
-            Ok(None)
-        } else if packet_type.is_last() {
-            let zbuffer = unsafe { BUFFER.acquire(self.accessor)? };
-
-            if let Ok(payload) = buffer.payload() {
-                zbuffer.write(payload)?;
+            if packet_type.is_next() {
+                return Ok(None);
             }
 
             let data = zbuffer.read_exact();
-            let (head, tail) = data[1..].split_at(unsafe { *INIT_LEN });
+            let (head, tail) = data[1..].split_at(ctx.upload_init_len);
 
             Ok(Some(UploaderOutput {
                 p2: data[0],
@@ -145,8 +176,20 @@ impl Uploader {
                 data: tail,
                 accessor: self.accessor,
             }))
-        } else {
-            Err(UploaderError::PacketTypeInvalid)
         }
     }
+
+    /// Writes the reply to a packet which didn't complete the upload,
+    /// returning its length
+    ///
+    /// Only sequenced packets are acknowledged, with the number
+    /// of bytes received so far
+    pub fn ack(ctx: &AppContext, p1: u8, out: &mut [u8]) -> usize {
+        if p1 & SEQUENCED_PAYLOAD == 0 || p1 & !(COMPRESSED_PAYLOAD | SEQUENCED_PAYLOAD) == 0 {
+            return 0;
+        }
+
+        out[..SEQUENCE_ACK_LEN].copy_from_slice(&ctx.upload_progress.received().to_be_bytes());
+        SEQUENCE_ACK_LEN
+    }
 }
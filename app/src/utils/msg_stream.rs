@@ -0,0 +1,345 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use core::mem::MaybeUninit;
+
+use bolos::hash::{Hasher, Keccak, Sha256};
+
+use crate::{
+    constants::ApduError as Error,
+    handlers::resources::ZBuffer,
+    parser::{MAX_ASCII_LEN, U32_SIZE},
+};
+
+enum MsgHasher {
+    Keccak(Keccak<32>),
+    Sha256(Sha256),
+}
+
+impl MsgHasher {
+    fn update(&mut self, data: &[u8]) -> Result<(), Error> {
+        match self {
+            Self::Keccak(k) => k.update(data),
+            Self::Sha256(s) => s.update(data),
+        }
+        .map_err(|_| Error::Unknown)
+    }
+
+    fn finalize(&mut self) -> Result<[u8; 32], Error> {
+        match self {
+            Self::Keccak(k) => k.finalize_dirty(),
+            Self::Sha256(s) => s.finalize_dirty(),
+        }
+        .map_err(|_| Error::Unknown)
+    }
+}
+
+/// Keeps track of a message while it's being uploaded
+///
+/// The message is expected as: tag | msg.len() as 4-bytes big-endian integer | msg
+///
+/// Everything is hashed as it arrives, but only the preview of the message
+/// is written to `AppContext::buffer`, that is the length followed by
+/// the first [`MAX_ASCII_LEN`] bytes of the message,
+/// see [`crate::parser::Message::preview_from_bytes_into`].
+pub struct MsgStream {
+    hasher: MsgHasher,
+    // expected at the start of the data, it's checked but not kept
+    tag: &'static [u8],
+    received: usize,
+    len: [u8; U32_SIZE],
+    // whether all the bytes after the tag are ascii
+    is_ascii: bool,
+}
+
+impl MsgStream {
+    fn new(hasher: MsgHasher, tag: &'static [u8]) -> Self {
+        Self {
+            hasher,
+            tag,
+            received: 0,
+            len: [0; U32_SIZE],
+            is_ascii: true,
+        }
+    }
+
+    /// Starts a stream of an ethereum personal message
+    ///
+    /// `header` is hashed before the received data,
+    /// as it's not part of it
+    #[inline(never)]
+    pub fn new_keccak(header: &[u8]) -> Result<Self, Error> {
+        let mut hasher = {
+            let mut k = MaybeUninit::uninit();
+            Keccak::<32>::new_gce(&mut k).map_err(|_| Error::Unknown)?;
+
+            //safe: initialized
+            unsafe { k.assume_init() }
+        };
+        hasher.update(header).map_err(|_| Error::Unknown)?;
+
+        Ok(Self::new(MsgHasher::Keccak(hasher), &[]))
+    }
+
+    /// Starts a stream of a message starting with `tag`,
+    /// which is hashed together with the message
+    #[inline(never)]
+    pub fn new_sha256(tag: &'static [u8]) -> Result<Self, Error> {
+        let hasher = {
+            let mut s = MaybeUninit::uninit();
+            Sha256::new_gce(&mut s).map_err(|_| Error::Unknown)?;
+
+            //safe: initialized
+            unsafe { s.assume_init() }
+        };
+
+        Ok(Self::new(MsgHasher::Sha256(hasher), tag))
+    }
+
+    // number of bytes before the message
+    fn msg_offset(&self) -> usize {
+        self.tag.len() + U32_SIZE
+    }
+
+    /// Returns the length of the message, if received already
+    pub fn msg_len(&self) -> Option<usize> {
+        if self.received < self.msg_offset() {
+            return None;
+        }
+
+        Some(u32::from_be_bytes(self.len) as usize)
+    }
+
+    /// Returns true once all the bytes of the message were received
+    pub fn is_complete(&self) -> bool {
+        match self.msg_len() {
+            Some(len) => self.received - self.msg_offset() == len,
+            None => false,
+        }
+    }
+
+    /// Retrieve the hash of the received message
+    ///
+    /// Fails if the message was not ascii
+    pub fn finalize(&mut self) -> Result<[u8; 32], Error> {
+        if !self.is_complete() {
+            return Err(Error::ApduCodeConditionsNotSatisfied);
+        }
+
+        if !self.is_ascii {
+            return Err(Error::DataInvalid);
+        }
+
+        self.hasher.finalize()
+    }
+
+    /// Process a new chunk of the message
+    #[inline(never)]
+    pub fn feed(&mut self, buffer: &mut ZBuffer, mut data: &[u8]) -> Result<(), Error> {
+        self.hasher.update(data)?;
+
+        while !data.is_empty() {
+            let tag_len = self.tag.len();
+
+            let n = if self.received < tag_len {
+                let n = core::cmp::min(tag_len - self.received, data.len());
+                if data[..n] != self.tag[self.received..][..n] {
+                    return Err(Error::DataInvalid);
+                }
+
+                n
+            } else if self.received < self.msg_offset() {
+                let offset = self.received - tag_len;
+                let n = core::cmp::min(U32_SIZE - offset, data.len());
+                self.len[offset..][..n].copy_from_slice(&data[..n]);
+                self.is_ascii &= data[..n].is_ascii();
+
+                if offset + n == U32_SIZE {
+                    buffer.write(&self.len).map_err(|_| Error::ExecutionError)?;
+                }
+
+                n
+            } else {
+                let offset = self.received - self.msg_offset();
+                let missing = self.msg_len().unwrap_or_default() - offset;
+
+                // more bytes than what the message length says
+                if data.len() > missing {
+                    return Err(Error::DataInvalid);
+                }
+
+                let kept = core::cmp::min(MAX_ASCII_LEN.saturating_sub(offset), data.len());
+                if kept > 0 {
+                    buffer
+                        .write(&data[..kept])
+                        .map_err(|_| Error::ExecutionError)?;
+                }
+                self.is_ascii &= data.is_ascii();
+
+                data.len()
+            };
+
+            self.received += n;
+            data = &data[n..];
+        }
+
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::handlers::resources::{AppContext, BUFFERAccessors};
+    use std::vec::Vec;
+
+    const ETH_HEADER: &[u8] = b"\x19Ethereum Signed Message:\n";
+    const AVAX_TAG: &[u8] = b"\x1AAvalanche Signed Message:\n";
+
+    /// len | msg, with `len` bytes of printable ascii,
+    /// or a non-ascii byte past what is previewed when `ascii` is false
+    fn message(len: usize, ascii: bool) -> Vec<u8> {
+        let mut msg: Vec<u8> = (0..len).map(|i| b' ' + (i % 95) as u8).collect();
+        if !ascii {
+            msg[len - 1] = 0x80;
+        }
+
+        [&(len as u32).to_be_bytes()[..], &msg].concat()
+    }
+
+    /// Streams `data` cut at each offset of `cuts`,
+    /// returning the digest and what was kept in the buffer
+    fn stream(
+        mut stream: MsgStream,
+        data: &[u8],
+        cuts: &[usize],
+    ) -> (Result<[u8; 32], Error>, Vec<u8>) {
+        //safe: the context of the test thread, only used here
+        let ctx = unsafe { AppContext::current() };
+        let buffer = ctx.buffer.lock(BUFFERAccessors::SignMsg);
+        buffer.reset();
+
+        let mut start = 0;
+        for &end in cuts.iter().chain(Some(&data.len())) {
+            stream.feed(buffer, &data[start..end]).unwrap();
+            start = end;
+        }
+        assert!(stream.is_complete());
+
+        (stream.finalize(), buffer.read_exact().to_vec())
+    }
+
+    /// What the whole message buffered before hashing gave:
+    /// the digest of `prefix | data`, if `data` is all ascii
+    fn buffered<H: Hasher<32>>(prefix: &[u8], data: &[u8]) -> Result<[u8; 32], Error> {
+        if !data.is_ascii() {
+            return Err(Error::DataInvalid);
+        }
+
+        H::digest(&[prefix, data].concat()).map_err(|_| Error::Unknown)
+    }
+
+    fn preview(data: &[u8]) -> &[u8] {
+        &data[..core::cmp::min(data.len(), U32_SIZE + MAX_ASCII_LEN)]
+    }
+
+    #[test]
+    fn keccak_matches_buffered() {
+        // 200 has a non-ascii length, which is rejected too
+        for len in [1, MAX_ASCII_LEN, MAX_ASCII_LEN + 1, 200, 300] {
+            for ascii in [true, false] {
+                let data = message(len, ascii);
+                let expected = buffered::<Keccak<32>>(ETH_HEADER, &data);
+
+                // inside the length, at the end of it, at the end of the preview
+                let boundaries = [1, 3, U32_SIZE, U32_SIZE + MAX_ASCII_LEN];
+                let mut cuts: Vec<usize> = boundaries
+                    .iter()
+                    .copied()
+                    .filter(|&cut| cut < data.len())
+                    .collect();
+
+                for cuts in [&[][..], &cuts[..1], &cuts[..]] {
+                    let new = MsgStream::new_keccak(ETH_HEADER).unwrap();
+                    let (digest, kept) = stream(new, &data, cuts);
+                    assert_eq!(digest, expected, "len {} cuts {:?}", len, cuts);
+                    assert_eq!(&kept[..], preview(&data));
+                }
+
+                // one byte at a time
+                cuts = (1..data.len()).collect();
+                let new = MsgStream::new_keccak(ETH_HEADER).unwrap();
+                assert_eq!(stream(new, &data, &cuts).0, expected);
+            }
+        }
+    }
+
+    #[test]
+    fn sha256_matches_buffered() {
+        let tag_len = AVAX_TAG.len();
+
+        for len in [1, MAX_ASCII_LEN, MAX_ASCII_LEN + 1, 200, 300] {
+            for ascii in [true, false] {
+                let msg = message(len, ascii);
+                let data = [AVAX_TAG, &msg].concat();
+                let expected = buffered::<Sha256>(AVAX_TAG, &msg);
+
+                // inside the tag, at its end, inside the length, at the end of the preview
+                let boundaries = [5, tag_len, tag_len + 2, tag_len + U32_SIZE + MAX_ASCII_LEN];
+                let cuts: Vec<usize> = boundaries
+                    .iter()
+                    .copied()
+                    .filter(|&cut| cut < data.len())
+                    .collect();
+
+                for cuts in [&[][..], &cuts[..1], &cuts[1..3], &cuts[..]] {
+                    let new = MsgStream::new_sha256(AVAX_TAG).unwrap();
+                    let (digest, kept) = stream(new, &data, cuts);
+                    assert_eq!(digest, expected, "len {} cuts {:?}", len, cuts);
+                    assert_eq!(&kept[..], preview(&msg));
+                }
+
+                let cuts: Vec<usize> = (1..data.len()).collect();
+                let new = MsgStream::new_sha256(AVAX_TAG).unwrap();
+                assert_eq!(stream(new, &data, &cuts).0, expected);
+            }
+        }
+    }
+
+    #[test]
+    fn rejects_bad_tag_and_extra_bytes() {
+        //safe: the context of the test thread, only used here
+        let ctx = unsafe { AppContext::current() };
+        let buffer = ctx.buffer.lock(BUFFERAccessors::SignMsg);
+        buffer.reset();
+
+        let mut stream = MsgStream::new_sha256(AVAX_TAG).unwrap();
+        // the tag is checked while it's received
+        stream.feed(buffer, &AVAX_TAG[..5]).unwrap();
+        assert_eq!(stream.feed(buffer, b"x"), Err(Error::DataInvalid));
+
+        let data = message(10, true);
+        let mut stream = MsgStream::new_keccak(ETH_HEADER).unwrap();
+        stream.feed(buffer, &data[..6]).unwrap();
+        assert_eq!(
+            stream.finalize(),
+            Err(Error::ApduCodeConditionsNotSatisfied)
+        );
+        assert_eq!(
+            stream.feed(buffer, &[&data[6..], b"!"].concat()),
+            Err(Error::DataInvalid)
+        );
+    }
+}
@@ -0,0 +1,215 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use arrayvec::ArrayVec;
+use bolos::{nvm::NVMError, SwappingBuffer};
+
+use super::{
+    trace::{self, TraceId},
+    ApduPanic,
+};
+
+/// Number of bytes written to flash since the app started
+///
+/// The counters are never reset, not even by [`PagedBuffer::reset`],
+/// so the writes of an operation are the difference between
+/// the counters read before and after it
+#[derive(Clone, Copy, Default, PartialEq, Eq)]
+#[cfg_attr(test, derive(Debug))]
+pub struct FlashStats {
+    pub bytes: u32,
+    pub writes: u32,
+}
+
+/// A [`SwappingBuffer`] which coalesces writes into whole NVM pages
+///
+/// As long as the data fits in the RAM stage every write goes straight through,
+/// once it doesn't the incoming bytes are collected until the next
+/// page boundary, so every write to the flash stage is page-aligned
+/// instead of being one write per chunk.
+pub struct PagedBuffer<const RAM: usize, const FLASH: usize, const PAGE: usize> {
+    inner: SwappingBuffer<'static, 'static, RAM, FLASH>,
+    // bytes written to `inner`
+    written: usize,
+    // bytes waiting for the next page boundary
+    pending: ArrayVec<u8, PAGE>,
+    stats: FlashStats,
+}
+
+impl<const RAM: usize, const FLASH: usize, const PAGE: usize> PagedBuffer<RAM, FLASH, PAGE> {
+    pub fn new(inner: SwappingBuffer<'static, 'static, RAM, FLASH>) -> Self {
+        Self {
+            inner,
+            written: 0,
+            pending: ArrayVec::new(),
+            stats: FlashStats::default(),
+        }
+    }
+
+    /// Number of bytes written so far
+    pub fn len(&self) -> usize {
+        self.written + self.pending.len()
+    }
+
+    /// Number of bytes that can be written in total
+    pub fn capacity(&self) -> usize {
+        FLASH
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Copies the bytes written at `offset` into `out`,
+    /// without flushing the pending ones
+    ///
+    /// Returns `None` if not enough bytes were written yet
+    pub fn read_back(&mut self, offset: usize, out: &mut [u8]) -> Option<()> {
+        let end = offset.checked_add(out.len())?;
+        if end > self.len() {
+            return None;
+        }
+
+        let flushed = self.inner.read_exact();
+        for (pos, b) in (offset..end).zip(out.iter_mut()) {
+            *b = if pos < self.written {
+                flushed[pos]
+            } else {
+                self.pending[pos - self.written]
+            };
+        }
+
+        Some(())
+    }
+
+    /// Returns the flash usage counters, see [`FlashStats`]
+    pub fn flash_stats(&self) -> FlashStats {
+        self.stats
+    }
+
+    #[inline(never)]
+    pub fn write(&mut self, mut data: &[u8]) -> Result<(), NVMError> {
+        // still in the RAM stage, nothing to coalesce
+        if self.pending.is_empty() && self.len() + data.len() <= RAM {
+            self.inner.write(data)?;
+            self.written += data.len();
+
+            return Ok(());
+        }
+
+        // wouldn't fit anyways, let `inner` report it
+        if self.len() + data.len() > FLASH {
+            self.flush()?;
+            return self.inner.write(data);
+        }
+
+        while !data.is_empty() {
+            let room = PAGE - self.len() % PAGE;
+            let n = core::cmp::min(room, data.len());
+
+            self.pending.extend(data[..n].iter().copied());
+            data = &data[n..];
+
+            if self.len() % PAGE == 0 {
+                self.flush()?;
+            }
+        }
+
+        Ok(())
+    }
+
+    /// Writes the pending bytes to `inner`
+    fn flush(&mut self) -> Result<(), NVMError> {
+        if self.pending.is_empty() {
+            return Ok(());
+        }
+
+        let total = self.len();
+        let _span = (total > RAM).then(|| trace::span(TraceId::NvmWrite));
+        if total > RAM {
+            // the first write past the RAM stage moves
+            // its content to flash too
+            let bytes = if self.written <= RAM {
+                total
+            } else {
+                self.pending.len()
+            };
+
+            self.stats.bytes = self.stats.bytes.saturating_add(bytes as u32);
+            self.stats.writes = self.stats.writes.saturating_add(1);
+        }
+
+        self.inner.write(&self.pending)?;
+        self.written = total;
+        self.pending.clear();
+
+        Ok(())
+    }
+
+    /// Forgets the written bytes, the flash stats are kept
+    pub fn reset(&mut self) {
+        self.inner.reset();
+        self.written = 0;
+        self.pending.clear();
+    }
+
+    pub fn read_exact(&mut self) -> &'static [u8] {
+        // capacity was checked when writing
+        self.flush().apdu_unwrap();
+
+        self.inner.read_exact()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use bolos::new_swapping_buffer;
+
+    #[test]
+    fn coalesced_writes() {
+        let mut buffer: PagedBuffer<8, 0x100, 16> =
+            PagedBuffer::new(new_swapping_buffer!(8, 0x100));
+
+        let data = (0..100u8).collect::<std::vec::Vec<_>>();
+
+        // fits in RAM
+        buffer.write(&data[..5]).unwrap();
+        assert_eq!(buffer.flash_stats(), FlashStats::default());
+
+        for chunk in data[5..].chunks(7) {
+            buffer.write(chunk).unwrap();
+        }
+        assert_eq!(buffer.read_exact(), &data[..]);
+
+        // pages of 16 bytes, the last one partially filled
+        let stats = buffer.flash_stats();
+        assert_eq!(stats.writes, 7);
+        assert_eq!(stats.bytes, 100);
+
+        buffer.reset();
+        assert!(buffer.read_exact().is_empty());
+        assert_eq!(buffer.flash_stats(), stats);
+
+        // one page flushed, the rest still pending
+        let mut out = [0; 10];
+        buffer.write(&data[..20]).unwrap();
+        buffer.read_back(10, &mut out).unwrap();
+        assert_eq!(&out, &data[10..20]);
+        assert!(buffer.read_back(15, &mut out).is_none());
+
+        assert!(buffer.write(&[0; 0x101]).is_err());
+    }
+}
@@ -0,0 +1,104 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Responses longer than a single APDU
+//!
+//! A handler can write its result here instead of the APDU buffer,
+//! the dispatcher then returns it in frames as large as the buffer allows:
+//! every frame but the last comes with [`ApduError::MoreDataAvailable`],
+//! and the following ones are retrieved with `INS_GET_RESPONSE`.
+
+use arrayvec::ArrayVec;
+
+use crate::constants::ApduError;
+
+pub struct ResponseStream<const N: usize> {
+    data: ArrayVec<u8, N>,
+    // bytes already returned
+    read: usize,
+}
+
+impl<const N: usize> Default for ResponseStream<N> {
+    fn default() -> Self {
+        Self {
+            data: ArrayVec::new(),
+            read: 0,
+        }
+    }
+}
+
+impl<const N: usize> ResponseStream<N> {
+    pub fn reset(&mut self) {
+        self.data.clear();
+        self.read = 0;
+    }
+
+    /// Whether all the response was returned already
+    pub fn is_empty(&self) -> bool {
+        self.read == self.data.len()
+    }
+
+    /// Number of bytes that can still be written
+    pub fn room(&self) -> usize {
+        self.data.remaining_capacity()
+    }
+
+    pub fn write(&mut self, bytes: &[u8]) -> Result<(), ApduError> {
+        self.data
+            .try_extend_from_slice(bytes)
+            .map_err(|_| ApduError::OutputBufferTooSmall)
+    }
+
+    /// Moves the next bytes of the response to `out`,
+    /// returning how many were moved
+    pub fn read(&mut self, out: &mut [u8]) -> usize {
+        let pending = &self.data[self.read..];
+        let len = core::cmp::min(pending.len(), out.len());
+
+        out[..len].copy_from_slice(&pending[..len]);
+        self.read += len;
+
+        len
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn frames() {
+        let mut stream = ResponseStream::<8>::default();
+        assert!(stream.is_empty());
+
+        stream.write(&[1, 2, 3, 4, 5]).unwrap();
+        assert_eq!(stream.room(), 3);
+        assert!(stream.write(&[6, 7, 8, 9]).is_err());
+
+        let mut out = [0; 2];
+        assert_eq!(stream.read(&mut out), 2);
+        assert_eq!(out, [1, 2]);
+        assert_eq!(stream.read(&mut out), 2);
+        assert_eq!(out, [3, 4]);
+        assert!(!stream.is_empty());
+
+        assert_eq!(stream.read(&mut out), 1);
+        assert_eq!(out[0], 5);
+        assert!(stream.is_empty());
+
+        stream.reset();
+        assert_eq!(stream.room(), 8);
+    }
+}
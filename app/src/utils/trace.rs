@@ -0,0 +1,377 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Begin/end events recorded into a ring buffer, for timing analysis
+//!
+//! Spans are opened with [`span`] and closed when the returned guard is
+//! dropped. Without the `trace` feature recording does nothing and
+//! compiles away.
+//!
+//! The timestamp of each event depends on where the app runs:
+//! * host builds: microseconds since the context was created
+//! * `armbench`: instructions executed since the start of the run
+//! * device: there's no clock available to the app, so the number of
+//!   the event is used instead, which only keeps the order
+//!
+//! On the device the buffer is exported as `TRACE` (see [`TraceBuffer`]
+//! for the layout) and `armbench --trace` turns it into a Chrome trace.
+//! Host builds keep it in the context of each thread instead,
+//! see [`crate::handlers::resources::AppContext`], which tests
+//! turn into a Chrome trace with [`chrome_trace`].
+
+/// Identifies what a span measures
+///
+/// The values are part of the trace format, see `armbench/src/trace.rs`
+#[repr(u8)]
+#[derive(Clone, Copy, PartialEq, Eq)]
+#[cfg_attr(test, derive(Debug))]
+pub enum TraceId {
+    /// An APDU from dispatch to response, the argument is the instruction
+    Apdu = 0,
+    /// Parsing and preparing the review of an AVAX transaction
+    StartSign = 1,
+    /// Parsing a transaction
+    Parse = 2,
+    /// Hashing a transaction
+    Hash = 3,
+    /// Deriving a public key
+    Derive = 4,
+    /// Rendering an item of a review, the argument is the item
+    Render = 5,
+    /// Writing to flash
+    NvmWrite = 6,
+    /// Work done on a ticker event
+    Idle = 7,
+}
+
+impl TraceId {
+    pub const NAMES: [&'static str; 8] = [
+        "apdu",
+        "start_sign",
+        "parse",
+        "hash",
+        "derive",
+        "render",
+        "nvm_write",
+        "idle",
+    ];
+}
+
+pub const PHASE_BEGIN: u8 = b'B';
+pub const PHASE_END: u8 = b'E';
+
+#[repr(C)]
+#[derive(Clone, Copy, PartialEq, Eq)]
+#[cfg_attr(test, derive(Debug))]
+pub struct Event {
+    pub time: u32,
+    /// A [`TraceId`]
+    pub id: u8,
+    /// [`PHASE_BEGIN`] or [`PHASE_END`]
+    pub phase: u8,
+    pub arg: u16,
+}
+
+impl Event {
+    const EMPTY: Self = Self {
+        time: 0,
+        id: 0,
+        phase: 0,
+        arg: 0,
+    };
+}
+
+/// Keeps the last `N` events, `N` must be a power of 2
+///
+/// The layout is fixed for the host tools: the number of events recorded
+/// (u32), followed by the `N` events of 8 bytes each, little endian,
+/// with the event number `i` at `i % N`
+#[repr(C)]
+pub struct TraceBuffer<const N: usize> {
+    recorded: u32,
+    events: [Event; N],
+}
+
+impl<const N: usize> TraceBuffer<N> {
+    pub const fn new() -> Self {
+        Self {
+            recorded: 0,
+            events: [Event::EMPTY; N],
+        }
+    }
+
+    /// Number of events recorded since the last reset,
+    /// including the ones overwritten
+    pub fn recorded(&self) -> u32 {
+        self.recorded
+    }
+
+    pub fn push(&mut self, event: Event) {
+        self.events[self.recorded as usize % N] = event;
+        self.recorded = self.recorded.wrapping_add(1);
+    }
+
+    pub fn reset(&mut self) {
+        self.recorded = 0;
+    }
+
+    /// The events kept, oldest first
+    pub fn events(&self) -> impl Iterator<Item = &Event> {
+        let recorded = self.recorded as usize;
+        let len = core::cmp::min(recorded, N);
+        let first = recorded - len;
+
+        (first..recorded).map(move |i| &self.events[i % N])
+    }
+}
+
+/// Events kept by the app
+pub const TRACE_EVENTS: usize = 256;
+
+cfg_if::cfg_if! {
+    if #[cfg(all(feature = "trace", any(test, fuzzing)))] {
+        use std::time::Instant;
+
+        use crate::handlers::resources::AppContext;
+
+        /// The trace of a context of a host build
+        pub struct ContextTrace {
+            start: Instant,
+            events: TraceBuffer<TRACE_EVENTS>,
+        }
+
+        impl ContextTrace {
+            pub fn new() -> Self {
+                Self {
+                    start: Instant::now(),
+                    events: TraceBuffer::new(),
+                }
+            }
+        }
+
+        fn record(id: TraceId, phase: u8, arg: u16) {
+            //safe: only the trace is accessed, and not kept
+            let trace = unsafe { &mut AppContext::current().trace };
+
+            let time = trace.start.elapsed().as_micros() as u32;
+            trace.events.push(Event {
+                time,
+                id: id as u8,
+                phase,
+                arg,
+            });
+        }
+
+        /// The events recorded in the context of this thread, oldest first
+        pub fn events() -> std::vec::Vec<Event> {
+            //safe: only the trace is accessed, and not kept
+            let trace = unsafe { &AppContext::current().trace };
+            trace.events.events().copied().collect()
+        }
+
+        pub fn reset() {
+            //safe: only the trace is accessed, and not kept
+            unsafe { AppContext::current() }.trace.events.reset()
+        }
+    } else if #[cfg(feature = "trace")] {
+        /// Read by the host tools, see [`TraceBuffer`]
+        ///
+        /// Not part of the context, so the tools find it by its symbol
+        /// and recording doesn't initialize the context
+        #[no_mangle]
+        pub static mut TRACE: TraceBuffer<TRACE_EVENTS> = TraceBuffer::new();
+
+        #[cfg(armbench)]
+        fn clock(_: u32) -> u32 {
+            extern "C" {
+                // counts instructions, see `armbench/shim.c`
+                fn armbench_clock() -> u32;
+            }
+
+            unsafe { armbench_clock() }
+        }
+
+        #[cfg(not(armbench))]
+        fn clock(recorded: u32) -> u32 {
+            recorded
+        }
+
+        #[inline(never)]
+        fn record(id: TraceId, phase: u8, arg: u16) {
+            //safe: single threaded
+            let trace = unsafe { &mut TRACE };
+
+            trace.push(Event {
+                time: clock(trace.recorded()),
+                id: id as u8,
+                phase,
+                arg,
+            });
+        }
+
+        pub fn reset() {
+            //safe: single threaded
+            unsafe { TRACE.reset() }
+        }
+    } else {
+        #[inline(always)]
+        fn record(_: TraceId, _: u8, _: u16) {}
+
+        #[inline(always)]
+        pub fn reset() {}
+    }
+}
+
+/// Ends its span when dropped
+#[must_use]
+pub struct Span {
+    id: TraceId,
+}
+
+impl Drop for Span {
+    #[inline(always)]
+    fn drop(&mut self) {
+        record(self.id, PHASE_END, 0);
+    }
+}
+
+/// Begins a span, ended when the returned guard is dropped
+#[inline(always)]
+pub fn span(id: TraceId) -> Span {
+    span_with(id, 0)
+}
+
+/// Begins a span with an argument, see [`TraceId`]
+#[inline(always)]
+pub fn span_with(id: TraceId, arg: u16) -> Span {
+    record(id, PHASE_BEGIN, arg);
+    Span { id }
+}
+
+/// Converts `events` to the Chrome trace format,
+/// to be opened with `chrome://tracing` or Perfetto
+#[cfg(test)]
+pub fn chrome_trace<'e>(events: impl IntoIterator<Item = &'e Event>) -> serde_json::Value {
+    let events = events
+        .into_iter()
+        .map(|event| {
+            let name = TraceId::NAMES
+                .get(event.id as usize)
+                .copied()
+                .unwrap_or("unknown");
+
+            serde_json::json!({
+                "name": name,
+                "ph": std::string::String::from(event.phase as char),
+                "ts": event.time,
+                "pid": 0,
+                "tid": 0,
+                "args": { "arg": event.arg },
+            })
+        })
+        .collect::<std::vec::Vec<_>>();
+
+    serde_json::json!({ "traceEvents": events })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn event(time: u32) -> Event {
+        Event {
+            time,
+            id: TraceId::Parse as u8,
+            phase: PHASE_BEGIN,
+            arg: 0,
+        }
+    }
+
+    #[test]
+    fn keeps_the_last_events() {
+        let mut trace = TraceBuffer::<4>::new();
+        assert_eq!(trace.events().count(), 0);
+
+        for time in 0..3 {
+            trace.push(event(time));
+        }
+        let times = trace.events().map(|e| e.time).collect::<std::vec::Vec<_>>();
+        assert_eq!(times, [0, 1, 2]);
+
+        for time in 3..7 {
+            trace.push(event(time));
+        }
+        let times = trace.events().map(|e| e.time).collect::<std::vec::Vec<_>>();
+        assert_eq!(times, [3, 4, 5, 6]);
+        assert_eq!(trace.recorded(), 7);
+
+        trace.reset();
+        assert_eq!(trace.events().count(), 0);
+    }
+
+    #[test]
+    fn chrome_trace_events() {
+        let mut trace = TraceBuffer::<8>::new();
+        trace.push(Event {
+            time: 10,
+            id: TraceId::Apdu as u8,
+            phase: PHASE_BEGIN,
+            arg: 0x02,
+        });
+        trace.push(Event {
+            time: 25,
+            id: TraceId::Apdu as u8,
+            phase: PHASE_END,
+            arg: 0,
+        });
+
+        let json = chrome_trace(trace.events());
+        let events = json["traceEvents"].as_array().unwrap();
+
+        assert_eq!(events.len(), 2);
+        assert_eq!(events[0]["name"], "apdu");
+        assert_eq!(events[0]["ph"], "B");
+        assert_eq!(events[0]["args"]["arg"], 2);
+        assert_eq!(events[1]["ph"], "E");
+        assert_eq!(events[1]["ts"], 25);
+    }
+
+    #[cfg(feature = "trace")]
+    #[test]
+    fn spans_are_nested() {
+        reset();
+        {
+            let _apdu = span_with(TraceId::Apdu, 0x02);
+            let _parse = span(TraceId::Parse);
+        }
+
+        let events = events();
+        let recorded = events
+            .iter()
+            .map(|e| (e.id, e.phase))
+            .collect::<std::vec::Vec<_>>();
+
+        assert_eq!(
+            recorded,
+            [
+                (TraceId::Apdu as u8, PHASE_BEGIN),
+                (TraceId::Parse as u8, PHASE_BEGIN),
+                (TraceId::Parse as u8, PHASE_END),
+                (TraceId::Apdu as u8, PHASE_END),
+            ]
+        );
+        assert!(events.windows(2).all(|w| w[0].time <= w[1].time));
+    }
+}
@@ -0,0 +1,258 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Compressed upload payloads
+//!
+//! Avalanche transactions repeat the same 32-byte values (asset ids, tx ids)
+//! and 20-byte addresses over and over, so the client can send each of them once
+//! and refer to it afterwards.
+//!
+//! A compressed payload is a sequence of tokens, never split between packets:
+//!
+//! | tag           | token                                  |
+//! |---------------|----------------------------------------|
+//! | `0x00..=0x7F` | `tag + 1` literal bytes follow         |
+//! | `0x80..=0x9F` | 32-byte value number `tag & 0x1F`      |
+//! | `0xA0..=0xBF` | 20-byte value number `tag & 0x1F`      |
+//! | `0xC0..=0xFF` | reserved                               |
+//!
+//! Values are numbered in order of appearance: the first reference to the next
+//! free number is followed by the value itself.
+//!
+//! The buffer always receives the original bytes, so the data reviewed
+//! and signed doesn't depend on how it was uploaded.
+
+use core::convert::TryFrom;
+
+use arrayvec::ArrayVec;
+
+use super::{PagedBuffer, UploaderError};
+
+/// Set in P1 of the packets carrying a compressed payload
+pub const COMPRESSED_PAYLOAD: u8 = 0x80;
+
+const MAX_VALUES: usize = 32;
+const INDEX_MASK: u8 = 0x1F;
+
+const LITERAL_MAX_TAG: u8 = 0x7F;
+const SHORT_TAG: u8 = 0xA0;
+const RESERVED_TAG: u8 = 0xC0;
+
+const LONG_LEN: usize = 32;
+const SHORT_LEN: usize = 20;
+
+/// The values seen during a compressed upload
+///
+/// Only their position in the buffer is kept, the bytes are read
+/// back from there when referenced again.
+#[derive(Default)]
+pub struct UploadRefs {
+    long: ArrayVec<u16, MAX_VALUES>,
+    short: ArrayVec<u16, MAX_VALUES>,
+}
+
+impl UploadRefs {
+    pub fn reset(&mut self) {
+        self.long.clear();
+        self.short.clear();
+    }
+
+    /// Writes the data encoded in `payload` to `out`
+    ///
+    /// The payload is checked in full first, so when it's rejected
+    /// neither `out` nor the values seen are changed, and the packet
+    /// can be sent again
+    #[inline(never)]
+    pub fn expand<const RAM: usize, const FLASH: usize, const PAGE: usize>(
+        &mut self,
+        out: &mut PagedBuffer<RAM, FLASH, PAGE>,
+        mut payload: &[u8],
+    ) -> Result<(), UploaderError> {
+        let len = self.expanded_len(out.len(), payload)?;
+        if out.len() + len > out.capacity() {
+            return Err(UploaderError::Capacity);
+        }
+
+        while let Some((&tag, rest)) = payload.split_first() {
+            let (len, values) = match tag {
+                0..=LITERAL_MAX_TAG => {
+                    let len = tag as usize + 1;
+                    let literal = rest.get(..len).ok_or(UploaderError::Compression)?;
+                    out.write(literal)?;
+
+                    payload = &rest[len..];
+                    continue;
+                }
+                _ if tag < SHORT_TAG => (LONG_LEN, &mut self.long),
+                _ if tag < RESERVED_TAG => (SHORT_LEN, &mut self.short),
+                _ => return Err(UploaderError::Compression),
+            };
+
+            payload = Self::expand_value(out, values, len, (tag & INDEX_MASK) as usize, rest)?;
+        }
+
+        Ok(())
+    }
+
+    /// Returns the number of bytes `payload` expands to,
+    /// when written after the first `written` bytes
+    fn expanded_len(&self, written: usize, mut payload: &[u8]) -> Result<usize, UploaderError> {
+        let mut len = 0;
+        // values that would be seen by then
+        let mut num_long = self.long.len();
+        let mut num_short = self.short.len();
+
+        while let Some((&tag, rest)) = payload.split_first() {
+            let (value_len, num_values) = match tag {
+                0..=LITERAL_MAX_TAG => {
+                    let literal_len = tag as usize + 1;
+                    payload = rest.get(literal_len..).ok_or(UploaderError::Compression)?;
+                    len += literal_len;
+
+                    continue;
+                }
+                _ if tag < SHORT_TAG => (LONG_LEN, &mut num_long),
+                _ if tag < RESERVED_TAG => (SHORT_LEN, &mut num_short),
+                _ => return Err(UploaderError::Compression),
+            };
+
+            let index = (tag & INDEX_MASK) as usize;
+            payload = rest;
+            if index == *num_values {
+                // its offset has to fit in the refs
+                u16::try_from(written + len).map_err(|_| UploaderError::Compression)?;
+                payload = rest.get(value_len..).ok_or(UploaderError::Compression)?;
+                *num_values += 1;
+            } else if index > *num_values {
+                return Err(UploaderError::Compression);
+            }
+
+            len += value_len;
+        }
+
+        Ok(len)
+    }
+
+    fn expand_value<'p, const RAM: usize, const FLASH: usize, const PAGE: usize>(
+        out: &mut PagedBuffer<RAM, FLASH, PAGE>,
+        values: &mut ArrayVec<u16, MAX_VALUES>,
+        len: usize,
+        index: usize,
+        data: &'p [u8],
+    ) -> Result<&'p [u8], UploaderError> {
+        // a new value, remember where it's written
+        if index == values.len() {
+            let value = data.get(..len).ok_or(UploaderError::Compression)?;
+            let offset = u16::try_from(out.len()).map_err(|_| UploaderError::Compression)?;
+
+            values.push(offset);
+            out.write(value)?;
+
+            return Ok(&data[len..]);
+        }
+
+        let offset = *values.get(index).ok_or(UploaderError::Compression)?;
+
+        let mut value = [0; LONG_LEN];
+        let value = &mut value[..len];
+        out.read_back(offset as usize, value)
+            .ok_or(UploaderError::Compression)?;
+        out.write(value)?;
+
+        Ok(data)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use bolos::new_swapping_buffer;
+    use std::{vec, vec::Vec};
+
+    fn expand(payloads: &[&[u8]]) -> Result<Vec<u8>, UploaderError> {
+        let mut buffer: PagedBuffer<8, 0x400, 16> =
+            PagedBuffer::new(new_swapping_buffer!(8, 0x400));
+        let mut refs = UploadRefs::default();
+
+        for payload in payloads {
+            refs.expand(&mut buffer, payload)?;
+        }
+
+        Ok(buffer.read_exact().to_vec())
+    }
+
+    #[test]
+    fn references() {
+        let asset = [0xAA; LONG_LEN];
+        let address = [0xBB; SHORT_LEN];
+
+        let first = [&[0x02, 1, 2, 3, 0x80][..], &asset, &[0xA0], &address].concat();
+        let second = [0x80, 0x00, 4, 0xA0, 0x80];
+
+        let mut expected = vec![1, 2, 3];
+        expected.extend_from_slice(&asset);
+        expected.extend_from_slice(&address);
+        expected.extend_from_slice(&asset);
+        expected.push(4);
+        expected.extend_from_slice(&address);
+        expected.extend_from_slice(&asset);
+
+        assert_eq!(expand(&[&first, &second]).unwrap(), expected);
+    }
+
+    #[test]
+    fn rejected_payload_leaves_no_trace() {
+        let mut buffer: PagedBuffer<8, 0x400, 16> =
+            PagedBuffer::new(new_swapping_buffer!(8, 0x400));
+        let mut refs = UploadRefs::default();
+
+        let asset = [0xAA; LONG_LEN];
+        let other = [0xCC; LONG_LEN];
+
+        let first = [&[0x01, 1, 2, 0x80][..], &asset].concat();
+        refs.expand(&mut buffer, &first).unwrap();
+        let expected = buffer.read_exact().to_vec();
+
+        // a new value, then a reserved tag
+        let bad = [&[0x00, 3, 0x81][..], &other, &[0xC0]].concat();
+        assert!(refs.expand(&mut buffer, &bad).is_err());
+        // more than fits in the buffer
+        let long = [0x80; 40];
+        assert!(refs.expand(&mut buffer, &long).is_err());
+
+        assert_eq!(buffer.read_exact(), &expected[..]);
+
+        // value 1 is still to be sent
+        let second = [&[0x81][..], &other, &[0x80]].concat();
+        refs.expand(&mut buffer, &second).unwrap();
+
+        let mut expected = expected;
+        expected.extend_from_slice(&other);
+        expected.extend_from_slice(&asset);
+        assert_eq!(buffer.read_exact(), &expected[..]);
+    }
+
+    #[test]
+    fn invalid_tokens() {
+        // literal cut short
+        assert!(expand(&[&[0x03, 1, 2]]).is_err());
+        // value cut short
+        assert!(expand(&[&[0xA0, 1, 2]]).is_err());
+        // value never sent
+        assert!(expand(&[&[0x81]]).is_err());
+        // reserved
+        assert!(expand(&[&[0xC0]]).is_err());
+    }
+}
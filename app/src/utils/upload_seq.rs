@@ -0,0 +1,169 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Resumable uploads
+//!
+//! The packets following the first one can be sent with [`SEQUENCED_PAYLOAD`]
+//! set in P1, with their data prefixed by:
+//!
+//! | field    | type      | content                                           |
+//! |----------|-----------|---------------------------------------------------|
+//! | offset   | u16 (BE)  | position of the data in the upload, first excluded|
+//! | checksum | u32 (BE)  | CRC-32 (IEEE) of the data                         |
+//!
+//! The device replies to each of them with the number of bytes received
+//! contiguously so far (u16, BE), so after a transport error the client
+//! can resume from there instead of starting over.
+//! A packet without data only retrieves that number.
+//!
+//! Packets already received are acknowledged without writing them again,
+//! while a packet past the acknowledged offset or with a wrong checksum
+//! is rejected right away.
+//!
+//! Offsets count the bytes as sent, so they can be combined with
+//! [`super::COMPRESSED_PAYLOAD`].
+
+use core::convert::TryInto;
+
+use super::UploaderError;
+
+/// Set in P1 of the packets carrying a sequenced payload
+pub const SEQUENCED_PAYLOAD: u8 = 0x40;
+
+/// Length of the header of a sequenced payload
+pub const SEQUENCE_HEADER_LEN: usize = 2 + 4;
+
+/// Length of the acknowledgment
+pub const SEQUENCE_ACK_LEN: usize = 2;
+
+/// CRC-32 as used by zlib and ethernet
+pub fn crc32(data: &[u8]) -> u32 {
+    const POLY: u32 = 0xEDB8_8320;
+
+    !data.iter().fold(!0, |crc, &b| {
+        (0..8).fold(crc ^ b as u32, |crc, _| {
+            // the mask is either all 0s or all 1s, depending on the last bit
+            (crc >> 1) ^ (POLY & (crc & 1).wrapping_neg())
+        })
+    })
+}
+
+/// Progress of a sequenced upload
+#[derive(Default)]
+pub struct UploadProgress {
+    received: u16,
+}
+
+impl UploadProgress {
+    pub fn reset(&mut self) {
+        self.received = 0;
+    }
+
+    /// Number of bytes received contiguously so far
+    pub fn received(&self) -> u16 {
+        self.received
+    }
+
+    /// Checks a sequenced payload, returning the data
+    /// which should be written next, if any
+    ///
+    /// [`UploadProgress::advance`] must be called once the data is written
+    pub fn check<'p>(&self, payload: &'p [u8]) -> Result<Option<&'p [u8]>, UploaderError> {
+        if payload.len() < SEQUENCE_HEADER_LEN {
+            return Err(UploaderError::Sequence);
+        }
+        let (header, data) = payload.split_at(SEQUENCE_HEADER_LEN);
+
+        if data.is_empty() {
+            return Ok(None);
+        }
+
+        let offset = u16::from_be_bytes(header[..2].try_into().unwrap()) as usize;
+        let checksum = u32::from_be_bytes(header[2..].try_into().unwrap());
+        let received = self.received as usize;
+
+        match offset {
+            // received already, and in full
+            _ if offset + data.len() <= received => Ok(None),
+            _ if offset != received => Err(UploaderError::Sequence),
+            _ if crc32(data) != checksum => Err(UploaderError::Sequence),
+            _ => Ok(Some(data)),
+        }
+    }
+
+    pub fn advance(&mut self, data: &[u8]) -> Result<(), UploaderError> {
+        self.received = data
+            .len()
+            .try_into()
+            .ok()
+            .and_then(|len| self.received.checked_add(len))
+            .ok_or(UploaderError::Sequence)?;
+
+        Ok(())
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::vec::Vec;
+
+    fn chunk(offset: u16, data: &[u8]) -> Vec<u8> {
+        let mut out = offset.to_be_bytes().to_vec();
+        out.extend_from_slice(&crc32(data).to_be_bytes());
+        out.extend_from_slice(data);
+        out
+    }
+
+    #[test]
+    fn checksum() {
+        assert_eq!(crc32(b""), 0);
+        assert_eq!(crc32(b"123456789"), 0xCBF4_3926);
+    }
+
+    #[test]
+    fn resume() {
+        let mut progress = UploadProgress::default();
+
+        let first = chunk(0, &[1, 2, 3]);
+        let data = progress.check(&first).unwrap().unwrap();
+        progress.advance(data).unwrap();
+        assert_eq!(progress.received(), 3);
+
+        // sent again, after a lost acknowledgment
+        assert!(progress.check(&first).unwrap().is_none());
+
+        // a chunk was lost
+        assert!(progress.check(&chunk(6, &[7, 8])).is_err());
+
+        // corrupted
+        let mut corrupted = chunk(3, &[4, 5, 6]);
+        corrupted[SEQUENCE_HEADER_LEN] ^= 1;
+        assert!(progress.check(&corrupted).is_err());
+
+        // only asking where to resume from
+        assert!(progress.check(&chunk(0, &[])).unwrap().is_none());
+        assert_eq!(progress.received(), 3);
+
+        let second = chunk(3, &[4, 5, 6]);
+        let data = progress.check(&second).unwrap().unwrap();
+        assert_eq!(data, &[4, 5, 6]);
+        progress.advance(data).unwrap();
+        assert_eq!(progress.received(), 6);
+
+        // no header
+        assert!(progress.check(&[0, 0]).is_err());
+    }
+}
@@ -0,0 +1,32 @@
+/*******************************************************************************
+ *   (c) 2023 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ********************************************************************************/
+// Platform functions the library expects from the C side of the app,
+// reduced to what the benchmarks need. Anything else provided by the
+// OS is left unresolved, see `link.ld`.
+
+// the image runs at the address it's linked at
+void *pic(void *linked_address) { return linked_address; }
+
+void check_canary() {}
+
+void zemu_log(const char *buf) { (void)buf; }
+
+void zemu_log_stack(const char *ctx) { (void)ctx; }
+
+// written by the emulator on every call, see `rslib::utils::trace`
+volatile unsigned int armbench_clock_value;
+
+unsigned int armbench_clock(void) { return armbench_clock_value; }
@@ -0,0 +1,370 @@
+//! Instruction counts and peak stack of the parser on the device ISA
+//!
+//! The library is built with `--cfg armbench` for a device target and linked
+//! into a bare image (`make -C app rust_armbench`, or `just armbench`),
+//! which is then run here under an emulated Cortex-M, one entry point
+//! of `rslib::armbench` per test vector.
+//!
+//! Calls to the device OS (crypto, NVM...) are not part of the image:
+//! they return 0 right away and are reported separately, so the counts
+//! only cover the code of the app.
+//!
+//! Usage: `armbench <elf> [--cpu m0|m33] [--vectors <dir>] [--save <json>]
+//! [--baseline <json>] [--tolerance <percent>] [--trace <json>]`
+//!
+//! With a baseline, any vector using more instructions than allowed by the
+//! tolerance, or more stack, is reported and the run fails.
+//! CI saves the results of an image built from the base commit and passes
+//! them as the baseline of the new one (`just armbench <rev>` does the same).
+//!
+//! With `--trace`, the spans recorded by a library built with the `trace`
+//! feature (`make -C app rust_armbench TRACE=1`) are written as a Chrome
+//! trace, one process per vector, timed in instructions.
+mod trace;
+
+use std::{collections::BTreeMap, fs, path::PathBuf, process};
+
+use object::{Object, ObjectSection, ObjectSymbol, SectionKind};
+use serde_json::{json, Value};
+use unicorn_engine::{
+    unicorn_const::{Arch, Mode, Permission},
+    ArmCpuModel, RegisterARM, Unicorn,
+};
+
+// see `link.ld`
+const OS_STUB_BASE: u64 = 0;
+const FLASH_BASE: u64 = 0x1000;
+const FLASH_LEN: usize = 0x7F000;
+const RAM_BASE: u64 = 0x2000_0000;
+const RAM_LEN: usize = 0x10000;
+
+// `movs r0, #0; bx lr`
+const OS_STUB: [u8; 4] = [0x00, 0x20, 0x70, 0x47];
+
+// returning here ends the run
+const RETURN_ADDR: u64 = FLASH_BASE + FLASH_LEN as u64 - 4;
+const STACK_TOP: u64 = RAM_BASE + RAM_LEN as u64;
+
+// see `rslib::armbench`
+const KIND_PARSE: u32 = 0;
+const KIND_REVIEW: u32 = 1;
+const KIND_BS58: u32 = 2;
+const KIND_U256: u32 = 3;
+
+// collected while running
+#[derive(Default)]
+struct Stats {
+    instructions: u64,
+    min_sp: u64,
+    os_calls: u64,
+}
+
+struct Measure {
+    instructions: u64,
+    /// Peak stack usage, in bytes
+    stack: u64,
+    os_calls: u64,
+    trace: Vec<trace::Event>,
+}
+
+struct Image {
+    sections: Vec<(u64, Vec<u8>)>,
+    entry: u64,
+    input: u64,
+    input_len: usize,
+    /// `armbench_clock` and the value it returns
+    clock: Option<(u64, u64)>,
+    /// The `TRACE` buffer and its size, when the library records spans
+    trace: Option<(u64, usize)>,
+}
+
+struct Args {
+    elf: PathBuf,
+    cpu: ArmCpuModel,
+    vectors: PathBuf,
+    save: Option<PathBuf>,
+    baseline: Option<PathBuf>,
+    tolerance: f64,
+    trace: Option<PathBuf>,
+}
+
+fn usage() -> ! {
+    eprintln!(
+        "usage: armbench <elf> [--cpu m0|m33] [--vectors <dir>] [--save <json>] \
+         [--baseline <json>] [--tolerance <percent>] [--trace <json>]"
+    );
+    process::exit(2)
+}
+
+fn parse_args() -> Args {
+    let mut args = std::env::args().skip(1);
+
+    let mut parsed = Args {
+        elf: args.next().map(PathBuf::from).unwrap_or_else(|| usage()),
+        cpu: ArmCpuModel::UC_CPU_ARM_CORTEX_M0,
+        vectors: PathBuf::from(concat!(
+            env!("CARGO_MANIFEST_DIR"),
+            "/../app/src/parser/testvectors"
+        )),
+        save: None,
+        baseline: None,
+        tolerance: 1.0,
+        trace: None,
+    };
+
+    while let Some(flag) = args.next() {
+        let value = args.next().unwrap_or_else(|| usage());
+        match flag.as_str() {
+            "--cpu" => {
+                parsed.cpu = match value.as_str() {
+                    "m0" => ArmCpuModel::UC_CPU_ARM_CORTEX_M0,
+                    "m33" => ArmCpuModel::UC_CPU_ARM_CORTEX_M33,
+                    _ => usage(),
+                }
+            }
+            "--vectors" => parsed.vectors = value.into(),
+            "--save" => parsed.save = Some(value.into()),
+            "--baseline" => parsed.baseline = Some(value.into()),
+            "--tolerance" => parsed.tolerance = value.parse().unwrap_or_else(|_| usage()),
+            "--trace" => parsed.trace = Some(value.into()),
+            _ => usage(),
+        }
+    }
+
+    parsed
+}
+
+fn load_image(elf: &PathBuf) -> Image {
+    let bytes = fs::read(elf).expect("reading the image");
+    let obj = object::File::parse(&*bytes).expect("parsing the image");
+
+    let sections = obj
+        .sections()
+        .filter(|section| {
+            matches!(
+                section.kind(),
+                SectionKind::Text | SectionKind::ReadOnlyData | SectionKind::Data
+            )
+        })
+        .map(|section| {
+            let data = section.data().expect("reading a section").to_vec();
+            (section.address(), data)
+        })
+        .collect();
+
+    let find = |name: &str| obj.symbols().find(|symbol| symbol.name() == Ok(name));
+    let symbol = |name: &str| {
+        find(name).unwrap_or_else(|| {
+            panic!(
+                "{} not found, was the image built with --cfg armbench?",
+                name
+            )
+        })
+    };
+
+    let input = symbol("ARMBENCH_INPUT");
+    Image {
+        sections,
+        // thumb
+        entry: symbol("armbench_run").address() & !1,
+        input: input.address(),
+        input_len: input.size() as usize,
+        clock: find("armbench_clock").and_then(|clock| {
+            let value = find("armbench_clock_value")?;
+            Some((clock.address() & !1, value.address()))
+        }),
+        trace: find("TRACE").map(|trace| (trace.address(), trace.size() as usize)),
+    }
+}
+
+/// Runs the benchmark `kind` over `data`, from a fresh state
+fn run(image: &Image, cpu: ArmCpuModel, kind: u32, data: &[u8]) -> Result<Measure, String> {
+    let err = |e| format!("{:?}", e);
+
+    let mut emu = Unicorn::new_with_data(Arch::ARM, Mode::THUMB | Mode::MCLASS, Stats::default())
+        .map_err(err)?;
+    emu.ctl_set_cpu_model(cpu as i32).map_err(err)?;
+
+    emu.mem_map(OS_STUB_BASE, FLASH_BASE as usize, Permission::ALL)
+        .map_err(err)?;
+    emu.mem_map(FLASH_BASE, FLASH_LEN, Permission::ALL)
+        .map_err(err)?;
+    emu.mem_map(RAM_BASE, RAM_LEN, Permission::ALL)
+        .map_err(err)?;
+
+    emu.mem_write(OS_STUB_BASE, &OS_STUB).map_err(err)?;
+    for (address, data) in &image.sections {
+        emu.mem_write(*address, data).map_err(err)?;
+    }
+
+    if data.len() > image.input_len {
+        return Err(format!("input too long ({} bytes)", data.len()));
+    }
+    emu.mem_write(image.input, data).map_err(err)?;
+
+    let clock = image.clock;
+    emu.add_code_hook(OS_STUB_BASE, RETURN_ADDR, move |uc, address, _| {
+        let sp = uc.reg_read(RegisterARM::SP).unwrap_or(STACK_TOP);
+
+        let stats = uc.get_data_mut();
+        if address == OS_STUB_BASE {
+            stats.os_calls += 1;
+        } else if address >= FLASH_BASE {
+            stats.instructions += 1;
+        }
+        stats.min_sp = stats.min_sp.min(sp);
+
+        if let Some((clock, value)) = clock {
+            if address == clock {
+                let now = (uc.get_data().instructions as u32).to_le_bytes();
+                let _ = uc.mem_write(value, &now);
+            }
+        }
+    })
+    .map_err(err)?;
+
+    emu.add_intr_hook(|uc, intno| {
+        eprintln!(
+            "unexpected exception {} at {:#x}",
+            intno,
+            uc.pc_read().unwrap_or(0)
+        );
+        let _ = uc.emu_stop();
+    })
+    .map_err(err)?;
+
+    emu.get_data_mut().min_sp = STACK_TOP;
+    emu.reg_write(RegisterARM::SP, STACK_TOP).map_err(err)?;
+    emu.reg_write(RegisterARM::LR, RETURN_ADDR | 1)
+        .map_err(err)?;
+    emu.reg_write(RegisterARM::R0, kind as u64).map_err(err)?;
+    emu.reg_write(RegisterARM::R1, data.len() as u64)
+        .map_err(err)?;
+
+    emu.emu_start(image.entry | 1, RETURN_ADDR, 0, 0)
+        .map_err(err)?;
+
+    let pc = emu.pc_read().map_err(err)?;
+    if pc != RETURN_ADDR {
+        return Err(format!("stopped at {:#x}", pc));
+    }
+
+    let status = emu.reg_read(RegisterARM::R0).map_err(err)?;
+    if status != 0 {
+        return Err(format!("returned {}", status));
+    }
+
+    let trace = match image.trace {
+        Some((address, size)) => trace::decode(&emu.mem_read_as_vec(address, size).map_err(err)?),
+        None => Vec::new(),
+    };
+
+    let stats = emu.get_data();
+    Ok(Measure {
+        instructions: stats.instructions,
+        stack: STACK_TOP - stats.min_sp,
+        os_calls: stats.os_calls,
+        trace,
+    })
+}
+
+/// The test vectors of the parser, followed by the formatting routines
+fn vectors(dir: &PathBuf) -> Vec<(String, u32, Vec<u8>)> {
+    let mut files = fs::read_dir(dir)
+        .expect("reading the test vectors")
+        .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+        .filter(|path| path.extension().map_or(false, |ext| ext == "json"))
+        .collect::<Vec<_>>();
+    files.sort();
+
+    let mut vectors = Vec::new();
+    for path in files {
+        let name = path.file_stem().unwrap().to_string_lossy().into_owned();
+        let data: Vec<u8> =
+            serde_json::from_slice(&fs::read(&path).expect("reading a test vector"))
+                .unwrap_or_else(|e| panic!("{}: {}", path.display(), e));
+
+        vectors.push((format!("{}/parse", name), KIND_PARSE, data.clone()));
+        vectors.push((format!("{}/review", name), KIND_REVIEW, data));
+    }
+
+    // a tx id, and an address
+    vectors.push(("bs58/32".into(), KIND_BS58, vec![0xA5; 32]));
+    vectors.push(("bs58/20".into(), KIND_BS58, vec![0xA5; 20]));
+    vectors.push(("u256/max".into(), KIND_U256, vec![0xFF; 32]));
+    vectors.push(("u256/1e18".into(), KIND_U256, {
+        let mut n = vec![0; 32];
+        n[24..].copy_from_slice(&1_000_000_000_000_000_000u64.to_be_bytes());
+        n
+    }));
+
+    vectors
+}
+
+fn main() {
+    let args = parse_args();
+    let image = load_image(&args.elf);
+    if args.trace.is_some() && image.trace.is_none() {
+        panic!("TRACE not found, was the library built with TRACE=1?");
+    }
+
+    let baseline: Option<BTreeMap<String, Value>> = args.baseline.as_ref().map(|path| {
+        serde_json::from_slice(&fs::read(path).expect("reading the baseline"))
+            .expect("parsing the baseline")
+    });
+
+    let mut results = BTreeMap::new();
+    let mut trace_events = Vec::new();
+    let mut failed = false;
+
+    println!(
+        "{:<48} {:>12} {:>8} {:>6}",
+        "vector", "instructions", "stack", "os"
+    );
+    for (pid, (name, kind, data)) in vectors(&args.vectors).into_iter().enumerate() {
+        let measure = match run(&image, args.cpu, kind, &data) {
+            Ok(measure) => measure,
+            Err(e) => {
+                println!("{:<48} failed: {}", name, e);
+                failed = true;
+                continue;
+            }
+        };
+
+        let mut note = String::new();
+        if let Some(base) = baseline.as_ref().and_then(|base| base.get(&name)) {
+            let base_instructions = base["instructions"].as_u64().unwrap_or(u64::MAX);
+            let base_stack = base["stack"].as_u64().unwrap_or(u64::MAX);
+
+            let allowed = base_instructions as f64 * (1.0 + args.tolerance / 100.0);
+            if measure.instructions as f64 > allowed || measure.stack > base_stack {
+                note = format!("  REGRESSION (was {} / {})", base_instructions, base_stack);
+                failed = true;
+            }
+        }
+
+        println!(
+            "{:<48} {:>12} {:>8} {:>6}{}",
+            name, measure.instructions, measure.stack, measure.os_calls, note
+        );
+        trace_events.extend(trace::chrome_events(pid, &name, &measure.trace));
+        results.insert(
+            name,
+            json!({ "instructions": measure.instructions, "stack": measure.stack }),
+        );
+    }
+
+    if let Some(path) = args.save {
+        let json = serde_json::to_string_pretty(&results).unwrap();
+        fs::write(path, json).expect("writing the results");
+    }
+
+    if let Some(path) = args.trace {
+        let json = serde_json::to_string(&json!({ "traceEvents": trace_events })).unwrap();
+        fs::write(path, json).expect("writing the trace");
+    }
+
+    if failed {
+        process::exit(1);
+    }
+}
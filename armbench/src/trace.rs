@@ -0,0 +1,72 @@
+//! Decoding of the spans recorded by the library, into Chrome traces
+//!
+//! See `rslib::utils::trace` for the layout of the buffer
+use serde_json::{json, Value};
+
+// see `rslib::utils::trace::TraceId`
+const NAMES: [&str; 8] = [
+    "apdu",
+    "start_sign",
+    "parse",
+    "hash",
+    "derive",
+    "render",
+    "nvm_write",
+    "idle",
+];
+
+const EVENT_LEN: usize = 8;
+
+pub struct Event {
+    /// Instructions executed since the start of the run
+    pub time: u32,
+    pub id: u8,
+    pub phase: u8,
+    pub arg: u16,
+}
+
+/// Decodes the events kept in the buffer, oldest first
+pub fn decode(buffer: &[u8]) -> Vec<Event> {
+    let recorded = u32::from_le_bytes([buffer[0], buffer[1], buffer[2], buffer[3]]) as usize;
+    let events = &buffer[4..];
+
+    let capacity = events.len() / EVENT_LEN;
+    let len = recorded.min(capacity);
+
+    (recorded - len..recorded)
+        .map(|i| {
+            let event = &events[(i % capacity) * EVENT_LEN..][..EVENT_LEN];
+            Event {
+                time: u32::from_le_bytes([event[0], event[1], event[2], event[3]]),
+                id: event[4],
+                phase: event[5],
+                arg: u16::from_le_bytes([event[6], event[7]]),
+            }
+        })
+        .collect()
+}
+
+/// The events of a run, as Chrome trace events of the process `pid`
+///
+/// The timestamps are instruction counts, shown as microseconds
+pub fn chrome_events(pid: usize, name: &str, events: &[Event]) -> Vec<Value> {
+    let mut out = vec![json!({
+        "name": "process_name",
+        "ph": "M",
+        "pid": pid,
+        "args": { "name": name },
+    })];
+
+    out.extend(events.iter().map(|event| {
+        json!({
+            "name": NAMES.get(event.id as usize).copied().unwrap_or("unknown"),
+            "ph": (event.phase as char).to_string(),
+            "ts": event.time,
+            "pid": pid,
+            "tid": 0,
+            "args": { "arg": event.arg },
+        })
+    }));
+
+    out
+}
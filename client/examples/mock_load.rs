@@ -0,0 +1,52 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Sessions per second of the mock device, each one signing a hash,
+//! e.g `make client_load SESSIONS=10000`
+use std::time::Instant;
+
+use futures::executor::block_on;
+use ledger_avalanche::{mock::MockDevice, AvalancheApp, PathSuffix};
+
+fn main() {
+    let sessions: u64 = std::env::args()
+        .nth(1)
+        .and_then(|n| n.parse().ok())
+        .unwrap_or(1000);
+
+    let root = "m/44'/9000'/0'".parse().unwrap();
+    let signers = [PathSuffix(0, 0), PathSuffix(0, 1)];
+
+    let start = Instant::now();
+    block_on(async {
+        for session in 0..sessions {
+            let app = AvalancheApp::new(MockDevice::new());
+
+            let mut hash = [0; 32];
+            hash[..8].copy_from_slice(&session.to_be_bytes());
+            app.sign_hash(&root, &signers, &hash)
+                .await
+                .expect("sign_hash");
+        }
+    });
+    let elapsed = start.elapsed();
+
+    println!(
+        "{} sessions in {:.2?}, {:.0} sessions/s",
+        sessions,
+        elapsed,
+        sessions as f64 / elapsed.as_secs_f64()
+    );
+}
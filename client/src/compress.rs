@@ -0,0 +1,200 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Compression of uploaded payloads, see `app/src/utils/upload_refs.rs` for the format
+use std::collections::{HashMap, HashSet};
+
+const LITERAL_MAX_LEN: usize = 0x80;
+const MAX_UPLOAD_VALUES: usize = 32;
+const LONG_VALUE_TAG: u8 = 0x80;
+const SHORT_VALUE_TAG: u8 = 0xA0;
+const LONG_VALUE_LEN: usize = 32;
+const SHORT_VALUE_LEN: usize = 20;
+
+struct ValueKind<'d> {
+    len: usize,
+    tag: u8,
+    repeated: HashSet<&'d [u8]>,
+    values: HashMap<&'d [u8], u8>,
+}
+
+impl<'d> ValueKind<'d> {
+    fn new(data: &'d [u8], len: usize, tag: u8) -> Self {
+        // values found more than once in the data
+        let mut seen = HashSet::new();
+        let repeated = data
+            .windows(len)
+            .filter(|value| !seen.insert(*value))
+            .collect();
+
+        Self {
+            len,
+            tag,
+            repeated,
+            values: HashMap::new(),
+        }
+    }
+}
+
+fn tokenize(data: &[u8]) -> Vec<Vec<u8>> {
+    let mut tokens = Vec::new();
+    let mut kinds = [
+        ValueKind::new(data, LONG_VALUE_LEN, LONG_VALUE_TAG),
+        ValueKind::new(data, SHORT_VALUE_LEN, SHORT_VALUE_TAG),
+    ];
+
+    let push_literals = |tokens: &mut Vec<Vec<u8>>, literal: &[u8]| {
+        for chunk in literal.chunks(LITERAL_MAX_LEN) {
+            let mut token = Vec::with_capacity(1 + chunk.len());
+            token.push((chunk.len() - 1) as u8);
+            token.extend_from_slice(chunk);
+            tokens.push(token);
+        }
+    };
+
+    let mut literal_start = 0;
+    let mut pos = 0;
+    'next: while pos < data.len() {
+        for kind in kinds.iter_mut() {
+            let value = match data.get(pos..pos + kind.len) {
+                Some(value) if kind.repeated.contains(value) => value,
+                _ => continue,
+            };
+
+            let token = match kind.values.get(value) {
+                Some(index) => vec![kind.tag | index],
+                None if kind.values.len() < MAX_UPLOAD_VALUES => {
+                    // first time, the value follows its number
+                    let index = kind.values.len() as u8;
+                    kind.values.insert(value, index);
+
+                    let mut token = vec![kind.tag | index];
+                    token.extend_from_slice(value);
+                    token
+                }
+                None => continue,
+            };
+
+            push_literals(&mut tokens, &data[literal_start..pos]);
+            tokens.push(token);
+
+            pos += kind.len;
+            literal_start = pos;
+            continue 'next;
+        }
+
+        pos += 1;
+    }
+    push_literals(&mut tokens, &data[literal_start..]);
+
+    tokens
+}
+
+/// Splits `data` in compressed chunks of at most `chunk_size` bytes,
+/// sending repeated 32-byte and 20-byte values (asset ids, tx ids, addresses) only once
+///
+/// Chunks are only split between tokens, as required by the app
+pub fn compress_chunks(data: &[u8], chunk_size: usize) -> Vec<Vec<u8>> {
+    let mut chunks = Vec::new();
+
+    let mut current = Vec::new();
+    for token in tokenize(data) {
+        if current.len() + token.len() > chunk_size {
+            chunks.push(std::mem::take(&mut current));
+        }
+        current.extend_from_slice(&token);
+    }
+
+    if !current.is_empty() {
+        chunks.push(current);
+    }
+
+    chunks
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::CHUNK_SIZE;
+
+    // mirrors UploadRefs::expand on the device
+    fn expand_chunks(chunks: &[Vec<u8>]) -> Vec<u8> {
+        let mut out = Vec::new();
+        let (mut long, mut short) = (Vec::new(), Vec::new());
+
+        for chunk in chunks {
+            let mut p = 0;
+            while p < chunk.len() {
+                let tag = chunk[p];
+                p += 1;
+
+                if tag < LONG_VALUE_TAG {
+                    let end = p + tag as usize + 1;
+                    assert!(end <= chunk.len(), "literal split between chunks");
+                    out.extend_from_slice(&chunk[p..end]);
+                    p = end;
+                    continue;
+                }
+
+                let (len, values) = if tag >= SHORT_VALUE_TAG {
+                    (SHORT_VALUE_LEN, &mut short)
+                } else {
+                    (LONG_VALUE_LEN, &mut long)
+                };
+
+                let index = (tag & 0x1F) as usize;
+                if index == values.len() {
+                    values.push(out.len());
+                    out.extend_from_slice(&chunk[p..p + len]);
+                    p += len;
+                } else {
+                    let offset = values[index];
+                    out.extend_from_within(offset..offset + len);
+                }
+            }
+        }
+
+        out
+    }
+
+    #[test]
+    fn compress_repeated_values() {
+        let asset = [0xAA; 32];
+        let address = [0xBB; 20];
+
+        let mut data = vec![0, 0, 0, 1];
+        for i in 0..20u8 {
+            data.extend_from_slice(&asset);
+            data.extend_from_slice(&[i, 1, 2]);
+            data.extend_from_slice(&address);
+            data.extend_from_slice(&[i; 8]);
+        }
+
+        let chunks = compress_chunks(&data, CHUNK_SIZE);
+        assert!(chunks.iter().all(|chunk| chunk.len() <= CHUNK_SIZE));
+
+        let size: usize = chunks.iter().map(Vec::len).sum();
+        assert!(size < data.len() / 2);
+        assert_eq!(expand_chunks(&chunks), data);
+    }
+
+    #[test]
+    fn compress_without_repetitions() {
+        let data = (0..300).map(|i| i as u8).collect::<Vec<_>>();
+
+        let chunks = compress_chunks(&data, CHUNK_SIZE);
+        assert_eq!(expand_chunks(&chunks), data);
+    }
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+use crate::path::PathError;
+
+/// Status words of the app, see `docs/APDUSPEC.md`
+pub mod status {
+    pub const SUCCESS: u16 = 0x9000;
+    pub const MORE_DATA_AVAILABLE: u16 = 0x6310;
+    pub const EXECUTION_ERROR: u16 = 0x6400;
+    pub const WRONG_LENGTH: u16 = 0x6700;
+    pub const EMPTY_BUFFER: u16 = 0x6982;
+    pub const OUTPUT_BUFFER_TOO_SMALL: u16 = 0x6983;
+    pub const DATA_INVALID: u16 = 0x6A80;
+    pub const CONDITIONS_NOT_SATISFIED: u16 = 0x6985;
+    pub const COMMAND_NOT_ALLOWED: u16 = 0x6986;
+    pub const INVALID_P1_P2: u16 = 0x6B00;
+    pub const INS_NOT_SUPPORTED: u16 = 0x6D00;
+    pub const CLA_NOT_SUPPORTED: u16 = 0x6E00;
+    pub const UNKNOWN: u16 = 0x6F00;
+    pub const BUSY: u16 = 0x9001;
+}
+
+fn describe(code: &u16) -> &'static str {
+    match *code {
+        status::EXECUTION_ERROR => "execution error",
+        status::WRONG_LENGTH => "wrong length",
+        status::EMPTY_BUFFER => "empty buffer",
+        status::OUTPUT_BUFFER_TOO_SMALL => "output buffer too small",
+        status::DATA_INVALID => "data invalid",
+        status::CONDITIONS_NOT_SATISFIED => "conditions not satisfied",
+        status::COMMAND_NOT_ALLOWED => "command not allowed",
+        status::INVALID_P1_P2 => "invalid P1/P2",
+        status::INS_NOT_SUPPORTED => "INS not supported",
+        status::CLA_NOT_SUPPORTED => "CLA not supported, is the Avalanche app open?",
+        status::BUSY => "busy",
+        _ => "unknown",
+    }
+}
+
+#[derive(Debug, thiserror::Error)]
+pub enum LedgerAppError<E: std::error::Error> {
+    #[error("transport error: {0}")]
+    Transport(#[from] E),
+    /// The app answered with an error, `data` is the rest of the answer,
+    /// which may explain it (e.g why a transaction couldn't be parsed)
+    #[error("[{code:#06x}] {}{}", describe(.code), extra_info(.data))]
+    Device { code: u16, data: Vec<u8> },
+    #[error("invalid response from the app")]
+    InvalidResponse,
+    #[error(transparent)]
+    InvalidPath(PathError),
+    #[error("invalid argument: {0}")]
+    InvalidArgument(&'static str),
+}
+
+impl<E: std::error::Error> LedgerAppError<E> {
+    /// The status word returned by the app, if that's the error
+    pub fn status_word(&self) -> Option<u16> {
+        match self {
+            Self::Device { code, .. } => Some(*code),
+            _ => None,
+        }
+    }
+}
+
+fn extra_info(data: &[u8]) -> String {
+    match std::str::from_utf8(data) {
+        Ok(info) if !info.is_empty() => format!(" extra_info=({})", info.trim_end_matches('\0')),
+        _ => String::new(),
+    }
+}
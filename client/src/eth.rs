@@ -0,0 +1,218 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! The EVM instructions of the app, compatible with the Ethereum app
+use std::convert::TryFrom;
+
+use crate::{
+    evm_instructions::*, AvalancheApp, BIP32Path, Exchange, LedgerAppError, Result, CHAIN_CODE_LEN,
+};
+
+// P1 of uploads
+const ETH_FIRST: u8 = 0x00;
+const ETH_NEXT: u8 = 0x80;
+
+// the largest payload of a packet
+const MAX_PAYLOAD: usize = 255;
+
+const NFT_INFO_TYPE: u8 = 1;
+const NFT_INFO_VERSION: u8 = 1;
+const COLLECTION_NAME_MAX_LEN: usize = 50;
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct EthPublicKey {
+    /// Uncompressed public key
+    pub public_key: Vec<u8>,
+    /// Hex encoded, without `0x`
+    pub address: String,
+    pub chain_code: Option<[u8; CHAIN_CODE_LEN]>,
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct EthSignature {
+    pub v: u8,
+    pub r: [u8; 32],
+    pub s: [u8; 32],
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct EthAppConfiguration {
+    /// See `app/src/handlers/eth/get_app_configuration.rs`
+    pub flags: u8,
+    pub major: u8,
+    pub minor: u8,
+    pub patch: u8,
+}
+
+impl<E> AvalancheApp<E>
+where
+    E: Exchange + Send + Sync,
+    E::Error: std::error::Error,
+{
+    /// The public key and address at `path`, `show` to have the user verify the address
+    pub async fn eth_get_public_key(
+        &self,
+        path: &BIP32Path,
+        show: bool,
+        with_chain_code: bool,
+    ) -> Result<EthPublicKey, E::Error> {
+        let response = self
+            .send(
+                CLA_ETH,
+                INS_ETH_GET_PUBLIC_KEY,
+                show as u8,
+                with_chain_code as u8,
+                &path.serialize(),
+            )
+            .await?;
+
+        // [pk_len | pk | address_len | address | chain_code]
+        let (public_key, rest) = crate::split_len_prefixed(&response)?;
+        let (address, chain_code) = crate::split_len_prefixed(rest)?;
+
+        let chain_code = match (with_chain_code, chain_code.len()) {
+            (false, 0) => None,
+            (true, CHAIN_CODE_LEN) => {
+                let mut out = [0; CHAIN_CODE_LEN];
+                out.copy_from_slice(chain_code);
+                Some(out)
+            }
+            _ => return Err(LedgerAppError::InvalidResponse),
+        };
+
+        Ok(EthPublicKey {
+            public_key: public_key.to_vec(),
+            address: String::from_utf8(address.to_vec())
+                .map_err(|_| LedgerAppError::InvalidResponse)?,
+            chain_code,
+        })
+    }
+
+    /// Has the user review the RLP encoded transaction `tx`
+    /// (prefixed with its type for typed transactions), then signs it
+    ///
+    /// For ERC-721 transfers, the collection is provided beforehand
+    /// with [`Self::eth_provide_nft_info`]
+    pub async fn eth_sign_transaction(
+        &self,
+        path: &BIP32Path,
+        tx: &[u8],
+    ) -> Result<EthSignature, E::Error> {
+        self.eth_upload(INS_ETH_SIGN, path, tx).await
+    }
+
+    /// Has the user review `message`, then signs it as an Ethereum signed message
+    pub async fn eth_sign_personal_message(
+        &self,
+        path: &BIP32Path,
+        message: &[u8],
+    ) -> Result<EthSignature, E::Error> {
+        let len =
+            u32::try_from(message.len()).map_err(|_| LedgerAppError::InvalidArgument("message"))?;
+
+        // the app prepends the header itself
+        let mut payload = Vec::with_capacity(4 + message.len());
+        payload.extend_from_slice(&len.to_be_bytes());
+        payload.extend_from_slice(message);
+
+        self.eth_upload(INS_SIGN_ETH_MSG, path, &payload).await
+    }
+
+    pub async fn eth_get_app_configuration(&self) -> Result<EthAppConfiguration, E::Error> {
+        let response = self
+            .send(CLA_ETH, INS_ETH_GET_APP_CONFIGURATION, 0, 0, &[])
+            .await?;
+
+        match response.get(..4) {
+            Some(config) => Ok(EthAppConfiguration {
+                flags: config[0],
+                major: config[1],
+                minor: config[2],
+                patch: config[3],
+            }),
+            None => Err(LedgerAppError::InvalidResponse),
+        }
+    }
+
+    /// Accepted for compatibility with the Ethereum app, the app ignores it
+    pub async fn eth_set_plugin(&self, data: &[u8]) -> Result<(), E::Error> {
+        self.send(CLA_ETH, INS_SET_PLUGIN, 0, 0, data).await?;
+        Ok(())
+    }
+
+    /// Accepted for compatibility with the Ethereum app, the app ignores it
+    /// and recognizes the known tokens on its own
+    pub async fn eth_provide_erc20(&self, descriptor: &[u8]) -> Result<(), E::Error> {
+        self.send(CLA_ETH, INS_ETH_PROVIDE_ERC20, 0, 0, descriptor)
+            .await?;
+        Ok(())
+    }
+
+    /// The name of the ERC-721 collection at `contract`,
+    /// shown when reviewing the next transfer of one of its tokens
+    pub async fn eth_provide_nft_info(
+        &self,
+        contract: &[u8; 20],
+        name: &str,
+        chain_id: u64,
+    ) -> Result<(), E::Error> {
+        if name.len() > COLLECTION_NAME_MAX_LEN {
+            return Err(LedgerAppError::InvalidArgument("name"));
+        }
+
+        let mut data = Vec::with_capacity(3 + name.len() + contract.len() + 8);
+        data.extend_from_slice(&[NFT_INFO_TYPE, NFT_INFO_VERSION, name.len() as u8]);
+        data.extend_from_slice(name.as_bytes());
+        data.extend_from_slice(contract);
+        data.extend_from_slice(&chain_id.to_be_bytes());
+
+        self.send(CLA_ETH, INS_PROVIDE_NFT_INFORMATION, 0, 0, &data)
+            .await?;
+        Ok(())
+    }
+
+    /// Sends `path` and `payload` in packets of up to 255 bytes,
+    /// the last one being answered with the signature once the user reviewed the payload
+    async fn eth_upload(
+        &self,
+        ins: u8,
+        path: &BIP32Path,
+        payload: &[u8],
+    ) -> Result<EthSignature, E::Error> {
+        let mut first = path.serialize();
+        let split = payload.len().min(MAX_PAYLOAD - first.len());
+        first.extend_from_slice(&payload[..split]);
+
+        let mut response = self.send(CLA_ETH, ins, ETH_FIRST, 0, &first).await?;
+        for chunk in payload[split..].chunks(MAX_PAYLOAD) {
+            response = self.send(CLA_ETH, ins, ETH_NEXT, 0, chunk).await?;
+        }
+
+        // [v | r | s]
+        if response.len() != 65 {
+            return Err(LedgerAppError::InvalidResponse);
+        }
+
+        let mut signature = EthSignature {
+            v: response[0],
+            r: [0; 32],
+            s: [0; 32],
+        };
+        signature.r.copy_from_slice(&response[1..33]);
+        signature.s.copy_from_slice(&response[33..]);
+
+        Ok(signature)
+    }
+}
@@ -0,0 +1,621 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Client of the Avalanche app for Ledger devices
+//!
+//! [`AvalancheApp`] sends the instructions of the app over any [`Exchange`] transport:
+//! * a device connected over USB, with [`hid`] (feature `hid`)
+//! * the app itself running in-process, with [`mock::MockDevice`] (feature `mock`)
+//!
+//! See `docs/APDUSPEC.md` for the format of each instruction,
+//! the methods of the EVM instructions are prefixed with `eth_`.
+
+use std::convert::TryFrom;
+
+pub use ledger_transport::{APDUAnswer, APDUCommand, Exchange};
+
+mod compress;
+mod error;
+mod eth;
+mod path;
+
+#[cfg(feature = "mock")]
+pub mod mock;
+
+pub use compress::compress_chunks;
+pub use error::{status, LedgerAppError};
+pub use eth::{EthAppConfiguration, EthPublicKey, EthSignature};
+pub use path::{BIP32Path, PathError, PathSuffix, MAX_PATH_DEPTH};
+
+/// The instructions of the app, see `app/src/constants.rs`
+pub mod instructions {
+    pub const CLA: u8 = 0x80;
+
+    pub const INS_GET_VERSION: u8 = 0x00;
+    pub const INS_GET_WALLET_ID: u8 = 0x01;
+    pub const INS_GET_PUBLIC_KEY: u8 = 0x02;
+    pub const INS_GET_EXTENDED_PUBLIC_KEY: u8 = 0x03;
+    pub const INS_SIGN_HASH: u8 = 0x04;
+    pub const INS_SIGN: u8 = 0x05;
+    pub const INS_SIGN_MSG: u8 = 0x06;
+    pub const INS_SET_POLICY: u8 = 0x07;
+    pub const INS_GET_RESPONSE: u8 = 0xC0;
+    pub const INS_DEV_FLASH_STATS: u8 = 0xF0;
+}
+
+/// The EVM instructions of the app, see `app/src/constants.rs`
+pub mod evm_instructions {
+    pub const CLA_ETH: u8 = 0xE0;
+
+    pub const INS_ETH_GET_PUBLIC_KEY: u8 = 0x02;
+    pub const INS_ETH_SIGN: u8 = 0x04;
+    pub const INS_ETH_GET_APP_CONFIGURATION: u8 = 0x06;
+    pub const INS_SET_PLUGIN: u8 = 0x16;
+    pub const INS_PROVIDE_NFT_INFORMATION: u8 = 0x14;
+    pub const INS_ETH_PROVIDE_ERC20: u8 = 0x0A;
+    pub const INS_SIGN_ETH_MSG: u8 = 0x08;
+}
+
+use instructions::*;
+
+/// Payload uploaded per packet
+pub const CHUNK_SIZE: usize = 250;
+pub const HASH_LEN: usize = 32;
+pub const WALLET_ID_LEN: usize = 6;
+pub const CHAIN_CODE_LEN: usize = 32;
+const ADDRESS_HASH_LEN: usize = 20;
+const MAX_HRP_LEN: usize = 24;
+
+// P1 of uploads
+const PAYLOAD_INIT: u8 = 0x00;
+const PAYLOAD_ADD: u8 = 0x01;
+const PAYLOAD_LAST: u8 = 0x02;
+const PAYLOAD_COMPRESSED: u8 = 0x80;
+
+// P1 of INS_SIGN_HASH, also the P2 of the first upload packet
+const FIRST_MESSAGE: u8 = 0x01;
+const NEXT_MESSAGE: u8 = 0x03;
+const LAST_MESSAGE: u8 = 0x02;
+
+const P1_ONLY_RETRIEVE: u8 = 0x00;
+const P1_SHOW: u8 = 0x01;
+const P2_XPUB_BULK: u8 = 0x01;
+
+const AVAX_MSG_HEADER: &[u8] = b"\x1AAvalanche Signed Message:\n";
+
+pub type Result<T, E> = std::result::Result<T, LedgerAppError<E>>;
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Version {
+    pub test_mode: bool,
+    pub major: u8,
+    pub minor: u8,
+    pub patch: u8,
+    /// Only reported by recent versions of the app
+    pub locked: Option<bool>,
+    pub target_id: Option<u32>,
+}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct PublicKey {
+    /// Compressed public key
+    pub public_key: Vec<u8>,
+    /// Ripemd160(Sha256(public_key))
+    pub hash: [u8; ADDRESS_HASH_LEN],
+    pub address: String,
+}
+
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct ExtendedPublicKey {
+    /// Compressed public key
+    pub public_key: Vec<u8>,
+    pub chain_code: [u8; CHAIN_CODE_LEN],
+}
+
+/// The signature of each signing path, in the order requested
+pub type Signatures = Vec<(PathSuffix, Vec<u8>)>;
+
+/// Writes to flash of the transaction buffer since the app started,
+/// only answered by `dev` builds of the app
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct FlashStats {
+    pub bytes: u32,
+    pub writes: u32,
+}
+
+/// The network of the keys of [`AvalancheApp::get_public_key`]
+/// and [`AvalancheApp::get_extended_public_key`], the app's defaults otherwise
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct Network<'a> {
+    /// Human readable part of the address, `avax` by default
+    pub hrp: Option<&'a str>,
+    /// P-Chain by default
+    pub chain_id: Option<&'a [u8; 32]>,
+}
+
+impl Network<'_> {
+    fn serialize<E: std::error::Error>(&self, out: &mut Vec<u8>) -> Result<(), E> {
+        let hrp = self.hrp.unwrap_or_default();
+        if hrp.len() > MAX_HRP_LEN || !hrp.bytes().all(|c| (33..=126).contains(&c)) {
+            return Err(LedgerAppError::InvalidArgument("hrp"));
+        }
+        out.push(hrp.len() as u8);
+        out.extend_from_slice(hrp.as_bytes());
+
+        match self.chain_id {
+            Some(chain_id) => {
+                out.push(chain_id.len() as u8);
+                out.extend_from_slice(chain_id);
+            }
+            None => out.push(0),
+        }
+
+        Ok(())
+    }
+}
+
+/// The Avalanche app, reached through `transport`
+pub struct AvalancheApp<E> {
+    transport: E,
+}
+
+impl<E> AvalancheApp<E>
+where
+    E: Exchange + Send + Sync,
+    E::Error: std::error::Error,
+{
+    pub fn new(transport: E) -> Self {
+        Self { transport }
+    }
+
+    pub fn into_transport(self) -> E {
+        self.transport
+    }
+
+    /// Sends a command, returning its answer without the status word
+    ///
+    /// Answers longer than a single APDU are retrieved with [`INS_GET_RESPONSE`]
+    pub async fn send(
+        &self,
+        cla: u8,
+        ins: u8,
+        p1: u8,
+        p2: u8,
+        data: &[u8],
+    ) -> Result<Vec<u8>, E::Error> {
+        let command = APDUCommand {
+            cla,
+            ins,
+            p1,
+            p2,
+            data,
+        };
+        let answer = self.transport.exchange(&command).await?;
+        let mut response = answer.data().to_vec();
+        let mut code = answer.retcode();
+
+        while code == status::MORE_DATA_AVAILABLE {
+            let command = APDUCommand {
+                cla: CLA,
+                ins: INS_GET_RESPONSE,
+                p1: 0,
+                p2: 0,
+                data: &[][..],
+            };
+            let answer = self.transport.exchange(&command).await?;
+            response.extend_from_slice(answer.data());
+            code = answer.retcode();
+        }
+
+        if code != status::SUCCESS {
+            return Err(LedgerAppError::Device {
+                code,
+                data: response,
+            });
+        }
+
+        Ok(response)
+    }
+
+    pub async fn get_version(&self) -> Result<Version, E::Error> {
+        let response = self.send(CLA, INS_GET_VERSION, 0, 0, &[]).await?;
+        if response.len() < 4 {
+            return Err(LedgerAppError::InvalidResponse);
+        }
+
+        let (locked, target_id) = match response.get(4..9) {
+            Some(rest) => (
+                Some(rest[0] != 0),
+                Some(u32::from_be_bytes([rest[1], rest[2], rest[3], rest[4]])),
+            ),
+            None => (None, None),
+        };
+
+        Ok(Version {
+            test_mode: response[0] != 0,
+            major: response[1],
+            minor: response[2],
+            patch: response[3],
+            locked,
+            target_id,
+        })
+    }
+
+    /// The id of the wallet, `show` to display it on the device
+    pub async fn get_wallet_id(&self, show: bool) -> Result<[u8; WALLET_ID_LEN], E::Error> {
+        let p1 = if show { P1_SHOW } else { P1_ONLY_RETRIEVE };
+        let response = self.send(CLA, INS_GET_WALLET_ID, p1, 0, &[]).await?;
+
+        let mut id = [0; WALLET_ID_LEN];
+        id.copy_from_slice(
+            response
+                .get(..WALLET_ID_LEN)
+                .ok_or(LedgerAppError::InvalidResponse)?,
+        );
+
+        Ok(id)
+    }
+
+    /// The public key and address at `path`, `show` to have the user verify the address
+    pub async fn get_public_key(
+        &self,
+        path: &BIP32Path,
+        network: Network<'_>,
+        show: bool,
+    ) -> Result<PublicKey, E::Error> {
+        let mut data = Vec::new();
+        network.serialize(&mut data)?;
+        data.extend_from_slice(&path.serialize());
+
+        let p1 = if show { P1_SHOW } else { P1_ONLY_RETRIEVE };
+        let response = self.send(CLA, INS_GET_PUBLIC_KEY, p1, 0, &data).await?;
+
+        // [pk_len | pk | hash | address]
+        let (public_key, rest) = split_len_prefixed(&response)?;
+        if rest.len() < ADDRESS_HASH_LEN {
+            return Err(LedgerAppError::InvalidResponse);
+        }
+        let (hash, address) = rest.split_at(ADDRESS_HASH_LEN);
+
+        let mut out = PublicKey {
+            public_key: public_key.to_vec(),
+            hash: [0; ADDRESS_HASH_LEN],
+            address: String::from_utf8(address.to_vec())
+                .map_err(|_| LedgerAppError::InvalidResponse)?,
+        };
+        out.hash.copy_from_slice(hash);
+
+        Ok(out)
+    }
+
+    /// The public key and chain code at `path`, `show` to have the user verify them
+    pub async fn get_extended_public_key(
+        &self,
+        path: &BIP32Path,
+        network: Network<'_>,
+        show: bool,
+    ) -> Result<ExtendedPublicKey, E::Error> {
+        let mut data = Vec::new();
+        network.serialize(&mut data)?;
+        data.extend_from_slice(&path.serialize());
+
+        let p1 = if show { P1_SHOW } else { P1_ONLY_RETRIEVE };
+        let response = self
+            .send(CLA, INS_GET_EXTENDED_PUBLIC_KEY, p1, 0, &data)
+            .await?;
+
+        // [pk_len | pk | chain_code]
+        let (public_key, chain_code) = split_len_prefixed(&response)?;
+        extended_public_key(public_key, chain_code)
+    }
+
+    /// The extended public keys of `prefix/account'` for each account, without confirmation
+    pub async fn get_extended_public_keys(
+        &self,
+        prefix: &BIP32Path,
+        accounts: &[u32],
+    ) -> Result<Vec<ExtendedPublicKey>, E::Error> {
+        const KEY_LEN: usize = 33;
+
+        if prefix.components().len() >= MAX_PATH_DEPTH || accounts.len() > u8::MAX as usize {
+            return Err(LedgerAppError::InvalidArgument("accounts"));
+        }
+
+        let mut keys = Vec::with_capacity(accounts.len());
+        // the app returns as many keys as fit in its response buffer,
+        // the remaining accounts are requested again
+        while keys.len() < accounts.len() {
+            let remaining = &accounts[keys.len()..];
+
+            let mut data = prefix.serialize();
+            data.push(remaining.len() as u8);
+            for account in remaining {
+                data.extend_from_slice(&account.to_be_bytes());
+            }
+
+            let response = self
+                .send(
+                    CLA,
+                    INS_GET_EXTENDED_PUBLIC_KEY,
+                    P1_ONLY_RETRIEVE,
+                    P2_XPUB_BULK,
+                    &data,
+                )
+                .await?;
+
+            let (&count, entries) = response
+                .split_first()
+                .ok_or(LedgerAppError::InvalidResponse)?;
+            if count == 0 || entries.len() < count as usize * (KEY_LEN + CHAIN_CODE_LEN) {
+                return Err(LedgerAppError::InvalidResponse);
+            }
+
+            for entry in entries
+                .chunks_exact(KEY_LEN + CHAIN_CODE_LEN)
+                .take(count as usize)
+            {
+                let (public_key, chain_code) = entry.split_at(KEY_LEN);
+                keys.push(extended_public_key(public_key, chain_code)?);
+            }
+        }
+
+        keys.truncate(accounts.len());
+        Ok(keys)
+    }
+
+    /// Has the user review `hash`, then signs it with each of `signers`, relative to `root`
+    pub async fn sign_hash(
+        &self,
+        root: &BIP32Path,
+        signers: &[PathSuffix],
+        hash: &[u8; HASH_LEN],
+    ) -> Result<Signatures, E::Error> {
+        let mut data = root.serialize();
+        data.extend_from_slice(hash);
+
+        self.send(CLA, INS_SIGN_HASH, FIRST_MESSAGE, 0, &data)
+            .await?;
+
+        self.collect_signatures(signers).await
+    }
+
+    /// Has the user review `tx`, then signs it with each of `signers`, relative to `root`
+    ///
+    /// The outputs to `signers` and `change` aren't shown during the review
+    pub async fn sign(
+        &self,
+        root: &BIP32Path,
+        signers: &[PathSuffix],
+        change: &[PathSuffix],
+        tx: &[u8],
+    ) -> Result<Signatures, E::Error> {
+        let payload = tx_payload(signers, change, tx);
+        self.upload(INS_SIGN, &root.serialize(), &payload, false)
+            .await?;
+
+        self.collect_signatures(signers).await
+    }
+
+    /// Like [`Self::sign`], but uploads the repeated ids and addresses of the transaction only once
+    pub async fn sign_compressed(
+        &self,
+        root: &BIP32Path,
+        signers: &[PathSuffix],
+        change: &[PathSuffix],
+        tx: &[u8],
+    ) -> Result<Signatures, E::Error> {
+        let payload = tx_payload(signers, change, tx);
+        self.upload(INS_SIGN, &root.serialize(), &payload, true)
+            .await?;
+
+        self.collect_signatures(signers).await
+    }
+
+    /// Has the user review `message`, then signs it as an Avalanche signed message
+    /// with each of `signers`, relative to `root`
+    pub async fn sign_msg(
+        &self,
+        root: &BIP32Path,
+        signers: &[PathSuffix],
+        message: &[u8],
+    ) -> Result<Signatures, E::Error> {
+        let len =
+            u32::try_from(message.len()).map_err(|_| LedgerAppError::InvalidArgument("message"))?;
+
+        let mut payload = Vec::with_capacity(AVAX_MSG_HEADER.len() + 4 + message.len());
+        payload.extend_from_slice(AVAX_MSG_HEADER);
+        payload.extend_from_slice(&len.to_be_bytes());
+        payload.extend_from_slice(message);
+
+        self.upload(INS_SIGN_MSG, &root.serialize(), &payload, false)
+            .await?;
+
+        self.collect_signatures(signers).await
+    }
+
+    /// Has the user approve `policy`, under which transactions are then signed without review
+    pub async fn set_policy(&self, policy: &[u8]) -> Result<(), E::Error> {
+        self.upload(INS_SET_POLICY, &[], policy, false).await
+    }
+
+    /// Has the user approve disabling signing without review
+    pub async fn clear_policy(&self) -> Result<(), E::Error> {
+        self.set_policy(&[]).await
+    }
+
+    pub async fn flash_stats(&self) -> Result<FlashStats, E::Error> {
+        let response = self.send(CLA, INS_DEV_FLASH_STATS, 0, 0, &[]).await?;
+        match response.get(..8) {
+            Some(stats) => Ok(FlashStats {
+                bytes: u32::from_be_bytes([stats[0], stats[1], stats[2], stats[3]]),
+                writes: u32::from_be_bytes([stats[4], stats[5], stats[6], stats[7]]),
+            }),
+            None => Err(LedgerAppError::InvalidResponse),
+        }
+    }
+
+    /// Sends `init` then `payload` in Init/Add/Last packets,
+    /// the last one being answered once the user reviewed the payload
+    async fn upload(
+        &self,
+        ins: u8,
+        init: &[u8],
+        payload: &[u8],
+        compress: bool,
+    ) -> Result<(), E::Error> {
+        self.send(CLA, ins, PAYLOAD_INIT, FIRST_MESSAGE, init)
+            .await?;
+
+        let mut chunks = if compress {
+            compress_chunks(payload, CHUNK_SIZE)
+        } else {
+            payload.chunks(CHUNK_SIZE).map(<[u8]>::to_vec).collect()
+        };
+        // an empty payload still needs its last packet
+        if chunks.is_empty() {
+            chunks.push(Vec::new());
+        }
+
+        let flags = if compress { PAYLOAD_COMPRESSED } else { 0 };
+        for (i, chunk) in chunks.iter().enumerate() {
+            let p1 = if i + 1 == chunks.len() {
+                PAYLOAD_LAST
+            } else {
+                PAYLOAD_ADD
+            };
+            self.send(CLA, ins, p1 | flags, 0, chunk).await?;
+        }
+
+        Ok(())
+    }
+
+    /// Signs the reviewed hash with each of `signers`
+    async fn collect_signatures(&self, signers: &[PathSuffix]) -> Result<Signatures, E::Error> {
+        let mut signatures = Vec::with_capacity(signers.len());
+        for (i, signer) in signers.iter().enumerate() {
+            let p1 = if i + 1 == signers.len() {
+                LAST_MESSAGE
+            } else {
+                NEXT_MESSAGE
+            };
+
+            let signature = self
+                .send(CLA, INS_SIGN_HASH, p1, 0, &signer.serialize())
+                .await?;
+            signatures.push((*signer, signature));
+        }
+
+        Ok(signatures)
+    }
+}
+
+/// The change paths (signers included, so that their outputs aren't shown) followed by `tx`
+fn tx_payload(signers: &[PathSuffix], change: &[PathSuffix], tx: &[u8]) -> Vec<u8> {
+    let mut paths = signers.to_vec();
+    for path in change {
+        if !paths.contains(path) {
+            paths.push(*path);
+        }
+    }
+
+    let mut payload = Vec::with_capacity(1 + 9 * paths.len() + tx.len());
+    payload.push(paths.len() as u8);
+    for path in &paths {
+        payload.extend_from_slice(&path.serialize());
+    }
+    payload.extend_from_slice(tx);
+
+    payload
+}
+
+fn split_len_prefixed<E: std::error::Error>(data: &[u8]) -> Result<(&[u8], &[u8]), E> {
+    let (&len, rest) = data.split_first().ok_or(LedgerAppError::InvalidResponse)?;
+    if rest.len() < len as usize {
+        return Err(LedgerAppError::InvalidResponse);
+    }
+
+    Ok(rest.split_at(len as usize))
+}
+
+fn extended_public_key<E: std::error::Error>(
+    public_key: &[u8],
+    chain_code: &[u8],
+) -> Result<ExtendedPublicKey, E> {
+    if chain_code.len() != CHAIN_CODE_LEN {
+        return Err(LedgerAppError::InvalidResponse);
+    }
+
+    let mut out = ExtendedPublicKey {
+        public_key: public_key.to_vec(),
+        chain_code: [0; CHAIN_CODE_LEN],
+    };
+    out.chain_code.copy_from_slice(chain_code);
+
+    Ok(out)
+}
+
+/// Connects to the first Ledger device found over USB
+#[cfg(feature = "hid")]
+pub fn hid() -> std::result::Result<
+    ledger_transport_hid::TransportNativeHID,
+    ledger_transport_hid::LedgerHIDError,
+> {
+    let api = ledger_transport_hid::hidapi::HidApi::new()?;
+    ledger_transport_hid::TransportNativeHID::new(&api)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn tx_payload_with_change_paths() {
+        let payload = tx_payload(
+            &[PathSuffix(0, 1)],
+            &[PathSuffix(1, 0), PathSuffix(0, 1)],
+            &[0xAA, 0xBB],
+        );
+
+        let mut expected = vec![2];
+        expected.extend_from_slice(&PathSuffix(0, 1).serialize());
+        expected.extend_from_slice(&PathSuffix(1, 0).serialize());
+        expected.extend_from_slice(&[0xAA, 0xBB]);
+        assert_eq!(payload, expected);
+    }
+
+    #[test]
+    fn network_defaults() {
+        let mut out = Vec::new();
+        Network::default()
+            .serialize::<std::io::Error>(&mut out)
+            .unwrap();
+        assert_eq!(out, [0, 0]);
+
+        let mut out = Vec::new();
+        let network = Network {
+            hrp: Some("fuji"),
+            chain_id: Some(&[7; 32]),
+        };
+        network.serialize::<std::io::Error>(&mut out).unwrap();
+        assert_eq!(&out[..6], &[4, b'f', b'u', b'j', b'i', 32]);
+        assert_eq!(&out[6..], &[7; 32]);
+
+        let network = Network {
+            hrp: Some("has space"),
+            chain_id: None,
+        };
+        assert!(network.serialize::<std::io::Error>(&mut out).is_err());
+    }
+}
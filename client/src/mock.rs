@@ -0,0 +1,310 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! A device running the app itself, in-process
+//!
+//! The app is linked in and driven with its own `handle_apdu`, as the fuzz targets in
+//! `hfuzz` do, so it must be built for the host the same way (see `make client_test`).
+//! Reviews are approved right away and, as when fuzzing, keys and signatures come
+//! from a cheap stand-in for the device crypto (see `app/src/crypto/mock.rs`):
+//! they are deterministic and well formed, but not valid secp256k1 values.
+//!
+//! Each [`MockDevice`] runs the app on a thread of its own, where the app keeps
+//! a separate session (e.g an upload) between APDUs like a real device, so devices
+//! can be used concurrently, uploads included. What the app keeps for the whole
+//! process is shared though: the output of the UI and the stored policy, so
+//! APDUs are handled one at a time.
+use std::{
+    sync::{mpsc, Mutex, MutexGuard, PoisonError},
+    thread::{self, JoinHandle},
+};
+
+use async_trait::async_trait;
+use ledger_transport::{APDUAnswer, APDUCommand, Exchange};
+
+use ledger_app::handle_apdu;
+
+const APDU_BUFFER_LEN: usize = 260;
+
+// the output of the UI and the stored policy, shared by every device
+static SHARED: Mutex<()> = Mutex::new(());
+
+fn shared() -> MutexGuard<'static, ()> {
+    // a device panicking doesn't leave the app in a worse state than an error
+    SHARED.lock().unwrap_or_else(PoisonError::into_inner)
+}
+
+/// The app running on a thread of its own, until dropped
+pub struct MockDevice {
+    // commands sent to the app, and their answers
+    channel: Option<Mutex<(mpsc::Sender<Vec<u8>>, mpsc::Receiver<Vec<u8>>)>>,
+    app: Option<JoinHandle<()>>,
+}
+
+impl MockDevice {
+    /// Starts a new session of the app
+    pub fn new() -> Self {
+        let (commands, commands_rx) = mpsc::channel();
+        let (answers_tx, answers) = mpsc::channel();
+        let app = thread::spawn(move || Self::run(commands_rx, answers_tx));
+
+        Self {
+            channel: Some(Mutex::new((commands, answers))),
+            app: Some(app),
+        }
+    }
+
+    fn run(commands: mpsc::Receiver<Vec<u8>>, answers: mpsc::Sender<Vec<u8>>) {
+        for command in commands {
+            let answer = {
+                let _shared = shared();
+                Self::handle(&command)
+            };
+
+            if answers.send(answer).is_err() {
+                break;
+            }
+        }
+    }
+
+    fn handle(command: &[u8]) -> Vec<u8> {
+        let mut buffer = [0; APDU_BUFFER_LEN];
+        let rx = command.len().min(APDU_BUFFER_LEN);
+        buffer[..rx].copy_from_slice(&command[..rx]);
+
+        let mut flags = 0;
+        let mut tx = 0;
+        handle_apdu(&mut flags, &mut tx, rx as u32, &mut buffer);
+
+        // answers produced after a review are in the output of the UI,
+        // which approves it right away
+        let answer = match zemu_sys::get_out() {
+            Some((len, out)) => out[..len].to_vec(),
+            None => buffer[..tx as usize].to_vec(),
+        };
+
+        // the work queued for ticker events, e.g writing an approved policy
+        unsafe { ledger_app::rs_idle_tick() };
+
+        answer
+    }
+
+    /// Sends a raw command to the app, returning its answer with the status word
+    pub fn exchange_raw(&self, command: &[u8]) -> Vec<u8> {
+        let channel = self.channel.as_ref().expect("open device");
+        let (commands, answers) = &*channel.lock().unwrap_or_else(PoisonError::into_inner);
+
+        commands.send(command.to_vec()).expect("the app stopped");
+        answers.recv().expect("the app stopped")
+    }
+}
+
+impl Default for MockDevice {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for MockDevice {
+    fn drop(&mut self) {
+        // the app stops once there are no more commands
+        self.channel.take();
+        if let Some(app) = self.app.take() {
+            let _ = app.join();
+        }
+    }
+}
+
+#[async_trait]
+impl Exchange for MockDevice {
+    type Error = MockError;
+    type AnswerType = Vec<u8>;
+
+    async fn exchange<I>(
+        &self,
+        command: &APDUCommand<I>,
+    ) -> Result<APDUAnswer<Self::AnswerType>, Self::Error>
+    where
+        I: std::ops::Deref<Target = [u8]> + Send + Sync,
+    {
+        if command.data.len() > u8::MAX as usize {
+            return Err(MockError::CommandTooLong);
+        }
+
+        let answer = self.exchange_raw(&command.serialize());
+        APDUAnswer::from_answer(answer).map_err(|_| MockError::InvalidAnswer)
+    }
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq, thiserror::Error)]
+pub enum MockError {
+    #[error("command longer than an APDU")]
+    CommandTooLong,
+    #[error("answer without status word")]
+    InvalidAnswer,
+}
+
+#[cfg(test)]
+mod tests {
+    use futures::executor::block_on;
+
+    use super::*;
+    use crate::{instructions::*, status, AvalancheApp, LedgerAppError, Network, PathSuffix};
+
+    fn app() -> AvalancheApp<MockDevice> {
+        AvalancheApp::new(MockDevice::new())
+    }
+
+    #[test]
+    fn version() {
+        let app = app();
+
+        let version = block_on(app.get_version()).unwrap();
+        let eth = block_on(app.eth_get_app_configuration()).unwrap();
+        assert_eq!(
+            (version.major, version.minor, version.patch),
+            (eth.major, eth.minor, eth.patch)
+        );
+    }
+
+    #[test]
+    fn sessions_are_independent() {
+        let first = MockDevice::new();
+        let second = app();
+        let prefix: crate::BIP32Path = "m/44'/9000'".parse().unwrap();
+
+        // the first frame of a response longer than an APDU
+        let mut data = prefix.serialize();
+        data.push(10);
+        (0..10u32).for_each(|account| data.extend_from_slice(&account.to_be_bytes()));
+        let mut command = vec![CLA, INS_GET_EXTENDED_PUBLIC_KEY, 0, 1, data.len() as u8];
+        command.extend_from_slice(&data);
+
+        let answer = first.exchange_raw(&command);
+        assert_eq!(
+            answer[answer.len() - 2..],
+            status::MORE_DATA_AVAILABLE.to_be_bytes()
+        );
+
+        // a command of another session doesn't drop the rest of it
+        block_on(second.get_version()).unwrap();
+
+        let answer = first.exchange_raw(&[CLA, INS_GET_RESPONSE, 0, 0, 0]);
+        assert!(answer.len() > 2);
+        let code = u16::from_be_bytes([answer[answer.len() - 2], answer[answer.len() - 1]]);
+        assert!(code == status::SUCCESS || code == status::MORE_DATA_AVAILABLE);
+    }
+
+    #[test]
+    fn uploads_interleave() {
+        let first = MockDevice::new();
+        let second = app();
+        let root: crate::BIP32Path = "m/44'/9000'/0'".parse().unwrap();
+        let signers = [PathSuffix(0, 0)];
+
+        let message = b"interleaved";
+        let mut payload = crate::AVAX_MSG_HEADER.to_vec();
+        payload.extend_from_slice(&(message.len() as u32).to_be_bytes());
+        payload.extend_from_slice(message);
+        let (head, tail) = payload.split_at(payload.len() / 2);
+
+        let send = |p1: u8, p2: u8, data: &[u8]| {
+            let mut command = vec![CLA, INS_SIGN_MSG, p1, p2, data.len() as u8];
+            command.extend_from_slice(data);
+            let answer = first.exchange_raw(&command);
+            assert_eq!(answer[answer.len() - 2..], status::SUCCESS.to_be_bytes());
+        };
+
+        // the first session stops in the middle of its upload
+        send(crate::PAYLOAD_INIT, crate::FIRST_MESSAGE, &root.serialize());
+        send(crate::PAYLOAD_ADD, 0, head);
+
+        // while another one uploads and signs a whole message
+        let signatures = block_on(second.sign_msg(&root, &signers, message)).unwrap();
+        assert_eq!(signatures.len(), 1);
+
+        // then picks it up where it left off
+        send(crate::PAYLOAD_LAST, 0, tail);
+    }
+
+    #[test]
+    fn concurrent_sessions() {
+        let sessions = (0..4)
+            .map(|_| {
+                std::thread::spawn(|| {
+                    let app = app();
+                    let root = "m/44'/9000'/0'".parse().unwrap();
+                    let signers = [PathSuffix(0, 0), PathSuffix(0, 1)];
+
+                    for _ in 0..10 {
+                        let signatures =
+                            block_on(app.sign_hash(&root, &signers, &[0x42; 32])).unwrap();
+                        assert_eq!(signatures.len(), signers.len());
+                    }
+                })
+            })
+            .collect::<Vec<_>>();
+
+        for session in sessions {
+            session.join().unwrap();
+        }
+    }
+
+    #[test]
+    fn public_keys() {
+        let app = app();
+        let path = "m/44'/9000'/0'/0/0".parse().unwrap();
+
+        let key = block_on(app.get_public_key(&path, Network::default(), false)).unwrap();
+        assert_eq!(key.public_key.len(), 33);
+        assert!(key.address.contains("avax1"));
+
+        let xpub = block_on(app.get_extended_public_key(&path, Network::default(), false)).unwrap();
+        assert_eq!(xpub.public_key, key.public_key);
+    }
+
+    #[test]
+    fn extended_public_keys_span_frames() {
+        let app = app();
+        let prefix = "m/44'/9000'".parse().unwrap();
+        let accounts = (0..10).collect::<Vec<_>>();
+
+        let keys = block_on(app.get_extended_public_keys(&prefix, &accounts)).unwrap();
+        assert_eq!(keys.len(), accounts.len());
+    }
+
+    #[test]
+    fn sign_hash() {
+        let app = app();
+        let root = "m/44'/9000'/0'".parse().unwrap();
+        let signers = [PathSuffix(0, 0), PathSuffix(0, 1)];
+
+        let signatures = block_on(app.sign_hash(&root, &signers, &[0x42; 32])).unwrap();
+        assert_eq!(signatures.len(), 2);
+        assert_eq!(signatures[0].0, signers[0]);
+        assert_eq!(signatures[1].1.len(), 65);
+    }
+
+    #[test]
+    fn device_errors() {
+        let app = app();
+        let root = "m/44'/9000'/0'".parse().unwrap();
+
+        // a transaction that can't be parsed
+        let err = block_on(app.sign(&root, &[PathSuffix(0, 0)], &[], &[0xFF; 40])).unwrap_err();
+        assert!(matches!(err, LedgerAppError::Device { .. }));
+        assert_ne!(err.status_word(), Some(status::SUCCESS));
+    }
+}
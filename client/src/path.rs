@@ -0,0 +1,184 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+//! Derivation paths, as sent to the app
+use std::{fmt, str::FromStr};
+
+const HARDENED: u32 = 0x8000_0000;
+
+/// Components of a path, up to 6, as supported by the app
+pub const MAX_PATH_DEPTH: usize = 6;
+
+/// A derivation path, e.g `m/44'/9000'/0'`
+#[derive(Debug, Clone, PartialEq, Eq, Hash)]
+pub struct BIP32Path(Vec<u32>);
+
+impl BIP32Path {
+    pub fn new(components: Vec<u32>) -> Result<Self, PathError> {
+        if components.is_empty() || components.len() > MAX_PATH_DEPTH {
+            return Err(PathError::Depth);
+        }
+
+        Ok(Self(components))
+    }
+
+    pub fn components(&self) -> &[u32] {
+        &self.0
+    }
+
+    /// The number of components followed by each of them, big endian
+    pub fn serialize(&self) -> Vec<u8> {
+        let mut out = Vec::with_capacity(1 + 4 * self.0.len());
+        out.push(self.0.len() as u8);
+        for component in &self.0 {
+            out.extend_from_slice(&component.to_be_bytes());
+        }
+
+        out
+    }
+}
+
+impl FromStr for BIP32Path {
+    type Err = PathError;
+
+    fn from_str(s: &str) -> Result<Self, Self::Err> {
+        let mut parts = s.split('/');
+        if parts.next() != Some("m") {
+            return Err(PathError::Format);
+        }
+
+        let components = parts.map(parse_component).collect::<Result<_, _>>()?;
+        Self::new(components)
+    }
+}
+
+impl fmt::Display for BIP32Path {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "m")?;
+        for &component in &self.0 {
+            if component >= HARDENED {
+                write!(f, "/{}'", component - HARDENED)?;
+            } else {
+                write!(f, "/{}", component)?;
+            }
+        }
+
+        Ok(())
+    }
+}
+
+/// The last 2 components of a signing or change path, e.g `0/3`,
+/// appended by the app to the root path of the operation
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, PartialOrd, Ord)]
+pub struct PathSuffix(pub u32, pub u32);
+
+impl PathSuffix {
+    pub fn serialize(&self) -> [u8; 9] {
+        let mut out = [0; 9];
+        out[0] = 2;
+        out[1..5].copy_from_slice(&self.0.to_be_bytes());
+        out[5..].copy_from_slice(&self.1.to_be_bytes());
+
+        out
+    }
+}
+
+impl FromStr for PathSuffix {
+    type Err = PathError;
+
+    fn from_str(s: &str) -> Result<Self, Self::Err> {
+        let mut parts = s.split('/').map(parse_component);
+        match (parts.next(), parts.next(), parts.next()) {
+            (Some(a), Some(b), None) => {
+                let (a, b) = (a?, b?);
+                if a >= HARDENED || b >= HARDENED {
+                    return Err(PathError::Hardened);
+                }
+                Ok(Self(a, b))
+            }
+            _ => Err(PathError::Format),
+        }
+    }
+}
+
+impl fmt::Display for PathSuffix {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        write!(f, "{}/{}", self.0, self.1)
+    }
+}
+
+fn parse_component(s: &str) -> Result<u32, PathError> {
+    let (number, hardened) = match s.strip_suffix('\'') {
+        Some(number) => (number, HARDENED),
+        None => (s, 0),
+    };
+
+    let number: u32 = number.parse().map_err(|_| PathError::Format)?;
+    if number >= HARDENED {
+        return Err(PathError::Format);
+    }
+
+    Ok(number + hardened)
+}
+
+#[derive(Debug, Clone, Copy, PartialEq, Eq, thiserror::Error)]
+pub enum PathError {
+    #[error("invalid path, expected e.g m/44'/9000'/0' or 0/3 for suffixes")]
+    Format,
+    #[error("paths have between 1 and 6 components")]
+    Depth,
+    #[error("path suffixes can't be hardened")]
+    Hardened,
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn parse_path() {
+        let path: BIP32Path = "m/44'/9000'/0'/0/3".parse().unwrap();
+        assert_eq!(
+            path.components(),
+            &[HARDENED + 44, HARDENED + 9000, HARDENED, 0, 3]
+        );
+        assert_eq!(path.to_string(), "m/44'/9000'/0'/0/3");
+        assert_eq!(
+            path.serialize(),
+            [5, 0x80, 0, 0, 44, 0x80, 0, 0x23, 0x28, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3]
+        );
+
+        assert_eq!("44'/0'".parse::<BIP32Path>(), Err(PathError::Format));
+        assert_eq!("m".parse::<BIP32Path>(), Err(PathError::Depth));
+        assert_eq!(
+            "m/1/2/3/4/5/6/7".parse::<BIP32Path>(),
+            Err(PathError::Depth)
+        );
+        assert_eq!("m/44'/x".parse::<BIP32Path>(), Err(PathError::Format));
+        assert_eq!("m/2147483648".parse::<BIP32Path>(), Err(PathError::Format));
+    }
+
+    #[test]
+    fn parse_suffix() {
+        let suffix: PathSuffix = "0/3".parse().unwrap();
+        assert_eq!(suffix, PathSuffix(0, 3));
+        assert_eq!(suffix.to_string(), "0/3");
+        assert_eq!(suffix.serialize(), [2, 0, 0, 0, 0, 0, 0, 0, 3]);
+
+        assert_eq!("0".parse::<PathSuffix>(), Err(PathError::Format));
+        assert_eq!("0/1/2".parse::<PathSuffix>(), Err(PathError::Format));
+        assert_eq!("0'/1".parse::<PathSuffix>(), Err(PathError::Hardened));
+    }
+}
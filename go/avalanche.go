@@ -39,7 +39,7 @@ func FindLedgerAvalancheApp() (_ *LedgerAvalanche, rerr error) {
 		}
 	}()
 
-	app := &LedgerAvalanche{ledgerAPI, VersionInfo{}}
+	app := &LedgerAvalanche{api: ledgerAPI}
 	appVersion, err := app.GetVersion()
 	if err != nil {
 		if err.Error() == "[APDU_CODE_CLA_NOT_SUPPORTED] CLA not supported" {
@@ -72,8 +72,11 @@ func (ledger *LedgerAvalanche) CheckVersion(ver VersionInfo) error {
 
 // GetVersion returns the current version of the Avalanche user app
 func (ledger *LedgerAvalanche) GetVersion() (*VersionInfo, error) {
+	op := ledger.operation("getVersion")
+	defer op.end()
+
 	message := []byte{CLA, INS_GET_VERSION, 0, 0, 0}
-	response, err := ledger.api.Exchange(message)
+	response, err := op.exchange(message, false)
 
 	if err != nil {
 		return nil, err
@@ -95,6 +98,9 @@ func (ledger *LedgerAvalanche) GetVersion() (*VersionInfo, error) {
 
 // GetPubKey returns the pubkey and hash
 func (ledger *LedgerAvalanche) GetPubKey(path string, show bool, hrp string, chainid string) (*ResponseAddr, error) {
+	op := ledger.operation("getPubKey")
+	defer op.end()
+
 	if len(hrp) > 83 {
 		return nil, errors.New("hrp len should be < 83 chars")
 	}
@@ -126,7 +132,7 @@ func (ledger *LedgerAvalanche) GetPubKey(path string, show bool, hrp string, cha
 	message = append(message, serializedPath...)
 	message[4] = byte(len(message) - len(header)) // update length
 
-	response, err := ledger.api.Exchange(message)
+	response, err := op.exchange(message, show)
 	if err != nil {
 		return nil, err
 	}
@@ -144,7 +150,79 @@ func (ledger *LedgerAvalanche) GetPubKey(path string, show bool, hrp string, cha
 	return &ResponseAddr{publicKey, hash, address}, nil
 }
 
+// GetExtendedPubKey returns the pubkey and chain code
+func (ledger *LedgerAvalanche) GetExtendedPubKey(path string, show bool, hrp string, chainid string) (*ResponseXPub, error) {
+	op := ledger.operation("getExtendedPubKey")
+	defer op.end()
+
+	if len(hrp) > 83 {
+		return nil, errors.New("hrp len should be < 83 chars")
+	}
+
+	serializedHRP, err := SerializeHrp(hrp)
+	if err != nil {
+		return nil, err
+	}
+
+	serializedPath, err := SerializePath(path)
+	if err != nil {
+		return nil, err
+	}
+
+	serializedChainID, err := SerializeChainID(chainid)
+	if err != nil {
+		return nil, err
+	}
+
+	p1 := byte(P1_ONLY_RETRIEVE)
+	if show {
+		p1 = byte(P1_SHOW_ADDRESS_IN_DEVICE)
+	}
+
+	// Prepare message
+	header := []byte{CLA, INS_GET_EXTENDED_PUBLIC_KEY, p1, 0, 0}
+	message := append(header, serializedHRP...)
+	message = append(message, serializedChainID...)
+	message = append(message, serializedPath...)
+	message[4] = byte(len(message) - len(header)) // update length
+
+	response, err := op.exchange(message, show)
+	if err != nil {
+		return nil, err
+	}
+
+	// [publicKeyLen | publicKey | chainCode]
+	if len(response) < 1 || len(response) != 1+int(response[0])+32 {
+		return nil, errors.New("Invalid response")
+	}
+
+	publicKeyLen := response[0]
+	publicKey := response[1 : publicKeyLen+1]
+	chainCode := response[publicKeyLen+1:]
+
+	return &ResponseXPub{publicKey, chainCode}, nil
+}
+
 func (ledger *LedgerAvalanche) Sign(pathPrefix string, signingPaths []string, message []byte, changePaths []string) (*ResponseSign, error) {
+	return ledger.sign(pathPrefix, signingPaths, message, changePaths, false, false)
+}
+
+// SignCompressed works like Sign, but uploads the repeated ids and addresses of the transaction only once
+func (ledger *LedgerAvalanche) SignCompressed(pathPrefix string, signingPaths []string, message []byte, changePaths []string) (*ResponseSign, error) {
+	return ledger.sign(pathPrefix, signingPaths, message, changePaths, true, false)
+}
+
+// SignResumable works like Sign, or SignCompressed if compress is set, but when the transport fails
+// before the whole transaction is uploaded, the upload is resumed from what the device received
+// instead of failing, up to 3 times
+func (ledger *LedgerAvalanche) SignResumable(pathPrefix string, signingPaths []string, message []byte, changePaths []string, compress bool) (*ResponseSign, error) {
+	return ledger.sign(pathPrefix, signingPaths, message, changePaths, compress, true)
+}
+
+func (ledger *LedgerAvalanche) sign(pathPrefix string, signingPaths []string, message []byte, changePaths []string, compress bool, resumable bool) (*ResponseSign, error) {
+	op := ledger.operation("sign")
+	defer op.end()
+
 	paths := signingPaths
 	if changePaths != nil {
 		paths = append(paths, changePaths...)
@@ -160,28 +238,69 @@ func (ledger *LedgerAvalanche) Sign(pathPrefix string, signingPaths []string, me
 	p2 := FIRST_MESSAGE
 	header := []byte{CLA, INS_SIGN, byte(payloadType), byte(p2), byte(len(serializedPath))}
 	bytesToSend := append(header, serializedPath...)
-	_, err = ledger.api.Exchange(bytesToSend)
+	_, err = op.exchange(bytesToSend, false)
 	if err != nil {
 		return nil, errors.New("command rejected")
 	}
 
 	msg := ConcatMessageAndChangePath(message, paths)
 
-	for i := 0; i < len(msg); i += CHUNK_SIZE {
-		end := i + CHUNK_SIZE
+	// sequenced chunks carry a header too
+	chunkSize := CHUNK_SIZE
+	if resumable {
+		chunkSize -= sequenceHeaderLength
+	}
+
+	var chunks [][]byte
+	if compress {
+		chunks = CompressChunks(msg, chunkSize)
+	} else {
+		for i := 0; i < len(msg); i += chunkSize {
+			end := i + chunkSize
+			if end > len(msg) {
+				end = len(msg)
+			}
+			chunks = append(chunks, msg[i:end])
+		}
+	}
+
+	offsets := chunkOffsets(chunks)
+	resumes := 0
+	for i := 0; i < len(chunks); i++ {
+		chunk := chunks[i]
+		last := i == len(chunks)-1
 		payloadType := PAYLOAD_ADD
 		p2 := 0
 
-		if end > len(msg) {
-			end = len(msg)
+		if last {
 			payloadType = PAYLOAD_LAST
 		}
-		chunk := msg[i:end]
-		chunkSize := end - i
+		if compress {
+			payloadType |= PAYLOAD_COMPRESSED
+		}
+		if resumable {
+			payloadType |= PAYLOAD_SEQUENCED
+			chunk = sequenceChunk(offsets[i], chunk)
+		}
+		chunkSize := len(chunk)
 
 		header := []byte{CLA, INS_SIGN, byte(payloadType), byte(p2), byte(chunkSize)}
 		bytesToSend := append(header, chunk...)
-		response, err := ledger.api.Exchange(bytesToSend)
+		// the last chunk is answered once the user reviewed the transaction
+		response, err := op.exchange(bytesToSend, last)
+		// the last chunk starts the review, which can't be resumed
+		if err != nil && resumable && !last && !isDeviceError(err) && resumes < maxUploadResumes {
+			resumes++
+			// sending the same chunk again is fine too, if already received it's only acknowledged
+			next := i
+			if received, ok := op.uploadReceived(INS_SIGN); ok {
+				if at := chunkAt(offsets, received); at >= 0 {
+					next = at
+				}
+			}
+			i = next - 1
+			continue
+		}
 		if err != nil {
 			if err.Error() == "[APDU_CODE_BAD_KEY_HANDLE] The parameters in the data field are incorrect" {
 				// In this special case, we can extract additional info
@@ -196,10 +315,13 @@ func (ledger *LedgerAvalanche) Sign(pathPrefix string, signingPaths []string, me
 
 	// Transaction was approved so start iterating over signing_paths to sign
 	// and collect each signature
-	return SignAndCollect(signingPaths, ledger)
+	return op.signAndCollect(signingPaths)
 }
 
 func (ledger *LedgerAvalanche) SignHash(pathPrefix string, signingPaths []string, hash []byte) (*ResponseSign, error) {
+	op := ledger.operation("signHash")
+	defer op.end()
+
 	if len(hash) != HASH_LEN {
 		return nil, errors.New("wrong hash size")
 	}
@@ -212,7 +334,7 @@ func (ledger *LedgerAvalanche) SignHash(pathPrefix string, signingPaths []string
 	header := []byte{CLA, INS_SIGN_HASH, FIRST_MESSAGE, byte(0x00), byte(len(serializedPath) + len(hash))}
 	bytesToSend := append(header, serializedPath...)
 	bytesToSend = append(bytesToSend, hash...)
-	firstResponse, err := ledger.api.Exchange(bytesToSend)
+	firstResponse, err := op.exchange(bytesToSend, true)
 
 	if err != nil {
 		return nil, errors.New("command rejected")
@@ -221,10 +343,18 @@ func (ledger *LedgerAvalanche) SignHash(pathPrefix string, signingPaths []string
 		return nil, errors.New("wrong response")
 	}
 
-	return SignAndCollect(signingPaths, ledger)
+	return op.signAndCollect(signingPaths)
 }
 
 func SignAndCollect(signingPaths []string, ledger *LedgerAvalanche) (*ResponseSign, error) {
+	op := ledger.operation("signAndCollect")
+	defer op.end()
+
+	return op.signAndCollect(signingPaths)
+}
+
+// signAndCollect collects the signatures as part of the call op
+func (op *operation) signAndCollect(signingPaths []string) (*ResponseSign, error) {
 	// Where each pair path_suffix, signature are stored
 	signatures := make(map[string][]byte)
 
@@ -242,7 +372,7 @@ func SignAndCollect(signingPaths []string, ledger *LedgerAvalanche) (*ResponseSi
 		// Send path to sign hash that should be in device's ram memory
 		header := []byte{CLA, INS_SIGN_HASH, byte(p1), byte(0x00), byte(len(pathBuf))}
 		bytesToSend := append(header, pathBuf...)
-		response, err := ledger.api.Exchange(bytesToSend)
+		response, err := op.exchange(bytesToSend, false)
 
 		if err != nil {
 			return nil, err
@@ -253,30 +383,29 @@ func SignAndCollect(signingPaths []string, ledger *LedgerAvalanche) (*ResponseSi
 	return &ResponseSign{nil, signatures}, nil
 }
 
+// VerifyMultipleSignatures checks the signature of each signing path.
+// Only the extended public key of rootPath is requested to the device,
+// the keys of the signing paths are derived from it, see VerifyBatch
 func (ledger *LedgerAvalanche) VerifyMultipleSignatures(response ResponseSign, messageHash []byte, rootPath string, signingPaths []string, hrp string, chainID string) error {
 	if len(response.Signature) != len(signingPaths) {
 		return errors.New("sizes of signatures and paths don't match")
 	}
 
-	for _, suffix := range signingPaths {
-		path := fmt.Sprintf("%s/%s", rootPath, suffix)
-
-		addr, err := ledger.GetPubKey(path, false, hrp, chainID)
-		if err != nil {
-			return errors.New("error getting the pubkey")
-		}
-
-		hexString := fmt.Sprintf("%x", addr.PublicKey)
-		fmt.Println(hexString)
-
-		sigLen := len(response.Signature[suffix])
-		verified := VerifySignature(addr.PublicKey, messageHash, response.Signature[suffix][:sigLen-1])
+	xpub, err := ledger.GetExtendedPubKey(rootPath, false, hrp, chainID)
+	if err != nil {
+		return errors.New("error getting the extended pubkey")
+	}
 
-		if !verified {
-			return errors.New("[VerifySig] Error verifying signature: ")
+	signatures := make(map[string][]byte, len(signingPaths))
+	for _, suffix := range signingPaths {
+		signature, ok := response.Signature[suffix]
+		if !ok {
+			return fmt.Errorf("[VerifySig] Missing signature for %s", suffix)
 		}
+		signatures[suffix] = signature
 	}
-	return nil
+
+	return VerifyBatch(xpub, messageHash, signatures)
 }
 
 // VerifySignature checks that the given public key created signature over hash.
@@ -0,0 +1,134 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+// see app/src/utils/upload_refs.rs for the format
+const (
+	literalMaxLen    = 0x80
+	maxUploadValues  = 32
+	longValueTag     = 0x80
+	shortValueTag    = 0xA0
+	longValueLength  = 32
+	shortValueLength = 20
+)
+
+type valueKind struct {
+	length   int
+	tag      byte
+	repeated map[string]bool
+	values   map[string]byte
+}
+
+// values found more than once in the data
+func repeatedValues(data []byte, length int) map[string]bool {
+	seen := make(map[string]bool)
+	repeated := make(map[string]bool)
+
+	for i := 0; i+length <= len(data); i++ {
+		value := string(data[i : i+length])
+		if seen[value] {
+			repeated[value] = true
+		} else {
+			seen[value] = true
+		}
+	}
+
+	return repeated
+}
+
+func tokenize(data []byte) [][]byte {
+	var tokens [][]byte
+
+	kinds := []*valueKind{
+		{longValueLength, longValueTag, repeatedValues(data, longValueLength), make(map[string]byte)},
+		{shortValueLength, shortValueTag, repeatedValues(data, shortValueLength), make(map[string]byte)},
+	}
+
+	literalStart := 0
+	pushLiteral := func(end int) {
+		for i := literalStart; i < end; i += literalMaxLen {
+			literalEnd := i + literalMaxLen
+			if literalEnd > end {
+				literalEnd = end
+			}
+			literal := data[i:literalEnd]
+			tokens = append(tokens, append([]byte{byte(len(literal) - 1)}, literal...))
+		}
+	}
+
+	pos := 0
+next:
+	for pos < len(data) {
+		for _, kind := range kinds {
+			if pos+kind.length > len(data) {
+				continue
+			}
+
+			value := string(data[pos : pos+kind.length])
+			if !kind.repeated[value] {
+				continue
+			}
+
+			var token []byte
+			if index, ok := kind.values[value]; ok {
+				token = []byte{kind.tag | index}
+			} else if len(kind.values) < maxUploadValues {
+				// first time, the value follows its number
+				index := byte(len(kind.values))
+				kind.values[value] = index
+				token = append([]byte{kind.tag | index}, value...)
+			} else {
+				continue
+			}
+
+			pushLiteral(pos)
+			tokens = append(tokens, token)
+
+			pos += kind.length
+			literalStart = pos
+			continue next
+		}
+
+		pos++
+	}
+	pushLiteral(len(data))
+
+	return tokens
+}
+
+// CompressChunks splits data in compressed chunks of at most chunkSize bytes,
+// sending repeated 32-byte and 20-byte values (asset ids, tx ids, addresses) only once
+//
+// Chunks are only split between tokens, as required by the device
+func CompressChunks(data []byte, chunkSize int) [][]byte {
+	var chunks [][]byte
+
+	var current []byte
+	for _, token := range tokenize(data) {
+		if len(current)+len(token) > chunkSize {
+			chunks = append(chunks, current)
+			current = nil
+		}
+		current = append(current, token...)
+	}
+
+	if len(current) > 0 {
+		chunks = append(chunks, current)
+	}
+
+	return chunks
+}
@@ -0,0 +1,96 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+import (
+	"bytes"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+)
+
+// mirrors UploadRefs::expand on the device
+func expandChunks(t *testing.T, chunks [][]byte) []byte {
+	var out []byte
+	var long, short []int
+
+	for _, chunk := range chunks {
+		for p := 0; p < len(chunk); {
+			tag := chunk[p]
+			p++
+
+			if tag < longValueTag {
+				end := p + int(tag) + 1
+				assert.LessOrEqual(t, end, len(chunk), "literal split between chunks")
+				out = append(out, chunk[p:end]...)
+				p = end
+				continue
+			}
+
+			length, values := longValueLength, &long
+			if tag >= shortValueTag {
+				length, values = shortValueLength, &short
+			}
+
+			index := int(tag & 0x1F)
+			if index == len(*values) {
+				*values = append(*values, len(out))
+				out = append(out, chunk[p:p+length]...)
+				p += length
+			} else {
+				offset := (*values)[index]
+				out = append(out, out[offset:offset+length]...)
+			}
+		}
+	}
+
+	return out
+}
+
+func Test_CompressChunks(t *testing.T) {
+	asset := bytes.Repeat([]byte{0xAA}, 32)
+	address := bytes.Repeat([]byte{0xBB}, 20)
+
+	data := []byte{0, 0, 0, 1}
+	for i := 0; i < 20; i++ {
+		data = append(data, asset...)
+		data = append(data, byte(i), 1, 2)
+		data = append(data, address...)
+		data = append(data, bytes.Repeat([]byte{byte(i)}, 8)...)
+	}
+
+	chunks := CompressChunks(data, CHUNK_SIZE)
+
+	size := 0
+	for _, chunk := range chunks {
+		assert.LessOrEqual(t, len(chunk), CHUNK_SIZE)
+		size += len(chunk)
+	}
+
+	assert.Less(t, size, len(data)/2)
+	assert.Equal(t, data, expandChunks(t, chunks))
+}
+
+func Test_CompressChunksNoRepetitions(t *testing.T) {
+	data := make([]byte, 300)
+	for i := range data {
+		data[i] = byte(i)
+	}
+
+	chunks := CompressChunks(data, CHUNK_SIZE)
+	assert.Equal(t, data, expandChunks(t, chunks))
+}
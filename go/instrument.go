@@ -0,0 +1,309 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+import (
+	"encoding/json"
+	"fmt"
+	"math"
+	"sort"
+	"strings"
+	"sync"
+	"time"
+)
+
+// ApduEvent describes an APDU exchanged with the device
+type ApduEvent struct {
+	// The call of the app the APDU is part of (e.g "sign")
+	Operation string `json:"operation"`
+	Cla       byte   `json:"cla"`
+	Ins       byte   `json:"ins"`
+	P1        byte   `json:"p1"`
+	P2        byte   `json:"p2"`
+	BytesSent int    `json:"bytesSent"`
+	// Without the status word, which the transport strips
+	BytesReceived int `json:"bytesReceived"`
+	// 0x9000, the status word of the error, or 0 when the transport failed
+	StatusWord uint16        `json:"statusWord"`
+	Error      string        `json:"error,omitempty"`
+	Start      time.Time     `json:"start"`
+	RTT        time.Duration `json:"rttNs"`
+	// The device waited for the user before answering
+	UserApproval bool `json:"userApproval"`
+}
+
+// RTTPercentiles are the round trips of an operation, in milliseconds
+type RTTPercentiles struct {
+	P50 float64 `json:"p50"`
+	P90 float64 `json:"p90"`
+	P99 float64 `json:"p99"`
+	Max float64 `json:"max"`
+}
+
+// OperationStats aggregates the APDUs of every call of an operation
+type OperationStats struct {
+	Operation     string `json:"operation"`
+	Calls         int    `json:"calls"`
+	Apdus         int    `json:"apdus"`
+	BytesSent     int    `json:"bytesSent"`
+	BytesReceived int    `json:"bytesReceived"`
+	// Of the APDUs that didn't wait for the user
+	RTTMs          RTTPercentiles `json:"rttMs"`
+	UserApprovalMs float64        `json:"userApprovalMs"`
+	TotalMs        float64        `json:"totalMs"`
+}
+
+type operationCalls struct {
+	calls int
+	total time.Duration
+}
+
+// Instrumentation records the APDUs exchanged by the app, see SetInstrumentation
+//
+// The hook, if any, is called after each APDU.
+// Marshalled to JSON, it exports the events along with the stats of each operation
+type Instrumentation struct {
+	hook func(ApduEvent)
+
+	mu     sync.Mutex
+	events []ApduEvent
+	calls  map[string]*operationCalls
+}
+
+func NewInstrumentation(hook func(ApduEvent)) *Instrumentation {
+	return &Instrumentation{hook: hook, calls: make(map[string]*operationCalls)}
+}
+
+// SetInstrumentation records the APDUs of the app in instrumentation, nil to stop
+func (ledger *LedgerAvalanche) SetInstrumentation(instrumentation *Instrumentation) {
+	ledger.instrumentation = instrumentation
+}
+
+// operation is one call of the app, the APDUs exchanged through it are grouped under its name.
+// The call is passed along rather than kept in Instrumentation, so calls of different
+// operations running at once on a shared Instrumentation are told apart
+type operation struct {
+	ledger          *LedgerAvalanche
+	instrumentation *Instrumentation
+	name            string
+	start           time.Time
+}
+
+// operation starts a call of the operation name, to be ended with end
+func (ledger *LedgerAvalanche) operation(name string) *operation {
+	return &operation{ledger: ledger, instrumentation: ledger.instrumentation, name: name, start: time.Now()}
+}
+
+// end records the duration of the call
+func (op *operation) end() {
+	i := op.instrumentation
+	if i == nil {
+		return
+	}
+
+	i.mu.Lock()
+	defer i.mu.Unlock()
+
+	calls, ok := i.calls[op.name]
+	if !ok {
+		calls = &operationCalls{}
+		i.calls[op.name] = calls
+	}
+	calls.calls++
+	calls.total += time.Since(op.start)
+}
+
+// exchange sends apdu to the device as part of the call, recording it when instrumented
+func (op *operation) exchange(apdu []byte, userApproval bool) ([]byte, error) {
+	i := op.instrumentation
+	if i == nil {
+		return op.ledger.api.Exchange(apdu)
+	}
+
+	start := time.Now()
+	response, err := op.ledger.api.Exchange(apdu)
+	i.record(op.name, apdu, response, err, start, time.Since(start), userApproval)
+
+	return response, err
+}
+
+// exchange sends apdu to the device outside of any operation
+func (ledger *LedgerAvalanche) exchange(apdu []byte, userApproval bool) ([]byte, error) {
+	op := operation{ledger: ledger, instrumentation: ledger.instrumentation}
+	return op.exchange(apdu, userApproval)
+}
+
+// status words of the errors returned by ledger-go, which only keeps their description
+var statusWords = map[string]uint16{
+	"[APDU_CODE_EXECUTION_ERROR]":          0x6400,
+	"[APDU_CODE_WRONG_LENGTH]":             0x6700,
+	"[APDU_CODE_EMPTY_BUFFER]":             0x6982,
+	"[APDU_CODE_OUTPUT_BUFFER_TOO_SMALL]":  0x6983,
+	"[APDU_CODE_DATA_INVALID]":             0x6984,
+	"[APDU_CODE_CONDITIONS_NOT_SATISFIED]": 0x6985,
+	"[APDU_CODE_COMMAND_NOT_ALLOWED]":      0x6986,
+	"[APDU_CODE_BAD_KEY_HANDLE]":           0x6a80,
+	"[APDU_CODE_INVALID_P1P2]":             0x6b00,
+	"[APDU_CODE_INS_NOT_SUPPORTED]":        0x6d00,
+	"[APDU_CODE_CLA_NOT_SUPPORTED]":        0x6e00,
+	"[APDU_CODE_UNKNOWN]":                  0x6f00,
+	"[APDU_CODE_SIGN_VERIFY_ERROR]":        0x6f01,
+}
+
+// statusWord returns the status word the device answered with err, 0 if the transport failed
+func statusWord(err error) uint16 {
+	message := err.Error()
+	if end := strings.IndexByte(message, ']'); strings.HasPrefix(message, "[APDU_CODE_") && end > 0 {
+		return statusWords[message[:end+1]]
+	}
+
+	// the status words ledger-go has no description for
+	var sw uint16
+	if _, err := fmt.Sscanf(message, "Error code: %04x", &sw); err == nil {
+		return sw
+	}
+	return 0
+}
+
+func (i *Instrumentation) record(operation string, apdu []byte, response []byte, err error, start time.Time, rtt time.Duration, userApproval bool) {
+	event := ApduEvent{
+		Operation:     operation,
+		BytesSent:     len(apdu),
+		BytesReceived: len(response),
+		StatusWord:    uint16(NoErrors),
+		Start:         start,
+		RTT:           rtt,
+		UserApproval:  userApproval,
+	}
+	if len(apdu) >= 4 {
+		event.Cla, event.Ins, event.P1, event.P2 = apdu[0], apdu[1], apdu[2], apdu[3]
+	}
+	if err != nil {
+		event.StatusWord = statusWord(err)
+		event.Error = err.Error()
+	}
+	if event.Operation == "" {
+		event.Operation = fmt.Sprintf("ins_0x%02x", event.Ins)
+	}
+
+	i.mu.Lock()
+	i.events = append(i.events, event)
+	i.mu.Unlock()
+
+	if i.hook != nil {
+		i.hook(event)
+	}
+}
+
+// Events returns a copy of the recorded events
+func (i *Instrumentation) Events() []ApduEvent {
+	i.mu.Lock()
+	defer i.mu.Unlock()
+
+	return append([]ApduEvent(nil), i.events...)
+}
+
+// Reset forgets the recorded events
+func (i *Instrumentation) Reset() {
+	i.mu.Lock()
+	defer i.mu.Unlock()
+
+	i.events = nil
+	i.calls = make(map[string]*operationCalls)
+}
+
+func milliseconds(d time.Duration) float64 {
+	return float64(d) / float64(time.Millisecond)
+}
+
+// percentile by nearest rank, sorted in ascending order
+func percentile(sorted []time.Duration, p float64) float64 {
+	if len(sorted) == 0 {
+		return 0
+	}
+	rank := int(math.Ceil(p/100*float64(len(sorted)))) - 1
+	if rank < 0 {
+		rank = 0
+	}
+	if rank >= len(sorted) {
+		rank = len(sorted) - 1
+	}
+	return milliseconds(sorted[rank])
+}
+
+// Stats aggregates the recorded events by operation, in order of first use
+func (i *Instrumentation) Stats() []OperationStats {
+	i.mu.Lock()
+	defer i.mu.Unlock()
+
+	var order []string
+	byOperation := make(map[string][]ApduEvent)
+	for _, event := range i.events {
+		if _, ok := byOperation[event.Operation]; !ok {
+			order = append(order, event.Operation)
+		}
+		byOperation[event.Operation] = append(byOperation[event.Operation], event)
+	}
+
+	stats := make([]OperationStats, 0, len(order))
+	for _, operation := range order {
+		events := byOperation[operation]
+		s := OperationStats{Operation: operation, Apdus: len(events)}
+
+		var rtts []time.Duration
+		var approval, total time.Duration
+		for _, event := range events {
+			s.BytesSent += event.BytesSent
+			s.BytesReceived += event.BytesReceived
+			total += event.RTT
+			if event.UserApproval {
+				approval += event.RTT
+			} else {
+				rtts = append(rtts, event.RTT)
+			}
+		}
+		sort.Slice(rtts, func(a, b int) bool { return rtts[a] < rtts[b] })
+
+		s.RTTMs = RTTPercentiles{
+			P50: percentile(rtts, 50),
+			P90: percentile(rtts, 90),
+			P99: percentile(rtts, 99),
+			Max: percentile(rtts, 100),
+		}
+		s.UserApprovalMs = milliseconds(approval)
+
+		// APDUs sent outside of an operation are calls of their own
+		if calls, ok := i.calls[operation]; ok {
+			s.Calls = calls.calls
+			s.TotalMs = milliseconds(calls.total)
+		} else {
+			s.Calls = len(events)
+			s.TotalMs = milliseconds(total)
+		}
+
+		stats = append(stats, s)
+	}
+
+	return stats
+}
+
+func (i *Instrumentation) MarshalJSON() ([]byte, error) {
+	return json.Marshal(struct {
+		Operations []OperationStats `json:"operations"`
+		Apdus      []ApduEvent      `json:"apdus"`
+	}{i.Stats(), i.Events()})
+}
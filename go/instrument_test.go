@@ -0,0 +1,159 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+import (
+	"encoding/json"
+	"errors"
+	"sync"
+	"testing"
+	"time"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// answers each APDU with the next response, after a delay
+type scriptedDevice struct {
+	responses [][]byte
+	delay     time.Duration
+}
+
+func (d *scriptedDevice) Exchange(command []byte) ([]byte, error) {
+	time.Sleep(d.delay)
+	if len(d.responses) == 0 {
+		return nil, errors.New("[APDU_CODE_CONDITIONS_NOT_SATISFIED] Conditions of use not satisfied")
+	}
+	response := d.responses[0]
+	d.responses = d.responses[1:]
+	return response, nil
+}
+
+func (d *scriptedDevice) Close() error {
+	return nil
+}
+
+func Test_InstrumentSignHash(t *testing.T) {
+	device := &scriptedDevice{responses: [][]byte{{}, make([]byte, 65), make([]byte, 65)}, delay: time.Millisecond}
+	app := &LedgerAvalanche{api: device}
+
+	var hooked []ApduEvent
+	instrumentation := NewInstrumentation(func(event ApduEvent) { hooked = append(hooked, event) })
+	app.SetInstrumentation(instrumentation)
+
+	_, err := app.SignHash("m/44'/9000'/0'", []string{"0/0", "0/1"}, make([]byte, HASH_LEN))
+	require.NoError(t, err)
+
+	// the next APDU isn't answered, and is not part of an operation
+	_, err = app.exchange([]byte{CLA, INS_WALLET_ID, 0, 0, 0}, false)
+	require.Error(t, err)
+
+	events := instrumentation.Events()
+	assert.Equal(t, events, hooked)
+	require.Len(t, events, 4)
+	assert.True(t, events[0].UserApproval)
+	assert.Equal(t, 65, events[1].BytesReceived)
+	assert.Equal(t, uint16(ConditionsNotSatisfied), events[3].StatusWord)
+
+	stats := instrumentation.Stats()
+	require.Len(t, stats, 2)
+
+	signHash := stats[0]
+	assert.Equal(t, "signHash", signHash.Operation)
+	assert.Equal(t, 1, signHash.Calls)
+	assert.Equal(t, 3, signHash.Apdus)
+	assert.Equal(t, 130, signHash.BytesReceived)
+	assert.Greater(t, signHash.UserApprovalMs, 0.0)
+	assert.GreaterOrEqual(t, signHash.TotalMs, signHash.UserApprovalMs+signHash.RTTMs.P50)
+
+	assert.Equal(t, "ins_0x01", stats[1].Operation)
+	assert.Equal(t, 1, stats[1].Calls)
+
+	exported, err := json.Marshal(instrumentation)
+	require.NoError(t, err)
+
+	var decoded struct {
+		Operations []OperationStats `json:"operations"`
+		Apdus      []ApduEvent      `json:"apdus"`
+	}
+	require.NoError(t, json.Unmarshal(exported, &decoded))
+	assert.Len(t, decoded.Operations, 2)
+	assert.Len(t, decoded.Apdus, 4)
+}
+
+func Test_InstrumentConcurrentOperations(t *testing.T) {
+	instrumentation := NewInstrumentation(nil)
+
+	// two devices recorded in the same instrumentation
+	versions := &scriptedDevice{responses: [][]byte{{0, 1, 2, 3}, {0, 1, 2, 3}, {0, 1, 2, 3}}, delay: time.Millisecond}
+	hashes := &scriptedDevice{responses: [][]byte{{}, make([]byte, 65)}, delay: time.Millisecond}
+	versionApp := &LedgerAvalanche{api: versions}
+	versionApp.SetInstrumentation(instrumentation)
+	hashApp := &LedgerAvalanche{api: hashes}
+	hashApp.SetInstrumentation(instrumentation)
+
+	var wg sync.WaitGroup
+	wg.Add(2)
+	go func() {
+		defer wg.Done()
+		for i := 0; i < 3; i++ {
+			_, err := versionApp.GetVersion()
+			assert.NoError(t, err)
+		}
+	}()
+	go func() {
+		defer wg.Done()
+		_, err := hashApp.SignHash("m/44'/9000'/0'", []string{"0/0"}, make([]byte, HASH_LEN))
+		assert.NoError(t, err)
+	}()
+	wg.Wait()
+
+	for _, event := range instrumentation.Events() {
+		switch event.Ins {
+		case INS_GET_VERSION:
+			assert.Equal(t, "getVersion", event.Operation)
+		case INS_SIGN_HASH:
+			assert.Equal(t, "signHash", event.Operation)
+		}
+	}
+
+	calls := make(map[string]int)
+	for _, stats := range instrumentation.Stats() {
+		calls[stats.Operation] = stats.Calls
+	}
+	assert.Equal(t, map[string]int{"getVersion": 3, "signHash": 1}, calls)
+}
+
+func Test_StatusWord(t *testing.T) {
+	assert.Equal(t, uint16(TransactionRejected), statusWord(errors.New("[APDU_CODE_COMMAND_NOT_ALLOWED] Command not allowed (no current EF)")))
+	assert.Equal(t, uint16(0x6a80), statusWord(errors.New("[APDU_CODE_BAD_KEY_HANDLE] The parameters in the data field are incorrect")))
+	assert.Equal(t, uint16(0x6e00), statusWord(errors.New("[APDU_CODE_CLA_NOT_SUPPORTED] CLA not supported")))
+	assert.Equal(t, uint16(0x6a89), statusWord(errors.New("Error code: 6a89")))
+	assert.Equal(t, uint16(0), statusWord(errors.New("hidapi: failed to write")))
+}
+
+func Test_Percentile(t *testing.T) {
+	rtts := []time.Duration{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}
+	for i := range rtts {
+		rtts[i] *= time.Millisecond
+	}
+
+	assert.Equal(t, 5.0, percentile(rtts, 50))
+	assert.Equal(t, 9.0, percentile(rtts, 90))
+	assert.Equal(t, 10.0, percentile(rtts, 99))
+	assert.Equal(t, 0.0, percentile(nil, 50))
+}
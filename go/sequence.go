@@ -0,0 +1,77 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+import (
+	"encoding/binary"
+	"hash/crc32"
+	"strings"
+)
+
+// see app/src/utils/upload_seq.rs for the format
+const (
+	sequenceHeaderLength = 2 + 4
+	// times a sequenced upload is resumed before giving up
+	maxUploadResumes = 3
+)
+
+// sequenceChunk prefixes chunk with its offset in the upload and its checksum,
+// an empty chunk only retrieves the offset the device got to
+func sequenceChunk(offset int, chunk []byte) []byte {
+	out := make([]byte, sequenceHeaderLength, sequenceHeaderLength+len(chunk))
+	binary.BigEndian.PutUint16(out, uint16(offset))
+	binary.BigEndian.PutUint32(out[2:], crc32.ChecksumIEEE(chunk))
+	return append(out, chunk...)
+}
+
+// chunkOffsets returns the offset of each chunk in the upload, followed by its total length
+func chunkOffsets(chunks [][]byte) []int {
+	offsets := make([]int, 0, len(chunks)+1)
+	offset := 0
+	for _, chunk := range chunks {
+		offsets = append(offsets, offset)
+		offset += len(chunk)
+	}
+	return append(offsets, offset)
+}
+
+// chunkAt returns the index of the chunk starting at offset, -1 if none does
+func chunkAt(offsets []int, offset int) int {
+	for i, o := range offsets[:len(offsets)-1] {
+		if o == offset {
+			return i
+		}
+	}
+	return -1
+}
+
+// isDeviceError tells if err is a status word returned by the device,
+// rather than the transport failing
+func isDeviceError(err error) bool {
+	return strings.HasPrefix(err.Error(), "[APDU_CODE_")
+}
+
+// uploadReceived returns the number of bytes of a sequenced upload received by the device
+func (op *operation) uploadReceived(ins byte) (int, bool) {
+	data := sequenceChunk(0, nil)
+	header := []byte{CLA, ins, PAYLOAD_ADD | PAYLOAD_SEQUENCED, 0, byte(len(data))}
+	response, err := op.exchange(append(header, data...), false)
+	if err != nil || len(response) < 2 {
+		return 0, false
+	}
+	return int(binary.BigEndian.Uint16(response)), true
+}
@@ -0,0 +1,101 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+import (
+	"encoding/binary"
+	"errors"
+	"hash/crc32"
+	"testing"
+
+	"github.com/stretchr/testify/assert"
+	"github.com/stretchr/testify/require"
+)
+
+// mirrors UploadProgress on the device, losing the answer to
+// the sequenced packets listed in drop
+type sequencedDevice struct {
+	data    []byte
+	packets int
+	drop    map[int]bool
+}
+
+func (d *sequencedDevice) Exchange(command []byte) ([]byte, error) {
+	ins, p1, payload := command[1], command[2], command[5:]
+	if ins == INS_SIGN_HASH {
+		return make([]byte, 65), nil
+	}
+	if p1 == PAYLOAD_INIT {
+		d.data = nil
+		return []byte{}, nil
+	}
+
+	if p1&PAYLOAD_SEQUENCED == 0 || len(payload) < sequenceHeaderLength {
+		return nil, errors.New("[APDU_CODE_DATA_INVALID] Referenced data reversibly blocked (invalidated)")
+	}
+	offset := int(binary.BigEndian.Uint16(payload))
+	checksum := binary.BigEndian.Uint32(payload[2:])
+	data := payload[sequenceHeaderLength:]
+
+	if len(data) > 0 && offset+len(data) > len(d.data) {
+		if offset != len(d.data) || crc32.ChecksumIEEE(data) != checksum {
+			return nil, errors.New("[APDU_CODE_DATA_INVALID] Referenced data reversibly blocked (invalidated)")
+		}
+		d.data = append(d.data, data...)
+	}
+
+	d.packets++
+	if d.drop[d.packets] {
+		return nil, errors.New("hidapi: failed to read")
+	}
+	if p1&^PAYLOAD_SEQUENCED == PAYLOAD_LAST {
+		return []byte{}, nil
+	}
+
+	ack := make([]byte, 2)
+	binary.BigEndian.PutUint16(ack, uint16(len(d.data)))
+	return ack, nil
+}
+
+func (d *sequencedDevice) Close() error {
+	return nil
+}
+
+func Test_SignResumable(t *testing.T) {
+	message := make([]byte, 1000)
+	for i := range message {
+		message[i] = byte(i)
+	}
+	signers := []string{"0/0", "0/1"}
+
+	// the answer of the second packet is lost, then the one of the query for
+	// the received offset, and finally the one of the packet sent again
+	device := &sequencedDevice{drop: map[int]bool{2: true, 3: true, 4: true}}
+	app := &LedgerAvalanche{api: device}
+
+	response, err := app.SignResumable("m/44'/9000'/0'", signers, message, nil, false)
+	require.NoError(t, err)
+	assert.Len(t, response.Signature, len(signers))
+	assert.Equal(t, ConcatMessageAndChangePath(message, signers), device.data)
+
+	// gives up after a few times
+	device = &sequencedDevice{drop: map[int]bool{1: true, 2: true, 3: true, 4: true, 5: true, 6: true, 7: true}}
+	app = &LedgerAvalanche{api: device}
+
+	_, err = app.SignResumable("m/44'/9000'/0'", signers, message, nil, false)
+	require.Error(t, err)
+}
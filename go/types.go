@@ -33,6 +33,11 @@ const (
 	PAYLOAD_ADD  = 0x01
 	PAYLOAD_LAST = 0x02
 
+	// set in the payload type of compressed chunks, see CompressChunks
+	PAYLOAD_COMPRESSED = 0x80
+	// set in the payload type of sequenced chunks, see sequenceChunk
+	PAYLOAD_SEQUENCED = 0x40
+
 	FIRST_MESSAGE = 0x01
 	LAST_MESSAGE  = 0x02
 	NEXT_MESSAGE  = 0x03
@@ -86,8 +91,9 @@ const (
 
 // LedgerAvalanche represents a connection to the Avax app in a Ledger device
 type LedgerAvalanche struct {
-	api     ledger_go.LedgerDevice
-	version VersionInfo
+	api             ledger_go.LedgerDevice
+	version         VersionInfo
+	instrumentation *Instrumentation
 }
 
 // VersionInfo contains app version information
@@ -117,3 +123,10 @@ type ResponseAddr struct {
 	Hash      []byte
 	Address   string
 }
+
+// ResponseXPub is a compressed public key along with its BIP32 chain code,
+// enough to derive the public keys of its non-hardened children
+type ResponseXPub struct {
+	PublicKey []byte
+	ChainCode []byte
+}
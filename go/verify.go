@@ -0,0 +1,170 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+import (
+	"crypto/hmac"
+	"crypto/sha512"
+	"encoding/binary"
+	"errors"
+	"fmt"
+	"runtime"
+	"strconv"
+	"strings"
+	"sync"
+
+	"github.com/btcsuite/btcd/btcec/v2"
+)
+
+const hardenedOffset = 0x80000000
+
+// Child derives the public key of the non-hardened child at index (BIP32 CKDpub)
+func (xpub *ResponseXPub) Child(index uint32) (*ResponseXPub, error) {
+	if index >= hardenedOffset {
+		return nil, errors.New("hardened keys can't be derived from a public key")
+	}
+
+	parent, err := btcec.ParsePubKey(xpub.PublicKey)
+	if err != nil {
+		return nil, err
+	}
+
+	mac := hmac.New(sha512.New, xpub.ChainCode)
+	mac.Write(parent.SerializeCompressed())
+	_ = binary.Write(mac, binary.BigEndian, index)
+	i := mac.Sum(nil)
+
+	var tweak btcec.ModNScalar
+	if tweak.SetByteSlice(i[:32]) {
+		return nil, errors.New("invalid child key")
+	}
+
+	// child = tweak * G + parent
+	var tweakPoint, parentPoint, point btcec.JacobianPoint
+	btcec.ScalarBaseMultNonConst(&tweak, &tweakPoint)
+	parent.AsJacobian(&parentPoint)
+	btcec.AddNonConst(&tweakPoint, &parentPoint, &point)
+
+	if (point.X.IsZero() && point.Y.IsZero()) || point.Z.IsZero() {
+		return nil, errors.New("invalid child key")
+	}
+	point.ToAffine()
+
+	child := btcec.NewPublicKey(&point.X, &point.Y)
+	return &ResponseXPub{child.SerializeCompressed(), i[32:]}, nil
+}
+
+// Derive follows a relative path of non-hardened indices, like "0/5"
+func (xpub *ResponseXPub) Derive(path string) (*ResponseXPub, error) {
+	key := xpub
+	for _, component := range strings.Split(path, "/") {
+		index, err := strconv.ParseUint(component, 10, 32)
+		if err != nil {
+			return nil, fmt.Errorf("invalid path %s: %w", path, err)
+		}
+
+		key, err = key.Child(uint32(index))
+		if err != nil {
+			return nil, err
+		}
+	}
+
+	return key, nil
+}
+
+// VerifyBatch checks the signature of each path suffix against
+// the public key derived from xpub at that path.
+//
+// The keys shared by several paths (like the "0" of "0/1" and "0/2")
+// are derived once, then the signatures are verified in parallel
+func VerifyBatch(xpub *ResponseXPub, hash []byte, signatures map[string][]byte) error {
+	type job struct {
+		suffix    string
+		parent    *ResponseXPub
+		index     uint32
+		signature []byte
+	}
+
+	parents := make(map[string]*ResponseXPub)
+	jobs := make([]job, 0, len(signatures))
+
+	for suffix, signature := range signatures {
+		// signatures are [R || S || V]
+		if len(signature) != 65 {
+			return fmt.Errorf("[VerifySig] Invalid signature length for %s", suffix)
+		}
+
+		parentPath, last := "", suffix
+		if i := strings.LastIndex(suffix, "/"); i >= 0 {
+			parentPath, last = suffix[:i], suffix[i+1:]
+		}
+
+		index, err := strconv.ParseUint(last, 10, 32)
+		if err != nil {
+			return fmt.Errorf("invalid path %s: %w", suffix, err)
+		}
+
+		parent, ok := parents[parentPath]
+		if !ok {
+			parent = xpub
+			if parentPath != "" {
+				if parent, err = xpub.Derive(parentPath); err != nil {
+					return err
+				}
+			}
+			parents[parentPath] = parent
+		}
+
+		jobs = append(jobs, job{suffix, parent, uint32(index), signature[:64]})
+	}
+
+	workers := runtime.NumCPU()
+	if workers > len(jobs) {
+		workers = len(jobs)
+	}
+
+	queue := make(chan job)
+	failed := make(chan error, len(jobs))
+
+	var wg sync.WaitGroup
+	for w := 0; w < workers; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for j := range queue {
+				key, err := j.parent.Child(j.index)
+				if err != nil {
+					failed <- err
+					continue
+				}
+
+				if !VerifySignature(key.PublicKey, hash, j.signature) {
+					failed <- fmt.Errorf("[VerifySig] Error verifying signature of %s", j.suffix)
+				}
+			}
+		}()
+	}
+
+	for _, j := range jobs {
+		queue <- j
+	}
+	close(queue)
+	wg.Wait()
+	close(failed)
+
+	return <-failed
+}
@@ -0,0 +1,112 @@
+/*******************************************************************************
+*   (c) 2023 Zondax AG
+*
+*  Licensed under the Apache License, Version 2.0 (the "License");
+*  you may not use this file except in compliance with the License.
+*  You may obtain a copy of the License at
+*
+*      http://www.apache.org/licenses/LICENSE-2.0
+*
+*  Unless required by applicable law or agreed to in writing, software
+*  distributed under the License is distributed on an "AS IS" BASIS,
+*  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+*  See the License for the specific language governing permissions and
+*  limitations under the License.
+********************************************************************************/
+
+package ledger_avalanche_go
+
+import (
+	"crypto/hmac"
+	"crypto/sha256"
+	"crypto/sha512"
+	"encoding/binary"
+	"encoding/hex"
+	"strings"
+	"testing"
+
+	"github.com/btcsuite/btcd/btcec/v2"
+	"github.com/btcsuite/btcd/btcec/v2/ecdsa"
+	"github.com/stretchr/testify/assert"
+)
+
+// BIP32 CKDpriv, to sign with the keys derived by the verifier
+func privateChild(t *testing.T, key *btcec.PrivateKey, chainCode []byte, index uint32) (*btcec.PrivateKey, []byte) {
+	mac := hmac.New(sha512.New, chainCode)
+	mac.Write(key.PubKey().SerializeCompressed())
+	_ = binary.Write(mac, binary.BigEndian, index)
+	i := mac.Sum(nil)
+
+	var child btcec.ModNScalar
+	assert.False(t, child.SetByteSlice(i[:32]))
+	child.Add(&key.Key)
+
+	bytes := child.Bytes()
+	childKey, _ := btcec.PrivKeyFromBytes(bytes[:])
+	return childKey, i[32:]
+}
+
+func Test_DerivePublicChild(t *testing.T) {
+	// BIP32 test vector 1, m/0H to m/0H/1
+	xpub := &ResponseXPub{
+		PublicKey: mustDecode("035a784662a4a20a65bf6aab9ae98a6c068a81c52e4b032c0fb5400c706cfccc56"),
+		ChainCode: mustDecode("47fdacbd0f1097043b78c63c20c34ef4ed9a111d980047ad16282c7ae6236141"),
+	}
+
+	child, err := xpub.Child(1)
+	assert.NoError(t, err)
+	assert.Equal(t, mustDecode("03501e454bf00751f24b1b489aa925215d66af2234e3891c3b21a52bedb3cd711c"), child.PublicKey)
+	assert.Equal(t, mustDecode("2a7857631386ba23dacac34180dd1983734e444fdbf774041578e9b6adb37c19"), child.ChainCode)
+
+	_, err = xpub.Child(hardenedOffset)
+	assert.Error(t, err)
+}
+
+func Test_VerifyBatch(t *testing.T) {
+	root, _ := btcec.PrivKeyFromBytes(bytes32(0x11))
+	chainCode := bytes32(0x22)
+	xpub := &ResponseXPub{root.PubKey().SerializeCompressed(), chainCode}
+
+	hash := sha256.Sum256([]byte("AvalancheApp"))
+
+	signatures := make(map[string][]byte)
+	for _, path := range []string{"0/0", "0/1", "1/5", "4/8", "7"} {
+		key, code := root, chainCode
+		for _, component := range strings.Split(path, "/") {
+			index := uint32(component[0] - '0')
+			key, code = privateChild(t, key, code, index)
+		}
+
+		// [V || R || S] to the [R || S || V] returned by the device
+		compact, err := ecdsa.SignCompact(key, hash[:], true)
+		assert.NoError(t, err)
+		signatures[path] = append(compact[1:], compact[0])
+	}
+
+	assert.NoError(t, VerifyBatch(xpub, hash[:], signatures))
+
+	// signed by another key
+	signatures["1/5"], signatures["4/8"] = signatures["4/8"], signatures["1/5"]
+	assert.Error(t, VerifyBatch(xpub, hash[:], signatures))
+	signatures["1/5"], signatures["4/8"] = signatures["4/8"], signatures["1/5"]
+
+	// can't be derived from the xpub
+	signatures["0'/1"] = signatures["0/1"]
+	assert.Error(t, VerifyBatch(xpub, hash[:], signatures))
+}
+
+func mustDecode(s string) []byte {
+	b, err := hex.DecodeString(s)
+	if err != nil {
+		panic(err)
+	}
+	return b
+}
+
+func bytes32(b byte) []byte {
+	out := make([]byte, 32)
+	for i := range out {
+		out[i] = b
+	}
+	return out
+}
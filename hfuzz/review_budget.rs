@@ -0,0 +1,41 @@
+//! Flags transactions whose parsing and review cost grows faster than their size
+//!
+//! The size of a transaction is the number of objects in its lists,
+//! plus the pages shown to review it, as each page renders one of them.
+//! A parser and renderers that don't re-read lists more than necessary
+//! parse every object a fixed number of times, so they stay within a fixed
+//! number of parsed objects per unit of size no matter how long the lists are,
+//! while looking every item up from the start of a list grows with its length.
+//! Inputs over that budget are reported as crashes,
+//! to be looked at as algorithmic complexity regressions.
+//!
+//! The budget can be adjusted with `HFUZZ_PARSE_BUDGET`
+//! (parsed objects per listed object or page).
+use ledger_app::fuzzing::parse_and_review;
+
+const DEFAULT_BUDGET: usize = 8;
+
+fn main() {
+    let budget = std::env::var("HFUZZ_PARSE_BUDGET")
+        .ok()
+        .and_then(|budget| budget.parse().ok())
+        .unwrap_or(DEFAULT_BUDGET);
+
+    loop {
+        honggfuzz::fuzz!(|data: &[u8]| {
+            let cost = match parse_and_review(data) {
+                Some(cost) => cost,
+                None => return,
+            };
+
+            let size = cost.objects + cost.pages + 1;
+            let allowed = budget * size;
+            if cost.parsed_objects > allowed {
+                panic!(
+                    "{:?} over budget for a size of {} (allowed {} objects)",
+                    cost, size, allowed
+                );
+            }
+        });
+    }
+}
@@ -0,0 +1,187 @@
+//! Drives the app with sequences of commands, as a client would
+//!
+//! Unlike `apdu`, which sends a single random command, each input is decoded
+//! into a session of well-formed steps, so multi-packet uploads, `SignHash`
+//! after `Sign` and the ethereum 0x00/0x80 flows are all reachable.
+//!
+//! The app state is kept between steps of the same session.
+use arbitrary::{Arbitrary, Unstructured};
+use ledger_app::handle_apdu;
+
+const CLA: u8 = 0x80;
+const CLA_ETH: u8 = 0xE0;
+
+// avax upload packets
+const INIT: u8 = 0x00;
+const ADD: u8 = 0x01;
+const LAST: u8 = 0x02;
+
+// SignHash packets
+const NEXT_MESSAGE: u8 = 0x03;
+const LAST_MESSAGE: u8 = 0x02;
+
+// ethereum upload packets
+const ETH_FIRST: u8 = 0x00;
+const ETH_NEXT: u8 = 0x80;
+
+const MAX_STEPS: usize = 32;
+const MAX_PAYLOAD: usize = 255;
+
+#[derive(Arbitrary, Debug, Clone, Copy)]
+enum Cla {
+    Avax,
+    Eth,
+}
+
+#[derive(Arbitrary, Debug, Clone, Copy)]
+enum Upload {
+    Sign,
+    SignMsg,
+    SetPolicy,
+}
+
+#[derive(Arbitrary, Debug, Clone, Copy)]
+enum EthUpload {
+    Sign,
+    SignMsg,
+}
+
+#[derive(Arbitrary, Debug)]
+enum Step {
+    /// Any single command
+    Raw {
+        cla: Cla,
+        ins: u8,
+        p1: u8,
+        p2: u8,
+        data: Vec<u8>,
+    },
+    /// Data sent in Init/Add/Last packets
+    Upload {
+        ins: Upload,
+        p2: u8,
+        init: Vec<u8>,
+        data: Vec<u8>,
+        chunk_len: u8,
+    },
+    /// Data sent in 0x00/0x80 packets, the end is implied by the data
+    EthUpload {
+        ins: EthUpload,
+        data: Vec<u8>,
+        chunk_len: u8,
+    },
+    /// Root path and hash to review,
+    /// followed by the path suffixes to sign it with
+    SignHash {
+        init: Vec<u8>,
+        suffixes: Vec<Vec<u8>>,
+    },
+    /// Path suffix to sign a previously reviewed transaction or hash with
+    SignNext { last: bool, suffix: Vec<u8> },
+}
+
+fn send(cla: u8, ins: u8, p1: u8, p2: u8, data: &[u8]) {
+    let data = &data[..data.len().min(MAX_PAYLOAD)];
+
+    let mut buffer = [0u8; 260];
+    buffer[..5].copy_from_slice(&[cla, ins, p1, p2, data.len() as u8]);
+    buffer[5..][..data.len()].copy_from_slice(data);
+
+    let mut flags = 0;
+    let mut tx = 0;
+    handle_apdu(&mut flags, &mut tx, 5 + data.len() as u32, &mut buffer[..]);
+}
+
+fn chunks(data: &[u8], chunk_len: u8) -> impl Iterator<Item = &[u8]> {
+    data.chunks((chunk_len as usize).clamp(1, MAX_PAYLOAD))
+}
+
+impl Step {
+    fn run(&self) {
+        match self {
+            Self::Raw {
+                cla,
+                ins,
+                p1,
+                p2,
+                data,
+            } => {
+                let cla = match cla {
+                    Cla::Avax => CLA,
+                    Cla::Eth => CLA_ETH,
+                };
+                send(cla, *ins, *p1, *p2, data)
+            }
+            Self::Upload {
+                ins,
+                p2,
+                init,
+                data,
+                chunk_len,
+            } => {
+                let ins = match ins {
+                    Upload::Sign => 0x05,
+                    Upload::SignMsg => 0x06,
+                    Upload::SetPolicy => 0x07,
+                };
+
+                send(CLA, ins, INIT, *p2, init);
+
+                let mut chunks = chunks(data, *chunk_len).peekable();
+                while let Some(chunk) = chunks.next() {
+                    let p1 = if chunks.peek().is_some() { ADD } else { LAST };
+                    send(CLA, ins, p1, *p2, chunk);
+                }
+            }
+            Self::EthUpload {
+                ins,
+                data,
+                chunk_len,
+            } => {
+                let ins = match ins {
+                    EthUpload::Sign => 0x04,
+                    EthUpload::SignMsg => 0x08,
+                };
+
+                for (i, chunk) in chunks(data, *chunk_len).enumerate() {
+                    let p1 = if i == 0 { ETH_FIRST } else { ETH_NEXT };
+                    send(CLA_ETH, ins, p1, 0, chunk);
+                }
+            }
+            Self::SignHash { init, suffixes } => {
+                // FIRST_MESSAGE
+                send(CLA, 0x04, 0x01, 0, init);
+
+                for (i, suffix) in suffixes.iter().enumerate() {
+                    let p1 = if i + 1 == suffixes.len() {
+                        LAST_MESSAGE
+                    } else {
+                        NEXT_MESSAGE
+                    };
+                    send(CLA, 0x04, p1, 0, suffix);
+                }
+            }
+            Self::SignNext { last, suffix } => {
+                let p1 = if *last { LAST_MESSAGE } else { NEXT_MESSAGE };
+                send(CLA, 0x04, p1, 0, suffix)
+            }
+        }
+    }
+}
+
+fn main() {
+    loop {
+        honggfuzz::fuzz!(|data: &[u8]| {
+            let mut u = Unstructured::new(data);
+
+            let mut steps = 0;
+            while !u.is_empty() && steps < MAX_STEPS {
+                match Step::arbitrary(&mut u) {
+                    Ok(step) => step.run(),
+                    Err(_) => break,
+                }
+                steps += 1;
+            }
+        });
+    }
+}
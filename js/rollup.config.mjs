@@ -1,10 +1,15 @@
 import dts from 'rollup-plugin-dts'
 import esbuild from 'rollup-plugin-esbuild'
 
+// The ETH and BTC dependencies are imported on first use, so they're kept external
+const input = 'src/index.ts'
+const external = [/^@ledgerhq\//, /^@noble\//, 'bs58', 'ledger-bitcoin']
+
 // Always provide both CJS and ES exports
 const config = [
   {
-    input: `src/index.ts`,
+    input,
+    external,
     plugins: [esbuild()],
     output: [
       {
@@ -15,7 +20,8 @@ const config = [
     ],
   },
   {
-    input: `src/index.ts`,
+    input,
+    external,
     plugins: [dts()],
     output: [
       {
@@ -25,6 +25,8 @@ export const INS = {
   SIGN_HASH: 0x04,
   SIGN: 0x05,
   SIGN_MSG: 0x06,
+  SET_POLICY: 0x07,
+  GET_RESPONSE: 0xc0,
   ETH_PROVIDE_NFT_INFO: 0x14,
 }
 
@@ -34,11 +36,27 @@ export const PAYLOAD_TYPE = {
   LAST: 0x02,
 }
 
+// set in the payload type of compressed chunks, see `compressChunks`
+export const PAYLOAD_COMPRESSED = 0x80
+
+// set in the payload type of sequenced chunks, see `sequenceChunk`
+export const PAYLOAD_SEQUENCED = 0x40
+
+// times a sequenced upload is resumed before giving up
+export const MAX_UPLOAD_RESUMES = 3
+
+// return code of processErrorResponse when the transport failed, not the device
+export const TRANSPORT_ERROR = 0xffff
+
 export const P1_VALUES = {
   ONLY_RETRIEVE: 0x00,
   SHOW_ADDRESS_IN_DEVICE: 0x01,
 }
 
+export const P2_VALUES = {
+  XPUB_BULK: 0x01,
+}
+
 export enum LedgerError {
   U2FUnknown = 1,
   U2FBadRequest = 2,
@@ -47,6 +65,7 @@ export enum LedgerError {
   U2FTimeout = 5,
   Timeout = 14,
   NoErrors = 0x9000,
+  MoreDataAvailable = 0x6310,
   DeviceIsBusy = 0x9001,
   ErrorDerivingKeys = 0x6802,
   ExecutionError = 0x6400,
@@ -72,6 +91,7 @@ export const ERROR_DESCRIPTION = {
   [LedgerError.U2FTimeout]: 'U2F: Timeout',
   [LedgerError.Timeout]: 'Timeout',
   [LedgerError.NoErrors]: 'No errors',
+  [LedgerError.MoreDataAvailable]: 'More data available',
   [LedgerError.DeviceIsBusy]: 'Device is busy',
   [LedgerError.ErrorDerivingKeys]: 'Error deriving keys',
   [LedgerError.ExecutionError]: 'Execution Error',
@@ -113,13 +133,13 @@ export function processErrorResponse(response?: any) {
       }
     }
     return {
-      returnCode: 0xffff,
+      returnCode: TRANSPORT_ERROR,
       errorMessage: response.toString(),
     }
   }
 
   return {
-    returnCode: 0xffff,
+    returnCode: TRANSPORT_ERROR,
     errorMessage: response.toString(),
   }
 }
@@ -0,0 +1,126 @@
+/** ******************************************************************************
+ *  (c) 2023 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************* */
+import { CHUNK_SIZE } from './common'
+
+// see `app/src/utils/upload_refs.rs` for the format
+const LITERAL_MAX_LEN = 0x80
+const MAX_VALUES = 32
+
+const VALUE_KINDS = [
+  { len: 32, tag: 0x80 },
+  { len: 20, tag: 0xa0 },
+]
+
+// values found more than once in the data
+function repeatedValues(data: Buffer, len: number): Set<string> {
+  const seen = new Set<string>()
+  const repeated = new Set<string>()
+
+  for (let i = 0; i + len <= data.length; i += 1) {
+    const value = data.toString('hex', i, i + len)
+    if (seen.has(value)) {
+      repeated.add(value)
+    } else {
+      seen.add(value)
+    }
+  }
+
+  return repeated
+}
+
+function tokenize(data: Buffer): Buffer[] {
+  const tokens: Buffer[] = []
+  const kinds = VALUE_KINDS.map(kind => ({
+    ...kind,
+    repeated: repeatedValues(data, kind.len),
+    values: new Map<string, number>(),
+  }))
+
+  let literalStart = 0
+  const pushLiteral = (end: number) => {
+    for (let i = literalStart; i < end; i += LITERAL_MAX_LEN) {
+      const literal = data.subarray(i, Math.min(end, i + LITERAL_MAX_LEN))
+      tokens.push(Buffer.concat([Buffer.from([literal.length - 1]), literal]))
+    }
+  }
+
+  let pos = 0
+  next: while (pos < data.length) {
+    for (const kind of kinds) {
+      if (pos + kind.len > data.length) {
+        continue
+      }
+
+      const value = data.toString('hex', pos, pos + kind.len)
+      if (!kind.repeated.has(value)) {
+        continue
+      }
+
+      let token
+      const index = kind.values.get(value)
+      if (index !== undefined) {
+        token = Buffer.from([kind.tag | index])
+      } else if (kind.values.size < MAX_VALUES) {
+        // first time, the value follows its number
+        token = Buffer.concat([Buffer.from([kind.tag | kind.values.size]), data.subarray(pos, pos + kind.len)])
+        kind.values.set(value, kind.values.size)
+      } else {
+        continue
+      }
+
+      pushLiteral(pos)
+      tokens.push(token)
+
+      pos += kind.len
+      literalStart = pos
+      continue next
+    }
+
+    pos += 1
+  }
+  pushLiteral(data.length)
+
+  return tokens
+}
+
+/**
+ * Splits `data` in compressed chunks, sending repeated 32-byte and
+ * 20-byte values (asset ids, tx ids, addresses) only once
+ *
+ * Chunks are only split between tokens, as required by the device
+ */
+export function compressChunks(data: Buffer, chunkSize: number = CHUNK_SIZE): Buffer[] {
+  const chunks: Buffer[] = []
+
+  let current: Buffer[] = []
+  let size = 0
+  for (const token of tokenize(data)) {
+    if (size + token.length > chunkSize) {
+      chunks.push(Buffer.concat(current))
+      current = []
+      size = 0
+    }
+
+    current.push(token)
+    size += token.length
+  }
+
+  if (current.length > 0) {
+    chunks.push(Buffer.concat(current))
+  }
+
+  return chunks
+}
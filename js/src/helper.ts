@@ -98,7 +98,53 @@ export function serializePathSuffix(path: string): Buffer {
   return buf
 }
 
-export function serializeHrp(hrp?: string): Buffer {
+// Serializes a path prefix (e.g "m/44'/9000'") followed by the list of accounts,
+// which are always hardened
+export function serializeAccounts(prefix: string, accounts: number[]): Buffer {
+  if (!prefix.startsWith('m')) {
+    throw new Error('Path prefix should start with "m" (e.g "m/44\'/9000\'")')
+  }
+
+  const pathArray = prefix.split('/').slice(1)
+  if (pathArray.length < 1 || pathArray.length > 5) {
+    throw new Error("Invalid path prefix. (e.g \"m/44'/9000'\")")
+  }
+
+  if (accounts.length < 1 || accounts.length > 255) {
+    throw new Error('Expected between 1 and 255 accounts')
+  }
+
+  const buf = Buffer.alloc(1 + pathArray.length * 4 + 1 + accounts.length * 4)
+  let offset = buf.writeUInt8(pathArray.length)
+
+  for (let child of pathArray) {
+    let value = 0
+    if (child.endsWith("'")) {
+      value += HARDENED
+      child = child.slice(0, -1)
+    }
+
+    const childNumber = Number(child)
+    if (Number.isNaN(childNumber) || childNumber >= HARDENED) {
+      throw new Error(`Invalid path prefix : ${child}`)
+    }
+
+    offset = buf.writeUInt32BE(value + childNumber, offset)
+  }
+
+  offset = buf.writeUInt8(accounts.length, offset)
+  for (const account of accounts) {
+    if (!Number.isInteger(account) || account < 0 || account >= HARDENED) {
+      throw new Error(`Invalid account : ${account}`)
+    }
+
+    offset = buf.writeUInt32BE(HARDENED + account, offset)
+  }
+
+  return buf
+}
+
+hrp?: string): Buffer {
   if (hrp) {
     const bufHrp = Buffer.from(hrp, 'ascii')
     return Buffer.concat([Buffer.alloc(1, bufHrp.length), bufHrp])
@@ -29,25 +29,50 @@ import {
   INS,
   LAST_MESSAGE,
   LedgerError,
+  MAX_UPLOAD_RESUMES,
   NEXT_MESSAGE,
   P1_VALUES,
+  P2_VALUES,
+  PAYLOAD_COMPRESSED,
+  PAYLOAD_SEQUENCED,
   PAYLOAD_TYPE,
   processErrorResponse,
+  TRANSPORT_ERROR,
   TYPE_1,
   VERSION_1,
 } from './common'
-import { pathCoinType, serializeChainID, serializeHrp, serializePath, serializePathSuffix } from './helper'
-import { ResponseAddress, ResponseAppInfo, ResponseBase, ResponseSign, ResponseVersion, ResponseWalletId, ResponseXPub } from './types'
-
-import Eth from '@ledgerhq/hw-app-eth'
-import { AppClient, DefaultWalletPolicy, WalletPolicy, PsbtV2 } from 'ledger-bitcoin';
-
-import { LedgerEthTransactionResolution, LoadConfig } from '@ledgerhq/hw-app-eth/lib/services/types'
+import { compressChunks } from './compress'
+import { SEQUENCE_HEADER_LEN, sequenceChunk } from './sequence'
+import { Apdu, Instrumentation } from './instrument'
+import { DescriptorStore, resolutionOf } from './resolution'
+import { signatureVerifier, verifySignatures } from './verify'
+import { pathCoinType, serializeAccounts, serializeChainID, serializeHrp, serializePath, serializePathSuffix } from './helper'
+import {
+  ResponseAddress,
+  ResponseAppInfo,
+  ResponseBase,
+  ResponseSign,
+  ResponseVersion,
+  ResponseWalletId,
+  ResponseXPub,
+  ResponseXPubs,
+  SignHashOptions,
+  SignOptions,
+} from './types'
+
+import { sha256 } from '@noble/hashes/sha256'
+import type Eth from '@ledgerhq/hw-app-eth'
+import type { AppClient, WalletPolicy, PsbtV2 } from 'ledger-bitcoin'
+
+import type { LedgerEthTransactionResolution, LoadConfig } from '@ledgerhq/hw-app-eth/lib/services/types'
 
 export * from './types'
 export { LedgerError }
-// reexport bitcoin types
-export {WalletPolicy, PsbtV2, DefaultWalletPolicy}
+export * from './verify'
+export * from './instrument'
+export * from './resolution'
+// reexport bitcoin types, the AppClient itself is only imported on first use
+export { WalletPolicy, PsbtV2, DefaultWalletPolicy } from 'ledger-bitcoin'
 
 function processGetAddrResponse(response: Buffer) {
   let partialResponse = response
@@ -103,8 +128,13 @@ function processGetXPubResponse(response: Buffer) {
 
 export default class AvalancheApp {
   transport
-  private eth
-  private btc
+  // the ETH and BTC clients are only loaded when first used
+  private eth?: Promise<Eth>
+  private btc?: Promise<AppClient>
+  private readonly ethScrambleKey: string
+  private readonly ethLoadConfig: LoadConfig
+  private instrumentation?: Instrumentation
+  private descriptors?: DescriptorStore
 
   constructor(transport: Transport, ethScrambleKey = 'w0w', ethLoadConfig: LoadConfig = {}) {
     this.transport = transport
@@ -112,11 +142,73 @@ export default class AvalancheApp {
       throw new Error('Transport has not been defined')
     }
 
-    this.eth = new Eth(transport, ethScrambleKey, ethLoadConfig)
-    this.btc = new AppClient(transport);
+    this.ethScrambleKey = ethScrambleKey
+    this.ethLoadConfig = ethLoadConfig
+  }
+
+  private async ethClient(): Promise<Eth> {
+    if (this.eth === undefined) {
+      this.eth = import('@ledgerhq/hw-app-eth').then(
+        ({ default: EthApp }) => new EthApp(this.transport, this.ethScrambleKey, this.ethLoadConfig),
+      )
+      // allow retrying a failed load
+      this.eth.catch(() => (this.eth = undefined))
+    }
+    return this.eth
+  }
+
+  private async btcClient(): Promise<AppClient> {
+    if (this.btc === undefined) {
+      this.btc = import('ledger-bitcoin').then(({ AppClient }) => new AppClient(this.transport))
+      // allow retrying a failed load
+      this.btc.catch(() => (this.btc = undefined))
+    }
+    return this.btc
+  }
+
+  // record the APDUs of the app, grouped by call (e.g sign), undefined to stop
+  setInstrumentation(instrumentation?: Instrumentation) {
+    this.instrumentation = instrumentation
+  }
+
+  // resolve the tokens and NFTs of EVM transactions with `descriptors` instead of
+  // the network services of hw-app-eth, undefined to go back to them
+  setDescriptorStore(descriptors?: DescriptorStore) {
+    this.descriptors = descriptors
+  }
+
+  // responses longer than one APDU come in frames, all but the last one ending with MoreDataAvailable,
+  // the following ones are retrieved with GET_RESPONSE and returned together
+  private async send(apdu: Apdu, statusList: number[] = [LedgerError.NoErrors]): Promise<Buffer> {
+    const accepted = [...statusList, LedgerError.MoreDataAvailable]
+
+    const frames = []
+    let response = await this.exchange(apdu, accepted)
+    while (response.readUInt16BE(response.length - 2) === LedgerError.MoreDataAvailable) {
+      frames.push(response.slice(0, -2))
+      // eslint-disable-next-line no-await-in-loop
+      response = await this.exchange({ cla: CLA, ins: INS.GET_RESPONSE, p1: 0, p2: 0 }, accepted)
+    }
+
+    return frames.length === 0 ? response : Buffer.concat([...frames, response])
   }
 
-  private static prepareChunks(message: Buffer, serializedPathBuffer?: Buffer) {
+  private async exchange(apdu: Apdu, statusList: number[]): Promise<Buffer> {
+    const send = () => this.transport.send(apdu.cla, apdu.ins, apdu.p1, apdu.p2, apdu.data, statusList)
+    if (this.instrumentation === undefined) {
+      return send()
+    }
+    return this.instrumentation.exchange(apdu, send)
+  }
+
+  private async operation<T>(name: string, fn: () => Promise<T>): Promise<T> {
+    if (this.instrumentation === undefined) {
+      return fn()
+    }
+    return this.instrumentation.run(name, fn)
+  }
+
+  private static prepareChunks(message: Buffer, serializedPathBuffer?: Buffer, compress = false, chunkSize = CHUNK_SIZE) {
     const chunks = []
 
     // First chunk (only path)
@@ -125,11 +217,15 @@ export default class AvalancheApp {
       chunks.push(serializedPathBuffer)
     }
 
+    if (compress) {
+      return chunks.concat(compressChunks(message, chunkSize))
+    }
+
     const messageBuffer = Buffer.from(message)
 
     const buffer = Buffer.concat([messageBuffer])
-    for (let i = 0; i < buffer.length; i += CHUNK_SIZE) {
-      let end = i + CHUNK_SIZE
+    for (let i = 0; i < buffer.length; i += chunkSize) {
+      let end = i + chunkSize
       if (i > buffer.length) {
         end = buffer.length
       }
@@ -139,11 +235,11 @@ export default class AvalancheApp {
     return chunks
   }
 
-  private async signGetChunks(message: Buffer, path?: string) {
+  private async signGetChunks(message: Buffer, path?: string, compress = false, chunkSize = CHUNK_SIZE) {
     if (path === undefined) {
-      return AvalancheApp.prepareChunks(message, Buffer.alloc(0))
+      return AvalancheApp.prepareChunks(message, Buffer.alloc(0), compress, chunkSize)
     } else {
-      return AvalancheApp.prepareChunks(message, serializePath(path))
+      return AvalancheApp.prepareChunks(message, serializePath(path), compress, chunkSize)
     }
   }
 
@@ -171,6 +267,8 @@ export default class AvalancheApp {
     chunk: Buffer,
     param?: number,
     ins: number = INS.SIGN,
+    compressed = false,
+    sequenced = false,
   ): Promise<ResponseSign> {
     let payloadType = PAYLOAD_TYPE.ADD
     let p2 = 0
@@ -184,73 +282,109 @@ export default class AvalancheApp {
     if (chunkIdx === chunkNum) {
       payloadType = PAYLOAD_TYPE.LAST
     }
+    // the first chunk (path) is never compressed
+    if (compressed && chunkIdx !== 1) {
+      payloadType |= PAYLOAD_COMPRESSED
+    }
+    // nor sequenced, see `sendChunksResumable`
+    if (sequenced && chunkIdx !== 1) {
+      payloadType |= PAYLOAD_SEQUENCED
+    }
 
-    return this.transport
-      .send(CLA, ins, payloadType, p2, chunk, [
-        LedgerError.NoErrors,
-        LedgerError.DataIsInvalid,
-        LedgerError.BadKeyHandle,
-        LedgerError.SignVerifyError,
-      ])
-      .then((response: Buffer) => {
-        const errorCodeData = response.slice(-2)
-        const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
-        let errorMessage = errorCodeToString(returnCode)
+    // the last chunk is answered once the user reviewed the data
+    const userApproval = chunkIdx === chunkNum
 
-        if (
-          returnCode === LedgerError.BadKeyHandle ||
-          returnCode === LedgerError.DataIsInvalid ||
-          returnCode === LedgerError.SignVerifyError
-        ) {
-          errorMessage = `${errorMessage} : ${response.slice(0, response.length - 2).toString('ascii')}`
-        }
+    return this.send({ cla: CLA, ins, p1: payloadType, p2, data: chunk, userApproval }, [
+      LedgerError.NoErrors,
+      LedgerError.DataIsInvalid,
+      LedgerError.BadKeyHandle,
+      LedgerError.SignVerifyError,
+    ]).then((response: Buffer) => {
+      const errorCodeData = response.slice(-2)
+      const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
+      let errorMessage = errorCodeToString(returnCode)
 
-        if (returnCode === LedgerError.NoErrors && response.length > 2) {
-          return {
-            hash: null,
-            signature: null,
-            returnCode: returnCode,
-            errorMessage: errorMessage,
-          }
-        }
+      if (
+        returnCode === LedgerError.BadKeyHandle ||
+        returnCode === LedgerError.DataIsInvalid ||
+        returnCode === LedgerError.SignVerifyError
+      ) {
+        errorMessage = `${errorMessage} : ${response.slice(0, response.length - 2).toString('ascii')}`
+      }
 
+      if (returnCode === LedgerError.NoErrors && response.length > 2) {
         return {
+          hash: null,
+          signature: null,
           returnCode: returnCode,
           errorMessage: errorMessage,
         }
-      }, processErrorResponse)
+      }
+
+      return {
+        returnCode: returnCode,
+        errorMessage: errorMessage,
+      }
+    }, processErrorResponse)
+  }
+
+  async signHash(
+    path_prefix: string,
+    signing_paths: Array<string>,
+    hash: Buffer,
+    { verify = false }: SignHashOptions = {},
+  ): Promise<ResponseSign> {
+    return this.operation('signHash', () => this._signHash(path_prefix, signing_paths, hash, verify))
   }
 
-  async signHash(path_prefix: string, signing_paths: Array<string>, hash: Buffer): Promise<ResponseSign> {
+  private async _signHash(path_prefix: string, signing_paths: Array<string>, hash: Buffer, verify: boolean): Promise<ResponseSign> {
     if (hash.length !== HASH_LEN) {
       throw new Error('Invalid hash length')
     }
 
+    let verifier
+    if (verify) {
+      const xpub = await this._xpub(path_prefix, false)
+      if (xpub.returnCode !== LedgerError.NoErrors) {
+        return { returnCode: xpub.returnCode, errorMessage: xpub.errorMessage, hash: null, signatures: null }
+      }
+      verifier = signatureVerifier(xpub, hash)
+    }
+
     //send hash and path
-    const first_response = await this.transport
-      .send(CLA, INS.SIGN_HASH, FIRST_MESSAGE, 0x00, Buffer.concat([serializePath(path_prefix), hash]), [LedgerError.NoErrors])
-      .then((response: Buffer) => {
-        const errorCodeData = response.slice(-2)
-        const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
-        let errorMessage = errorCodeToString(returnCode)
+    const first_response = await this.send({
+      cla: CLA,
+      ins: INS.SIGN_HASH,
+      p1: FIRST_MESSAGE,
+      p2: 0x00,
+      data: Buffer.concat([serializePath(path_prefix), hash]),
+      userApproval: true,
+    }).then((response: Buffer) => {
+      const errorCodeData = response.slice(-2)
+      const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
+      let errorMessage = errorCodeToString(returnCode)
 
-        if (returnCode === LedgerError.BadKeyHandle || returnCode === LedgerError.DataIsInvalid) {
-          errorMessage = `${errorMessage} : ${response.slice(0, response.length - 2).toString('ascii')}`
-        }
-        return {
-          returnCode: returnCode,
-          errorMessage: errorMessage,
-        }
-      }, processErrorResponse)
+      if (returnCode === LedgerError.BadKeyHandle || returnCode === LedgerError.DataIsInvalid) {
+        errorMessage = `${errorMessage} : ${response.slice(0, response.length - 2).toString('ascii')}`
+      }
+      return {
+        returnCode: returnCode,
+        errorMessage: errorMessage,
+      }
+    }, processErrorResponse)
 
     if (first_response.returnCode !== LedgerError.NoErrors) {
       return first_response
     }
 
-    return this._signAndCollect(signing_paths)
+    return this._signAndCollect(signing_paths, verifier)
   }
 
-  private async _signAndCollect(signing_paths: Array<string>): Promise<ResponseSign> {
+  // verify: checks each signature while the device computes the next one
+  private async _signAndCollect(
+    signing_paths: Array<string>,
+    verify?: (suffix: string, signature: Buffer) => boolean,
+  ): Promise<ResponseSign> {
     // base response object to output on each iteration
     const result = {
       returnCode: LedgerError.NoErrors,
@@ -262,6 +396,15 @@ export default class AvalancheApp {
     // where each pair path_suffix, signature are stored
     const signatures = new Map()
 
+    const invalid: string[] = []
+    let unverified: string | undefined
+    const verifyPending = () => {
+      if (verify !== undefined && unverified !== undefined && !verify(unverified, signatures.get(unverified))) {
+        invalid.push(unverified)
+      }
+      unverified = undefined
+    }
+
     for (let idx = 0; idx < signing_paths.length; idx++) {
       const suffix = signing_paths[idx]
       const path_buf = serializePathSuffix(suffix)
@@ -269,45 +412,132 @@ export default class AvalancheApp {
       const p1 = idx >= signing_paths.length - 1 ? LAST_MESSAGE : NEXT_MESSAGE
 
       // send path to sign hash that should be in device's ram memory
-      await this.transport
-        .send(CLA, INS.SIGN_HASH, p1, 0x00, path_buf, [
-          LedgerError.NoErrors,
-          LedgerError.DataIsInvalid,
-          LedgerError.BadKeyHandle,
-          LedgerError.SignVerifyError,
-        ])
-        .then((response: Buffer) => {
-          const errorCodeData = response.slice(-2)
-          const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
-          const errorMessage = errorCodeToString(returnCode)
-
-          if (
-            returnCode === LedgerError.BadKeyHandle ||
-            returnCode === LedgerError.DataIsInvalid ||
-            returnCode === LedgerError.SignVerifyError
-          ) {
-            result.errorMessage = `${errorMessage} : ${response.slice(0, response.length - 2).toString('ascii')}`
-          }
+      const exchange = this.send({ cla: CLA, ins: INS.SIGN_HASH, p1, p2: 0x00, data: path_buf }, [
+        LedgerError.NoErrors,
+        LedgerError.DataIsInvalid,
+        LedgerError.BadKeyHandle,
+        LedgerError.SignVerifyError,
+      ]).then((response: Buffer) => {
+        const errorCodeData = response.slice(-2)
+        const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
+        const errorMessage = errorCodeToString(returnCode)
 
-          if (returnCode === LedgerError.NoErrors && response.length > 2) {
-            signatures.set(suffix, response.slice(0, -2))
-          }
+        if (
+          returnCode === LedgerError.BadKeyHandle ||
+          returnCode === LedgerError.DataIsInvalid ||
+          returnCode === LedgerError.SignVerifyError
+        ) {
+          result.errorMessage = `${errorMessage} : ${response.slice(0, response.length - 2).toString('ascii')}`
+        }
+
+        if (returnCode === LedgerError.NoErrors && response.length > 2) {
+          signatures.set(suffix, response.slice(0, -2))
+        }
 
-          result.returnCode = returnCode
-          result.errorMessage = errorMessage
+        result.returnCode = returnCode
+        result.errorMessage = errorMessage
 
-          return
-        }, processErrorResponse)
+        return
+      }, processErrorResponse)
+
+      verifyPending()
+      await exchange
 
       if (result.returnCode !== LedgerError.NoErrors) {
         break
       }
+      unverified = suffix
+    }
+    verifyPending()
+
+    if (invalid.length > 0) {
+      result.returnCode = LedgerError.SignVerifyError
+      result.errorMessage = `${errorCodeToString(LedgerError.SignVerifyError)} : ${invalid.join(', ')}`
     }
+
     result.signatures = signatures
     return result
   }
 
-  async sign(path_prefix: string, signing_paths: Array<string>, message: Buffer, change_paths?: Array<string>): Promise<ResponseSign> {
+  // sends the chunks following the first one as sequenced, so when the transport fails
+  // before the last one the upload is resumed from what the device acknowledged
+  // instead of failing, up to MAX_UPLOAD_RESUMES times
+  private async sendChunksResumable(chunks: Buffer[], ins: number, compressed: boolean): Promise<ResponseSign> {
+    // offset of each chunk in the upload, the first one excluded
+    const offsets = [0]
+    for (let i = 1; i < chunks.length; i += 1) {
+      offsets.push(offsets[i - 1] + chunks[i].length)
+    }
+
+    let result: ResponseSign = { returnCode: LedgerError.NoErrors, errorMessage: errorCodeToString(LedgerError.NoErrors) }
+    let resumes = 0
+    for (let i = 1; i < chunks.length; i += 1) {
+      const chunk = sequenceChunk(offsets[i - 1], chunks[i])
+      // eslint-disable-next-line no-await-in-loop
+      result = await this.signSendChunk(1 + i, chunks.length, chunk, NEXT_MESSAGE, ins, compressed, true)
+
+      // the last chunk starts the review, which can't be resumed
+      if (result.returnCode === TRANSPORT_ERROR && i < chunks.length - 1 && resumes < MAX_UPLOAD_RESUMES) {
+        resumes += 1
+
+        // eslint-disable-next-line no-await-in-loop
+        const received = await this.uploadReceived(ins)
+        const next = received === undefined ? -1 : offsets.indexOf(received)
+        // sending the same chunk again is fine too, if already received it's only acknowledged
+        i = next >= 0 ? next : i - 1
+        continue
+      }
+
+      if (result.returnCode !== LedgerError.NoErrors) {
+        break
+      }
+    }
+
+    return result
+  }
+
+  // number of bytes of a sequenced upload received by the device, undefined if it couldn't be retrieved
+  private async uploadReceived(ins: number): Promise<number | undefined> {
+    const p1 = PAYLOAD_TYPE.ADD | PAYLOAD_SEQUENCED
+    try {
+      const response = await this.send({ cla: CLA, ins, p1, p2: 0, data: sequenceChunk(0, Buffer.alloc(0)) })
+      return response.length >= 4 ? response.readUInt16BE(0) : undefined
+    } catch {
+      return undefined
+    }
+  }
+
+  // see `SignOptions`, resumable uploads are sent by `sendChunksResumable`
+  async sign(
+    path_prefix: string,
+    signing_paths: Array<string>,
+    message: Buffer,
+    change_paths?: Array<string>,
+    { compress = false, verify = false, resumable = false }: SignOptions = {},
+  ): Promise<ResponseSign> {
+    return this.operation('sign', () => this._sign(path_prefix, signing_paths, message, change_paths, compress, verify, resumable))
+  }
+
+  private async _sign(
+    path_prefix: string,
+    signing_paths: Array<string>,
+    message: Buffer,
+    change_paths: Array<string> | undefined,
+    compress: boolean,
+    verify: boolean,
+    resumable: boolean,
+  ): Promise<ResponseSign> {
+    // the key of the prefix is retrieved before the review,
+    // the ones of the signing paths are derived from it
+    let verifier
+    if (verify) {
+      const xpub = await this._xpub(path_prefix, false)
+      if (xpub.returnCode !== LedgerError.NoErrors) {
+        return { returnCode: xpub.returnCode, errorMessage: xpub.errorMessage, hash: null, signatures: null }
+      }
+      verifier = signatureVerifier(xpub, Buffer.from(sha256(message)))
+    }
+
     // Do not show outputs that go to the signers
     let paths = signing_paths
     if (change_paths !== undefined) {
@@ -319,9 +549,10 @@ export default class AvalancheApp {
     // shown at parsing
     const msg = this.concatMessageAndChangePath(message, paths)
 
-    // Send transaction for review
-    const response = await this.signGetChunks(msg, path_prefix).then(chunks => {
-      return this.signSendChunk(1, chunks.length, chunks[0], FIRST_MESSAGE, INS.SIGN).then(async response => {
+    // Send transaction for review, sequenced chunks carry a header too
+    const chunkSize = resumable ? CHUNK_SIZE - SEQUENCE_HEADER_LEN : CHUNK_SIZE
+    const response = await this.signGetChunks(msg, path_prefix, compress, chunkSize).then(chunks => {
+      return this.signSendChunk(1, chunks.length, chunks[0], FIRST_MESSAGE, INS.SIGN, compress).then(async response => {
         // initialize response
         let result = {
           returnCode: response.returnCode,
@@ -329,10 +560,14 @@ export default class AvalancheApp {
           signatures: null as null | Map<string, Buffer>,
         }
 
+        if (resumable && result.returnCode === LedgerError.NoErrors) {
+          return { ...result, ...(await this.sendChunksResumable(chunks, INS.SIGN, compress)) }
+        }
+
         // send chunks
         for (let i = 1; i < chunks.length; i += 1) {
           // eslint-disable-next-line no-await-in-loop
-          result = await this.signSendChunk(1 + i, chunks.length, chunks[i], NEXT_MESSAGE, INS.SIGN)
+          result = await this.signSendChunk(1 + i, chunks.length, chunks[i], NEXT_MESSAGE, INS.SIGN, compress)
           if (result.returnCode !== LedgerError.NoErrors) {
             break
           }
@@ -347,7 +582,7 @@ export default class AvalancheApp {
 
     // Transaction was approved so start iterating over signing_paths to sign
     // and collect each signature
-    return this._signAndCollect(signing_paths)
+    return this._signAndCollect(signing_paths, verifier)
   }
 
   // Sign an arbitrary message.
@@ -355,6 +590,10 @@ export default class AvalancheApp {
   // signing_paths: ["0/1", "5/8"]
   // message: The message to be signed
   async signMsg(path_prefix: string, signing_paths: Array<string>, message: string): Promise<ResponseSign> {
+    return this.operation('signMsg', () => this._signMsg(path_prefix, signing_paths, message))
+  }
+
+  private async _signMsg(path_prefix: string, signing_paths: Array<string>, message: string): Promise<ResponseSign> {
     const coinType = pathCoinType(path_prefix)
 
     if (coinType !== "9000'") {
@@ -401,12 +640,47 @@ export default class AvalancheApp {
     return this._signAndCollect(signing_paths)
   }
 
+  // Approve on the device a policy under which transactions are signed without review.
+  // policy: the serialized policy, please check the APDU specification for its structure
+  async setPolicy(policy: Buffer): Promise<ResponseBase> {
+    return this.operation('setPolicy', () => this._setPolicy(policy))
+  }
+
+  // Disable signing without review, once approved on the device
+  async clearPolicy(): Promise<ResponseBase> {
+    return this.operation('clearPolicy', () => this._setPolicy(Buffer.alloc(0)))
+  }
+
+  private async _setPolicy(policy: Buffer): Promise<ResponseBase> {
+    return this.signGetChunks(policy).then(async chunks => {
+      // an empty policy is still sent, to be reviewed
+      if (chunks.length === 1) {
+        chunks.push(Buffer.alloc(0))
+      }
+
+      let result = await this.signSendChunk(1, chunks.length, chunks[0], FIRST_MESSAGE, INS.SET_POLICY)
+
+      for (let i = 1; i < chunks.length; i += 1) {
+        if (result.returnCode !== LedgerError.NoErrors) {
+          break
+        }
+        // eslint-disable-next-line no-await-in-loop
+        result = await this.signSendChunk(1 + i, chunks.length, chunks[i], NEXT_MESSAGE, INS.SET_POLICY)
+      }
+
+      return {
+        returnCode: result.returnCode,
+        errorMessage: result.errorMessage,
+      }
+    }, processErrorResponse)
+  }
+
   async getVersion(): Promise<ResponseVersion> {
     return getVersion(this.transport).catch(err => processErrorResponse(err))
   }
 
   async getAppInfo(): Promise<ResponseAppInfo> {
-    return this.transport.send(0xb0, 0x01, 0, 0).then(response => {
+    return this.send({ cla: 0xb0, ins: 0x01, p1: 0, p2: 0 }).then(response => {
       const errorCodeData = response.slice(-2)
       const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
 
@@ -460,13 +734,18 @@ export default class AvalancheApp {
     const serializedHrp = serializeHrp(hrp)
     const serializedChainID = serializeChainID(chainid)
 
-    return this.transport
-      .send(CLA, INS.GET_ADDR, p1, 0, Buffer.concat([serializedHrp, serializedChainID, serializedPath]), [LedgerError.NoErrors])
-      .then(processGetAddrResponse, processErrorResponse)
+    return this.send({
+      cla: CLA,
+      ins: INS.GET_ADDR,
+      p1,
+      p2: 0,
+      data: Buffer.concat([serializedHrp, serializedChainID, serializedPath]),
+      userApproval: show,
+    }).then(processGetAddrResponse, processErrorResponse)
   }
 
   async getAddressAndPubKey(path: string, show: boolean, hrp?: string, chainid?: string) {
-    return this._pubkey(path, show, hrp, chainid)
+    return this.operation('getAddressAndPubKey', () => this._pubkey(path, show, hrp, chainid))
   }
 
   private async _xpub(path: string, show: boolean, hrp?: string, chainid?: string): Promise<ResponseXPub> {
@@ -475,21 +754,80 @@ export default class AvalancheApp {
     const serializedHrp = serializeHrp(hrp)
     const serializedChainID = serializeChainID(chainid)
 
-    return this.transport
-      .send(CLA, INS.GET_EXTENDED_PUBLIC_KEY, p1, 0, Buffer.concat([serializedHrp, serializedChainID, serializedPath]), [
-        LedgerError.NoErrors,
-      ])
-      .then(processGetXPubResponse, processErrorResponse)
+    return this.send({
+      cla: CLA,
+      ins: INS.GET_EXTENDED_PUBLIC_KEY,
+      p1,
+      p2: 0,
+      data: Buffer.concat([serializedHrp, serializedChainID, serializedPath]),
+      userApproval: show,
+    }).then(processGetXPubResponse, processErrorResponse)
   }
 
   async getExtendedPubKey(path: string, show: boolean, hrp?: string, chainid?: string) {
-    return this._xpub(path, show, hrp, chainid)
+    return this.operation('getExtendedPubKey', () => this._xpub(path, show, hrp, chainid))
+  }
+
+  // Retrieve without confirmation the extended public keys of multiple accounts,
+  // each derived at prefix/account' (e.g "m/44'/9000'" and [0, 1, 2])
+  async getExtendedPubKeys(prefix: string, accounts: number[]): Promise<ResponseXPubs> {
+    const keys: ResponseXPubs['keys'] = []
+
+    // the device returns as many keys as fit in a response,
+    // the remaining accounts are requested again
+    while (keys.length < accounts.length) {
+      const payload = serializeAccounts(prefix, accounts.slice(keys.length))
+
+      // eslint-disable-next-line no-await-in-loop
+      const response = await this.send({
+        cla: CLA,
+        ins: INS.GET_EXTENDED_PUBLIC_KEY,
+        p1: P1_VALUES.ONLY_RETRIEVE,
+        p2: P2_VALUES.XPUB_BULK,
+        data: payload,
+      }).catch(processErrorResponse)
+
+      if (!Buffer.isBuffer(response)) {
+        return { ...response, keys }
+      }
+
+      const count = response[0]
+      if (count === 0) {
+        return { keys, returnCode: LedgerError.ExecutionError, errorMessage: errorCodeToString(LedgerError.ExecutionError) }
+      }
+
+      for (let i = 0; i < count; i += 1) {
+        const entry = response.slice(1 + i * 65, 1 + (i + 1) * 65)
+        keys.push({ publicKey: Buffer.from(entry.slice(0, 33)), chain_code: Buffer.from(entry.slice(33)) })
+      }
+    }
+
+    return { keys, returnCode: LedgerError.NoErrors, errorMessage: errorCodeToString(LedgerError.NoErrors) }
+  }
+
+  // Check signatures returned by sign/signHash (e.g from another session) against the keys of the device,
+  // only the extended public key of path_prefix is retrieved
+  async verifySignatures(path_prefix: string, hash: Buffer, signatures: Map<string, Buffer>): Promise<ResponseBase> {
+    const xpub = await this._xpub(path_prefix, false)
+    if (xpub.returnCode !== LedgerError.NoErrors) {
+      return { returnCode: xpub.returnCode, errorMessage: xpub.errorMessage }
+    }
+
+    const invalid = verifySignatures(xpub, hash, signatures)
+    if (invalid.length > 0) {
+      return {
+        returnCode: LedgerError.SignVerifyError,
+        errorMessage: `${errorCodeToString(LedgerError.SignVerifyError)} : ${invalid.join(', ')}`,
+      }
+    }
+
+    return { returnCode: LedgerError.NoErrors, errorMessage: errorCodeToString(LedgerError.NoErrors) }
   }
 
   private async _walletId(show: boolean): Promise<ResponseWalletId> {
     const p1 = show ? P1_VALUES.SHOW_ADDRESS_IN_DEVICE : P1_VALUES.ONLY_RETRIEVE
 
-    return this.transport.send(CLA, INS.WALLET_ID, p1, 0).then(response => {
+    return this.send({ cla: CLA, ins: INS.WALLET_ID, p1, p2: 0, userApproval: show }).then(response => {
       const errorCodeData = response.slice(-2)
       const returnCode = (errorCodeData[0] * 256 + errorCodeData[1]) as LedgerError
 
@@ -502,14 +840,14 @@ export default class AvalancheApp {
   }
 
   async getWalletId() {
-    return this._walletId(false)
+    return this.operation('getWalletId', () => this._walletId(false))
   }
 
   async showWalletId() {
-    return this._walletId(true)
+    return this.operation('showWalletId', () => this._walletId(true))
   }
 
-  signEVMTransaction(
+  async signEVMTransaction(
     path: string,
     rawTxHex: string,
     resolution?: LedgerEthTransactionResolution | null,
@@ -518,10 +856,21 @@ export default class AvalancheApp {
     v: string
     r: string
   }> {
-    return this.eth.signTransaction(path, rawTxHex, resolution)
+    if (resolution === undefined && this.descriptors !== undefined) {
+      const descriptor = await this.descriptors.lookupTransaction(rawTxHex)
+      if (descriptor?.kind === 'erc721') {
+        const response = await this.provideNftInfo(descriptor.contractAddress.replace(/^0x/, ''), descriptor.name, descriptor.chainId)
+        if (response.returnCode !== LedgerError.NoErrors) {
+          throw new Error(`Could not provide the NFT info: ${response.errorMessage}`)
+        }
+      }
+      resolution = resolutionOf(descriptor)
+    }
+
+    return (await this.ethClient()).signTransaction(path, rawTxHex, resolution)
   }
 
-  getETHAddress(
+  async getETHAddress(
     path: string,
     boolDisplay?: boolean,
     boolChaincode?: boolean,
@@ -530,17 +879,17 @@ export default class AvalancheApp {
     address: string
     chainCode?: string
   }> {
-    return this.eth.getAddress(path, boolDisplay, boolChaincode)
+    return (await this.ethClient()).getAddress(path, boolDisplay, boolChaincode)
   }
 
-  getAppConfiguration(): Promise<{
+  async getAppConfiguration(): Promise<{
     arbitraryDataEnabled: number
     erc20ProvisioningNecessary: number
     starkEnabled: number
     starkv2Supported: number
     version: string
   }> {
-    return this.eth.getAppConfiguration()
+    return (await this.ethClient()).getAppConfiguration()
   }
 
   // Function that provides the necessary token information to parse ERC721 transactions
@@ -584,7 +933,7 @@ export default class AvalancheApp {
     const id = BigInt(chainId)
     buffer.writeBigUInt64BE(id, offset)
 
-    return this.transport.send(CLA_ETH, INS.ETH_PROVIDE_NFT_INFO, p1, p2, buffer).then((response: Buffer) => {
+    return this.send({ cla: CLA_ETH, ins: INS.ETH_PROVIDE_NFT_INFO, p1, p2, data: buffer }).then((response: Buffer) => {
       const errorCodeData = response.slice(-2)
       const returnCode = errorCodeData[0] * 256 + errorCodeData[1]
       let errorMessage = errorCodeToString(returnCode)
@@ -608,7 +957,7 @@ export default class AvalancheApp {
   }
 
   async getMasterFingerprint(): Promise<string> {
-    return this.btc.getMasterFingerprint()
+    return (await this.btcClient()).getMasterFingerprint()
   }
 
   async signPsbt(
@@ -618,7 +967,7 @@ export default class AvalancheApp {
     progressCallback?: () => void
   // ): Promise<[number, Buffer, Buffer][]> {
   ): Promise<any> {
-    return this.btc.signPsbt(psbt, walletPolicy, walletHMAC, progressCallback)
+    return (await this.btcClient()).signPsbt(psbt, walletPolicy, walletHMAC, progressCallback)
   }
 
   async getWalletAddress(
@@ -628,19 +977,19 @@ export default class AvalancheApp {
     addressIndex: number,
     display: boolean
   ): Promise<string> {
-    return this.btc.getWalletAddress(walletPolicy, walletHMAC, change, addressIndex, display)
+    return (await this.btcClient()).getWalletAddress(walletPolicy, walletHMAC, change, addressIndex, display)
   }
   async registerWallet(
     walletPolicy: WalletPolicy
   ): Promise<readonly [Buffer, Buffer]> {
 
-    return this.btc.registerWallet(walletPolicy)
+    return (await this.btcClient()).registerWallet(walletPolicy)
 
   }
   async getBtcExtendedPubkey(
     path: string,
     display: boolean = false
   ): Promise<string> {
-    return this.btc.getExtendedPubkey(path, display)
+    return (await this.btcClient()).getExtendedPubkey(path, display)
   }
 }
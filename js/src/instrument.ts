@@ -0,0 +1,180 @@
+/** ******************************************************************************
+ *  (c) 2023 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************* */
+
+export interface ApduEvent {
+  // the call of the app the APDU is part of (e.g "sign")
+  operation: string
+  cla: number
+  ins: number
+  p1: number
+  p2: number
+  bytesSent: number
+  // including the status word
+  bytesReceived: number
+  // 0 if the transport failed without one
+  statusWord: number
+  // milliseconds since the epoch
+  start: number
+  rttMs: number
+  // the device waited for the user before answering
+  userApproval: boolean
+}
+
+export interface OperationStats {
+  operation: string
+  calls: number
+  apdus: number
+  bytesSent: number
+  bytesReceived: number
+  // round trips of the APDUs that didn't wait for the user
+  rttMs: { p50: number; p90: number; p99: number; max: number }
+  userApprovalMs: number
+  totalMs: number
+}
+
+export interface Apdu {
+  cla: number
+  ins: number
+  p1: number
+  p2: number
+  data?: Buffer
+  userApproval?: boolean
+}
+
+// nearest rank, `sorted` in ascending order
+function percentile(sorted: number[], p: number): number {
+  if (sorted.length === 0) {
+    return 0
+  }
+  return sorted[Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1)]
+}
+
+/**
+ * Records the APDUs exchanged by the app, see `AvalancheApp.setInstrumentation`
+ *
+ * `hook` is called after each APDU, and `toJSON` exports
+ * the events along with the stats of each operation
+ */
+export class Instrumentation {
+  readonly events: ApduEvent[] = []
+  private calls = new Map<string, { calls: number; totalMs: number }>()
+  private operation?: string
+
+  constructor(private readonly hook?: (event: ApduEvent) => void) {}
+
+  // the APDUs exchanged by `fn` are part of the operation `name`,
+  // nested operations are part of the outer one
+  async run<T>(name: string, fn: () => Promise<T>): Promise<T> {
+    if (this.operation !== undefined) {
+      return fn()
+    }
+
+    this.operation = name
+    const start = performance.now()
+    try {
+      return await fn()
+    } finally {
+      this.operation = undefined
+
+      const calls = this.calls.get(name) ?? { calls: 0, totalMs: 0 }
+      calls.calls += 1
+      calls.totalMs += performance.now() - start
+      this.calls.set(name, calls)
+    }
+  }
+
+  async exchange(apdu: Apdu, send: () => Promise<Buffer>): Promise<Buffer> {
+    const start = Date.now()
+    const t0 = performance.now()
+
+    let bytesReceived = 0
+    let statusWord = 0
+    try {
+      const response = await send()
+      bytesReceived = response.length
+      if (response.length >= 2) {
+        statusWord = response.readUInt16BE(response.length - 2)
+      }
+      return response
+    } catch (e: any) {
+      // status words not expected by the caller
+      if (typeof e?.statusCode === 'number') {
+        bytesReceived = 2
+        statusWord = e.statusCode
+      }
+      throw e
+    } finally {
+      const event = {
+        operation: this.operation ?? `ins_0x${apdu.ins.toString(16).padStart(2, '0')}`,
+        cla: apdu.cla,
+        ins: apdu.ins,
+        p1: apdu.p1,
+        p2: apdu.p2,
+        bytesSent: 5 + (apdu.data?.length ?? 0),
+        bytesReceived,
+        statusWord,
+        start,
+        rttMs: performance.now() - t0,
+        userApproval: apdu.userApproval ?? false,
+      }
+
+      this.events.push(event)
+      this.hook?.(event)
+    }
+  }
+
+  stats(): OperationStats[] {
+    const byOperation = new Map<string, ApduEvent[]>()
+    for (const event of this.events) {
+      const events = byOperation.get(event.operation) ?? []
+      events.push(event)
+      byOperation.set(event.operation, events)
+    }
+
+    return [...byOperation].map(([operation, events]) => {
+      const rtts = events
+        .filter(event => !event.userApproval)
+        .map(event => event.rttMs)
+        .sort((a, b) => a - b)
+      const calls = this.calls.get(operation)
+
+      return {
+        operation,
+        calls: calls?.calls ?? events.length,
+        apdus: events.length,
+        bytesSent: events.reduce((sum, event) => sum + event.bytesSent, 0),
+        bytesReceived: events.reduce((sum, event) => sum + event.bytesReceived, 0),
+        rttMs: {
+          p50: percentile(rtts, 50),
+          p90: percentile(rtts, 90),
+          p99: percentile(rtts, 99),
+          max: percentile(rtts, 100),
+        },
+        userApprovalMs: events.filter(event => event.userApproval).reduce((sum, event) => sum + event.rttMs, 0),
+        totalMs: calls?.totalMs ?? events.reduce((sum, event) => sum + event.rttMs, 0),
+      }
+    })
+  }
+
+  reset() {
+    this.events.length = 0
+    this.calls.clear()
+  }
+
+  toJSON() {
+    return { operations: this.stats(), apdus: this.events }
+  }
+}
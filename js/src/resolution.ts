@@ -0,0 +1,183 @@
+/** ******************************************************************************
+ *  (c) 2023 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************* */
+
+import type { LedgerEthTransactionResolution } from '@ledgerhq/hw-app-eth/lib/services/types'
+
+export interface TokenDescriptor {
+  kind: 'erc20' | 'erc721'
+  // hex, with or without 0x, any case
+  contractAddress: string
+  chainId: number
+  // ticker of ERC-20 tokens, collection name of NFTs
+  name: string
+  // signed ERC-20 descriptor as served by the Ledger crypto assets list, in hex
+  signedData?: string
+}
+
+// where descriptors missing from the cache are looked up (e.g a file or a database),
+// undefined when the contract is unknown
+export type DescriptorSource = (
+  contractAddress: string,
+  chainId: number,
+) => TokenDescriptor | undefined | Promise<TokenDescriptor | undefined>
+
+function descriptorKey(contractAddress: string, chainId: number): string {
+  return `${chainId}:${contractAddress.toLowerCase().replace(/^0x/, '')}`
+}
+
+/**
+ * Resolves the token and NFT descriptors of EVM transactions without network access,
+ * see `AvalancheApp.setDescriptorStore`
+ *
+ * Descriptors come from a preloaded list, indexed by contract and chain,
+ * or from a `DescriptorSource`, the last `capacity` lookups (misses included) are cached
+ */
+export class DescriptorStore {
+  private readonly source: DescriptorSource
+  // in order of use, least recent first
+  private readonly cache = new Map<string, TokenDescriptor | undefined>()
+
+  constructor(descriptors: TokenDescriptor[] | DescriptorSource, private readonly capacity = 256) {
+    if (typeof descriptors === 'function') {
+      this.source = descriptors
+    } else {
+      const index = new Map(descriptors.map(d => [descriptorKey(d.contractAddress, d.chainId), d]))
+      this.source = (contractAddress, chainId) => index.get(descriptorKey(contractAddress, chainId))
+    }
+  }
+
+  async lookup(contractAddress: string, chainId: number): Promise<TokenDescriptor | undefined> {
+    const key = descriptorKey(contractAddress, chainId)
+    if (this.cache.has(key)) {
+      const descriptor = this.cache.get(key)
+      // move to the most recent end
+      this.cache.delete(key)
+      this.cache.set(key, descriptor)
+      return descriptor
+    }
+
+    const descriptor = await this.source(contractAddress, chainId)
+    this.cache.set(key, descriptor)
+    if (this.cache.size > this.capacity) {
+      this.cache.delete(this.cache.keys().next().value)
+    }
+    return descriptor
+  }
+
+  // the descriptor of the contract called by `rawTxHex`, if any
+  async lookupTransaction(rawTxHex: string): Promise<TokenDescriptor | undefined> {
+    const tx = decodeTransaction(Buffer.from(rawTxHex.replace(/^0x/, ''), 'hex'))
+    if (tx === undefined || tx.to.length === 0) {
+      return undefined
+    }
+    return this.lookup(tx.to.toString('hex'), tx.chainId)
+  }
+
+  clear() {
+    this.cache.clear()
+  }
+}
+
+// the resolution given to hw-app-eth, which would otherwise fetch the descriptors itself
+export function resolutionOf(descriptor?: TokenDescriptor): LedgerEthTransactionResolution {
+  return {
+    erc20Tokens: descriptor?.kind === 'erc20' && descriptor.signedData !== undefined ? [descriptor.signedData] : [],
+    nfts: [],
+    externalPlugin: [],
+    plugin: [],
+    domains: [],
+  }
+}
+
+type RlpItem = Buffer | RlpItem[]
+
+// decodes the RLP item at `offset`, returning it along with the offset that follows
+function decodeRlp(input: Buffer, offset: number): [RlpItem, number] {
+  const prefix = input[offset]
+  if (prefix === undefined) {
+    throw new Error('RLP: unexpected end of input')
+  }
+
+  const lengthOf = (lenLen: number) => {
+    let len = 0
+    for (let i = 0; i < lenLen; i++) {
+      len = len * 256 + input[offset + 1 + i]
+    }
+    return len
+  }
+
+  if (prefix < 0x80) {
+    return [input.subarray(offset, offset + 1), offset + 1]
+  }
+
+  const isList = prefix >= 0xc0
+  // short items and lists have their length in the prefix, long ones in the bytes that follow it
+  const short = isList ? prefix < 0xf8 : prefix < 0xb8
+  const base = isList ? 0xc0 : 0x80
+  const lenLen = short ? 0 : prefix - base - 55
+  const len = short ? prefix - base : lengthOf(lenLen)
+  const start = offset + 1 + lenLen
+
+  const end = start + len
+  if (end > input.length) {
+    throw new Error('RLP: unexpected end of input')
+  }
+  if (!isList) {
+    return [input.subarray(start, end), end]
+  }
+
+  const items: RlpItem[] = []
+  for (let at = start; at < end; ) {
+    const [item, next] = decodeRlp(input, at)
+    items.push(item)
+    at = next
+  }
+  return [items, end]
+}
+
+function toNumber(item: RlpItem): number {
+  if (!Buffer.isBuffer(item)) {
+    throw new Error('RLP: expected a number')
+  }
+  return item.reduce((n, byte) => n * 256 + byte, 0)
+}
+
+// the recipient and chain of an unsigned legacy (EIP-155) or typed (EIP-2930, EIP-1559) transaction,
+// undefined when it can't be decoded
+export function decodeTransaction(raw: Buffer): { to: Buffer; chainId: number } | undefined {
+  try {
+    // typed transactions start with their type, followed by [chainId, nonce, ..., to, ...]
+    const typed = raw[0] === 0x01 || raw[0] === 0x02
+    const [fields] = decodeRlp(raw, typed ? 1 : 0)
+    if (!Array.isArray(fields)) {
+      return undefined
+    }
+
+    // EIP-2930: [chainId, nonce, gasPrice, gasLimit, to, ...]
+    // EIP-1559: [chainId, nonce, maxPriorityFee, maxFee, gasLimit, to, ...]
+    // legacy: [nonce, gasPrice, gasLimit, to, value, data, chainId, 0, 0]
+    const toIndex = typed ? raw[0] + 3 : 3
+    const to = fields[toIndex]
+    const chainId = typed ? fields[0] : fields[6]
+    if (!Buffer.isBuffer(to) || chainId === undefined) {
+      return undefined
+    }
+
+    return { to, chainId: toNumber(chainId) }
+  } catch {
+    return undefined
+  }
+}
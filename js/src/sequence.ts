@@ -0,0 +1,39 @@
+/** ******************************************************************************
+ *  (c) 2023 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************* */
+
+// see `app/src/utils/upload_seq.rs` for the format
+export const SEQUENCE_HEADER_LEN = 2 + 4
+
+// CRC-32 as used by zlib and ethernet
+export function crc32(data: Buffer): number {
+  let crc = ~0
+  for (const b of data) {
+    crc ^= b
+    for (let i = 0; i < 8; i += 1) {
+      crc = (crc >>> 1) ^ (0xedb88320 & -(crc & 1))
+    }
+  }
+  return ~crc >>> 0
+}
+
+// prefixes `chunk` with its offset in the upload and its checksum,
+// an empty chunk only retrieves the offset the device got to
+export function sequenceChunk(offset: number, chunk: Buffer): Buffer {
+  const header = Buffer.alloc(SEQUENCE_HEADER_LEN)
+  header.writeUInt16BE(offset, 0)
+  header.writeUInt32BE(crc32(chunk), 2)
+  return Buffer.concat([header, chunk])
+}
@@ -14,6 +14,10 @@ export interface ResponseXPub extends ResponseBase {
   chain_code: Buffer
 }
 
+export interface ResponseXPubs extends ResponseBase {
+  keys: { publicKey: Buffer; chain_code: Buffer }[]
+}
+
 export interface ResponseVersion extends ResponseBase {
   testMode: boolean
   major: number
@@ -40,6 +44,18 @@ export interface ResponseSign extends ResponseBase {
   signatures: null | Map<string, Buffer>
 }
 
+export interface SignHashOptions {
+  // check each signature against the device's public keys before returning it
+  verify?: boolean
+}
+
+export interface SignOptions extends SignHashOptions {
+  // upload repeated ids and addresses only once, the signatures are the same
+  compress?: boolean
+  // resume the upload of the transaction after a transport error
+  resumable?: boolean
+}
+
 export interface ResponseWalletId extends ResponseBase {
   id: Buffer
 }
@@ -0,0 +1,96 @@
+/** ******************************************************************************
+ *  (c) 2023 Zondax AG
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ ******************************************************************************* */
+import * as secp256k1 from '@noble/secp256k1'
+import { hmac } from '@noble/hashes/hmac'
+import { sha512 } from '@noble/hashes/sha512'
+
+const HARDENED = 0x80000000
+
+export interface ExtendedPublicKey {
+  publicKey: Buffer
+  chain_code: Buffer
+}
+
+// BIP32 CKDpub, the public key of the non-hardened child at `index`
+export function deriveChild(xpub: ExtendedPublicKey, index: number): ExtendedPublicKey {
+  if (!Number.isInteger(index) || index < 0 || index >= HARDENED) {
+    throw new Error('Only non-hardened children can be derived from a public key')
+  }
+
+  const data = Buffer.alloc(xpub.publicKey.length + 4)
+  xpub.publicKey.copy(data)
+  data.writeUInt32BE(index, xpub.publicKey.length)
+
+  const I = Buffer.from(hmac(sha512, xpub.chain_code, data))
+  const tweak = BigInt(`0x${I.subarray(0, 32).toString('hex')}`)
+  if (tweak === 0n || tweak >= secp256k1.CURVE.n) {
+    throw new Error('Invalid child key')
+  }
+
+  const child = secp256k1.Point.BASE.multiply(tweak).add(secp256k1.Point.fromHex(xpub.publicKey))
+  if (child.equals(secp256k1.Point.ZERO)) {
+    throw new Error('Invalid child key')
+  }
+
+  return { publicKey: Buffer.from(child.toRawBytes(true)), chain_code: I.subarray(32) }
+}
+
+// Derives a relative path of non-hardened children (e.g "0/3")
+export function derivePath(xpub: ExtendedPublicKey, path: string): ExtendedPublicKey {
+  return path.split('/').reduce((key, child) => deriveChild(key, Number(child)), xpub)
+}
+
+/**
+ * Returns a function checking the signature of a path suffix (e.g "0/3")
+ * against the key derived from `xpub`, the key of the path prefix
+ *
+ * The keys shared by several suffixes (the "0" of "0/1" and "0/2")
+ * are only derived once
+ */
+export function signatureVerifier(xpub: ExtendedPublicKey, hash: Buffer): (suffix: string, signature: Buffer) => boolean {
+  const parents = new Map<string, ExtendedPublicKey>()
+
+  return (suffix, signature) => {
+    // signatures are [R || S || V]
+    if (signature.length !== 65) {
+      return false
+    }
+
+    const split = suffix.lastIndexOf('/')
+    const parentPath = suffix.slice(0, Math.max(split, 0))
+
+    try {
+      let parent = parents.get(parentPath)
+      if (parent === undefined) {
+        parent = parentPath === '' ? xpub : derivePath(xpub, parentPath)
+        parents.set(parentPath, parent)
+      }
+
+      const key = deriveChild(parent, Number(suffix.slice(split + 1)))
+      const compact = secp256k1.Signature.fromCompact(signature.subarray(0, 64))
+      return secp256k1.verify(compact, hash, key.publicKey, { strict: true })
+    } catch {
+      return false
+    }
+  }
+}
+
+// Checks every signature, returning the path suffixes whose signature is invalid
+export function verifySignatures(xpub: ExtendedPublicKey, hash: Buffer, signatures: Map<string, Buffer>): string[] {
+  const verify = signatureVerifier(xpub, hash)
+
+  return [...signatures].filter(([suffix, signature]) => !verify(suffix, signature)).map(([suffix]) => suffix)
+}
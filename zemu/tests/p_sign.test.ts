@@ -192,3 +192,58 @@ describe.each(models)('P_Sign[$name]; sign', function (m) {
     }
   })
 })
+
+describe.each(models)('P_Sign[$name]; resumable', function (m) {
+  test.concurrent('sign p-chain resumed after a transport error', async function () {
+    const sim = new Zemu(m.path)
+    try {
+      await sim.start(defaultOptions(m))
+      const transport = sim.getTransport()
+      const app = new AvalancheApp(transport)
+      const msg = ADD_DELEGATOR_DATA
+
+      // the first sequenced chunk reaches the device, but its answer is lost
+      const send = transport.send.bind(transport)
+      let dropped = false
+      transport.send = async (cla, ins, p1, p2, data, statusList) => {
+        const response = await send(cla, ins, p1, p2, data, statusList)
+        if (!dropped && p1 === (0x40 | 0x01) && data !== undefined && data.length > 6) {
+          dropped = true
+          throw new Error('disconnected')
+        }
+        return response
+      }
+
+      const signers = ['0/0', '0/1', '1/100']
+      const respReq = app.sign(ROOT_PATH, signers, msg, undefined, { resumable: true })
+
+      await sim.waitUntilScreenIsNot(sim.getMainMenuSnapshot())
+
+      // same screens as the add_delegator case, under a name of its own
+      // as both run concurrently and would share the snapshots-tmp folder
+      await sim.compareSnapshotsAndApprove('.', `${m.prefix.toLowerCase()}-sign-add_delegator-resumable`)
+
+      const resp = await respReq
+
+      console.log(resp, m.name)
+
+      expect(dropped).toEqual(true)
+      expect(resp.returnCode).toEqual(0x9000)
+      expect(resp.errorMessage).toEqual('No errors')
+      expect(resp.signatures?.size).toEqual(signers.length)
+
+      const hash = crypto.createHash('sha256')
+      const msgHash = Uint8Array.from(hash.update(msg).digest())
+
+      for (const signer of signers) {
+        const resp_addr = await app.getAddressAndPubKey(`${ROOT_PATH}/${signer}`, false)
+        const pk = Uint8Array.from(resp_addr.publicKey)
+        const signatureRS = Uint8Array.from(resp.signatures?.get(signer)!).slice(0, -1)
+
+        expect(secp256k1.ecdsaVerify(signatureRS, msgHash, pk)).toEqual(true)
+      }
+    } finally {
+      await sim.close()
+    }
+  })
+})
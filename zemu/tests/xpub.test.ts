@@ -70,4 +70,31 @@ describe.each(models)('Standard [%s] - extended pubkey', function (m) {
       }
     },
   );
+
+  test.concurrent(
+    'get pubkeys of many accounts',
+    async function () {
+      const sim = new Zemu(m.path)
+      try {
+        await sim.start(defaultOptions(m))
+        const app = new AvalancheApp(sim.getTransport())
+
+        // more keys than fit in one APDU, or in a single response
+        const accounts = [...Array(10).keys()]
+        const resp = await app.getExtendedPubKeys("m/44'/9000'", accounts)
+
+        expect(resp.returnCode).toEqual(0x9000)
+        expect(resp.errorMessage).toEqual('No errors')
+        expect(resp.keys.length).toEqual(accounts.length)
+
+        for (const account of accounts) {
+          const single = await app.getExtendedPubKey(`m/44'/9000'/${account}'`, false)
+          expect(resp.keys[account].publicKey).toEqual(single.publicKey)
+          expect(resp.keys[account].chain_code).toEqual(single.chain_code)
+        }
+      } finally {
+        await sim.close()
+      }
+    },
+  );
 })